@@ -557,6 +557,8 @@ __aclp__parse_aci(char *str, aci_t *aci_item, char **errbuf)
                 slapi_filter_free(f, 1);
                 return (ACL_SYNTAX_ERR);
             } else {
+                /* The targetfilter is tested by all the operations, compile its substring assertions once */
+                filter_compile_substrings(f);
                 aci_item->targetFilter = f;
             }
         } else if (type & ACI_TARGET_MODDN) {
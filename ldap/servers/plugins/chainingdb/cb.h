@@ -64,6 +64,14 @@
 #define CB_MONITOR_COMPARECOUNT "nsCompareCount"
 #define CB_MONITOR_OUTGOINGCONN "nsOpenOpConnectionCount"
 #define CB_MONITOR_OUTGOINGBINDCOUNT "nsOpenBindConnectionCount"
+#define CB_MONITOR_PENDINGOPCOUNT "nsPendingOpCount"
+#define CB_MONITOR_CONNWAITQUEUE "nsOpConnectionWaitQueue"
+#define CB_MONITOR_CONNWAITCOUNT "nsOpConnectionWaitCount"
+#define CB_MONITOR_CONNWAITTIME "nsOpConnectionWaitTime"
+#define CB_MONITOR_CONNMAXWAITTIME "nsOpConnectionMaxWaitTime"
+#define CB_MONITOR_SEARCHCACHEHITS "nsSearchCacheHits"
+#define CB_MONITOR_SEARCHCACHEMISSES "nsSearchCacheMisses"
+#define CB_MONITOR_SEARCHCACHEENTRIES "nsSearchCacheEntries"
 
 /* Global configuration */
 #define CB_CONFIG_GLOBAL_FORWARD_CTRLS "nsTransmittedControls"
@@ -107,6 +115,8 @@
 #define CB_CONFIG_BINDRETRY "nsBindRetryLimit"
 #define CB_CONFIG_LOCALACL "nsCheckLocalACI"
 #define CB_CONFIG_HOPLIMIT "nsHopLimit"
+#define CB_CONFIG_SEARCHCACHE_TTL "nsSearchCacheTTL"
+#define CB_CONFIG_SEARCHCACHE_MAXENTRIES "nsSearchCacheMaxEntries"
 
 /* not documented */
 #define CB_CONFIG_ILLEGAL_ATTRS "nsServerDefinedAttributes"
@@ -136,6 +146,8 @@
 #define CB_DEF_MAX_TEST_TIME "15"        /* CB_CONFIG_MAX_TEST_TIME */
 #define CB_DEF_STARTTLS "off"            /* CB_CONFIG_STARTTLS */
 #define CB_DEF_BINDMECH LDAP_SASL_SIMPLE /* CB_CONFIG_BINDMECH */
+#define CB_DEF_SEARCHCACHE_TTL "0"            /* CB_CONFIG_SEARCHCACHE_TTL, 0 disables the cache */
+#define CB_DEF_SEARCHCACHE_MAXENTRIES "10000" /* CB_CONFIG_SEARCHCACHE_MAXENTRIES */
 
 #define CB_SIMPLE_BINDMECH "SIMPLE" /* will be translated to LDAP_SASL_SIMPLE */
 
@@ -264,6 +276,15 @@ typedef struct
         Slapi_CondVar *conn_list_cv;
         cb_outgoing_conn *conn_list;
         unsigned int conn_list_count;
+        unsigned int conn_pending; /* being opened, counted against maxconnections */
+        uint64_t generation;       /* incremented by cb_stale_all_connections() */
+
+        /* Statistics, protected by conn_list_mutex */
+        unsigned long ops_inflight; /* operations sent on the connections */
+        unsigned int waiters;       /* threads waiting for a connection */
+        unsigned long waitcount;    /* number of times a thread had to wait */
+        uint64_t waittime;          /* total wait time (microseconds) */
+        uint64_t maxwaittime;       /* longest wait (microseconds) */
 
     } conn;
 
@@ -321,10 +342,14 @@ typedef struct _cb_backend_instance
     int hoplimit;
     int max_idle_time; /* how long we wait before pinging the farm server */
     int max_test_time; /* how long we wait during ping */
+    int searchcache_ttl;        /* seconds the search results are cached, 0 if disabled */
+    int searchcache_maxentries; /* max number of cached entries */
 
     cb_conn_pool *pool;      /* Operation cnx pool */
     cb_conn_pool *bind_pool; /* Bind cnx pool */
 
+    struct _cb_search_cache *search_cache; /* cb_search_cache.c */
+
     Slapi_Eq_Context eq_ctx; /* Use to identify the function put in the queue */
 
     /* Monitoring */
@@ -380,6 +405,8 @@ typedef struct _cb_searchContext
     LDAPMessage *pending_result;
     int pending_result_type;
     Slapi_Entry *readahead;
+    size_t nbentries; /* CB_SEARCHCONTEXT_ENTRY: entries of data not returned yet */
+    struct _cb_search_cache_fill *cache_fill; /* result being collected for the search cache */
 } cb_searchContext;
 
 #define CB_REOPEN_CONN -1968 /* Different from any LDAP_XXX errors */
@@ -468,6 +495,21 @@ int cb_check_availability(cb_backend_instance *cb, Slapi_PBlock *pb);
 
 char *get_localhost_DNS(void);
 
+/* cb_search_cache.c */
+typedef struct _cb_search_cache cb_search_cache;
+typedef struct _cb_search_cache_fill cb_search_cache_fill;
+void cb_search_cache_init(cb_backend_instance *inst);
+void cb_search_cache_free(cb_backend_instance *inst);
+void cb_search_cache_flush(cb_backend_instance *inst);
+void cb_search_cache_get_stats(cb_backend_instance *inst, uint64_t *hits, uint64_t *misses, size_t *nbentries);
+char *cb_search_cache_key(cb_backend_instance *inst, Slapi_PBlock *pb, char **attrs);
+int cb_search_cache_get(cb_backend_instance *inst, const char *key, Slapi_Entry ***entries, size_t *nbentries, int *rc);
+uint64_t cb_search_cache_generation(cb_backend_instance *inst);
+cb_search_cache_fill *cb_search_cache_fill_new(cb_backend_instance *inst, char *key, uint64_t generation);
+void cb_search_cache_fill_add(cb_backend_instance *inst, cb_search_cache_fill **fill, const Slapi_Entry *e);
+void cb_search_cache_fill_done(cb_backend_instance *inst, cb_search_cache_fill **fill, int rc);
+void cb_search_cache_fill_free(cb_search_cache_fill **fill);
+
 /* this function is called when state of a backend changes */
 void cb_be_state_change(void *handle, char *be_name, int old_be_state, int new_be_state);
 
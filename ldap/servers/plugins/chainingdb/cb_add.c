@@ -190,6 +190,8 @@ chaining_back_add(Slapi_PBlock *pb)
             break;
 
         default:
+            /* The farm server may have applied the write: cached searches are outdated */
+            cb_search_cache_flush(cb);
             serverctrls = NULL;
             matched_msg = error_msg = NULL;
             referrals = NULL;
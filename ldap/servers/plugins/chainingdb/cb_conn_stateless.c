@@ -24,6 +24,10 @@
  *    parameter associated with it that caps the number of outstanding operations
  *    per connection.  For each connection we maintain a "usecount"
  *    which is used to track the number of threads using the connection.
+ *    Each thread waits for the result of its own msgid, libldap queues the
+ *    results of the other operations of the connection for their threads.
+ *    A request is sent on the least used connection, a new connection is
+ *    only opened when all of them have "maxconcurrency" outstanding operations.
  *
  * 3) IMPORTANT NOTE: This connexion management is stateless i.e there is no garanty that
  *    operation from the same incoming client connections are sent to the same
@@ -37,7 +41,12 @@
  *
  * 5) If no connection is available to service a request , threads
  *    go to sleep on a condition variable and one is woken up each time
- *    a connection's "usecount" is decremented.
+ *    a connection's "usecount" is decremented (all of them when a new
+ *    connection is opened).  The number of waiting threads and the time
+ *    they waited are reported in the monitor entry of the instance.
+ *    The pool is not locked while a new connection is being opened and
+ *    bound, so a slow farm server does not block the threads using the
+ *    already open connections.
  *
  * 6) If we see an LDAP_CONNECT_ERROR or LDAP_SERVER_DOWN error on a
  *    session handle, we mark its status as CB_LDAP_STATUS_DOWN and
@@ -117,6 +126,211 @@ cb_close_conn_pool(cb_conn_pool *pool)
     slapi_unlock_mutex(pool->conn.conn_list_mutex);
 }
 
+/*
+ * Open (and bind if needed) a new connection to the farm server.
+ * Called without the pool lock: connecting and binding may take a while
+ * and must not block the threads using the already open connections.
+ */
+static int
+cb_open_connection(cb_conn_pool *pool,
+                   char *hostname,
+                   unsigned int port,
+                   int secure,
+                   int isMultiThread,
+                   char *binddn,
+                   char *password,
+                   char *mech,
+                   struct timeval *bind_to,
+                   LDAP **lld,
+                   char **errmsg)
+{
+    int rc = LDAP_SUCCESS;
+    int version = LDAP_VERSION3;
+    LDAP *ld = NULL;
+
+    *lld = NULL;
+
+    /* No need to lock. url can't be changed dynamically */
+    ld = slapi_ldap_init(hostname, port, secure, isMultiThread);
+    if (NULL == ld) {
+        static int warned_init = 0;
+        if (!warned_init) {
+            slapi_log_err(SLAPI_LOG_ERR, CB_PLUGIN_SUBSYSTEM,
+                          "cb_open_connection -  Can't contact server <%s> port <%d>.\n",
+                          hostname, port);
+            warned_init = 1;
+        }
+        if (errmsg) {
+            *errmsg = slapi_ch_smprintf("%s", ENDUSERMSG);
+        }
+        return LDAP_CONNECT_ERROR;
+    }
+
+    ldap_set_option(ld, LDAP_OPT_PROTOCOL_VERSION, &version);
+    /* Don't chase referrals */
+    ldap_set_option(ld, LDAP_OPT_REFERRALS, LDAP_OPT_OFF);
+
+    /* no controls and simple bind only */
+    /* For now, bind even if no user to detect error */
+    /* earlier                     */
+    if (pool->bindit) {
+        PRErrorCode prerr = 0;
+        LDAPControl **serverctrls = NULL;
+
+        char *plain = NULL;
+        int ret = -1;
+
+        if (cb_debug_on()) {
+            slapi_log_err(SLAPI_LOG_PLUGIN, CB_PLUGIN_SUBSYSTEM,
+                          "cb_open_connection - Bind to to server <%s> port <%d> as <%s>\n",
+                          hostname, port, binddn);
+        }
+
+        ret = pw_rever_decode(password, &plain, CB_CONFIG_USERPASSWORD);
+
+        /* Pb occured in decryption: stop now, binding will fail */
+        if (ret == -1) {
+            static int warned_pw = 0;
+            if (!warned_pw) {
+                slapi_log_err(SLAPI_LOG_ERR, CB_PLUGIN_SUBSYSTEM,
+                              "cb_open_connection - Internal credentials decoding error; "
+                              "password storage schemes do not match or "
+                              "encrypted password is corrupted.\n");
+                warned_pw = 1;
+            }
+            if (errmsg) {
+                *errmsg = slapi_ch_smprintf("%s", ENDUSERMSG);
+            }
+            rc = LDAP_INVALID_CREDENTIALS;
+            goto done;
+        }
+
+        /* Password-based client authentication */
+        rc = slapi_ldap_bind(ld, binddn, plain, mech, NULL, &serverctrls,
+                             bind_to, NULL);
+
+        if (ret == 0)
+            slapi_ch_free_string(&plain); /* free plain only if it has been duplicated */
+
+        if (rc == LDAP_TIMEOUT) {
+            static int warned_bind_timeout = 0;
+            if (!warned_bind_timeout) {
+                slapi_log_err(SLAPI_LOG_ERR, CB_PLUGIN_SUBSYSTEM,
+                              "cb_open_connection - Can't bind to server <%s> port <%d>. (%s)\n",
+                              hostname, port, "time-out expired");
+                warned_bind_timeout = 1;
+            }
+            if (errmsg) {
+                *errmsg = slapi_ch_smprintf("%s", ENDUSERMSG);
+            }
+            rc = LDAP_CONNECT_ERROR;
+            goto done;
+        } else if (rc != LDAP_SUCCESS) {
+            prerr = PR_GetError();
+            static int warned_bind_err = 0;
+            if (!warned_bind_err) {
+                slapi_log_err(SLAPI_LOG_ERR, CB_PLUGIN_SUBSYSTEM,
+                              "cb_open_connection - Can't bind to server <%s> port <%d>. "
+                              "(LDAP error %d - %s; " SLAPI_COMPONENT_NAME_NSPR " error %d - %s)\n",
+                              hostname, port, rc,
+                              ldap_err2string(rc),
+                              prerr, slapd_pr_strerror(prerr));
+                warned_bind_err = 1;
+            }
+            if (errmsg) {
+                *errmsg = slapi_ch_smprintf("%s", ENDUSERMSG);
+            }
+            rc = LDAP_CONNECT_ERROR;
+            goto done;
+        }
+
+        if (serverctrls) {
+            int i;
+            for (i = 0; serverctrls[i] != NULL; ++i) {
+                if (!(strcmp(serverctrls[i]->ldctl_oid, LDAP_CONTROL_PWEXPIRED))) {
+                    /* Bind is successful but password has expired */
+                    slapi_log_err(SLAPI_LOG_ERR, CB_PLUGIN_SUBSYSTEM,
+                                  "cb_open_connection - Successfully bound as %s to remote server %s:%d, "
+                                  "but password has expired.\n",
+                                  binddn, hostname, port);
+                } else if (!(strcmp(serverctrls[i]->ldctl_oid, LDAP_CONTROL_PWEXPIRING))) {
+                    /* The password is expiring in n seconds */
+                    if ((serverctrls[i]->ldctl_value.bv_val != NULL) &&
+                        (serverctrls[i]->ldctl_value.bv_len > 0)) {
+                        int password_expiring = atoi(serverctrls[i]->ldctl_value.bv_val);
+                        slapi_log_err(SLAPI_LOG_ERR, CB_PLUGIN_SUBSYSTEM,
+                                      "cb_open_connection - Successfully bound as %s to remote server %s:%d, "
+                                      "but password is expiring in %d seconds.\n",
+                                      binddn, hostname, port, password_expiring);
+                    }
+                }
+            }
+            ldap_controls_free(serverctrls);
+        }
+    } else if (secure == 2) {
+        /* the start_tls operation is usually performed in slapi_ldap_bind, but
+           since we are not binding we still need to start_tls */
+        if (cb_debug_on()) {
+            slapi_log_err(SLAPI_LOG_PLUGIN, CB_PLUGIN_SUBSYSTEM,
+                          "cb_open_connection - doing start_tls on connection 0x%p\n", ld);
+        }
+        if ((rc = ldap_start_tls_s(ld, NULL, NULL))) {
+            PRErrorCode prerr = PR_GetError();
+            slapi_log_err(SLAPI_LOG_ERR, CB_PLUGIN_SUBSYSTEM,
+                          "cb_open_connection - Unable to do start_tls on connection to %s:%d "
+                          "LDAP error %d:%s NSS error %d:%s\n",
+                          hostname, port,
+                          rc, ldap_err2string(rc), prerr,
+                          slapd_pr_strerror(prerr));
+        }
+    }
+
+done:
+    if (rc == LDAP_SUCCESS) {
+        *lld = ld;
+    } else {
+        slapi_ldap_unbind(ld);
+    }
+    return rc;
+}
+
+/*
+ * Read the parameters used to open a connection of the pool.
+ * Returns the generation of the pool connections they belong to: a new
+ * connection opened with them is stale if cb_stale_all_connections() ran
+ * since (see cb_get_connection()).
+ */
+static uint64_t
+cb_read_connection_config(cb_conn_pool *pool, char **password, char **binddn, char **hostname,
+                          unsigned int *port, int *secure, char **mech)
+{
+    uint64_t generation;
+
+    slapi_rwlock_rdlock(pool->rwl_config_lock);
+    generation = __atomic_load_n(&pool->conn.generation, __ATOMIC_ACQUIRE);
+
+    /* SD 02/10/2000 temp fix                        */
+    /* allow dynamic update of the binddn & password */
+    /* host, port and security mode             */
+    /* previous values are NOT freed when changed    */
+    /* won't likely to be changed often         */
+    /* pointers put in the waste basket fields and   */
+    /* freed when the backend is stopped.            */
+
+    *password = pool->password;
+    *binddn = pool->binddn;
+    *hostname = pool->hostname;
+    *port = pool->port;
+    *secure = pool->secure;
+    if (pool->starttls) {
+        *secure = 2;
+    }
+    *mech = pool->mech;
+
+    slapi_rwlock_unlock(pool->rwl_config_lock);
+    return generation;
+}
+
 /*
  * Get an LDAP session handle for communicating with the farm servers.
  *
@@ -139,15 +353,17 @@ cb_get_connection(cb_conn_pool *pool,
     cb_outgoing_conn *connprev = NULL;
     LDAP *ld = NULL;
     int checktime = 0;
+    int waited = 0;
+    struct timespec wait_start;
     struct timeval bind_to, op_to;
     unsigned int maxconcurrency, maxconnections;
     char *password, *binddn, *hostname;
     unsigned int port;
     int secure;
     char *mech = NULL;
-    ;
     static char *error1 = "Can't contact remote server : %s";
     int isMultiThread = ENABLE_MULTITHREAD_PER_CONN; /* by default, we enable multiple operations per connection */
+    uint64_t generation;
 
     struct timespec cb_expire_time;
 
@@ -168,27 +384,10 @@ cb_get_connection(cb_conn_pool *pool,
     bind_to.tv_usec = pool->conn.bind_timeout.tv_usec;
     op_to.tv_sec = pool->conn.op_timeout.tv_sec;
     op_to.tv_usec = pool->conn.op_timeout.tv_usec;
-
-    /* SD 02/10/2000 temp fix                        */
-    /* allow dynamic update of the binddn & password */
-    /* host, port and security mode             */
-    /* previous values are NOT freed when changed    */
-    /* won't likely to be changed often         */
-    /* pointers put in the waste basket fields and   */
-    /* freed when the backend is stopped.            */
-
-    password = pool->password;
-    binddn = pool->binddn;
-    hostname = pool->hostname;
-    port = pool->port;
-    secure = pool->secure;
-    if (pool->starttls) {
-        secure = 2;
-    }
-    mech = pool->mech;
-
     slapi_rwlock_unlock(pool->rwl_config_lock);
 
+    generation = cb_read_connection_config(pool, &password, &binddn, &hostname, &port, &secure, &mech);
+
     if (secure) {
         isMultiThread = DISABLE_MULTITHREAD_PER_CONN;
     }
@@ -281,7 +480,14 @@ cb_get_connection(cb_conn_pool *pool,
                 }
             }
         } else {
-            connprev = NULL;
+            /*
+             * The operations are pipelined on the connections: use the least
+             * loaded one, so that an operation does not queue behind the
+             * outstanding operations of a busy connection while another one
+             * is idle.
+             */
+            cb_outgoing_conn *best = NULL;
+
             for (conn = pool->conn.conn_list; conn != NULL; conn = conn->next) {
                 if (cb_debug_on()) {
                     slapi_log_err(SLAPI_LOG_PLUGIN, CB_PLUGIN_SUBSYSTEM,
@@ -289,164 +495,58 @@ cb_get_connection(cb_conn_pool *pool,
                                   conn->status, conn->refcount);
                 }
 
-                if (conn->status == CB_CONNSTATUS_OK && conn->refcount < maxconcurrency) {
-                    if (cb_debug_on()) {
-                        slapi_log_err(SLAPI_LOG_PLUGIN, CB_PLUGIN_SUBSYSTEM,
-                                      "cb_get_connection - server found conn 0x%p to use)\n", conn);
-                    }
-                    goto unlock_and_return; /* found one */
+                if (conn->status == CB_CONNSTATUS_OK && conn->refcount < maxconcurrency &&
+                    (best == NULL || conn->refcount < best->refcount)) {
+                    best = conn;
+                }
+            }
+            if (best != NULL) {
+                conn = best;
+                if (cb_debug_on()) {
+                    slapi_log_err(SLAPI_LOG_PLUGIN, CB_PLUGIN_SUBSYSTEM,
+                                  "cb_get_connection - server found conn 0x%p to use)\n", conn);
                 }
-                connprev = conn;
+                goto unlock_and_return; /* found one */
             }
         }
 
-        if (secure || pool->conn.conn_list_count < maxconnections) {
-
-            int version = LDAP_VERSION3;
+        if (secure || pool->conn.conn_list_count + pool->conn.conn_pending < maxconnections) {
 
             /*
-                      * we have not exceeded the maximum number of connections allowed,
-                      * so we initialize a new one and add it to the end of our list.
-                      */
-
-            /* No need to lock. url can't be changed dynamically */
-            ld = slapi_ldap_init(hostname, port, secure, isMultiThread);
-            if (NULL == ld) {
-                static int warned_init = 0;
-                if (!warned_init) {
-                    slapi_log_err(SLAPI_LOG_ERR, CB_PLUGIN_SUBSYSTEM,
-                                  "cb_get_connection -  Can't contact server <%s> port <%d>.\n",
-                                  hostname, port);
-                    warned_init = 1;
-                }
-                if (errmsg) {
-                    *errmsg = slapi_ch_smprintf("%s", ENDUSERMSG);
-                }
-                rc = LDAP_CONNECT_ERROR;
+             * we have not exceeded the maximum number of connections allowed,
+             * so we open a new one and add it to the end of our list.
+             * The pool is unlocked meanwhile, the connection being opened is
+             * counted against maxconnections.
+             */
+
+            pool->conn.conn_pending++;
+            slapi_unlock_mutex(pool->conn.conn_list_mutex);
+            rc = cb_open_connection(pool, hostname, port, secure, isMultiThread,
+                                    binddn, password, mech, &bind_to, &ld, errmsg);
+            slapi_lock_mutex(pool->conn.conn_list_mutex);
+            pool->conn.conn_pending--;
+
+            if (rc != LDAP_SUCCESS) {
+                /* Another waiting thread may try in turn */
+                if (!secure)
+                    slapi_notify_condvar(pool->conn.conn_list_cv, 0);
                 goto unlock_and_return;
             }
-
-            ldap_set_option(ld, LDAP_OPT_PROTOCOL_VERSION, &version);
-            /* Don't chase referrals */
-            ldap_set_option(ld, LDAP_OPT_REFERRALS, LDAP_OPT_OFF);
-
-            /* no controls and simple bind only */
-            /* For now, bind even if no user to detect error */
-            /* earlier                     */
-            if (pool->bindit) {
-                PRErrorCode prerr = 0;
-                LDAPControl **serverctrls = NULL;
-
-                char *plain = NULL;
-                int ret = -1;
-
-                rc = LDAP_SUCCESS;
-
-                if (cb_debug_on()) {
-                    slapi_log_err(SLAPI_LOG_PLUGIN, CB_PLUGIN_SUBSYSTEM,
-                                  "cb_get_connection - Bind to to server <%s> port <%d> as <%s>\n",
-                                  hostname, port, binddn);
-                }
-
-                ret = pw_rever_decode(password, &plain, CB_CONFIG_USERPASSWORD);
-
-                /* Pb occured in decryption: stop now, binding will fail */
-                if (ret == -1) {
-                    static int warned_pw = 0;
-                    if (!warned_pw) {
-                        slapi_log_err(SLAPI_LOG_ERR, CB_PLUGIN_SUBSYSTEM,
-                                      "cb_get_connection - Internal credentials decoding error; "
-                                      "password storage schemes do not match or "
-                                      "encrypted password is corrupted.\n");
-                        warned_pw = 1;
-                    }
-                    if (errmsg) {
-                        *errmsg = slapi_ch_smprintf("%s", ENDUSERMSG);
-                    }
-                    rc = LDAP_INVALID_CREDENTIALS;
-                    goto unlock_and_return;
-                }
-
-                /* Password-based client authentication */
-                rc = slapi_ldap_bind(ld, binddn, plain, mech, NULL, &serverctrls,
-                                     &bind_to, NULL);
-
-                if (ret == 0)
-                    slapi_ch_free_string(&plain); /* free plain only if it has been duplicated */
-
-                if (rc == LDAP_TIMEOUT) {
-                    static int warned_bind_timeout = 0;
-                    if (!warned_bind_timeout) {
-                        slapi_log_err(SLAPI_LOG_ERR, CB_PLUGIN_SUBSYSTEM,
-                                      "cb_get_connection - Can't bind to server <%s> port <%d>. (%s)\n",
-                                      hostname, port, "time-out expired");
-                        warned_bind_timeout = 1;
-                    }
-                    if (errmsg) {
-                        *errmsg = slapi_ch_smprintf("%s", ENDUSERMSG);
-                    }
-                    rc = LDAP_CONNECT_ERROR;
-                    goto unlock_and_return;
-                } else if (rc != LDAP_SUCCESS) {
-                    prerr = PR_GetError();
-                    static int warned_bind_err = 0;
-                    if (!warned_bind_err) {
-                        slapi_log_err(SLAPI_LOG_ERR, CB_PLUGIN_SUBSYSTEM,
-                                      "cb_get_connection - Can't bind to server <%s> port <%d>. "
-                                      "(LDAP error %d - %s; " SLAPI_COMPONENT_NAME_NSPR " error %d - %s)\n",
-                                      hostname, port, rc,
-                                      ldap_err2string(rc),
-                                      prerr, slapd_pr_strerror(prerr));
-                        warned_bind_err = 1;
-                    }
-                    if (errmsg) {
-                        *errmsg = slapi_ch_smprintf("%s", ENDUSERMSG);
-                    }
-                    rc = LDAP_CONNECT_ERROR;
-                    goto unlock_and_return;
-                }
-
-                if (serverctrls) {
-                    int i;
-                    for (i = 0; serverctrls[i] != NULL; ++i) {
-                        if (!(strcmp(serverctrls[i]->ldctl_oid, LDAP_CONTROL_PWEXPIRED))) {
-                            /* Bind is successful but password has expired */
-                            slapi_log_err(SLAPI_LOG_ERR, CB_PLUGIN_SUBSYSTEM,
-                                          "cb_get_connection - Successfully bound as %s to remote server %s:%d, "
-                                          "but password has expired.\n",
-                                          binddn, hostname, port);
-                        } else if (!(strcmp(serverctrls[i]->ldctl_oid, LDAP_CONTROL_PWEXPIRING))) {
-                            /* The password is expiring in n seconds */
-                            if ((serverctrls[i]->ldctl_value.bv_val != NULL) &&
-                                (serverctrls[i]->ldctl_value.bv_len > 0)) {
-                                int password_expiring = atoi(serverctrls[i]->ldctl_value.bv_val);
-                                slapi_log_err(SLAPI_LOG_ERR, CB_PLUGIN_SUBSYSTEM,
-                                              "cb_get_connection - Successfully bound as %s to remote server %s:%d, "
-                                              "but password is expiring in %d seconds.\n",
-                                              binddn, hostname, port, password_expiring);
-                            }
-                        }
-                    }
-                    ldap_controls_free(serverctrls);
-                }
-            } else if (secure == 2) {
-                /* the start_tls operation is usually performed in slapi_ldap_bind, but
-                   since we are not binding we still need to start_tls */
-                if (cb_debug_on()) {
-                    slapi_log_err(SLAPI_LOG_PLUGIN, CB_PLUGIN_SUBSYSTEM,
-                                  "cb_get_connection - doing start_tls on connection 0x%p\n", conn);
-                }
-                if ((rc = ldap_start_tls_s(ld, NULL, NULL))) {
-                    PRErrorCode prerr = PR_GetError();
-                    slapi_log_err(SLAPI_LOG_ERR, CB_PLUGIN_SUBSYSTEM,
-                                  "cb_get_connection - Unable to do start_tls on connection to %s:%d "
-                                  "LDAP error %d:%s NSS error %d:%s\n",
-                                  hostname, port,
-                                  rc, ldap_err2string(rc), prerr,
-                                  slapd_pr_strerror(prerr));
-
-                    goto unlock_and_return;
-                }
+            if (__atomic_load_n(&pool->conn.generation, __ATOMIC_ACQUIRE) != generation) {
+                /*
+                 * The configuration changed while the connection was opened,
+                 * cb_stale_all_connections() could not see it: it may be bound
+                 * to the previous farm server or with the previous credentials.
+                 */
+                slapi_ldap_unbind(ld);
+                ld = NULL;
+                if (!secure)
+                    slapi_notify_condvar(pool->conn.conn_list_cv, 0);
+                slapi_unlock_mutex(pool->conn.conn_list_mutex);
+                generation = cb_read_connection_config(pool, &password, &binddn, &hostname, &port, &secure, &mech);
+                isMultiThread = secure ? DISABLE_MULTITHREAD_PER_CONN : ENABLE_MULTITHREAD_PER_CONN;
+                slapi_lock_mutex(pool->conn.conn_list_mutex);
+                continue;
             }
 
             conn = (cb_outgoing_conn *)slapi_ch_malloc(sizeof(cb_outgoing_conn));
@@ -464,11 +564,18 @@ cb_get_connection(cb_conn_pool *pool,
                     pool->connarray[PR_ThreadSelf()] = conn;
                 }
             } else {
+                /* the list may have changed while it was unlocked */
+                for (connprev = pool->conn.conn_list; connprev && connprev->next; connprev = connprev->next)
+                    ;
                 if (NULL == connprev) {
                     pool->conn.conn_list = conn;
                 } else {
                     connprev->next = conn;
                 }
+                /* The waiting threads can pipeline their operations on it */
+                if (maxconcurrency > 1) {
+                    slapi_notify_condvar(pool->conn.conn_list_cv, 1);
+                }
             }
 
             ++pool->conn.conn_list_count;
@@ -487,8 +594,20 @@ cb_get_connection(cb_conn_pool *pool,
                           "cb_get_connection - waiting for conn to free up\n");
         }
 
-        if (!secure)
-            slapi_wait_condvar_pt(pool->conn.conn_list_cv, pool->conn.conn_list_mutex, NULL);
+        if (!waited) {
+            waited = 1;
+            pool->conn.waitcount++;
+            clock_gettime(CLOCK_MONOTONIC, &wait_start);
+        }
+        if (!secure) {
+            /* Wake up regularly to check the time limit */
+            struct timeval wait_to = {1, 0};
+
+            pool->conn.waiters++;
+            slapi_wait_condvar_pt(pool->conn.conn_list_cv, pool->conn.conn_list_mutex,
+                                  checktime ? &wait_to : NULL);
+            pool->conn.waiters--;
+        }
 
         if (cb_debug_on()) {
             slapi_log_err(SLAPI_LOG_PLUGIN, CB_PLUGIN_SUBSYSTEM,
@@ -497,8 +616,21 @@ cb_get_connection(cb_conn_pool *pool,
     }
 
 unlock_and_return:
+    if (waited) {
+        struct timespec now, elapsed;
+        uint64_t usec;
+
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        slapi_timespec_diff(&now, &wait_start, &elapsed);
+        usec = (uint64_t)elapsed.tv_sec * 1000000 + elapsed.tv_nsec / 1000;
+        pool->conn.waittime += usec;
+        if (usec > pool->conn.maxwaittime) {
+            pool->conn.maxwaittime = usec;
+        }
+    }
     if (conn != NULL) {
         ++conn->refcount;
+        ++pool->conn.ops_inflight;
         *lld = conn->ld;
         *cc = conn;
         if (cb_debug_on()) {
@@ -561,6 +693,7 @@ cb_release_op_connection(cb_conn_pool *pool, LDAP *lld, int dispose)
     } else {
 
         --conn->refcount;
+        --pool->conn.ops_inflight;
 
         if (cb_debug_on()) {
             slapi_log_err(SLAPI_LOG_PLUGIN, CB_PLUGIN_SUBSYSTEM,
@@ -788,6 +921,8 @@ cb_stale_all_connections(cb_backend_instance *cb)
 
     for (i = 0; pools[i]; i++) {
         slapi_lock_mutex(pools[i]->conn.conn_list_mutex);
+        /* the connections being opened are stale too */
+        __atomic_add_fetch(&pools[i]->conn.generation, 1, __ATOMIC_RELEASE);
         for (j = 0; j < MAX_CONN_ARRAY; j++) {
             prev_conn = NULL;
             for (conn = pools[i]->connarray[j]; conn != NULL; conn = next_conn) {
@@ -171,6 +171,8 @@ chaining_back_delete(Slapi_PBlock *pb)
 #endif
             break;
         default:
+            /* The farm server may have applied the write: cached searches are outdated */
+            cb_search_cache_flush(cb);
             matched_msg = error_msg = NULL;
             parse_rc = ldap_parse_result(ld, res, &rc, &matched_msg,
                                          &error_msg, &referrals, &serverctrls, 1);
@@ -45,6 +45,8 @@ static void *cb_instance_timelimit_get(void *arg);
 static void *cb_instance_hoplimit_get(void *arg);
 static void *cb_instance_max_idle_get(void *arg);
 static void *cb_instance_max_test_get(void *arg);
+static void *cb_instance_searchcache_ttl_get(void *arg);
+static void *cb_instance_searchcache_maxentries_get(void *arg);
 
 
 /* Set functions */
@@ -71,6 +73,8 @@ static int cb_instance_timelimit_set(void *arg, void *value, char *errorbuf, int
 static int cb_instance_hoplimit_set(void *arg, void *value, char *errorbuf, int phase, int apply);
 static int cb_instance_max_idle_set(void *arg, void *value, char *errorbuf, int phase, int apply);
 static int cb_instance_max_test_set(void *arg, void *value, char *errorbuf, int phase, int apply);
+static int cb_instance_searchcache_ttl_set(void *arg, void *value, char *errorbuf, int phase, int apply);
+static int cb_instance_searchcache_maxentries_set(void *arg, void *value, char *errorbuf, int phase, int apply);
 
 /* Default hardwired values */
 
@@ -97,6 +101,8 @@ cb_instance_config_info cb_the_instance_config[] = {
     {CB_CONFIG_MAX_TEST_TIME, CB_CONFIG_TYPE_INT, CB_DEF_MAX_TEST_TIME, &cb_instance_max_test_get, &cb_instance_max_test_set, CB_ALWAYS_SHOW},
     {CB_CONFIG_STARTTLS, CB_CONFIG_TYPE_ONOFF, CB_DEF_STARTTLS, &cb_instance_starttls_get, &cb_instance_starttls_set, CB_ALWAYS_SHOW},
     {CB_CONFIG_BINDMECH, CB_CONFIG_TYPE_STRING, CB_DEF_BINDMECH, &cb_instance_bindmech_get, &cb_instance_bindmech_set, CB_ALWAYS_SHOW},
+    {CB_CONFIG_SEARCHCACHE_TTL, CB_CONFIG_TYPE_INT, CB_DEF_SEARCHCACHE_TTL, &cb_instance_searchcache_ttl_get, &cb_instance_searchcache_ttl_set, CB_ALWAYS_SHOW},
+    {CB_CONFIG_SEARCHCACHE_MAXENTRIES, CB_CONFIG_TYPE_INT, CB_DEF_SEARCHCACHE_MAXENTRIES, &cb_instance_searchcache_maxentries_get, &cb_instance_searchcache_maxentries_set, CB_ALWAYS_SHOW},
     {NULL, 0, NULL, NULL, NULL, 0}};
 
 /* Others forward declarations */
@@ -179,6 +185,8 @@ cb_instance_alloc(cb_backend *cb, char *name, char *basedn)
     inst->bind_pool->conn.conn_list_mutex = slapi_new_mutex();
     inst->bind_pool->conn.conn_list_cv = slapi_new_condvar(inst->bind_pool->conn.conn_list_mutex);
 
+    cb_search_cache_init(inst);
+
     inst->backend_type = cb;
     /* initialize monitor_availability */
     inst->monitor_availability.farmserver_state = FARMSERVER_AVAILABLE; /* we expect the farm to be available */
@@ -243,6 +251,8 @@ cb_instance_free(cb_backend_instance *inst)
             slapi_ch_free((void **)&inst->pool);
         }
 
+        cb_search_cache_free(inst);
+
         slapi_destroy_mutex(inst->monitor.mutex);
         slapi_destroy_mutex(inst->monitor_availability.cpt_lock);
         slapi_destroy_mutex(inst->monitor_availability.lock_timeLimit);
@@ -993,6 +1003,57 @@ cb_instance_max_test_set(void *arg, void *value, char *errorbuf __attribute__((u
     return LDAP_SUCCESS;
 }
 
+static void *
+cb_instance_searchcache_ttl_get(void *arg)
+{
+    cb_backend_instance *inst = (cb_backend_instance *)arg;
+    uintptr_t data;
+
+    slapi_rwlock_rdlock(inst->rwl_config_lock);
+    data = inst->searchcache_ttl;
+    slapi_rwlock_unlock(inst->rwl_config_lock);
+    return (void *)data;
+}
+
+static int
+cb_instance_searchcache_ttl_set(void *arg, void *value, char *errorbuf __attribute__((unused)), int phase __attribute__((unused)), int apply)
+{
+    cb_backend_instance *inst = (cb_backend_instance *)arg;
+    if (apply) {
+        slapi_rwlock_wrlock(inst->rwl_config_lock);
+        inst->searchcache_ttl = (int)((uintptr_t)value);
+        slapi_rwlock_unlock(inst->rwl_config_lock);
+        /* the cached results were kept for the previous ttl */
+        cb_search_cache_flush(inst);
+    }
+    return LDAP_SUCCESS;
+}
+
+static void *
+cb_instance_searchcache_maxentries_get(void *arg)
+{
+    cb_backend_instance *inst = (cb_backend_instance *)arg;
+    uintptr_t data;
+
+    slapi_rwlock_rdlock(inst->rwl_config_lock);
+    data = inst->searchcache_maxentries;
+    slapi_rwlock_unlock(inst->rwl_config_lock);
+    return (void *)data;
+}
+
+static int
+cb_instance_searchcache_maxentries_set(void *arg, void *value, char *errorbuf __attribute__((unused)), int phase __attribute__((unused)), int apply)
+{
+    cb_backend_instance *inst = (cb_backend_instance *)arg;
+    if (apply) {
+        slapi_rwlock_wrlock(inst->rwl_config_lock);
+        inst->searchcache_maxentries = (int)((uintptr_t)value);
+        slapi_rwlock_unlock(inst->rwl_config_lock);
+        cb_search_cache_flush(inst);
+    }
+    return LDAP_SUCCESS;
+}
+
 static void *
 cb_instance_max_idle_get(void *arg)
 {
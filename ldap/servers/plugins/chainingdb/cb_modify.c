@@ -179,6 +179,8 @@ chaining_back_modify(Slapi_PBlock *pb)
             break;
 
         default:
+            /* The farm server may have applied the write: cached searches are outdated */
+            cb_search_cache_flush(cb);
             matched_msg = error_msg = NULL;
             serverctrls = NULL;
             parse_rc = ldap_parse_result(ld, res, &rc, &matched_msg,
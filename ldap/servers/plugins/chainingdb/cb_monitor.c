@@ -60,6 +60,11 @@ cb_search_monitor_callback(Slapi_PBlock *pb __attribute__((unused)),
     unsigned long deletecount, addcount, modifycount, modrdncount, searchbasecount, searchonelevelcount;
     unsigned long searchsubtreecount, abandoncount, bindcount, unbindcount, comparecount;
     unsigned int outgoingconn, outgoingbindconn;
+    unsigned long pendingops, waitcount;
+    unsigned int waitqueue;
+    uint64_t waittime, maxwaittime;
+    uint64_t cachehits, cachemisses;
+    size_t cacheentries;
     cb_backend_instance *inst = (cb_backend_instance *)arg;
 
     /* First make sure the backend instance is configured */
@@ -98,8 +103,15 @@ cb_search_monitor_callback(Slapi_PBlock *pb __attribute__((unused)),
 
     slapi_lock_mutex(inst->pool->conn.conn_list_mutex);
     outgoingconn = inst->pool->conn.conn_list_count;
+    pendingops = inst->pool->conn.ops_inflight;
+    waitqueue = inst->pool->conn.waiters;
+    waitcount = inst->pool->conn.waitcount;
+    waittime = inst->pool->conn.waittime;
+    maxwaittime = inst->pool->conn.maxwaittime;
     slapi_unlock_mutex(inst->pool->conn.conn_list_mutex);
 
+    cb_search_cache_get_stats(inst, &cachehits, &cachemisses, &cacheentries);
+
     slapi_lock_mutex(inst->bind_pool->conn.conn_list_mutex);
     outgoingbindconn = inst->bind_pool->conn.conn_list_count;
     slapi_unlock_mutex(inst->bind_pool->conn.conn_list_mutex);
@@ -169,6 +181,47 @@ cb_search_monitor_callback(Slapi_PBlock *pb __attribute__((unused)),
     val.bv_len = strlen(buf);
     slapi_entry_attr_replace(e, CB_MONITOR_OUTGOINGBINDCOUNT, (struct berval **)vals);
 
+    sprintf(buf, "%lu", pendingops);
+    val.bv_val = buf;
+    val.bv_len = strlen(buf);
+    slapi_entry_attr_replace(e, CB_MONITOR_PENDINGOPCOUNT, (struct berval **)vals);
+
+    sprintf(buf, "%u", waitqueue);
+    val.bv_val = buf;
+    val.bv_len = strlen(buf);
+    slapi_entry_attr_replace(e, CB_MONITOR_CONNWAITQUEUE, (struct berval **)vals);
+
+    sprintf(buf, "%lu", waitcount);
+    val.bv_val = buf;
+    val.bv_len = strlen(buf);
+    slapi_entry_attr_replace(e, CB_MONITOR_CONNWAITCOUNT, (struct berval **)vals);
+
+    /* wait times in milliseconds */
+    sprintf(buf, "%" PRIu64, waittime / 1000);
+    val.bv_val = buf;
+    val.bv_len = strlen(buf);
+    slapi_entry_attr_replace(e, CB_MONITOR_CONNWAITTIME, (struct berval **)vals);
+
+    sprintf(buf, "%" PRIu64, maxwaittime / 1000);
+    val.bv_val = buf;
+    val.bv_len = strlen(buf);
+    slapi_entry_attr_replace(e, CB_MONITOR_CONNMAXWAITTIME, (struct berval **)vals);
+
+    sprintf(buf, "%" PRIu64, cachehits);
+    val.bv_val = buf;
+    val.bv_len = strlen(buf);
+    slapi_entry_attr_replace(e, CB_MONITOR_SEARCHCACHEHITS, (struct berval **)vals);
+
+    sprintf(buf, "%" PRIu64, cachemisses);
+    val.bv_val = buf;
+    val.bv_len = strlen(buf);
+    slapi_entry_attr_replace(e, CB_MONITOR_SEARCHCACHEMISSES, (struct berval **)vals);
+
+    sprintf(buf, "%zu", cacheentries);
+    val.bv_val = buf;
+    val.bv_len = strlen(buf);
+    slapi_entry_attr_replace(e, CB_MONITOR_SEARCHCACHEENTRIES, (struct berval **)vals);
+
     *returnCode = LDAP_SUCCESS;
     return (SLAPI_DSE_CALLBACK_OK);
 }
@@ -46,6 +46,9 @@ chainingdb_build_candidate_list(Slapi_PBlock *pb)
     char *matched_msg, *error_msg;
     char **referrals = NULL;
     char *cnxerrbuf = NULL;
+    char *cachekey = NULL;
+    Slapi_Entry **cached = NULL;
+    uint64_t cache_generation;
     int scope, attrsonly, sizelimit, timelimit, searchreferral;
     int rc, parse_rc, doit;
 
@@ -134,6 +137,7 @@ chainingdb_build_candidate_list(Slapi_PBlock *pb)
         ctx = (cb_searchContext *)slapi_ch_calloc(1, sizeof(cb_searchContext));
         ctx->type = CB_SEARCHCONTEXT_ENTRY;
         ctx->data = aciArray;
+        ctx->nbentries = 1;
         slapi_pblock_set(pb, SLAPI_SEARCH_RESULT_SET, ctx);
         return 0;
     }
@@ -182,6 +186,28 @@ chainingdb_build_candidate_list(Slapi_PBlock *pb)
         }
     }
 
+    /* Answer from the search cache if an identical search was done recently */
+    if ((cachekey = cb_search_cache_key(cb, pb, attrs)) != NULL) {
+        int cached_rc = LDAP_SUCCESS;
+        size_t nbcached = 0;
+
+        if (cb_search_cache_get(cb, cachekey, &cached, &nbcached, &cached_rc)) {
+            slapi_ch_free_string(&cachekey);
+            if (cached_rc != LDAP_SUCCESS) {
+                cb_send_ldap_result(pb, cached_rc, NULL, ENDUSERMSG, 0, NULL);
+                slapi_ch_free((void **)&cached);
+                return -1;
+            }
+            ctx = (cb_searchContext *)slapi_ch_calloc(1, sizeof(cb_searchContext));
+            ctx->type = CB_SEARCHCONTEXT_ENTRY;
+            ctx->data = cached;
+            ctx->nbentries = nbcached;
+            slapi_pblock_set(pb, SLAPI_SEARCH_RESULT_SET, ctx);
+            return 0;
+        }
+        slapi_ch_free_string(&cachekey);
+    }
+
     /* Grab a connection handle */
     rc = cb_get_connection(cb->pool, &ld, &cnx, &expire_time, &cnxerrbuf);
     if (LDAP_SUCCESS != rc) {
@@ -239,6 +265,8 @@ chainingdb_build_candidate_list(Slapi_PBlock *pb)
         endtime = slapi_current_rel_time_t() + cb->max_idle_time;
     }
 
+    /* before sending: a flush from now on invalidates the result */
+    cache_generation = cb_search_cache_generation(cb);
     rc = ldap_search_ext(ld, target, scope, filter, attrs, attrsonly,
                          ctrls, NULL, &timeout, sizelimit, &(ctx->msgid));
 
@@ -348,6 +376,10 @@ chainingdb_build_candidate_list(Slapi_PBlock *pb)
                     warned_rc = 1;
                 }
                 cb_send_ldap_result(pb, rc, NULL, ENDUSERMSG, 0, NULL);
+                if (rc == LDAP_NO_SUCH_OBJECT) {
+                    cb_search_cache_fill *fill = cb_search_cache_fill_new(cb, cb_search_cache_key(cb, pb, attrs), cache_generation);
+                    cb_search_cache_fill_done(cb, &fill, rc);
+                }
                 /* BEWARE: matched_msg points */
                 /* to ld fields.                */
                 matched_msg = NULL;
@@ -373,6 +405,8 @@ chainingdb_build_candidate_list(Slapi_PBlock *pb)
             doit = 0;
         }
     }
+    /* The entries are collected for the search cache while they are returned */
+    ctx->cache_fill = cb_search_cache_fill_new(cb, cb_search_cache_key(cb, pb, attrs), cache_generation);
     slapi_pblock_set(pb, SLAPI_SEARCH_RESULT_SET, ctx);
 
     return 0;
@@ -468,14 +502,15 @@ chainingdb_next_search_entry(Slapi_PBlock *pb)
 
         /*
         ** Return the Slapi_Entry of the result set one
-        ** by one
+        ** by one, from the end of the array
         */
 
-        for (n = 0, ptr = (Slapi_Entry **)ctx->data; ptr != NULL && ptr[n] != NULL; n++)
-            ;
-        if (n != 0) {
-            Slapi_Entry *anEntry = ptr[n - 1];
-            ptr[n - 1] = NULL;
+        if (ctx->nbentries != 0) {
+            Slapi_Entry *anEntry;
+
+            ptr = (Slapi_Entry **)ctx->data;
+            anEntry = ptr[--ctx->nbentries];
+            ptr[ctx->nbentries] = NULL;
             slapi_pblock_set(pb, SLAPI_SEARCH_RESULT_ENTRY, anEntry);
             slapi_pblock_set(pb, SLAPI_SEARCH_RESULT_SET, ctx);
             cb_set_acl_policy(pb);
@@ -510,6 +545,7 @@ chainingdb_next_search_entry(Slapi_PBlock *pb)
         if (cb_check_forward_abandon(cb, pb, ctx->ld, ctx->msgid)) {
             /* cnx handle released */
             ldap_msgfree(ctx->pending_result);
+            cb_search_cache_fill_free(&ctx->cache_fill);
             slapi_ch_free((void **)&ctx);
             slapi_pblock_set(pb, SLAPI_SEARCH_RESULT_SET, NULL);
             slapi_pblock_set(pb, SLAPI_SEARCH_RESULT_ENTRY, NULL);
@@ -552,6 +588,7 @@ chainingdb_next_search_entry(Slapi_PBlock *pb)
 
             ldap_msgfree(res);
             cb_release_op_connection(cb->pool, ctx->ld, CB_LDAP_CONN_ERROR(rc));
+            cb_search_cache_fill_free(&ctx->cache_fill);
             slapi_ch_free((void **)&ctx);
             return -1;
         case 0:
@@ -566,6 +603,7 @@ chainingdb_next_search_entry(Slapi_PBlock *pb)
 
                 ldap_msgfree(res);
                 cb_release_op_connection(cb->pool, ctx->ld, CB_LDAP_CONN_ERROR(rc));
+                cb_search_cache_fill_free(&ctx->cache_fill);
                 slapi_ch_free((void **)&ctx);
                 return -1;
             }
@@ -591,10 +629,12 @@ chainingdb_next_search_entry(Slapi_PBlock *pb)
 
                 ldap_msgfree(res);
                 cb_release_op_connection(cb->pool, ctx->ld, 0);
+                cb_search_cache_fill_free(&ctx->cache_fill);
                 slapi_ch_free((void **)&ctx);
                 return -1;
             }
 
+            cb_search_cache_fill_add(cb, &ctx->cache_fill, entry);
             ctx->tobefreed = entry;
             slapi_pblock_set(pb, SLAPI_SEARCH_RESULT_SET, ctx);
             slapi_pblock_set(pb, SLAPI_SEARCH_RESULT_ENTRY, entry);
@@ -613,11 +653,15 @@ chainingdb_next_search_entry(Slapi_PBlock *pb)
                 endtime = slapi_current_rel_time_t() + cb->max_idle_time;
             }
 
+            /* Results with references are not cached */
+            cb_search_cache_fill_free(&ctx->cache_fill);
+
             parse_rc = ldap_parse_reference(ctx->ld, res, &referrals, NULL, 1);
             if (parse_rc != LDAP_SUCCESS) {
                 cb_send_ldap_result(pb, LDAP_OPERATIONS_ERROR, NULL,
                                     ldap_err2string(parse_rc), 0, NULL);
                 cb_release_op_connection(cb->pool, ctx->ld, CB_LDAP_CONN_ERROR(parse_rc));
+                cb_search_cache_fill_free(&ctx->cache_fill);
                 slapi_ch_free((void **)&ctx);
 
                 slapi_pblock_set(pb, SLAPI_SEARCH_RESULT_SET, NULL);
@@ -692,6 +736,7 @@ chainingdb_next_search_entry(Slapi_PBlock *pb)
                     warned_rc = 1;
                 }
                 cb_send_ldap_result(pb, rc, matched_msg, ENDUSERMSG, 0, NULL);
+                cb_search_cache_fill_done(cb, &ctx->cache_fill, rc);
 
                 /* BEWARE: Don't free matched_msg */
                 /* Points to the ld fields               */
@@ -701,6 +746,10 @@ chainingdb_next_search_entry(Slapi_PBlock *pb)
                 /* Add control response sent by the farm server */
                 for (i = 0; serverctrls && serverctrls[i]; i++)
                     slapi_pblock_set(pb, SLAPI_ADD_RESCONTROL, serverctrls[i]);
+                /* Results with response controls are not cached */
+                if (serverctrls == NULL) {
+                    cb_search_cache_fill_done(cb, &ctx->cache_fill, LDAP_SUCCESS);
+                }
                 retcode = 0;
             }
 
@@ -710,6 +759,7 @@ chainingdb_next_search_entry(Slapi_PBlock *pb)
             charray_free(referrals);
 
             cb_release_op_connection(cb->pool, ctx->ld, 0);
+            cb_search_cache_fill_free(&ctx->cache_fill);
             slapi_ch_free((void **)&ctx);
             return retcode;
 
@@ -741,7 +791,14 @@ chaining_back_search_results_release(void **sr)
     }
     slapi_entry_free(ctx->tobefreed);
     ctx->tobefreed = NULL;
+    if (ctx->type == CB_SEARCHCONTEXT_ENTRY) {
+        /* entries not returned yet (abandoned search answered from the cache) */
+        for (Slapi_Entry **ptr = (Slapi_Entry **)ctx->data; ptr && *ptr; ptr++) {
+            slapi_entry_free(*ptr);
+        }
+    }
     slapi_ch_free((void **)&ctx->data);
+    cb_search_cache_fill_free(&ctx->cache_fill);
     slapi_ch_free((void **)&ctx);
     return;
 }
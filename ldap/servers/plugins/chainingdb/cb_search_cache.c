@@ -0,0 +1,440 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+#include "cb.h"
+
+/*
+ * Optional cache of the chained search results.
+ *
+ * Applications often issue the very same search thousands of times per
+ * minute, and each one of them used to be sent to the farm server.  When
+ * nsSearchCacheTTL is set, the complete result of a chained search is kept
+ * for that many seconds and the identical searches are answered from it:
+ *
+ * 1) The key is made of everything that may change the result: the
+ *    requestor, the base, the scope, the filter, the requested attributes,
+ *    attrsonly, the size limit and the request controls.
+ *
+ * 2) Only complete results are cached: successful searches that returned
+ *    no reference nor response control, and searches whose base does not
+ *    exist (noSuchObject) so that the lookups of missing entries are not
+ *    sent to the farm server again either.
+ *
+ * 3) nsSearchCacheMaxEntries bounds the number of cached entries (a
+ *    noSuchObject result counts as one entry).  The oldest results are
+ *    evicted first and larger results are not cached.
+ *
+ * 4) Any write sent through the chaining instance flushes the cache.  The
+ *    results of the searches still in progress at that time are not cached
+ *    since they may have been read before the write.  The writes made on
+ *    the farm server by other means are only seen once the results expire,
+ *    hence the short TTL.
+ */
+
+typedef struct _cb_cached_result
+{
+    char *key;
+    time_t expire;
+    int rc;                /* LDAP_SUCCESS or LDAP_NO_SUCH_OBJECT */
+    Slapi_Entry **entries; /* in the order they were returned */
+    size_t nbentries;
+    struct _cb_cached_result *prev; /* insertion order, for eviction */
+    struct _cb_cached_result *next;
+} cb_cached_result;
+
+struct _cb_search_cache
+{
+    Slapi_Mutex *lock;
+    PLHashTable *results; /* key -> cb_cached_result */
+    cb_cached_result *oldest;
+    cb_cached_result *newest;
+    size_t nbentries;
+    uint64_t generation; /* incremented by each flush */
+    uint64_t hits;
+    uint64_t misses;
+};
+
+struct _cb_search_cache_fill
+{
+    char *key;
+    uint64_t generation; /* of the cache when the search was sent */
+    Slapi_Entry **entries;
+    size_t nbentries;
+    size_t size;
+};
+
+typedef struct
+{
+    char *buf;
+    size_t len;
+    size_t size;
+} cb_cache_key;
+
+static void
+cb_search_cache_config(cb_backend_instance *inst, int *ttl, int *maxentries)
+{
+    slapi_rwlock_rdlock(inst->rwl_config_lock);
+    *ttl = inst->searchcache_ttl;
+    *maxentries = inst->searchcache_maxentries;
+    slapi_rwlock_unlock(inst->rwl_config_lock);
+}
+
+void
+cb_search_cache_init(cb_backend_instance *inst)
+{
+    cb_search_cache *cache = (cb_search_cache *)slapi_ch_calloc(1, sizeof(cb_search_cache));
+
+    cache->lock = slapi_new_mutex();
+    cache->results = PL_NewHashTable(64, PL_HashString, PL_CompareStrings,
+                                     PL_CompareValues, NULL, NULL);
+    inst->search_cache = cache;
+}
+
+static void
+cb_cached_result_free(cb_cached_result **r)
+{
+    for (size_t i = 0; i < (*r)->nbentries; i++) {
+        slapi_entry_free((*r)->entries[i]);
+    }
+    slapi_ch_free((void **)&(*r)->entries);
+    slapi_ch_free_string(&(*r)->key);
+    slapi_ch_free((void **)r);
+}
+
+/* Called with the cache lock held */
+static void
+cb_search_cache_remove(cb_search_cache *cache, cb_cached_result *r)
+{
+    PL_HashTableRemove(cache->results, r->key);
+    if (r->prev) {
+        r->prev->next = r->next;
+    } else {
+        cache->oldest = r->next;
+    }
+    if (r->next) {
+        r->next->prev = r->prev;
+    } else {
+        cache->newest = r->prev;
+    }
+    cache->nbentries -= r->nbentries ? r->nbentries : 1;
+    cb_cached_result_free(&r);
+}
+
+void
+cb_search_cache_flush(cb_backend_instance *inst)
+{
+    cb_search_cache *cache = inst->search_cache;
+
+    if (cache == NULL) {
+        return;
+    }
+    slapi_lock_mutex(cache->lock);
+    cache->generation++;
+    while (cache->oldest) {
+        cb_search_cache_remove(cache, cache->oldest);
+    }
+    slapi_unlock_mutex(cache->lock);
+}
+
+void
+cb_search_cache_free(cb_backend_instance *inst)
+{
+    cb_search_cache *cache = inst->search_cache;
+
+    if (cache == NULL) {
+        return;
+    }
+    cb_search_cache_flush(inst);
+    PL_HashTableDestroy(cache->results);
+    slapi_destroy_mutex(cache->lock);
+    slapi_ch_free((void **)&inst->search_cache);
+}
+
+void
+cb_search_cache_get_stats(cb_backend_instance *inst, uint64_t *hits, uint64_t *misses, size_t *nbentries)
+{
+    cb_search_cache *cache = inst->search_cache;
+
+    slapi_lock_mutex(cache->lock);
+    *hits = cache->hits;
+    *misses = cache->misses;
+    *nbentries = cache->nbentries;
+    slapi_unlock_mutex(cache->lock);
+}
+
+/* Append a length prefixed component, so that no two keys are ambiguous */
+static void
+cb_cache_key_add(cb_cache_key *key, const char *val, size_t len)
+{
+    char prefix[32];
+    size_t plen = snprintf(prefix, sizeof(prefix), "%zu:", len);
+
+    if (key->len + plen + len + 1 > key->size) {
+        key->size = (key->len + plen + len + 1) * 2;
+        key->buf = slapi_ch_realloc(key->buf, key->size);
+    }
+    memcpy(key->buf + key->len, prefix, plen);
+    key->len += plen;
+    memcpy(key->buf + key->len, val, len);
+    key->len += len;
+    key->buf[key->len] = '\0';
+}
+
+static void
+cb_cache_key_add_str(cb_cache_key *key, const char *val)
+{
+    cb_cache_key_add(key, val ? val : "", val ? strlen(val) : 0);
+}
+
+static void
+cb_cache_key_add_int(cb_cache_key *key, int val)
+{
+    char buf[32];
+
+    cb_cache_key_add(key, buf, snprintf(buf, sizeof(buf), "%d", val));
+}
+
+/* The control values are binary, they are hex encoded in the key */
+static void
+cb_cache_key_add_bv(cb_cache_key *key, const struct berval *bv)
+{
+    static const char hex[] = "0123456789abcdef";
+    char *buf = slapi_ch_malloc(bv->bv_len * 2 + 1);
+
+    for (size_t i = 0; i < bv->bv_len; i++) {
+        buf[2 * i] = hex[((unsigned char)bv->bv_val[i]) >> 4];
+        buf[2 * i + 1] = hex[((unsigned char)bv->bv_val[i]) & 0xf];
+    }
+    cb_cache_key_add(key, buf, bv->bv_len * 2);
+    slapi_ch_free_string(&buf);
+}
+
+/*
+ * Return the cache key of a chained search, NULL if the search cache is
+ * disabled.  attrs is the attribute list sent to the farm server.
+ */
+char *
+cb_search_cache_key(cb_backend_instance *inst, Slapi_PBlock *pb, char **attrs)
+{
+    cb_cache_key key = {0};
+    Slapi_DN *target_sdn = NULL;
+    LDAPControl **controls = NULL;
+    char *requestor = NULL;
+    char *filter = NULL;
+    int ttl, maxentries;
+    int scope, attrsonly, sizelimit;
+
+    cb_search_cache_config(inst, &ttl, &maxentries);
+    if (ttl <= 0 || maxentries <= 0) {
+        return NULL;
+    }
+
+    slapi_pblock_get(pb, SLAPI_REQUESTOR_NDN, &requestor);
+    slapi_pblock_get(pb, SLAPI_SEARCH_TARGET_SDN, &target_sdn);
+    slapi_pblock_get(pb, SLAPI_SEARCH_SCOPE, &scope);
+    slapi_pblock_get(pb, SLAPI_SEARCH_STRFILTER, &filter);
+    slapi_pblock_get(pb, SLAPI_SEARCH_ATTRSONLY, &attrsonly);
+    slapi_pblock_get(pb, SLAPI_SEARCH_SIZELIMIT, &sizelimit);
+    slapi_pblock_get(pb, SLAPI_REQCONTROLS, &controls);
+
+    cb_cache_key_add_str(&key, requestor);
+    cb_cache_key_add_str(&key, slapi_sdn_get_ndn(target_sdn));
+    cb_cache_key_add_int(&key, scope);
+    cb_cache_key_add_str(&key, filter);
+    cb_cache_key_add_int(&key, attrsonly);
+    cb_cache_key_add_int(&key, sizelimit);
+    for (size_t i = 0; attrs && attrs[i]; i++) {
+        cb_cache_key_add_str(&key, attrs[i]);
+    }
+    /* the attributes and the controls are separated by an empty component */
+    cb_cache_key_add(&key, "", 0);
+    for (size_t i = 0; controls && controls[i]; i++) {
+        cb_cache_key_add_str(&key, controls[i]->ldctl_oid);
+        cb_cache_key_add_int(&key, controls[i]->ldctl_iscritical);
+        cb_cache_key_add_bv(&key, &controls[i]->ldctl_value);
+    }
+    return key.buf;
+}
+
+/*
+ * Look for the result of a search in the cache.
+ * Returns 1 and sets rc, entries and nbentries if it is found.  The
+ * entries are copies, in the reverse order of the result, as expected by
+ * a CB_SEARCHCONTEXT_ENTRY search context.
+ */
+int
+cb_search_cache_get(cb_backend_instance *inst, const char *key, Slapi_Entry ***entries, size_t *nbentries, int *rc)
+{
+    cb_search_cache *cache = inst->search_cache;
+    cb_cached_result *r = NULL;
+    Slapi_Entry **copies = NULL;
+
+    slapi_lock_mutex(cache->lock);
+    r = (cb_cached_result *)PL_HashTableLookup(cache->results, key);
+    if (r && r->expire <= slapi_current_rel_time_t()) {
+        cb_search_cache_remove(cache, r);
+        r = NULL;
+    }
+    if (r == NULL) {
+        cache->misses++;
+        slapi_unlock_mutex(cache->lock);
+        return 0;
+    }
+    cache->hits++;
+    *rc = r->rc;
+    copies = (Slapi_Entry **)slapi_ch_calloc(r->nbentries + 1, sizeof(Slapi_Entry *));
+    for (size_t i = 0; i < r->nbentries; i++) {
+        copies[r->nbentries - 1 - i] = slapi_entry_dup(r->entries[i]);
+    }
+    slapi_unlock_mutex(cache->lock);
+
+    *entries = copies;
+    *nbentries = r->nbentries;
+    return 1;
+}
+
+/*
+ * Return the current generation of the cache. It must be read before the
+ * search is sent to the farm server: a flush done while the search runs
+ * then prevents caching a result that may predate the flushed update.
+ */
+uint64_t
+cb_search_cache_generation(cb_backend_instance *inst)
+{
+    cb_search_cache *cache = inst->search_cache;
+    uint64_t generation;
+
+    if (cache == NULL) {
+        return 0;
+    }
+    slapi_lock_mutex(cache->lock);
+    generation = cache->generation;
+    slapi_unlock_mutex(cache->lock);
+    return generation;
+}
+
+/*
+ * Start collecting the result of a search sent to the farm server.
+ * generation is the one returned by cb_search_cache_generation() before
+ * the search was sent. The key is consumed.
+ */
+cb_search_cache_fill *
+cb_search_cache_fill_new(cb_backend_instance *inst __attribute__((unused)), char *key, uint64_t generation)
+{
+    cb_search_cache_fill *fill = NULL;
+
+    if (key == NULL) {
+        return NULL;
+    }
+    fill = (cb_search_cache_fill *)slapi_ch_calloc(1, sizeof(cb_search_cache_fill));
+    fill->key = key;
+    fill->generation = generation;
+    return fill;
+}
+
+void
+cb_search_cache_fill_free(cb_search_cache_fill **fill)
+{
+    if (fill == NULL || *fill == NULL) {
+        return;
+    }
+    for (size_t i = 0; i < (*fill)->nbentries; i++) {
+        slapi_entry_free((*fill)->entries[i]);
+    }
+    slapi_ch_free((void **)&(*fill)->entries);
+    slapi_ch_free_string(&(*fill)->key);
+    slapi_ch_free((void **)fill);
+}
+
+/* Keep a copy of an entry of the result, give up if the result is too large */
+void
+cb_search_cache_fill_add(cb_backend_instance *inst, cb_search_cache_fill **fill, const Slapi_Entry *e)
+{
+    int ttl, maxentries;
+
+    if (*fill == NULL) {
+        return;
+    }
+    cb_search_cache_config(inst, &ttl, &maxentries);
+    if ((*fill)->nbentries >= (size_t)maxentries) {
+        cb_search_cache_fill_free(fill);
+        return;
+    }
+    if ((*fill)->nbentries == (*fill)->size) {
+        (*fill)->size = (*fill)->size ? (*fill)->size * 2 : 8;
+        (*fill)->entries = (Slapi_Entry **)slapi_ch_realloc((char *)(*fill)->entries,
+                                                           (*fill)->size * sizeof(Slapi_Entry *));
+    }
+    (*fill)->entries[(*fill)->nbentries++] = slapi_entry_dup(e);
+}
+
+/*
+ * The search is complete: cache its result if it can be, then free the
+ * collected entries.
+ */
+void
+cb_search_cache_fill_done(cb_backend_instance *inst, cb_search_cache_fill **fill, int rc)
+{
+    cb_search_cache *cache = inst->search_cache;
+    cb_cached_result *r = NULL;
+    size_t weight;
+    int ttl, maxentries;
+
+    if (*fill == NULL) {
+        return;
+    }
+    cb_search_cache_config(inst, &ttl, &maxentries);
+    weight = (*fill)->nbentries ? (*fill)->nbentries : 1;
+    if ((rc != LDAP_SUCCESS && !(rc == LDAP_NO_SUCH_OBJECT && (*fill)->nbentries == 0)) ||
+        ttl <= 0 || weight > (size_t)maxentries) {
+        cb_search_cache_fill_free(fill);
+        return;
+    }
+
+    slapi_lock_mutex(cache->lock);
+    if ((*fill)->generation != cache->generation) {
+        /* a write was sent meanwhile, the result may be outdated */
+        slapi_unlock_mutex(cache->lock);
+        cb_search_cache_fill_free(fill);
+        return;
+    }
+    if ((r = (cb_cached_result *)PL_HashTableLookup(cache->results, (*fill)->key)) != NULL) {
+        /* cached by a concurrent identical search */
+        cb_search_cache_remove(cache, r);
+    }
+    while (cache->oldest && cache->nbentries + weight > (size_t)maxentries) {
+        cb_search_cache_remove(cache, cache->oldest);
+    }
+
+    r = (cb_cached_result *)slapi_ch_calloc(1, sizeof(cb_cached_result));
+    r->key = (*fill)->key;
+    r->expire = slapi_current_rel_time_t() + ttl;
+    r->rc = rc;
+    r->entries = (*fill)->entries;
+    r->nbentries = (*fill)->nbentries;
+    r->prev = cache->newest;
+    if (cache->newest) {
+        cache->newest->next = r;
+    } else {
+        cache->oldest = r;
+    }
+    cache->newest = r;
+    cache->nbentries += weight;
+    PL_HashTableAdd(cache->results, r->key, r);
+    slapi_unlock_mutex(cache->lock);
+
+    /* now owned by the cache */
+    (*fill)->key = NULL;
+    (*fill)->entries = NULL;
+    (*fill)->nbentries = 0;
+    cb_search_cache_fill_free(fill);
+}
@@ -25,7 +25,11 @@
     multiple thread access to the cache,
     at the expense of modification speed.
     This means that when changes do occur,
-    the cache must be rebuilt from scratch.
+    a new cache must be built.  When only
+    templates change, it is built from the
+    current one, searching again only the
+    templates of the definitions using them,
+    otherwise it is rebuilt from scratch.
     However, this is achieved in such a way,
     so as to allow cache queries during the
     building of the new cache - so once a
@@ -54,6 +58,7 @@
 #include "prerror.h"
 #include "prcvar.h"
 #include "prio.h"
+#include "plhash.h"
 #include "vattr_spi.h"
 
 #include "cos_cache.h"
@@ -109,9 +114,15 @@ void *cos_get_plugin_identity(void);
 #define COSTYPE_INDIRECT 3
 #define COS_DEF_ERROR_NO_TEMPLATES -2
 
-/* both variables are protected by change_lock */
+/* what a change of an entry requires from the cache */
+#define COS_CHANGE_TEMPLATE 1   /* search the templates of some definitions again */
+#define COS_CHANGE_DEFINITION 2 /* rebuild the whole cache */
+
+/* these variables are protected by change_lock */
 static int cos_cache_notify_flag = 0;
 static PRBool cos_cache_at_work = PR_FALSE;
+static int cos_cache_full_rebuild = 1;       /* a definition or a backend changed */
+static char **cos_cache_changed_tmpls = NULL; /* dns of the templates changed since the last rebuild */
 
 /* service definition cache structs */
 
@@ -148,6 +159,7 @@ struct _cosAttribute
     int attr_operational;
     int attr_operational_default;
     int attr_cos_merge;
+    int attr_index; /* position in the cache attribute index */
     void *pParent;
 };
 typedef struct _cosAttribute cosAttributes;
@@ -162,6 +174,7 @@ struct _cosTemplate
     int template_default;
     void *pParent;
     unsigned long cosPriority;
+    struct _cosTemplate *pNextGrade; /* next template of the definition with the same grade */
 };
 
 typedef struct _cosTemplate cosTemplates;
@@ -180,9 +193,55 @@ struct _cosDefinition
     cosAttrValue *pCosOpDefault;
     cosAttrValue *pCosMerge;
     cosTemplates *pCosTmps;
+    int defIndex;             /* position in the definition list */
+    PLHashTable *pGradeIndex; /* classic: lower cased grade -> templates */
 };
 typedef struct _cosDefinition cosDefinitions;
 
+/*
+    cosAttrGroup: the entries of the cache attribute index for one
+    attribute type, and the definitions supplying it
+*/
+struct _cosAttrGroup
+{
+    int first; /* first occurrence in the attribute index */
+    int count;
+    cosDefinitions **ppDefs;
+    int defCount;
+};
+typedef struct _cosAttrGroup cosAttrGroup;
+
+/* cosScope: the definitions having a given target tree */
+struct _cosScope
+{
+    cosDefinitions *pDef;
+    struct _cosScope *pNext;
+};
+typedef struct _cosScope cosScope;
+
+/* cosSpecValues: the values of a cosSpecifier in the entry queried */
+struct _cosSpecValues
+{
+    Slapi_ValueSet *pVals;
+    char *actual_type_name;
+    int free_flags;
+    struct _cosSpecValues *pNext; /* next cosSpecifier of the definition */
+};
+typedef struct _cosSpecValues cosSpecValues;
+
+/* cosCandidates: attribute index entries to test for a query */
+#define COS_CANDIDATES_PREALLOC 32
+struct _cosCandidates
+{
+    int *index;
+    int count;
+    int size;
+    int prealloc[COS_CANDIDATES_PREALLOC];
+    cosSpecValues **ppSpecs; /* by definition index, fetched once per query */
+    int specCount;
+};
+typedef struct _cosCandidates cosCandidates;
+
 struct _cos_cache
 {
     cosDefinitions *pDefs;
@@ -192,6 +251,11 @@ struct _cos_cache
     int templateCount;
     int refCount;
     int vattr_cacheable;
+    int defCount;
+    int skippedDefs;           /* definitions skipped for lack of templates */
+    PLHashTable *pAttrGroups;  /* attribute type -> cosAttrGroup */
+    PLHashTable *pScopeIndex;  /* lower cased target tree -> cosScope */
+    cosScope *pScopeAll;       /* definitions applying to the whole DIT */
 };
 typedef struct _cos_cache cosCache;
 
@@ -199,16 +263,21 @@ typedef struct _cos_cache cosCache;
 static cosCache *pCache; /* always the current global cache, only use getref to get */
 
 /* the place to start if you want a new cache */
-static int cos_cache_create_unlock(void);
+static int cos_cache_create_unlock(char **changed_tmpls);
 static int cos_cache_creation_lock(void);
+static void cos_cache_destroy(cosCache *pOldCache);
 
 /* cache index related functions */
 static int cos_cache_index_all(cosCache *pCache);
+static int cos_cache_compile(cosCache *pCache);
+static void cos_cache_compile_free(cosCache *pCache);
+static void cos_cache_find_candidates(cosCache *pCache, cosAttrGroup *pGroup, vattr_context *context, Slapi_Entry *e, const char *pDn, char *type, cosCandidates *pCand);
+static cosSpecValues *cos_cache_get_specifiers(cosCache *pCache, cosCandidates *pCand, cosDefinitions *pDef, vattr_context *context, Slapi_Entry *e);
+static void cos_cache_candidates_done(cosCandidates *pCand);
 static int cos_cache_attr_compare(const void *e1, const void *e2);
 static int cos_cache_template_index_compare(const void *e1, const void *e2);
 static int cos_cache_string_compare(const void *e1, const void *e2);
 static int cos_cache_template_index_bsearch(const char *dn);
-static int cos_cache_attr_index_bsearch(const cosCache *pCache, const cosAttributes *key, int lower, int upper);
 
 /* the multi purpose list creation function, pass it something and it links it */
 static void cos_cache_add_ll_entry(void **attrval, void *theVal, int (*compare)(const void *elem1, const void *elem2));
@@ -231,8 +300,9 @@ static int cos_cache_add_dn_tmpls(char *dn, cosAttrValue *pCosSpecifier, cosAttr
 static int cos_cache_add_tmpl(cosTemplates **pTemplates, cosAttrValue *dn, cosAttrValue *objclasses, cosAttrValue *pCosSpecifier, cosAttributes *pAttrs, cosAttrValue *cosPriority);
 
 /* cosDefinitions manipulation */
-static int cos_cache_build_definition_list(cosDefinitions **pDefs, int *vattr_cacheable);
-static int cos_cache_add_dn_defs(char *dn, cosDefinitions **pDefs);
+static int cos_cache_build_definition_list(cosDefinitions **pDefs, int *vattr_cacheable, int *skipped);
+static int cos_cache_update_definition_list(cosCache *pOldCache, char **changed_tmpls, cosDefinitions **pDefs, int *skipped);
+static int cos_cache_add_dn_defs(char *dn, cosDefinitions **pDefs, int *skipped);
 static int cos_cache_add_defn(cosDefinitions **pDefs, cosAttrValue **dn, int cosType, cosAttrValue **tree, cosAttrValue **tmpDn, cosAttrValue **spec, cosAttrValue **pAttrs, cosAttrValue **pOverrides, cosAttrValue **pOperational, cosAttrValue **pCosMerge, cosAttrValue **pCosOpDefault);
 static int cos_cache_entry_is_cos_related(Slapi_Entry *e);
 
@@ -417,10 +487,12 @@ cos_cache_wait_on_change(void *arg __attribute__((unused)))
          * before we go running off doing lots of stuff lets check if we should stop
         */
         if (keeprunning) {
+            /* cos_cache_notify_flag is dealt with there */
             cos_cache_creation_lock();
+        } else {
+            cos_cache_notify_flag = 0;
         }
-        cos_cache_notify_flag = 0; /* Dealt with it */
-    }                              /* while */
+    } /* while */
 
     /* shut down the cache */
     slapi_unlock_mutex(change_lock);
@@ -434,6 +506,9 @@ cos_cache_wait_on_change(void *arg __attribute__((unused)))
     cos_cache_create_unlock
     ---------------------
     Walks the definitions in the DIT and creates the cache.
+    If only templates changed (changed_tmpls), the definitions
+    are taken from the current cache instead and only those
+    having changed templates search their templates again.
     Once created, it swaps the new cache for the old one,
     releasing its refcount to the old cache and allowing it
     to be destroyed.
@@ -441,10 +516,11 @@ cos_cache_wait_on_change(void *arg __attribute__((unused)))
         called while change_lock is NOT held
 */
 static int
-cos_cache_create_unlock(void)
+cos_cache_create_unlock(char **changed_tmpls)
 {
     int ret = -1;
     cosCache *pNewCache;
+    cosCache *pCurrentCache = NULL;
     static int firstTime = 1;
     int cache_built = 0;
 
@@ -455,8 +531,29 @@ cos_cache_create_unlock(void)
         pNewCache->pDefs = 0;
         pNewCache->refCount = 1;        /* 1 is for us */
         pNewCache->vattr_cacheable = 0; /* default is not cacheable */
-
-        ret = cos_cache_build_definition_list(&(pNewCache->pDefs), &(pNewCache->vattr_cacheable));
+        pNewCache->defCount = 0;
+        pNewCache->skippedDefs = 0;
+        pNewCache->pAttrGroups = NULL;
+        pNewCache->pScopeIndex = NULL;
+        pNewCache->pScopeAll = NULL;
+
+        if (changed_tmpls) {
+            /* this thread is the only one replacing pCache */
+            slapi_lock_mutex(cache_lock);
+            pCurrentCache = pCache;
+            if (pCurrentCache)
+                pCurrentCache->refCount++;
+            slapi_unlock_mutex(cache_lock);
+        }
+        if (pCurrentCache &&
+            cos_cache_update_definition_list(pCurrentCache, changed_tmpls, &(pNewCache->pDefs), &(pNewCache->skippedDefs)) == 0) {
+            pNewCache->vattr_cacheable = pCurrentCache->vattr_cacheable;
+            ret = pNewCache->pDefs ? 0 : -1;
+        } else {
+            ret = cos_cache_build_definition_list(&(pNewCache->pDefs), &(pNewCache->vattr_cacheable), &(pNewCache->skippedDefs));
+        }
+        if (pCurrentCache)
+            cos_cache_release(pCurrentCache);
         if (!ret) {
             /* OK, we have a cache, lets add indexing for
             that faster than slow feeling */
@@ -572,6 +669,7 @@ cos_cache_creation_lock(void)
 {
     int ret = -1;
     int max_tries = 10;
+    char **changed_tmpls = NULL;
 
     for (; max_tries != 0; max_tries--) {
         /* if the cos_cache is already under work (cos_cache_create_unlock)
@@ -583,14 +681,25 @@ cos_cache_creation_lock(void)
             continue;
         }
         cos_cache_at_work = PR_TRUE;
+        /* take the pending changes, those notified from now on need another rebuild */
+        if (!cos_cache_full_rebuild) {
+            changed_tmpls = cos_cache_changed_tmpls;
+        } else {
+            charray_free(cos_cache_changed_tmpls);
+        }
+        cos_cache_changed_tmpls = NULL;
+        cos_cache_full_rebuild = 0;
+        cos_cache_notify_flag = 0;
         slapi_unlock_mutex(change_lock);
-        ret = cos_cache_create_unlock();
+        ret = cos_cache_create_unlock(changed_tmpls);
+        charray_free(changed_tmpls);
         slapi_lock_mutex(change_lock);
         cos_cache_at_work = PR_FALSE;
         break;
     }
     if (!max_tries) {
         slapi_log_err(SLAPI_LOG_FATAL, COS_PLUGIN_SUBSYSTEM, "--> cos_cache_creation_lock  rebuilt was to long, skip this rebuild\n");
+        cos_cache_full_rebuild = 1;
     }
 
     return ret;
@@ -602,7 +711,7 @@ cos_cache_creation_lock(void)
     builds the list of cos definitions by searching for them throughout the DIT
 */
 static int
-cos_cache_build_definition_list(cosDefinitions **pDefs, int *vattr_cacheable)
+cos_cache_build_definition_list(cosDefinitions **pDefs, int *vattr_cacheable, int *skipped)
 {
     int ret = 0;
     Slapi_PBlock *pSuffixSearch = 0;
@@ -664,7 +773,7 @@ cos_cache_build_definition_list(cosDefinitions **pDefs, int *vattr_cacheable)
                             while (suffixVals[valIndex]) {
                                 /* here's a suffix, lets search it... */
                                 if (suffixVals[valIndex]->bv_val) {
-                                    if (!cos_cache_add_dn_defs(suffixVals[valIndex]->bv_val, pDefs)) {
+                                    if (!cos_cache_add_dn_defs(suffixVals[valIndex]->bv_val, pDefs, skipped)) {
                                         *vattr_cacheable = -1;
                                         cos_def_available = 1;
                                     }
@@ -704,12 +813,183 @@ next:
 }
 
 
+/*
+    cos_cache_dup_attrval_list
+    --------------------------
+    copies a value list, keeping its order
+*/
+static cosAttrValue *
+cos_cache_dup_attrval_list(cosAttrValue *pVal)
+{
+    cosAttrValue *pHead = NULL;
+    cosAttrValue **ppTail = &pHead;
+
+    for (; pVal; pVal = pVal->list.pNext) {
+        cosAttrValue *theVal = (cosAttrValue *)slapi_ch_calloc(1, sizeof(cosAttrValue));
+
+        theVal->val = slapi_ch_strdup(pVal->val);
+        *ppTail = theVal;
+        ppTail = (cosAttrValue **)&theVal->list.pNext;
+    }
+    return pHead;
+}
+
+/*
+    cos_cache_dup_tmpl_list
+    -----------------------
+    copies the templates of a definition, keeping their order.
+    The parent pointers and the attribute flags are set again
+    by cos_cache_index_all, the objectclasses allowing the
+    attributes by cos_cache_schema_build
+*/
+static cosTemplates *
+cos_cache_dup_tmpl_list(cosTemplates *pTmpl)
+{
+    cosTemplates *pHead = NULL;
+    cosTemplates **ppTail = &pHead;
+
+    for (; pTmpl; pTmpl = pTmpl->list.pNext) {
+        cosTemplates *theTemp = (cosTemplates *)slapi_ch_calloc(1, sizeof(cosTemplates));
+        cosAttributes **ppAttrTail = &theTemp->pAttrs;
+        cosAttributes *pAttr;
+
+        theTemp->pDn = cos_cache_dup_attrval_list(pTmpl->pDn);
+        theTemp->pObjectclasses = cos_cache_dup_attrval_list(pTmpl->pObjectclasses);
+        theTemp->cosGrade = slapi_ch_strdup(pTmpl->cosGrade);
+        theTemp->template_default = pTmpl->template_default;
+        theTemp->cosPriority = pTmpl->cosPriority;
+        for (pAttr = pTmpl->pAttrs; pAttr; pAttr = pAttr->list.pNext) {
+            cosAttributes *theAttr = (cosAttributes *)slapi_ch_calloc(1, sizeof(cosAttributes));
+
+            theAttr->pAttrName = slapi_ch_strdup(pAttr->pAttrName);
+            theAttr->pAttrValue = cos_cache_dup_attrval_list(pAttr->pAttrValue);
+            *ppAttrTail = theAttr;
+            ppAttrTail = (cosAttributes **)&theAttr->list.pNext;
+        }
+        *ppTail = theTemp;
+        ppTail = (cosTemplates **)&theTemp->list.pNext;
+    }
+    return pHead;
+}
+
+/*
+    cos_cache_update_definition_list
+    --------------------------------
+    builds the definition list of a new cache after changes of
+    templates only.  The definitions are copied from the current
+    cache but those having a cosTemplateDn above a changed template,
+    which search their templates again.  The DIT is not searched for
+    definitions, nor are the templates of the other definitions.
+
+    returns non-zero if the cache must be built from scratch: a
+    definition was skipped for lack of templates in the current
+    cache (one may have been added since), or a changed template
+    belongs to none of the cached definitions.
+*/
+static int
+cos_cache_update_definition_list(cosCache *pOldCache, char **changed_tmpls, cosDefinitions **pDefs, int *skipped)
+{
+    cosDefinitions *pDef;
+    cosDefinitions **ppTail = pDefs;
+    char *pAffected = NULL;
+    int i;
+
+    slapi_log_err(SLAPI_LOG_TRACE, COS_PLUGIN_SUBSYSTEM, "--> cos_cache_update_definition_list\n");
+
+    if (pOldCache->skippedDefs || pOldCache->defCount == 0) {
+        slapi_log_err(SLAPI_LOG_TRACE, COS_PLUGIN_SUBSYSTEM, "<-- cos_cache_update_definition_list\n");
+        return -1;
+    }
+
+    /* which definitions use the changed templates? */
+    pAffected = (char *)slapi_ch_calloc(pOldCache->defCount, sizeof(char));
+    for (i = 0; changed_tmpls[i]; i++) {
+        int used = 0;
+
+        for (pDef = pOldCache->pDefs; pDef; pDef = pDef->list.pNext) {
+            cosAttrValue *pTmplDn;
+
+            for (pTmplDn = pDef->pCosTemplateDn; pTmplDn; pTmplDn = pTmplDn->list.pNext) {
+                if (pTmplDn->val && slapi_dn_issuffix(changed_tmpls[i], pTmplDn->val)) {
+                    pAffected[pDef->defIndex] = 1;
+                    used = 1;
+                }
+            }
+        }
+        if (!used) {
+            slapi_log_err(SLAPI_LOG_PLUGIN, COS_PLUGIN_SUBSYSTEM, "cos_cache_update_definition_list - "
+                                                                  "Template %s is not used by the cached definitions, rebuilding the cache\n",
+                          changed_tmpls[i]);
+            slapi_ch_free((void **)&pAffected);
+            slapi_log_err(SLAPI_LOG_TRACE, COS_PLUGIN_SUBSYSTEM, "<-- cos_cache_update_definition_list\n");
+            return -1;
+        }
+    }
+
+    for (pDef = pOldCache->pDefs; pDef; pDef = pDef->list.pNext) {
+        cosDefinitions *theDef = (cosDefinitions *)slapi_ch_calloc(1, sizeof(cosDefinitions));
+
+        theDef->cosType = pDef->cosType;
+        theDef->pDn = cos_cache_dup_attrval_list(pDef->pDn);
+        theDef->pCosTargetTree = cos_cache_dup_attrval_list(pDef->pCosTargetTree);
+        theDef->pCosTemplateDn = cos_cache_dup_attrval_list(pDef->pCosTemplateDn);
+        theDef->pCosSpecifier = cos_cache_dup_attrval_list(pDef->pCosSpecifier);
+        theDef->pCosAttrs = cos_cache_dup_attrval_list(pDef->pCosAttrs);
+        theDef->pCosOverrides = cos_cache_dup_attrval_list(pDef->pCosOverrides);
+        theDef->pCosOperational = cos_cache_dup_attrval_list(pDef->pCosOperational);
+        theDef->pCosOpDefault = cos_cache_dup_attrval_list(pDef->pCosOpDefault);
+        theDef->pCosMerge = cos_cache_dup_attrval_list(pDef->pCosMerge);
+
+        if (pAffected[pDef->defIndex]) {
+            cosAttrValue *pTmplDn;
+            int tmplCount = 0;
+
+            slapi_log_err(SLAPI_LOG_PLUGIN, COS_PLUGIN_SUBSYSTEM, "cos_cache_update_definition_list - "
+                                                                  "Updating the templates of cosDefinition %s\n",
+                          theDef->pDn->val);
+            for (pTmplDn = theDef->pCosTemplateDn; pTmplDn; pTmplDn = pTmplDn->list.pNext) {
+                if (!cos_cache_add_dn_tmpls(pTmplDn->val, theDef->pCosSpecifier, theDef->pCosAttrs, &(theDef->pCosTmps)))
+                    tmplCount++;
+            }
+            if (tmplCount == 0) {
+                slapi_log_err(SLAPI_LOG_ERR, COS_PLUGIN_SUBSYSTEM, "cos_cache_update_definition_list - Skipping CoS Definition %s"
+                                                                   "--no CoS Templates found, which should be added before the CoS Definition.\n",
+                              theDef->pDn->val);
+                (*skipped)++;
+                /* release it as cos_cache_release would */
+                cos_cache_del_attrval_list(&(theDef->pDn));
+                cos_cache_del_attrval_list(&(theDef->pCosTargetTree));
+                cos_cache_del_attrval_list(&(theDef->pCosTemplateDn));
+                cos_cache_del_attrval_list(&(theDef->pCosSpecifier));
+                cos_cache_del_attrval_list(&(theDef->pCosAttrs));
+                cos_cache_del_attrval_list(&(theDef->pCosOverrides));
+                cos_cache_del_attrval_list(&(theDef->pCosOperational));
+                cos_cache_del_attrval_list(&(theDef->pCosMerge));
+                cos_cache_del_attrval_list(&(theDef->pCosOpDefault));
+                slapi_ch_free((void **)&theDef);
+                continue;
+            }
+        } else {
+            theDef->pCosTmps = cos_cache_dup_tmpl_list(pDef->pCosTmps);
+        }
+
+        *ppTail = theDef;
+        ppTail = (cosDefinitions **)&theDef->list.pNext;
+    }
+    slapi_ch_free((void **)&pAffected);
+
+    slapi_log_err(SLAPI_LOG_TRACE, COS_PLUGIN_SUBSYSTEM, "<-- cos_cache_update_definition_list\n");
+    return 0;
+}
+
+
 /* struct to support search callback API */
 struct dn_defs_info
 {
     cosDefinitions **pDefs;
     int vattr_cacheable;
     int ret;
+    int *skipped;
 };
 
 /*
@@ -974,6 +1254,8 @@ cos_dn_defs_cb(Slapi_Entry *e, void *callback_data)
              * Don't reset info->ret....it keeps track of any success
             */
             if (rc == COS_DEF_ERROR_NO_TEMPLATES) {
+                /* adding one of its templates will need a full rebuild of the cache */
+                (*info->skipped)++;
                 slapi_log_err(SLAPI_LOG_ERR, COS_PLUGIN_SUBSYSTEM, "cos_dn_defs_cb - Skipping CoS Definition %s"
                                                                    "--no CoS Templates found, which should be added before the CoS Definition.\n",
                               pTmpDn);
@@ -1038,14 +1320,15 @@ bail:
 #define DN_DEF_FILTER "(&(|(objectclass=cosSuperDefinition)(objectclass=cosDefinition))(objectclass=ldapsubentry))"
 
 static int
-cos_cache_add_dn_defs(char *dn, cosDefinitions **pDefs)
+cos_cache_add_dn_defs(char *dn, cosDefinitions **pDefs, int *skipped)
 {
     Slapi_PBlock *pDnSearch = 0;
-    struct dn_defs_info info = {NULL, 0, 0};
+    struct dn_defs_info info = {NULL, 0, 0, NULL};
     pDnSearch = slapi_pblock_new();
     if (pDnSearch) {
         info.ret = -1; /* assume no good defs */
         info.pDefs = pDefs;
+        info.skipped = skipped;
         slapi_search_internal_set_pb(pDnSearch, dn, LDAP_SCOPE_SUBTREE,
                                      DN_DEF_FILTER, NULL, 0,
                                      NULL, NULL, cos_get_plugin_identity(), 0);
@@ -1351,6 +1634,8 @@ cos_cache_add_defn(
         theDef = (cosDefinitions *)slapi_ch_malloc(sizeof(cosDefinitions));
         if (theDef) {
             theDef->pCosTmps = NULL;
+            theDef->defIndex = 0;
+            theDef->pGradeIndex = NULL;
 
             /* process each template in turn */
 
@@ -1679,8 +1964,6 @@ cos_cache_release(cos_cache *ptheCache)
     slapi_unlock_mutex(cache_lock);
 
     if (destroy && (pOldCache != NULL)) {
-        cosDefinitions *pDef = pOldCache->pDefs;
-
         /* now is the first time it is
          * safe to assess whether
          * vattr caching can be turned on
@@ -1696,50 +1979,64 @@ cos_cache_release(cos_cache *ptheCache)
 #pragma GCC diagnostic pop
 
         /* destroy the cache here - no locking required, no references outstanding */
+        cos_cache_destroy(pOldCache);
+    }
 
-        if (pDef)
-            cos_cache_del_schema(pOldCache);
+    slapi_log_err(SLAPI_LOG_TRACE, COS_PLUGIN_SUBSYSTEM, "<-- cos_cache_release\n");
 
-        while (pDef) {
-            cosDefinitions *pTmpD = pDef;
-            cosTemplates *pCosTmps = pDef->pCosTmps;
+    return ret;
+}
 
-            while (pCosTmps) {
-                cosTemplates *pTmpT = pCosTmps;
+/*
+    cos_cache_destroy
+    -----------------
+    frees a cache nobody references anymore
+*/
+static void
+cos_cache_destroy(cosCache *pOldCache)
+{
+    cosDefinitions *pDef = pOldCache->pDefs;
 
-                pCosTmps = pCosTmps->list.pNext;
+    if (pDef)
+        cos_cache_del_schema(pOldCache);
 
-                cos_cache_del_attr_list(&(pTmpT->pAttrs));
-                cos_cache_del_attrval_list(&(pTmpT->pObjectclasses));
-                cos_cache_del_attrval_list(&(pTmpT->pDn));
-                slapi_ch_free((void **)&(pTmpT->cosGrade));
-                slapi_ch_free((void **)&pTmpT);
-            }
+    cos_cache_compile_free(pOldCache);
+
+    while (pDef) {
+        cosDefinitions *pTmpD = pDef;
+        cosTemplates *pCosTmps = pDef->pCosTmps;
+
+        while (pCosTmps) {
+            cosTemplates *pTmpT = pCosTmps;
 
-            pDef = pDef->list.pNext;
+            pCosTmps = pCosTmps->list.pNext;
 
-            cos_cache_del_attrval_list(&(pTmpD->pDn));
-            cos_cache_del_attrval_list(&(pTmpD->pCosTargetTree));
-            cos_cache_del_attrval_list(&(pTmpD->pCosTemplateDn));
-            cos_cache_del_attrval_list(&(pTmpD->pCosSpecifier));
-            cos_cache_del_attrval_list(&(pTmpD->pCosAttrs));
-            cos_cache_del_attrval_list(&(pTmpD->pCosOverrides));
-            cos_cache_del_attrval_list(&(pTmpD->pCosOperational));
-            cos_cache_del_attrval_list(&(pTmpD->pCosMerge));
-            cos_cache_del_attrval_list(&(pTmpD->pCosOpDefault));
-            slapi_ch_free((void **)&pTmpD);
+            cos_cache_del_attr_list(&(pTmpT->pAttrs));
+            cos_cache_del_attrval_list(&(pTmpT->pObjectclasses));
+            cos_cache_del_attrval_list(&(pTmpT->pDn));
+            slapi_ch_free((void **)&(pTmpT->cosGrade));
+            slapi_ch_free((void **)&pTmpT);
         }
 
-        if (pOldCache->ppAttrIndex)
-            slapi_ch_free((void **)&(pOldCache->ppAttrIndex));
-        if (pOldCache->ppTemplateList)
-            slapi_ch_free((void **)&(pOldCache->ppTemplateList));
-        slapi_ch_free((void **)&pOldCache);
-    }
+        pDef = pDef->list.pNext;
 
-    slapi_log_err(SLAPI_LOG_TRACE, COS_PLUGIN_SUBSYSTEM, "<-- cos_cache_release\n");
+        cos_cache_del_attrval_list(&(pTmpD->pDn));
+        cos_cache_del_attrval_list(&(pTmpD->pCosTargetTree));
+        cos_cache_del_attrval_list(&(pTmpD->pCosTemplateDn));
+        cos_cache_del_attrval_list(&(pTmpD->pCosSpecifier));
+        cos_cache_del_attrval_list(&(pTmpD->pCosAttrs));
+        cos_cache_del_attrval_list(&(pTmpD->pCosOverrides));
+        cos_cache_del_attrval_list(&(pTmpD->pCosOperational));
+        cos_cache_del_attrval_list(&(pTmpD->pCosMerge));
+        cos_cache_del_attrval_list(&(pTmpD->pCosOpDefault));
+        slapi_ch_free((void **)&pTmpD);
+    }
 
-    return ret;
+    if (pOldCache->ppAttrIndex)
+        slapi_ch_free((void **)&(pOldCache->ppAttrIndex));
+    if (pOldCache->ppTemplateList)
+        slapi_ch_free((void **)&(pOldCache->ppTemplateList));
+    slapi_ch_free((void **)&pOldCache);
 }
 
 
@@ -1965,6 +2262,7 @@ cos_cache_add_tmpl(cosTemplates **pTemplates, cosAttrValue *dn, cosAttrValue *ob
         theTemp->cosGrade = slapi_ch_strdup(grade);
         theTemp->template_default = template_default;
         theTemp->cosPriority = (unsigned long)-1;
+        theTemp->pNextGrade = NULL;
 
         if (cosPriority) {
             theTemp->cosPriority = atol(cosPriority->val);
@@ -2184,6 +2482,9 @@ cos_cache_query_attr(cos_cache *ptheCache, vattr_context *context, Slapi_Entry *
     int using_default = 0;
     int entry_has_value = 0;
     int merge_mode = 0;
+    cosAttrGroup *pGroup = NULL;
+    cosCandidates candidates = {0};
+    int cand = 0;
 
     slapi_log_err(SLAPI_LOG_TRACE, COS_PLUGIN_SUBSYSTEM, "--> cos_cache_query_attr\n");
 
@@ -2228,11 +2529,12 @@ cos_cache_query_attr(cos_cache *ptheCache, vattr_context *context, Slapi_Entry *
         lets be sure we need to do something
         most of the time we probably don't
     */
-    attr_index = cos_cache_find_attr(pCache, type);
-    if (attr_index == -1) {
+    pGroup = (cosAttrGroup *)PL_HashTableLookupConst(pCache->pAttrGroups, type);
+    if (pGroup == NULL) {
         /* we don't know about this attribute */
         goto bail;
     }
+    attr_index = pGroup->first;
 
     /*
         if there is a value in the entry the outcome
@@ -2270,32 +2572,38 @@ cos_cache_query_attr(cos_cache *ptheCache, vattr_context *context, Slapi_Entry *
     }
 
     /** class of service specifier **/
+    /*
+        Only the attributes of the templates that may apply to this
+        entry are worth looking at, see cos_cache_find_candidates()
+    */
+    cos_cache_find_candidates(pCache, pGroup, context, e, pDn, type, &candidates);
+
     /*
         Now we need to iterate through the attributes to discover
         if one fits all the criteria, we'll take the first that does
         and blow off the rest unless the definition has merge-scheme
         set.
     */
-    do {
+    for (cand = 0; cand < candidates.count && (hit == 0 || merge_mode); cand++) {
         /* for convenience, define some pointers */
-        cosAttributes *pAttr = pCache->ppAttrIndex[attr_index];
+        cosAttributes *pAttr = pCache->ppAttrIndex[candidates.index[cand]];
         cosTemplates *pTemplate = (cosTemplates *)pAttr->pParent;
         cosDefinitions *pDef = (cosDefinitions *)pTemplate->pParent;
         cosAttrValue *pTargetTree = pDef->pCosTargetTree;
 
+        attr_index = candidates.index[cand];
+
         /* now for the tests */
 
         /* would we be allowed to supply this attribute if we had one? */
         if (entry_has_value && !pAttr->attr_override && !pAttr->attr_operational) {
             /* answer: no, move on to the next attribute */
-            attr_index++;
             continue;
         }
 
         /* if we are in merge_mode, can the attribute be merged? */
         if (merge_mode && pAttr->attr_cos_merge == 0) {
             /* answer: no, move on to the next attribute */
-            attr_index++;
             continue;
         }
 
@@ -2307,21 +2615,14 @@ cos_cache_query_attr(cos_cache *ptheCache, vattr_context *context, Slapi_Entry *
                 (views_api && views_entry_exists(views_api, pTargetTree->val, e)) /* might be in a view */
                 ) {
                 cosAttrValue *pSpec = pDef->pCosSpecifier;
+                /* fetched by cos_cache_find_candidates() already for classic definitions */
+                cosSpecValues *pSpecVals = cos_cache_get_specifiers(pCache, &candidates, pDef, context, e);
                 Slapi_ValueSet *pAttrSpecs = 0;
 
 
                 /* Does this entry have a correct cosSpecifier? */
                 do {
-                    int type_name_disposition = 0;
-                    char *actual_type_name = 0;
-                    int free_flags = 0;
-
-                    if (pSpec && pSpec->val) {
-                        ret = slapi_vattr_values_get_sp(context, e, pSpec->val, &pAttrSpecs, &type_name_disposition, &actual_type_name, 0, &free_flags);
-                        /* MAB: We need to free actual_type_name here !!!
-                        XXX BAD--should use slapi_vattr_values_free() */
-                        slapi_ch_free((void **)&actual_type_name);
-                    }
+                    pAttrSpecs = pSpecVals ? pSpecVals->pVals : NULL;
 
                     if (pAttrSpecs || pDef->cosType == COSTYPE_POINTER) {
                         int index = 0;
@@ -2445,13 +2746,11 @@ cos_cache_query_attr(cos_cache *ptheCache, vattr_context *context, Slapi_Entry *
 
                     if (pSpec)
                         pSpec = pSpec->list.pNext;
+                    if (pSpecVals)
+                        pSpecVals = pSpecVals->pNext;
 
                 } while (hit == 0 && pSpec);
 
-                /* MAB: We need to free pAttrSpecs here !!!
-                XXX BAD--should use slapi_vattr_values_free()*/
-                slapi_valueset_free(pAttrSpecs);
-
                 /* is the cosTemplate the default template? */
                 if (hit == 0 && pTemplate->template_default && !pDefAttr) {
                     /* then lets save the attr in case we need it later */
@@ -2462,15 +2761,7 @@ cos_cache_query_attr(cos_cache *ptheCache, vattr_context *context, Slapi_Entry *
             pTargetTree = pTargetTree->list.pNext;
 
         } /* while(hit == 0 && pTargetTree) */
-
-
-        if (hit == 0 || merge_mode)
-            attr_index++;
-
-    } while (
-        (hit == 0 || merge_mode) &&
-        pCache->attrCount > attr_index &&
-        !slapi_utf8casecmp((unsigned char *)type, (unsigned char *)pCache->ppAttrIndex[attr_index]->pAttrName));
+    }
 
     if (!merge_mode)
         attr_matched_index = attr_index;
@@ -2524,6 +2815,7 @@ cos_cache_query_attr(cos_cache *ptheCache, vattr_context *context, Slapi_Entry *
     }
 
 bail:
+    cos_cache_candidates_done(&candidates);
 
     slapi_log_err(SLAPI_LOG_TRACE, COS_PLUGIN_SUBSYSTEM, "<-- cos_cache_query_attr\n");
     return ret;
@@ -2540,20 +2832,13 @@ static int
 cos_cache_find_attr(cosCache *pCache, char *type)
 {
     int ret = -1; /* assume failure */
-    cosAttributes attr;
+    cosAttrGroup *pGroup;
 
     slapi_log_err(SLAPI_LOG_TRACE, COS_PLUGIN_SUBSYSTEM, "--> cos_cache_find_attr\n");
 
-    attr.pAttrName = type;
-
-    if (pCache->attrCount - 1 != 0)
-        ret = cos_cache_attr_index_bsearch(pCache, &attr, 0, pCache->attrCount - 1);
-    else {
-        /* only one attribute (that will fool our bsearch) lets check it here */
-        if (!slapi_utf8casecmp((unsigned char *)type, (unsigned char *)(pCache->ppAttrIndex)[0]->pAttrName)) {
-            ret = 0;
-        }
-    }
+    pGroup = (cosAttrGroup *)PL_HashTableLookupConst(pCache->pAttrGroups, type);
+    if (pGroup)
+        ret = pGroup->first;
 
     slapi_log_err(SLAPI_LOG_TRACE, COS_PLUGIN_SUBSYSTEM, "<-- cos_cache_find_attr\n");
     return ret;
@@ -2849,9 +3134,9 @@ cos_cache_index_all(cosCache *pCache)
 
             pCache->templateCount = actualCount;
 
-            slapi_log_err(SLAPI_LOG_PLUGIN, COS_PLUGIN_SUBSYSTEM, "cos_cache_index_all - cos cache index built\n");
-
-            ret = 0;
+            ret = cos_cache_compile(pCache);
+            if (ret == 0)
+                slapi_log_err(SLAPI_LOG_PLUGIN, COS_PLUGIN_SUBSYSTEM, "cos_cache_index_all - cos cache index built\n");
         } else {
             if (pCache->ppAttrIndex)
                 slapi_ch_free((void **)(&pCache->ppAttrIndex));
@@ -2870,6 +3155,505 @@ cos_cache_index_all(cosCache *pCache)
 }
 
 
+/* attribute types are ascii, hash them ignoring case */
+static PLHashNumber
+cos_cache_hash_nocase(const void *key)
+{
+    PLHashNumber h = 0;
+    const unsigned char *p;
+
+    for (p = (const unsigned char *)key; *p; p++) {
+        h = (h >> 28) ^ (h << 4) ^ tolower(*p);
+    }
+    return h;
+}
+
+static PRIntn
+cos_cache_compare_nocase(const void *v1, const void *v2)
+{
+    return slapi_utf8casecmp((unsigned char *)v1, (unsigned char *)v2) == 0;
+}
+
+/* returns an allocated lower cased copy of a dn or a grade */
+static char *
+cos_cache_lower(const char *s)
+{
+    char *lower = NULL;
+
+    if (s == NULL || *s == '\0') {
+        return slapi_ch_strdup("");
+    }
+    lower = (char *)slapi_utf8StrToLower((unsigned char *)s);
+    return lower ? lower : slapi_ch_strdup(s);
+}
+
+/*
+    adds a value to a lookup table of lists, "key" is lower cased and
+    "value" is chained (through pNext) to the values already there
+*/
+static void *
+cos_cache_lookup_add(PLHashTable *table, char *key, void *value)
+{
+    void *head = PL_HashTableLookup(table, key);
+
+    PL_HashTableAdd(table, key, value);
+    if (head) {
+        /* the table keeps its own copy of the key */
+        slapi_ch_free_string(&key);
+    }
+    return head;
+}
+
+static PRIntn
+cos_cache_free_grade_entry(PLHashEntry *he, PRIntn i __attribute__((unused)), void *arg __attribute__((unused)))
+{
+    slapi_ch_free((void **)&he->key);
+    return HT_ENUMERATE_REMOVE;
+}
+
+static PRIntn
+cos_cache_free_scope_entry(PLHashEntry *he, PRIntn i __attribute__((unused)), void *arg __attribute__((unused)))
+{
+    cosScope *pScope = (cosScope *)he->value;
+
+    while (pScope) {
+        cosScope *pNext = pScope->pNext;
+        slapi_ch_free((void **)&pScope);
+        pScope = pNext;
+    }
+    slapi_ch_free((void **)&he->key);
+    return HT_ENUMERATE_REMOVE;
+}
+
+static PRIntn
+cos_cache_free_group_entry(PLHashEntry *he, PRIntn i __attribute__((unused)), void *arg __attribute__((unused)))
+{
+    cosAttrGroup *pGroup = (cosAttrGroup *)he->value;
+
+    /* the key is the name of an attribute of the index */
+    slapi_ch_free((void **)&pGroup->ppDefs);
+    slapi_ch_free((void **)&pGroup);
+    return HT_ENUMERATE_REMOVE;
+}
+
+/*
+    cos_cache_compile
+    -----------------
+    builds the lookup structures cos_cache_query_attr() uses instead
+    of walking all the templates supplying an attribute:
+    - the attribute groups: for each attribute type, its range in the
+      (sorted) attribute index and the definitions supplying it
+    - the scope index: the definitions by target tree.  The entries in
+      scope of a definition are those whose dn or one of its ancestors
+      is a target tree of the definition, so looking up the dn and each
+      of its ancestors gives all the definitions applying to an entry
+    - the grade index of the classic definitions: their templates by
+      grade, to get the templates matching the cosSpecifier values of
+      an entry without comparing the values with every grade
+
+    called by cos_cache_index_all once the attribute index is sorted
+*/
+static int
+cos_cache_compile(cosCache *pCache)
+{
+    cosDefinitions *pDef;
+    char *pSeen = NULL;
+    int attr_index = 0;
+
+    slapi_log_err(SLAPI_LOG_TRACE, COS_PLUGIN_SUBSYSTEM, "--> cos_cache_compile\n");
+
+    pCache->pAttrGroups = PL_NewHashTable(64, cos_cache_hash_nocase, cos_cache_compare_nocase,
+                                          PL_CompareValues, NULL, NULL);
+    pCache->pScopeIndex = PL_NewHashTable(64, PL_HashString, PL_CompareStrings,
+                                          PL_CompareValues, NULL, NULL);
+    if (pCache->pAttrGroups == NULL || pCache->pScopeIndex == NULL) {
+        slapi_log_err(SLAPI_LOG_ERR, COS_PLUGIN_SUBSYSTEM, "cos_cache_compile - Failed to allocate memory\n");
+        return -1;
+    }
+
+    pCache->defCount = 0;
+    for (pDef = pCache->pDefs; pDef; pDef = pDef->list.pNext) {
+        cosAttrValue *pTree;
+        cosTemplates *pTmpl;
+
+        pDef->defIndex = pCache->defCount++;
+
+        for (pTree = pDef->pCosTargetTree; pTree; pTree = pTree->list.pNext) {
+            cosScope *pScope = (cosScope *)slapi_ch_malloc(sizeof(cosScope));
+
+            pScope->pDef = pDef;
+            if (pTree->val == NULL || *pTree->val == '\0') {
+                /* the whole DIT, as slapi_dn_issuffix() does for "" */
+                pScope->pNext = pCache->pScopeAll;
+                pCache->pScopeAll = pScope;
+            } else {
+                pScope->pNext = cos_cache_lookup_add(pCache->pScopeIndex, cos_cache_lower(pTree->val), pScope);
+            }
+        }
+
+        if (pDef->cosType == COSTYPE_CLASSIC) {
+            pDef->pGradeIndex = PL_NewHashTable(16, PL_HashString, PL_CompareStrings,
+                                                PL_CompareValues, NULL, NULL);
+            if (pDef->pGradeIndex == NULL) {
+                slapi_log_err(SLAPI_LOG_ERR, COS_PLUGIN_SUBSYSTEM, "cos_cache_compile - Failed to allocate memory\n");
+                return -1;
+            }
+            for (pTmpl = pDef->pCosTmps; pTmpl; pTmpl = pTmpl->list.pNext) {
+                pTmpl->pNextGrade = cos_cache_lookup_add(pDef->pGradeIndex, cos_cache_lower(pTmpl->cosGrade), pTmpl);
+            }
+        }
+    }
+
+    if (pCache->defCount) {
+        pSeen = (char *)slapi_ch_calloc(pCache->defCount, sizeof(char));
+    }
+    while (attr_index < pCache->attrCount) {
+        cosAttrGroup *pGroup = (cosAttrGroup *)slapi_ch_calloc(1, sizeof(cosAttrGroup));
+        char *pAttrName = pCache->ppAttrIndex[attr_index]->pAttrName;
+        int i;
+
+        pGroup->first = attr_index;
+        while (attr_index < pCache->attrCount &&
+               !slapi_utf8casecmp((unsigned char *)pAttrName, (unsigned char *)pCache->ppAttrIndex[attr_index]->pAttrName)) {
+            pCache->ppAttrIndex[attr_index]->attr_index = attr_index;
+            attr_index++;
+        }
+        pGroup->count = attr_index - pGroup->first;
+
+        pGroup->ppDefs = (cosDefinitions **)slapi_ch_calloc(pGroup->count, sizeof(cosDefinitions *));
+        for (i = pGroup->first; i < attr_index; i++) {
+            pDef = (cosDefinitions *)((cosTemplates *)pCache->ppAttrIndex[i]->pParent)->pParent;
+            if (!pSeen[pDef->defIndex]) {
+                pSeen[pDef->defIndex] = 1;
+                pGroup->ppDefs[pGroup->defCount++] = pDef;
+            }
+        }
+        for (i = 0; i < pGroup->defCount; i++) {
+            pSeen[pGroup->ppDefs[i]->defIndex] = 0;
+        }
+
+        PL_HashTableAdd(pCache->pAttrGroups, pAttrName, pGroup);
+    }
+    slapi_ch_free((void **)&pSeen);
+
+    slapi_log_err(SLAPI_LOG_TRACE, COS_PLUGIN_SUBSYSTEM, "<-- cos_cache_compile\n");
+    return 0;
+}
+
+/*
+    cos_cache_compile_free
+    ----------------------
+    frees what cos_cache_compile built
+*/
+static void
+cos_cache_compile_free(cosCache *pCache)
+{
+    cosDefinitions *pDef;
+
+    for (pDef = pCache->pDefs; pDef; pDef = pDef->list.pNext) {
+        if (pDef->pGradeIndex) {
+            PL_HashTableEnumerateEntries(pDef->pGradeIndex, cos_cache_free_grade_entry, NULL);
+            PL_HashTableDestroy(pDef->pGradeIndex);
+            pDef->pGradeIndex = NULL;
+        }
+    }
+    if (pCache->pAttrGroups) {
+        PL_HashTableEnumerateEntries(pCache->pAttrGroups, cos_cache_free_group_entry, NULL);
+        PL_HashTableDestroy(pCache->pAttrGroups);
+        pCache->pAttrGroups = NULL;
+    }
+    if (pCache->pScopeIndex) {
+        PL_HashTableEnumerateEntries(pCache->pScopeIndex, cos_cache_free_scope_entry, NULL);
+        PL_HashTableDestroy(pCache->pScopeIndex);
+        pCache->pScopeIndex = NULL;
+    }
+    while (pCache->pScopeAll) {
+        cosScope *pNext = pCache->pScopeAll->pNext;
+        slapi_ch_free((void **)&pCache->pScopeAll);
+        pCache->pScopeAll = pNext;
+    }
+}
+
+static void
+cos_cache_candidates_add(cosCandidates *pCand, int attr_index)
+{
+    if (pCand->index == NULL) {
+        pCand->index = pCand->prealloc;
+        pCand->size = COS_CANDIDATES_PREALLOC;
+    } else if (pCand->count == pCand->size) {
+        int *index = (int *)slapi_ch_malloc(pCand->size * 2 * sizeof(int));
+
+        memcpy(index, pCand->index, pCand->count * sizeof(int));
+        if (pCand->index != pCand->prealloc) {
+            slapi_ch_free((void **)&pCand->index);
+        }
+        pCand->index = index;
+        pCand->size *= 2;
+    }
+    pCand->index[pCand->count++] = attr_index;
+}
+
+/* adds the attribute "type" of a template */
+static void
+cos_cache_candidates_add_tmpl(cosCandidates *pCand, cosTemplates *pTmpl, char *type)
+{
+    cosAttributes *pAttr;
+
+    for (pAttr = pTmpl->pAttrs; pAttr; pAttr = pAttr->list.pNext) {
+        if (!slapi_utf8casecmp((unsigned char *)type, (unsigned char *)pAttr->pAttrName)) {
+            cos_cache_candidates_add(pCand, pAttr->attr_index);
+        }
+    }
+}
+
+/* adds the templates of a classic definition with the given grade */
+static void
+cos_cache_candidates_add_grade(cosCandidates *pCand, cosDefinitions *pDef, const char *grade, char *type)
+{
+    char *key = cos_cache_lower(grade);
+    cosTemplates *pTmpl;
+
+    for (pTmpl = (cosTemplates *)PL_HashTableLookupConst(pDef->pGradeIndex, key); pTmpl; pTmpl = pTmpl->pNextGrade) {
+        cos_cache_candidates_add_tmpl(pCand, pTmpl, type);
+    }
+    slapi_ch_free_string(&key);
+}
+
+static int
+cos_cache_candidates_compare(const void *e1, const void *e2)
+{
+    return *(const int *)e1 - *(const int *)e2;
+}
+
+/*
+    cos_cache_get_specifiers
+    ------------------------
+    returns the values of the cosSpecifiers of a definition in the
+    entry queried, in cosSpecifier order.  They are fetched the first
+    time only, the candidates own them until cos_cache_candidates_done().
+*/
+static cosSpecValues *
+cos_cache_get_specifiers(cosCache *pCache, cosCandidates *pCand, cosDefinitions *pDef, vattr_context *context, Slapi_Entry *e)
+{
+    cosSpecValues **ppLast;
+    cosAttrValue *pSpec;
+
+    if (pDef->pCosSpecifier == NULL) {
+        /* pointer definitions */
+        return NULL;
+    }
+    if (pCand->ppSpecs == NULL) {
+        pCand->ppSpecs = (cosSpecValues **)slapi_ch_calloc(pCache->defCount, sizeof(cosSpecValues *));
+        pCand->specCount = pCache->defCount;
+    }
+    if (pCand->ppSpecs[pDef->defIndex]) {
+        return pCand->ppSpecs[pDef->defIndex];
+    }
+
+    ppLast = &pCand->ppSpecs[pDef->defIndex];
+    for (pSpec = pDef->pCosSpecifier; pSpec; pSpec = pSpec->list.pNext) {
+        cosSpecValues *pSpecVals = (cosSpecValues *)slapi_ch_calloc(1, sizeof(cosSpecValues));
+        int type_name_disposition = 0;
+
+        if (pSpec->val &&
+            slapi_vattr_values_get_sp(context, e, pSpec->val, &pSpecVals->pVals, &type_name_disposition,
+                                      &pSpecVals->actual_type_name, 0, &pSpecVals->free_flags) != 0) {
+            slapi_vattr_values_free(&pSpecVals->pVals, &pSpecVals->actual_type_name, pSpecVals->free_flags);
+        }
+        *ppLast = pSpecVals;
+        ppLast = &pSpecVals->pNext;
+    }
+    return pCand->ppSpecs[pDef->defIndex];
+}
+
+static void
+cos_cache_candidates_done(cosCandidates *pCand)
+{
+    int i;
+
+    if (pCand->index != pCand->prealloc) {
+        slapi_ch_free((void **)&pCand->index);
+    }
+    pCand->index = NULL;
+    pCand->count = 0;
+
+    for (i = 0; i < pCand->specCount; i++) {
+        while (pCand->ppSpecs[i]) {
+            cosSpecValues *pSpecVals = pCand->ppSpecs[i];
+
+            pCand->ppSpecs[i] = pSpecVals->pNext;
+            slapi_vattr_values_free(&pSpecVals->pVals, &pSpecVals->actual_type_name, pSpecVals->free_flags);
+            slapi_ch_free((void **)&pSpecVals);
+        }
+    }
+    slapi_ch_free((void **)&pCand->ppSpecs);
+    pCand->specCount = 0;
+}
+
+/*
+    cos_cache_find_candidates
+    -------------------------
+    collects, in attribute index order, the entries of an attribute
+    group that may apply to an entry: the attributes of the definitions
+    having the entry in their scope and, for classic definitions, only
+    those of the templates whose grade is a cosSpecifier value of the
+    entry or of the default templates.  None of the other attributes of
+    the group could be a hit or a default in cos_cache_query_attr().
+*/
+static void
+cos_cache_find_candidates(cosCache *pCache, cosAttrGroup *pGroup, vattr_context *context, Slapi_Entry *e, const char *pDn, char *type, cosCandidates *pCand)
+{
+    char inscope_buf[256];
+    char *inscope = inscope_buf;
+    char *pLowerDn = cos_cache_lower(pDn);
+    const char *pSuffix;
+    cosScope *pScope;
+    int i, j;
+
+    if (pCache->defCount > (int)sizeof(inscope_buf)) {
+        inscope = (char *)slapi_ch_calloc(pCache->defCount, sizeof(char));
+    } else {
+        memset(inscope, 0, sizeof(inscope_buf));
+    }
+
+    /* the definitions in scope: the dn and every tail of it slapi_dn_issuffix() would accept */
+    for (pScope = pCache->pScopeAll; pScope; pScope = pScope->pNext) {
+        inscope[pScope->pDef->defIndex] = 1;
+    }
+    for (pSuffix = pLowerDn; pSuffix; pSuffix = strpbrk(pSuffix, ",;")) {
+        if (*pSuffix == ',' || *pSuffix == ';') {
+            pSuffix++;
+        }
+        for (pScope = (cosScope *)PL_HashTableLookupConst(pCache->pScopeIndex, pSuffix); pScope; pScope = pScope->pNext) {
+            inscope[pScope->pDef->defIndex] = 1;
+        }
+    }
+    slapi_ch_free_string(&pLowerDn);
+
+    for (i = 0; i < pGroup->defCount; i++) {
+        cosDefinitions *pDef = pGroup->ppDefs[i];
+        cosTemplates *pTmpl;
+
+        if (!inscope[pDef->defIndex] && views_api) {
+            /* might be in a view */
+            cosAttrValue *pTree;
+
+            for (pTree = pDef->pCosTargetTree; pTree && !inscope[pDef->defIndex]; pTree = pTree->list.pNext) {
+                if (pTree->val && views_entry_exists(views_api, pTree->val, e)) {
+                    inscope[pDef->defIndex] = 1;
+                }
+            }
+        }
+        if (!inscope[pDef->defIndex]) {
+            continue;
+        }
+
+        if (pDef->cosType == COSTYPE_CLASSIC && pDef->pGradeIndex) {
+            cosSpecValues *pSpecVals;
+
+            for (pSpecVals = cos_cache_get_specifiers(pCache, pCand, pDef, context, e); pSpecVals; pSpecVals = pSpecVals->pNext) {
+                Slapi_Value *val = NULL;
+                int index;
+
+                if (pSpecVals->pVals == NULL) {
+                    continue;
+                }
+                for (index = slapi_valueset_first_value(pSpecVals->pVals, &val); val;
+                     index = slapi_valueset_next_value(pSpecVals->pVals, index, &val)) {
+                    cos_cache_candidates_add_grade(pCand, pDef, slapi_value_get_string(val), type);
+                }
+            }
+            /* the default templates are graded <first cosSpecifier>-default */
+            if (pDef->pCosSpecifier && pDef->pCosSpecifier->val) {
+                char *grade = slapi_ch_smprintf("%s-default", pDef->pCosSpecifier->val);
+                cos_cache_candidates_add_grade(pCand, pDef, grade, type);
+                slapi_ch_free_string(&grade);
+            }
+        } else {
+            /* a template per cosTemplateDn for pointer definitions, a dummy one for indirect ones */
+            for (pTmpl = pDef->pCosTmps; pTmpl; pTmpl = pTmpl->list.pNext) {
+                cos_cache_candidates_add_tmpl(pCand, pTmpl, type);
+            }
+        }
+    }
+    if (inscope != inscope_buf) {
+        slapi_ch_free((void **)&inscope);
+    }
+
+    /* sort in attribute index order and remove the duplicates */
+    if (pCand->count > 1) {
+        qsort(pCand->index, pCand->count, sizeof(int), cos_cache_candidates_compare);
+        for (i = 1, j = 0; i < pCand->count; i++) {
+            if (pCand->index[i] != pCand->index[j]) {
+                pCand->index[++j] = pCand->index[i];
+            }
+        }
+        pCand->count = j + 1;
+    }
+}
+
+/*
+    cos_cache_test_classic
+    ----------------------
+    For the unit tests: builds, without searching the DIT, the cache
+    of a classic definition of the operational attribute type on the
+    target tree, with the cosSpecifiers in order and a template per
+    grade, whose value of type is the grade.
+*/
+cos_cache *
+cos_cache_test_classic(char *target, char **specifiers, char **grades, char *type)
+{
+    cosCache *pNewCache = (cosCache *)slapi_ch_calloc(1, sizeof(cosCache));
+    cosDefinitions *pDef = (cosDefinitions *)slapi_ch_calloc(1, sizeof(cosDefinitions));
+    int i;
+
+    pDef->cosType = COSTYPE_CLASSIC;
+    cos_cache_add_attrval(&pDef->pDn, "cn=test cos definition");
+    cos_cache_add_attrval(&pDef->pCosTargetTree, target);
+    cos_cache_add_attrval(&pDef->pCosTemplateDn, target);
+    /* values are added at the head of the lists */
+    for (i = 0; specifiers[i]; i++)
+        ;
+    while (i-- > 0) {
+        cos_cache_add_attrval(&pDef->pCosSpecifier, specifiers[i]);
+    }
+    cos_cache_add_attrval(&pDef->pCosAttrs, type);
+    cos_cache_add_attrval(&pDef->pCosOperational, type);
+    for (i = 0; grades[i]; i++) {
+        char *dn = slapi_ch_smprintf("cn=%s,%s", grades[i], target);
+        cosAttrValue *pDn = NULL;
+        cosAttrValue *pVal = NULL;
+        cosAttributes *pAttrs = NULL;
+
+        cos_cache_add_attrval(&pDn, dn);
+        cos_cache_add_attrval(&pVal, grades[i]);
+        cos_cache_add_attr(&pAttrs, type, pVal);
+        cos_cache_add_tmpl(&pDef->pCosTmps, pDn, NULL, pDef->pCosSpecifier, pAttrs, NULL);
+        slapi_ch_free_string(&dn);
+    }
+    cos_cache_add_ll_entry((void **)&pNewCache->pDefs, pDef, NULL);
+    pNewCache->refCount = 1;
+
+    if (cos_cache_index_all(pNewCache)) {
+        cos_cache_destroy(pNewCache);
+        return NULL;
+    }
+    return pNewCache;
+}
+
+int
+cos_cache_test_query(cos_cache *ptheCache, Slapi_Entry *e, char *type, Slapi_ValueSet **out_attr)
+{
+    return cos_cache_query_attr(ptheCache, NULL, e, type, out_attr, NULL, NULL, NULL, NULL);
+}
+
+void
+cos_cache_test_free(cos_cache *ptheCache)
+{
+    cos_cache_destroy((cosCache *)ptheCache);
+}
+
+
 /*
     cos_cache_total_attr_count
     --------------------------
@@ -3001,60 +3785,6 @@ cos_cache_template_index_bsearch(const char *dn)
     return ret;
 }
 
-/*
-    cos_cache_attr_index_bsearch - RECURSIVE
-    ----------------------------------------
-    performs a binary search on the cache attribute index
-    return -1 if key is not found
-    the index into attribute index array of the first occurrance
-    of that attribute type otherwise
-*/
-static int
-cos_cache_attr_index_bsearch(const cosCache *pCache, const cosAttributes *key, int lower, int upper)
-{
-    int ret = -1;
-    int index = 0;
-
-    slapi_log_err(SLAPI_LOG_TRACE, COS_PLUGIN_SUBSYSTEM, "--> cos_cache_attr_index_bsearch\n");
-
-    if (upper >= lower) {
-        if (upper != 0)
-            index = ((upper - lower) / 2) + lower;
-        else
-            index = 0;
-
-        ret = slapi_utf8casecmp((unsigned char *)key->pAttrName, (unsigned char *)(pCache->ppAttrIndex)[index]->pAttrName);
-        if (ret == 0) {
-            /*
-                we have a match, backtrack to the
-                first occurrance of this attribute
-                type
-            */
-            do {
-                index--;
-                if (index >= 0)
-                    ret = slapi_utf8casecmp((unsigned char *)key->pAttrName, (unsigned char *)(pCache->ppAttrIndex)[index]->pAttrName);
-            } while (index >= 0 && ret == 0);
-
-            index++;
-        } else {
-            /* seek elsewhere */
-            if (ret < 0) {
-                /* take the low road */
-                index = cos_cache_attr_index_bsearch(pCache, key, lower, index - 1);
-            } else {
-                /* go high */
-                index = cos_cache_attr_index_bsearch(pCache, key, index + 1, upper);
-            }
-        }
-    } else
-        index = -1;
-
-    slapi_log_err(SLAPI_LOG_TRACE, COS_PLUGIN_SUBSYSTEM, "<-- cos_cache_attr_index_bsearch\n");
-    return index;
-}
-
-
 static int
 cos_cache_cmp_attr(cosAttributes *pAttr, Slapi_Value *test_this, int *result)
 {
@@ -3159,8 +3889,9 @@ bail:
     period of time later, his mods get taken into account in the cos cache.
     This makes it hard to program reliable admin tools for COS--DSAME
     has already indicated this is an issue for them.
-    Additionally, it regenerates the _whole_ cache even for eeny weeny mods--
-    does it really neeed to ?  Additionally, in order to ensure we
+    Changes of templates only search again the templates of the
+    definitions using them, other changes regenerate the _whole_ cache.
+    Additionally, in order to ensure we
     do not miss any mods, we may tend to regen the cache, even if we've already
     taken a mod into account in an earlier regeneration--currently there is no
     way to know we've already dealt with the mod.
@@ -3174,7 +3905,9 @@ cos_cache_change_notify(Slapi_PBlock *pb)
     const char *dn;
     Slapi_DN *sdn = NULL;
     int do_update = 0;
+    int change;
     struct slapi_entry *e;
+    struct slapi_entry *post_e = NULL;
     Slapi_Backend *be = NULL;
     int rc = 0;
     int optype = -1;
@@ -3205,8 +3938,9 @@ cos_cache_change_notify(Slapi_PBlock *pb)
     /*
      * For DELETE, MODIFY, MODRDN: see if the pre-op entry was cos significant.
      * For ADD, MODIFY, MODRDN: see if the post-op was cos significant.
-     * Touching a cos significant entry triggers the update
-     * of the whole cache.
+     * Touching a cos definition triggers the update of the whole
+     * cache, touching a template only the update of the definitions
+     * having templates there.
     */
     slapi_pblock_get(pb, SLAPI_OPERATION_TYPE, &optype);
     if (optype == SLAPI_OPERATION_DELETE ||
@@ -3214,19 +3948,18 @@ cos_cache_change_notify(Slapi_PBlock *pb)
         optype == SLAPI_OPERATION_MODRDN) {
 
         slapi_pblock_get(pb, SLAPI_ENTRY_PRE_OP, &e);
-        if (cos_cache_entry_is_cos_related(e)) {
-            do_update = 1;
-        }
+        do_update = cos_cache_entry_is_cos_related(e);
     }
-    if (!do_update &&
+    if (do_update != COS_CHANGE_DEFINITION &&
         (optype == SLAPI_OPERATION_ADD ||
          optype == SLAPI_OPERATION_MODIFY ||
          optype == SLAPI_OPERATION_MODRDN)) {
 
         /* Adds have null pre-op entries */
-        slapi_pblock_get(pb, SLAPI_ENTRY_POST_OP, &e);
-        if (cos_cache_entry_is_cos_related(e)) {
-            do_update = 1;
+        slapi_pblock_get(pb, SLAPI_ENTRY_POST_OP, &post_e);
+        change = cos_cache_entry_is_cos_related(post_e);
+        if (change > do_update) {
+            do_update = change;
         }
     }
 
@@ -3248,12 +3981,21 @@ cos_cache_change_notify(Slapi_PBlock *pb)
         slapi_log_err(SLAPI_LOG_PLUGIN, COS_PLUGIN_SUBSYSTEM, "cos_cache_change_notify - "
                                                               "Updating due to indirect template change(%s)\n",
                       dn);
-        do_update = 1;
+        do_update = COS_CHANGE_DEFINITION;
     }
 
     /* Do the update if required */
     if (do_update) {
         slapi_lock_mutex(change_lock);
+        if (do_update == COS_CHANGE_TEMPLATE) {
+            charray_add(&cos_cache_changed_tmpls, slapi_ch_strdup(dn));
+            if (optype == SLAPI_OPERATION_MODRDN && post_e) {
+                /* the template moved */
+                charray_add(&cos_cache_changed_tmpls, slapi_ch_strdup(slapi_entry_get_dn_const(post_e)));
+            }
+        } else {
+            cos_cache_full_rebuild = 1;
+        }
         slapi_notify_condvar(something_changed, 1);
         cos_cache_notify_flag = 1;
         slapi_unlock_mutex(change_lock);
@@ -3440,14 +4182,17 @@ cos_cache_backend_state_change(void *handle __attribute__((unused)),
                                int new_be_state __attribute__((unused)))
 {
     slapi_lock_mutex(change_lock);
+    cos_cache_full_rebuild = 1;
+    cos_cache_notify_flag = 1;
     slapi_notify_condvar(something_changed, 1);
     slapi_unlock_mutex(change_lock);
 }
 
 /*
- * returns non-zero: entry is cos significant (note does not detect indirect
- *                    template entries).
- *             0       : entry is not cos significant.
+ * returns COS_CHANGE_DEFINITION: entry is a cos definition (or unknown).
+ *         COS_CHANGE_TEMPLATE: entry is a cos template (note does not detect
+ *                    indirect template entries).
+ *         0       : entry is not cos significant.
  */
 static int
 cos_cache_entry_is_cos_related(Slapi_Entry *e)
@@ -3459,7 +4204,7 @@ cos_cache_entry_is_cos_related(Slapi_Entry *e)
     if (e == NULL) {
         slapi_log_err(SLAPI_LOG_ERR, COS_PLUGIN_SUBSYSTEM, "cos_cache_entry_is_cos_related - "
                                                            "Modified entry is NULL--updating cache just in case\n");
-        rc = 1;
+        rc = COS_CHANGE_DEFINITION;
     } else {
 
         if (slapi_entry_attr_find(e, "objectclass", &pObjclasses)) {
@@ -3476,13 +4221,14 @@ cos_cache_entry_is_cos_related(Slapi_Entry *e)
             /* check out the object classes to see if this was a cosDefinition */
 
             index = slapi_attr_first_value(pObjclasses, &val);
-            while (!rc && val) {
+            while (rc != COS_CHANGE_DEFINITION && val) {
                 pObj = (char *)slapi_value_get_string(val);
 
                 if (!strcasecmp(pObj, "cosdefinition") ||
-                    !strcasecmp(pObj, "cossuperdefinition") ||
-                    !strcasecmp(pObj, "costemplate")) {
-                    rc = 1;
+                    !strcasecmp(pObj, "cossuperdefinition")) {
+                    rc = COS_CHANGE_DEFINITION;
+                } else if (!strcasecmp(pObj, "costemplate")) {
+                    rc = COS_CHANGE_TEMPLATE;
                 }
 
                 index = slapi_attr_next_value(pObjclasses, index, &val);
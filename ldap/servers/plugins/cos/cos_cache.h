@@ -23,4 +23,9 @@ int cos_cache_addref(cos_cache *pCache);
 int cos_cache_release(cos_cache *pCache);
 void cos_cache_change_notify(Slapi_PBlock *pb);
 
+/* for the unit tests */
+cos_cache *cos_cache_test_classic(char *target, char **specifiers, char **grades, char *type);
+int cos_cache_test_query(cos_cache *pCache, Slapi_Entry *e, char *type, Slapi_ValueSet **out_attr);
+void cos_cache_test_free(cos_cache *pCache);
+
 #endif /* _COS_CACHE_H */
@@ -0,0 +1,422 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * Multi-buffer PBKDF2-HMAC-SHA256.
+ *
+ * PBKDF2 output blocks are independent of each other: block i is the xor of
+ * a chain of HMACs seeded with salt || INT(i). Our PBKDF2_SHA256 scheme
+ * derives 256 bytes, that is 8 blocks, which NSS computes one after the
+ * other. Here each block (of one or many passwords) is assigned to a lane
+ * of a vector SHA-256, so 8 chains advance together with a single stream of
+ * instructions. On x86_64 with AVX2 one lane is one 32 bit element of a ymm
+ * register; elsewhere the compiler lowers the vector type to whatever the
+ * target offers.
+ *
+ * Only the iteration loop, where all the time is spent, is vectorised. The
+ * per password key setup and the first HMAC of every block use the scalar
+ * SHA-256 below.
+ *
+ * The server only ever runs one job at a time: pbkdf2_sha256_hash() hashes
+ * or verifies a single password, and the 8 blocks of its 256 byte output
+ * are what fills the lanes. Batching the verifications of several binds,
+ * or rehashing with update_pw_encoding, is not wired in; the batch
+ * interface is there for that and is only exercised by the tests.
+ */
+
+#include <string.h>
+#include "pwdstorage.h"
+
+#define SHA256_BLOCK_LEN 64
+#define SHA256_DIGEST_LEN 32
+#define SHA256_STATE_WORDS 8
+
+typedef uint32_t pbkdf2_mb_vec __attribute__((vector_size(PBKDF2_MB_LANES * sizeof(uint32_t))));
+
+typedef struct pbkdf2_mb_lanes
+{
+    pbkdf2_mb_vec istate[SHA256_STATE_WORDS];
+    pbkdf2_mb_vec ostate[SHA256_STATE_WORDS];
+    pbkdf2_mb_vec u[SHA256_STATE_WORDS];
+    pbkdf2_mb_vec t[SHA256_STATE_WORDS];
+} pbkdf2_mb_lanes;
+
+/* Keyed HMAC state of one job, shared by all of its blocks */
+typedef struct pbkdf2_mb_key
+{
+    uint32_t istate[SHA256_STATE_WORDS];
+    uint32_t ostate[SHA256_STATE_WORDS];
+} pbkdf2_mb_key;
+
+static const uint32_t sha256_k[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+static const uint32_t sha256_iv[SHA256_STATE_WORDS] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+#define BSIG0(x) (ROTR((x), 2) ^ ROTR((x), 13) ^ ROTR((x), 22))
+#define BSIG1(x) (ROTR((x), 6) ^ ROTR((x), 11) ^ ROTR((x), 25))
+#define SSIG0(x) (ROTR((x), 7) ^ ROTR((x), 18) ^ ((x) >> 3))
+#define SSIG1(x) (ROTR((x), 17) ^ ROTR((x), 19) ^ ((x) >> 10))
+#define CH(x, y, z) (((x) & (y)) ^ (~(x) & (z)))
+#define MAJ(x, y, z) (((x) & (y)) ^ ((x) & (z)) ^ ((y) & (z)))
+
+/*
+ * The SHA-256 compression function, written once over a generic type so it
+ * can be instantiated for a single scalar lane and for the vector lanes.
+ */
+#define SHA256_COMPRESS(TYPE, state, w)                                     \
+    do {                                                                    \
+        TYPE a = state[0], b = state[1], c = state[2], d = state[3];        \
+        TYPE e = state[4], f = state[5], g = state[6], h = state[7];        \
+        for (size_t r = 0; r < 64; r++) {                                   \
+            if (r >= 16) {                                                  \
+                w[r & 15] += SSIG1(w[(r - 2) & 15]) + w[(r - 7) & 15] +     \
+                             SSIG0(w[(r - 15) & 15]);                       \
+            }                                                               \
+            TYPE t1 = h + BSIG1(e) + CH(e, f, g) + sha256_k[r] + w[r & 15]; \
+            TYPE t2 = BSIG0(a) + MAJ(a, b, c);                              \
+            h = g;                                                          \
+            g = f;                                                          \
+            f = e;                                                          \
+            e = d + t1;                                                     \
+            d = c;                                                          \
+            c = b;                                                          \
+            b = a;                                                          \
+            a = t1 + t2;                                                    \
+        }                                                                   \
+        state[0] += a;                                                      \
+        state[1] += b;                                                      \
+        state[2] += c;                                                      \
+        state[3] += d;                                                      \
+        state[4] += e;                                                      \
+        state[5] += f;                                                      \
+        state[6] += g;                                                      \
+        state[7] += h;                                                      \
+    } while (0)
+
+static uint32_t
+load_be32(const unsigned char *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static void
+store_be32(unsigned char *p, uint32_t v)
+{
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+static void
+sha256_compress_block(uint32_t *state, const unsigned char *block)
+{
+    uint32_t w[16];
+    for (size_t i = 0; i < 16; i++) {
+        w[i] = load_be32(block + 4 * i);
+    }
+    SHA256_COMPRESS(uint32_t, state, w);
+}
+
+/*
+ * Continue a SHA-256 whose state already absorbed prefix_len bytes (a whole
+ * number of blocks) with the message parts, then pad and write the digest.
+ */
+static void
+sha256_finish(uint32_t *state, size_t prefix_len,
+              const unsigned char *m1, size_t m1_len,
+              const unsigned char *m2, size_t m2_len,
+              unsigned char *digest)
+{
+    unsigned char buf[SHA256_BLOCK_LEN];
+    size_t fill = 0;
+    uint64_t total = (uint64_t)(prefix_len + m1_len + m2_len) * 8;
+    const unsigned char *parts[2] = {m1, m2};
+    size_t lens[2] = {m1_len, m2_len};
+
+    for (size_t p = 0; p < 2; p++) {
+        const unsigned char *m = parts[p];
+        size_t len = lens[p];
+        while (len) {
+            size_t n = SHA256_BLOCK_LEN - fill;
+            if (n > len) {
+                n = len;
+            }
+            memcpy(buf + fill, m, n);
+            fill += n;
+            m += n;
+            len -= n;
+            if (fill == SHA256_BLOCK_LEN) {
+                sha256_compress_block(state, buf);
+                fill = 0;
+            }
+        }
+    }
+
+    buf[fill++] = 0x80;
+    if (fill > SHA256_BLOCK_LEN - 8) {
+        memset(buf + fill, 0, SHA256_BLOCK_LEN - fill);
+        sha256_compress_block(state, buf);
+        fill = 0;
+    }
+    memset(buf + fill, 0, SHA256_BLOCK_LEN - 8 - fill);
+    store_be32(buf + SHA256_BLOCK_LEN - 8, (uint32_t)(total >> 32));
+    store_be32(buf + SHA256_BLOCK_LEN - 4, (uint32_t)total);
+    sha256_compress_block(state, buf);
+
+    for (size_t i = 0; i < SHA256_STATE_WORDS; i++) {
+        store_be32(digest + 4 * i, state[i]);
+    }
+    memset(buf, 0, sizeof(buf));
+}
+
+static void
+pbkdf2_mb_key_init(pbkdf2_mb_key *key, const unsigned char *pwd, size_t pwd_len)
+{
+    unsigned char k[SHA256_BLOCK_LEN] = {0};
+    unsigned char pad[SHA256_BLOCK_LEN];
+
+    if (pwd_len > SHA256_BLOCK_LEN) {
+        uint32_t state[SHA256_STATE_WORDS];
+        memcpy(state, sha256_iv, sizeof(state));
+        sha256_finish(state, 0, pwd, pwd_len, NULL, 0, k);
+    } else if (pwd_len) {
+        memcpy(k, pwd, pwd_len);
+    }
+
+    for (size_t i = 0; i < SHA256_BLOCK_LEN; i++) {
+        pad[i] = k[i] ^ 0x36;
+    }
+    memcpy(key->istate, sha256_iv, sizeof(key->istate));
+    sha256_compress_block(key->istate, pad);
+
+    for (size_t i = 0; i < SHA256_BLOCK_LEN; i++) {
+        pad[i] = k[i] ^ 0x5c;
+    }
+    memcpy(key->ostate, sha256_iv, sizeof(key->ostate));
+    sha256_compress_block(key->ostate, pad);
+
+    memset(k, 0, sizeof(k));
+    memset(pad, 0, sizeof(pad));
+}
+
+/* U1 = HMAC(pwd, salt || INT(block)) */
+static void
+pbkdf2_mb_first_u(const pbkdf2_mb_key *key, const unsigned char *salt, size_t salt_len,
+                  uint32_t block, unsigned char *u)
+{
+    uint32_t state[SHA256_STATE_WORDS];
+    unsigned char inner[SHA256_DIGEST_LEN];
+    unsigned char index[4];
+
+    store_be32(index, block);
+    memcpy(state, key->istate, sizeof(state));
+    sha256_finish(state, SHA256_BLOCK_LEN, salt, salt_len, index, sizeof(index), inner);
+    memcpy(state, key->ostate, sizeof(state));
+    sha256_finish(state, SHA256_BLOCK_LEN, inner, sizeof(inner), NULL, 0, u);
+}
+
+/*
+ * Run rounds iterations of U = HMAC(pwd, U); T ^= U on every lane. Both the
+ * inner and the outer hash are a single block: 32 bytes of message, padding
+ * and a bit length of (64 + 32) * 8.
+ *
+ * This is always inlined so that each caller below gets its own copy built
+ * for its target ISA.
+ */
+static inline __attribute__((always_inline)) void
+pbkdf2_mb_iterate_body(pbkdf2_mb_lanes *l, uint32_t rounds)
+{
+    const pbkdf2_mb_vec zero = {0};
+    pbkdf2_mb_vec w[16];
+    pbkdf2_mb_vec s[SHA256_STATE_WORDS];
+
+    for (uint32_t it = 0; it < rounds; it++) {
+        for (size_t i = 0; i < SHA256_STATE_WORDS; i++) {
+            w[i] = l->u[i];
+            s[i] = l->istate[i];
+        }
+        w[8] = zero + 0x80000000;
+        for (size_t i = 9; i < 15; i++) {
+            w[i] = zero;
+        }
+        w[15] = zero + (SHA256_BLOCK_LEN + SHA256_DIGEST_LEN) * 8;
+        SHA256_COMPRESS(pbkdf2_mb_vec, s, w);
+
+        for (size_t i = 0; i < SHA256_STATE_WORDS; i++) {
+            w[i] = s[i];
+            s[i] = l->ostate[i];
+        }
+        w[8] = zero + 0x80000000;
+        for (size_t i = 9; i < 15; i++) {
+            w[i] = zero;
+        }
+        w[15] = zero + (SHA256_BLOCK_LEN + SHA256_DIGEST_LEN) * 8;
+        SHA256_COMPRESS(pbkdf2_mb_vec, s, w);
+
+        for (size_t i = 0; i < SHA256_STATE_WORDS; i++) {
+            l->u[i] = s[i];
+            l->t[i] ^= s[i];
+        }
+    }
+}
+
+static void
+pbkdf2_mb_iterate_generic(pbkdf2_mb_lanes *l, uint32_t rounds)
+{
+    pbkdf2_mb_iterate_body(l, rounds);
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+__attribute__((target("avx2"))) static void
+pbkdf2_mb_iterate_avx2(pbkdf2_mb_lanes *l, uint32_t rounds)
+{
+    pbkdf2_mb_iterate_body(l, rounds);
+}
+#endif
+
+typedef void (*pbkdf2_mb_iterate_fn)(pbkdf2_mb_lanes *l, uint32_t rounds);
+
+static pbkdf2_mb_iterate_fn
+pbkdf2_mb_select(void)
+{
+#if defined(__x86_64__) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return pbkdf2_mb_iterate_avx2;
+    }
+#endif
+    return pbkdf2_mb_iterate_generic;
+}
+
+static void
+pbkdf2_mb_store_block(pbkdf2_mb_job *job, uint32_t block, const unsigned char *t)
+{
+    size_t offset = (size_t)(block - 1) * SHA256_DIGEST_LEN;
+    size_t n = job->out_len - offset;
+    if (n > SHA256_DIGEST_LEN) {
+        n = SHA256_DIGEST_LEN;
+    }
+    memcpy(job->out + offset, t, n);
+}
+
+/*
+ * Derive the keys of njobs independent PBKDF2-HMAC-SHA256 jobs. The output
+ * is identical to PK11_PBEKeyGen with SEC_OID_PKCS5_PBKDF2/HMAC-SHA256.
+ * Jobs may have different passwords, salts, iteration counts and lengths.
+ * The server calls it with a single job (see the top of this file).
+ */
+void
+pbkdf2_sha256_mb(pbkdf2_mb_job *jobs, size_t njobs)
+{
+    static pbkdf2_mb_iterate_fn iterate = NULL;
+    pbkdf2_mb_lanes lanes;
+    pbkdf2_mb_key *keys;
+    size_t lane_job[PBKDF2_MB_LANES];
+    uint32_t lane_block[PBKDF2_MB_LANES];
+    uint32_t lane_left[PBKDF2_MB_LANES] = {0};
+    size_t next_job = 0;
+    uint32_t next_block = 1;
+    unsigned char u[SHA256_DIGEST_LEN];
+
+    if (iterate == NULL) {
+        iterate = pbkdf2_mb_select();
+    }
+    if (njobs == 0) {
+        return;
+    }
+
+    memset(&lanes, 0, sizeof(lanes));
+    keys = (pbkdf2_mb_key *)slapi_ch_calloc(njobs, sizeof(pbkdf2_mb_key));
+    for (size_t j = 0; j < njobs; j++) {
+        pbkdf2_mb_key_init(&keys[j], jobs[j].pwd, jobs[j].pwd_len);
+    }
+
+    while (1) {
+        uint32_t rounds = UINT32_MAX;
+        int32_t active = 0;
+
+        /* Hand out the next (job, block) pairs to the idle lanes */
+        for (size_t l = 0; l < PBKDF2_MB_LANES; l++) {
+            while (lane_left[l] == 0 && next_job < njobs) {
+                pbkdf2_mb_job *job = &jobs[next_job];
+                uint32_t nblocks = (job->out_len + SHA256_DIGEST_LEN - 1) / SHA256_DIGEST_LEN;
+                uint32_t block = next_block;
+
+                if (block >= nblocks) {
+                    next_job++;
+                    next_block = 1;
+                } else {
+                    next_block++;
+                }
+                if (nblocks == 0) {
+                    continue;
+                }
+
+                pbkdf2_mb_first_u(&keys[job - jobs], job->salt, job->salt_len, block, u);
+                if (job->iterations <= 1) {
+                    pbkdf2_mb_store_block(job, block, u);
+                    continue;
+                }
+                for (size_t i = 0; i < SHA256_STATE_WORDS; i++) {
+                    lanes.istate[i][l] = keys[job - jobs].istate[i];
+                    lanes.ostate[i][l] = keys[job - jobs].ostate[i];
+                    lanes.u[i][l] = load_be32(u + 4 * i);
+                    lanes.t[i][l] = lanes.u[i][l];
+                }
+                lane_job[l] = job - jobs;
+                lane_block[l] = block;
+                lane_left[l] = job->iterations - 1;
+            }
+            if (lane_left[l]) {
+                active = 1;
+                if (lane_left[l] < rounds) {
+                    rounds = lane_left[l];
+                }
+            }
+        }
+        if (!active) {
+            break;
+        }
+
+        /* Idle lanes just compute garbage alongside */
+        iterate(&lanes, rounds);
+
+        for (size_t l = 0; l < PBKDF2_MB_LANES; l++) {
+            if (lane_left[l] == 0) {
+                continue;
+            }
+            lane_left[l] -= rounds;
+            if (lane_left[l] == 0) {
+                for (size_t i = 0; i < SHA256_STATE_WORDS; i++) {
+                    store_be32(u + 4 * i, lanes.t[i][l]);
+                }
+                pbkdf2_mb_store_block(&jobs[lane_job[l]], lane_block[l], u);
+            }
+        }
+    }
+
+    memset(&lanes, 0, sizeof(lanes));
+    memset(keys, 0, njobs * sizeof(pbkdf2_mb_key));
+    memset(u, 0, sizeof(u));
+    slapi_ch_free((void **)&keys);
+}
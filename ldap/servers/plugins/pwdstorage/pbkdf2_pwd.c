@@ -88,8 +88,34 @@ pbkdf2_sha256_extract(char *hash_in, SECItem *salt, uint32_t *iterations)
     salt->len = PBKDF2_SALT_LENGTH;
 }
 
+/*
+ * Derive the hash with the multi-buffer implementation, which computes the
+ * independent output blocks side by side. In FIPS mode the derivation must
+ * stay within the NSS certified module.
+ */
 SECStatus
 pbkdf2_sha256_hash(char *hash_out, size_t hash_out_len, SECItem *pwd, SECItem *salt, uint32_t iterations)
+{
+    pbkdf2_mb_job job;
+
+    if (PK11_IsFIPS()) {
+        return pbkdf2_sha256_hash_nss(hash_out, hash_out_len, pwd, salt, iterations);
+    }
+
+    job.pwd = pwd->data;
+    job.pwd_len = pwd->len;
+    job.salt = salt->data;
+    job.salt_len = salt->len;
+    job.iterations = iterations;
+    job.out = (unsigned char *)hash_out;
+    job.out_len = hash_out_len;
+    pbkdf2_sha256_mb(&job, 1);
+
+    return SECSuccess;
+}
+
+SECStatus
+pbkdf2_sha256_hash_nss(char *hash_out, size_t hash_out_len, SECItem *pwd, SECItem *salt, uint32_t iterations)
 {
     SECAlgorithmID *algid = NULL;
     PK11SlotInfo *slot = NULL;
@@ -92,6 +92,7 @@ char *gost_yescrypt_pw_enc(const char *pwd);
 int pbkdf2_sha256_start(Slapi_PBlock *pb);
 int pbkdf2_sha256_close(Slapi_PBlock *pb);
 SECStatus pbkdf2_sha256_hash(char *hash_out, size_t hash_out_len, SECItem *pwd, SECItem *salt, PRUint32 iterations);
+SECStatus pbkdf2_sha256_hash_nss(char *hash_out, size_t hash_out_len, SECItem *pwd, SECItem *salt, PRUint32 iterations);
 char *pbkdf2_sha256_pw_enc(const char *pwd);
 int pbkdf2_sha256_pw_cmp(const char *userpwd, const char *dbpwd);
 
@@ -99,5 +100,19 @@ int pbkdf2_sha256_pw_cmp(const char *userpwd, const char *dbpwd);
 uint64_t pbkdf2_sha256_benchmark_iterations(void);
 PRUint32 pbkdf2_sha256_calculate_iterations(uint64_t time_nsec);
 
+/* Multi-buffer PBKDF2-HMAC-SHA256, see pbkdf2_mb.c. Only single jobs are used yet */
+#define PBKDF2_MB_LANES 8
+typedef struct pbkdf2_mb_job
+{
+    const unsigned char *pwd;
+    size_t pwd_len;
+    const unsigned char *salt;
+    size_t salt_len;
+    uint32_t iterations;
+    unsigned char *out;
+    size_t out_len;
+} pbkdf2_mb_job;
+void pbkdf2_sha256_mb(pbkdf2_mb_job *jobs, size_t njobs);
+
 /* Utility functions */
 PRUint32 pwdstorage_base64_decode_len(const char *encval, PRUint32 enclen);
@@ -28,6 +28,7 @@
 #include "prcvar.h"
 #include "prio.h"
 #include "avl.h"
+#include "plhash.h"
 #include "vattr_spi.h"
 #include "roles_cache.h"
 #include "views.h"
@@ -61,8 +62,38 @@ typedef struct _role_object
     int type;              /* ROLE_TYPE_MANAGED|ROLE_TYPE_FILTERED|ROLE_TYPE_NESTED */
     Slapi_Filter *filter;  /* if ROLE_TYPE_FILTERED */
     Avlnode *avl_tree;     /* if ROLE_TYPE_NESTED: tree of nested DNs (avl_data is a role_object_nested struct) */
+    int bit;               /* index of the role in the membership bitmaps of its suffix */
 } role_object;
 
+/* Roles membership of an entry: for each role of the suffix (by bit index)
+   whether it was already evaluated for the entry and whether the entry is
+   a member of it.
+   The bitmaps are only valid for the version of the entry they were computed
+   for (its max csn and entryusn, see roles_membership_version), while
+   the roles definitions (generation) and the virtual attributes (watermark)
+   are unchanged.
+ */
+struct _roles_membership
+{
+    char *uniqueid;            /* nsuniqueid of the entry, key of the membership table */
+    char *version;             /* version of the entry the bitmaps were computed for */
+    uint64_t generation;       /* roles_generation when the bitmaps were computed */
+    int32_t watermark;         /* vattr cache watermark when the bitmaps were computed */
+    uint64_t forgets;          /* forgets of the table when the bitmaps were computed */
+    int nb_roles;
+    int cacheable;             /* 0 if some evaluation could not complete */
+    uint64_t *evaluated;
+    uint64_t *member;
+};
+
+/* Roles membership of the entries of a suffix, by nsuniqueid */
+struct _roles_membership_table
+{
+    Slapi_Mutex *lock;
+    PLHashTable *entries; /* roles_membership structs */
+    uint64_t forgets;     /* incremented by each roles_membership_forget() */
+};
+
 /* Structure containing the roles definitions for a given suffix */
 typedef struct _roles_cache_def
 {
@@ -88,6 +119,10 @@ typedef struct _roles_cache_def
        NB: avl_data field is of type role_object
      */
     Avlnode *avl_tree;
+    int nb_roles;
+
+    /* Roles membership of the entries of the suffix */
+    roles_membership_table *membership;
 
     /* Next roles suffix definitions */
     struct _roles_cache_def *next;
@@ -105,6 +140,10 @@ static roles_cache_def *roles_list = NULL;
 
 static Slapi_RWLock *global_lock = NULL;
 
+/* Changed each time a role definition is added, modified or deleted, in any
+   suffix since nested roles may refer to the roles of other suffixes */
+static uint64_t roles_generation = 1;
+
 /* Structure holding the nsrole values */
 typedef struct _roles_cache_build_result
 {
@@ -113,6 +152,8 @@ typedef struct _roles_cache_build_result
     int has_value;                  /* flag to determine if a new value has been added to the result */
     int need_value;                 /* flag to determine if we need the result */
     vattr_context *context;         /* vattr context */
+    roles_cache_def *suffix;        /* suffix of the entry */
+    roles_membership *membership;   /* roles membership of the entry */
 } roles_cache_build_result;
 
 /* Structure used to check if is_entry_member_of is part of a role defined in its suffix */
@@ -121,6 +162,8 @@ typedef struct _roles_cache_search_in_nested
     Slapi_Entry *is_entry_member_of;
     int present; /* flag to know if the entry is part of a role */
     int hint;    /* to check the depth of the nested */
+    roles_cache_def *suffix;      /* suffix of the entry */
+    roles_membership *membership; /* roles membership of the entry, NULL if not recorded */
 } roles_cache_search_in_nested;
 
 /* Structure used to handle roles searches */
@@ -162,6 +205,9 @@ static int roles_cache_dump(caddr_t data, caddr_t arg);
 static int roles_cache_add_entry_cb(Slapi_Entry *e, void *callback_data);
 static void roles_cache_result_cb(int rc, void *callback_data);
 static Slapi_DN *roles_cache_get_top_suffix(Slapi_DN *suffix);
+static void roles_cache_index_roles(roles_cache_def *suffix_def);
+static void roles_membership_forget_entry(Slapi_Entry *entry);
+static void roles_membership_free(roles_membership *membership);
 
 /*     ============== FUNCTIONS ================ */
 
@@ -275,10 +321,12 @@ roles_cache_create_suffix(Slapi_DN *sdn)
     new_suffix->change_lock = slapi_new_mutex();
     new_suffix->stop_lock = slapi_new_mutex();
     new_suffix->create_lock = slapi_new_mutex();
+    new_suffix->membership = roles_membership_table_new();
     if (new_suffix->stop_lock == NULL ||
         new_suffix->change_lock == NULL ||
         new_suffix->cache_lock == NULL ||
-        new_suffix->create_lock == NULL) {
+        new_suffix->create_lock == NULL ||
+        new_suffix->membership == NULL) {
         slapi_log_err(SLAPI_LOG_ERR, ROLES_PLUGIN_SUBSYSTEM,
                       "roles_cache_create_suffix - Lock creation failed\n");
         roles_cache_role_def_free(new_suffix);
@@ -594,6 +642,7 @@ roles_cache_update(roles_cache_def *suffix_to_update)
             slapi_entry_free(entry);
         }
         suffix_to_update->notified_entry = NULL;
+        roles_cache_index_roles(suffix_to_update);
     }
 done:
     slapi_rwlock_unlock(suffix_to_update->cache_lock);
@@ -741,6 +790,12 @@ roles_cache_change_notify(Slapi_PBlock *pb)
                   ROLES_PLUGIN_SUBSYSTEM,
                   "--> roles_cache_change_notify\n");
 
+    /* The roles of the target entry have to be evaluated again, even if the
+       operation failed since they may have been evaluated on its modified copy */
+    slapi_pblock_get(pb, SLAPI_ENTRY_PRE_OP, &pre);
+    roles_membership_forget_entry(pre);
+    pre = NULL;
+
     /* if the current operation has failed, don't even try the post operation */
     slapi_pblock_get(pb, SLAPI_PLUGIN_OPRETURN, &rc);
     if (rc != LDAP_SUCCESS) {
@@ -943,6 +998,10 @@ roles_cache_add_roles_from_suffix(Slapi_DN *suffix_dn, roles_cache_def *suffix_d
     slapi_pblock_destroy(int_search_pb);
     int_search_pb = NULL;
 
+    slapi_rwlock_wrlock(suffix_def->cache_lock);
+    roles_cache_index_roles(suffix_def);
+    slapi_rwlock_unlock(suffix_def->cache_lock);
+
     if (info.rc == LDAP_SUCCESS) {
         rc = 0;
     }
@@ -1005,6 +1064,9 @@ roles_cache_create_role_under(roles_cache_def **roles_cache_suffix, Slapi_Entry
     if ((rc == 0) && new_role) {
         /* Add to the tree where avl_data is a role_object struct */
         rc = roles_cache_insert_object(&((*roles_cache_suffix)->avl_tree), new_role);
+        if (rc == 0) {
+            new_role->bit = (*roles_cache_suffix)->nb_roles++;
+        }
         slapi_log_err(SLAPI_LOG_PLUGIN,
                       ROLES_PLUGIN_SUBSYSTEM, "roles_cache_create_role_under - %s in tree %p rc: %d\n",
                       (char *)slapi_sdn_get_ndn(new_role->dn),
@@ -1510,11 +1572,16 @@ roles_cache_listroles_ext(vattr_context *c, Slapi_Entry *entry, int return_value
             arg.requested_entry = entry;
             arg.has_value = 0;
             arg.context = c;
+            arg.suffix = roles_cache;
 
             /* XXX really need a mutex for this read operation ? */
             slapi_rwlock_rdlock(roles_cache->cache_lock);
 
+            arg.membership = roles_membership_get(roles_cache->membership, entry, roles_cache->nb_roles,
+                                                  slapi_atomic_load_64(&roles_generation, __ATOMIC_ACQUIRE));
             avl_apply(roles_cache->avl_tree, roles_cache_build_nsrole, &arg, -1, AVL_INORDER);
+            roles_membership_put(roles_cache->membership, arg.membership,
+                                 slapi_atomic_load_64(&roles_generation, __ATOMIC_ACQUIRE));
 
             slapi_rwlock_unlock(roles_cache->cache_lock);
 
@@ -1570,6 +1637,8 @@ roles_cache_build_nsrole(caddr_t data, caddr_t arg)
     get_nsrole.is_entry_member_of = result->requested_entry;
     get_nsrole.present = 0;
     get_nsrole.hint = 0;
+    get_nsrole.suffix = result->suffix;
+    get_nsrole.membership = result->membership;
 
     tmprc = roles_is_entry_member_of_object_ext(result->context, (caddr_t)this_role, (caddr_t)&get_nsrole);
     if (SLAPI_VIRTUALATTRS_LOOP_DETECTED == tmprc) {
@@ -1631,6 +1700,8 @@ roles_check(Slapi_Entry *entry_to_check, Slapi_DN *role_dn, int *present)
     }
     slapi_rwlock_unlock(global_lock);
 
+    slapi_rwlock_rdlock(roles_cache->cache_lock);
+
     this_role = (role_object *)avl_find(roles_cache->avl_tree, (caddr_t)role_dn, roles_cache_find_node);
 
     /* MAB: For some reason the assumption made by this function (the role exists and is in scope)
@@ -1640,6 +1711,7 @@ roles_check(Slapi_Entry *entry_to_check, Slapi_DN *role_dn, int *present)
     /* Begin patch */
     if (!this_role) {
         /* Assume that the entry is not member of the role (*present=0) and leave... */
+        slapi_rwlock_unlock(roles_cache->cache_lock);
         return rc;
     }
     /* End patch */
@@ -1647,10 +1719,17 @@ roles_check(Slapi_Entry *entry_to_check, Slapi_DN *role_dn, int *present)
     get_nsrole.is_entry_member_of = entry_to_check;
     get_nsrole.present = 0;
     get_nsrole.hint = 0;
+    get_nsrole.suffix = roles_cache;
+    get_nsrole.membership = roles_membership_get(roles_cache->membership, entry_to_check, roles_cache->nb_roles,
+                                                 slapi_atomic_load_64(&roles_generation, __ATOMIC_ACQUIRE));
 
     roles_is_entry_member_of_object((caddr_t)this_role, (caddr_t)&get_nsrole);
     *present = get_nsrole.present;
 
+    roles_membership_put(roles_cache->membership, get_nsrole.membership,
+                         slapi_atomic_load_64(&roles_generation, __ATOMIC_ACQUIRE));
+    slapi_rwlock_unlock(roles_cache->cache_lock);
+
     slapi_log_err(SLAPI_LOG_PLUGIN,
                   ROLES_PLUGIN_SUBSYSTEM, "<-- roles_check\n");
 
@@ -1739,6 +1818,7 @@ roles_is_entry_member_of_object_ext(vattr_context *c, caddr_t data, caddr_t argu
 
     roles_cache_search_in_nested *get_nsrole = (roles_cache_search_in_nested *)argument;
     role_object *this_role = (role_object *)data;
+    roles_membership *membership = get_nsrole->membership;
 
     Slapi_Entry *entry_to_check = get_nsrole->is_entry_member_of;
 
@@ -1751,10 +1831,16 @@ roles_is_entry_member_of_object_ext(vattr_context *c, caddr_t data, caddr_t argu
         goto done;
     }
 
+    if (roles_membership_lookup(membership, this_role->bit, &get_nsrole->present)) {
+        /* Already evaluated for that entry */
+        rc = 0;
+        goto done;
+    }
+
     if (!roles_is_inscope(entry_to_check, this_role)) {
         slapi_log_err(SLAPI_LOG_PLUGIN,
                       ROLES_PLUGIN_SUBSYSTEM, "roles_is_entry_member_of_object - Entry not in scope of role\n");
-        return rc;
+        goto record;
     }
 
     if (this_role != NULL) {
@@ -1781,6 +1867,11 @@ roles_is_entry_member_of_object_ext(vattr_context *c, caddr_t data, caddr_t argu
                           ROLES_PLUGIN_SUBSYSTEM, "roles_is_entry_member_of_object - invalid role type\n");
         }
     }
+record:
+    if (rc == SLAPI_VIRTUALATTRS_LOOP_DETECTED) {
+        roles_membership_uncacheable(membership);
+    }
+    roles_membership_record(membership, this_role->bit, get_nsrole->present);
 done:
     slapi_log_err(SLAPI_LOG_PLUGIN,
                   ROLES_PLUGIN_SUBSYSTEM, "<-- roles_is_entry_member_of_object\n");
@@ -1881,6 +1972,9 @@ roles_check_nested(caddr_t data, caddr_t arg)
                       get_nsrole->hint,
                       ndn);
 
+        /* The result depends on the path to that role, don't record it */
+        roles_membership_uncacheable(get_nsrole->membership);
+
         /* Stop traversal value */
         return 0;
     }
@@ -1922,8 +2016,15 @@ roles_check_nested(caddr_t data, caddr_t arg)
         }
         /* get the role_object data associated to that dn */
         if (roles_is_inscope(get_nsrole->is_entry_member_of, this_role)) {
+            roles_membership *membership = get_nsrole->membership;
+
+            /* The bit indexes of the roles of another suffix do not match the membership */
+            if (roles_cache != get_nsrole->suffix) {
+                get_nsrole->membership = NULL;
+            }
             /* The list of nested roles is contained in the role definition */
             roles_is_entry_member_of_object((caddr_t)this_role, (caddr_t)get_nsrole);
+            get_nsrole->membership = membership;
             if (get_nsrole->present == 1) {
                 return 0;
             }
@@ -1975,6 +2076,329 @@ roles_is_inscope(Slapi_Entry *entry_to_check, role_object *this_role)
     return (rc);
 }
 
+/* roles_cache_index_roles
+   -----------------------
+   Give each role of a suffix its bit index in the membership bitmaps,
+   called with the cache_lock of the suffix held in write mode each time
+   its roles change. The membership bitmaps computed before are discarded.
+ */
+static int
+roles_cache_index_role(caddr_t data, caddr_t arg)
+{
+    role_object *this_role = (role_object *)data;
+    int *nb_roles = (int *)arg;
+
+    this_role->bit = (*nb_roles)++;
+    return 0;
+}
+
+static void
+roles_cache_index_roles(roles_cache_def *suffix_def)
+{
+    int nb_roles = 0;
+
+    avl_apply(suffix_def->avl_tree, roles_cache_index_role, &nb_roles, -1, AVL_INORDER);
+    suffix_def->nb_roles = nb_roles;
+
+    /* nested roles of the other suffixes may refer to these roles */
+    slapi_atomic_incr_64(&roles_generation, __ATOMIC_RELEASE);
+    roles_membership_clear(suffix_def->membership);
+}
+
+/* roles_membership_table_new
+   --------------------------
+   Create an empty membership table, NULL on failure.
+ */
+roles_membership_table *
+roles_membership_table_new(void)
+{
+    roles_membership_table *table = (roles_membership_table *)slapi_ch_calloc(1, sizeof(roles_membership_table));
+
+    table->lock = slapi_new_mutex();
+    table->entries = PL_NewHashTable(64, PL_HashString, PL_CompareStrings,
+                                     PL_CompareValues, NULL, NULL);
+    if ((table->lock == NULL) || (table->entries == NULL)) {
+        roles_membership_table_free(&table);
+    }
+    return table;
+}
+
+static PRIntn
+roles_membership_free_entry(PLHashEntry *he, PRIntn i __attribute__((unused)), void *arg __attribute__((unused)))
+{
+    roles_membership_free((roles_membership *)he->value);
+    return HT_ENUMERATE_REMOVE;
+}
+
+/* Free the entries while *arg (the number of entries to free) is not 0 */
+static PRIntn
+roles_membership_evict_entry(PLHashEntry *he, PRIntn i __attribute__((unused)), void *arg)
+{
+    size_t *count = (size_t *)arg;
+
+    if (*count == 0) {
+        return HT_ENUMERATE_STOP;
+    }
+    (*count)--;
+    roles_membership_free((roles_membership *)he->value);
+    return HT_ENUMERATE_REMOVE;
+}
+
+void
+roles_membership_table_free(roles_membership_table **table)
+{
+    if ((table == NULL) || (*table == NULL)) {
+        return;
+    }
+    if ((*table)->entries) {
+        PL_HashTableEnumerateEntries((*table)->entries, roles_membership_free_entry, NULL);
+        PL_HashTableDestroy((*table)->entries);
+    }
+    if ((*table)->lock) {
+        slapi_destroy_mutex((*table)->lock);
+    }
+    slapi_ch_free((void **)table);
+}
+
+/* roles_membership_version
+   ------------------------
+   Identify the version of an entry: every update changes its max csn
+   (replication) and its entryusn (USN plugin).  The entry may be freed and
+   its next version loaded at the same address, so its pointer can not be
+   used.  modifyTimestamp is not enough, several updates can be made within
+   a second.  Return NULL if the entry has neither.
+ */
+static char *
+roles_membership_version(Slapi_Entry *entry)
+{
+    const CSN *maxcsn = entry_get_maxcsn(entry);
+    const char *entryusn = slapi_entry_attr_get_ref(entry, "entryusn");
+    char csnstr[CSN_STRSIZE] = {0};
+
+    if ((maxcsn == NULL) && (entryusn == NULL)) {
+        return NULL;
+    }
+    if (maxcsn) {
+        csn_as_string(maxcsn, PR_FALSE, csnstr);
+    }
+    return slapi_ch_smprintf("%s;%s", csnstr, entryusn ? entryusn : "");
+}
+
+/* roles_membership_get
+   --------------------
+   Get the roles membership of an entry to evaluate its roles: the roles
+   already evaluated for that version of the entry are known, the others
+   are evaluated and recorded by roles_is_entry_member_of_object.
+   nb_roles is the number of roles of the suffix and generation the current
+   roles_generation.
+   Return NULL if the membership of the entry can not be recorded.
+ */
+roles_membership *
+roles_membership_get(roles_membership_table *table, Slapi_Entry *entry, int nb_roles, uint64_t generation)
+{
+    const char *uniqueid = slapi_entry_get_uniqueid(entry);
+    size_t nb_words = (nb_roles + 63) / 64;
+    roles_membership *membership = NULL;
+    roles_membership *cached = NULL;
+    char *version = NULL;
+
+    if ((table == NULL) || (uniqueid == NULL) || (nb_roles == 0)) {
+        return NULL;
+    }
+    if ((version = roles_membership_version(entry)) == NULL) {
+        return NULL;
+    }
+
+    membership = (roles_membership *)slapi_ch_calloc(1, sizeof(roles_membership));
+    membership->uniqueid = slapi_ch_strdup(uniqueid);
+    membership->version = version;
+    membership->generation = generation;
+    membership->watermark = slapi_entrycache_vattrcache_watermark_get();
+    membership->nb_roles = nb_roles;
+    membership->cacheable = 1;
+    membership->evaluated = (uint64_t *)slapi_ch_calloc(2 * nb_words, sizeof(uint64_t));
+    membership->member = membership->evaluated + nb_words;
+
+    slapi_lock_mutex(table->lock);
+    membership->forgets = table->forgets;
+    cached = (roles_membership *)PL_HashTableLookupConst(table->entries, uniqueid);
+    if (cached &&
+        (strcmp(cached->version, membership->version) == 0) &&
+        (cached->generation == membership->generation) &&
+        (cached->watermark == membership->watermark) &&
+        (cached->nb_roles == membership->nb_roles)) {
+        memcpy(membership->evaluated, cached->evaluated, 2 * nb_words * sizeof(uint64_t));
+    }
+    slapi_unlock_mutex(table->lock);
+
+    return membership;
+}
+
+/* roles_membership_put
+   --------------------
+   Record the roles membership of an entry once its roles are evaluated,
+   the membership is then owned by the table.  generation is the current
+   roles_generation.
+ */
+void
+roles_membership_put(roles_membership_table *table, roles_membership *membership, uint64_t generation)
+{
+    roles_membership *cached = NULL;
+
+    if (membership == NULL) {
+        return;
+    }
+    if (!membership->cacheable ||
+        (membership->generation != generation) ||
+        (membership->watermark != slapi_entrycache_vattrcache_watermark_get())) {
+        /* Some roles changed during the evaluation */
+        roles_membership_free(membership);
+        return;
+    }
+
+    slapi_lock_mutex(table->lock);
+    if (membership->forgets != table->forgets) {
+        /* An entry was updated during the evaluation, maybe this one:
+           a later version may already have been looked up */
+        slapi_unlock_mutex(table->lock);
+        roles_membership_free(membership);
+        return;
+    }
+    cached = (roles_membership *)PL_HashTableLookup(table->entries, membership->uniqueid);
+    if (cached) {
+        PL_HashTableRemove(table->entries, cached->uniqueid);
+        roles_membership_free(cached);
+    } else if (table->entries->nentries >= MAX_MEMBERSHIP_ENTRIES) {
+        /* make room for the next entries, whichever come first in the table */
+        size_t count = MEMBERSHIP_EVICT_ENTRIES;
+        PL_HashTableEnumerateEntries(table->entries, roles_membership_evict_entry, &count);
+    }
+    PL_HashTableAdd(table->entries, membership->uniqueid, membership);
+    slapi_unlock_mutex(table->lock);
+}
+
+/* roles_membership_forget
+   -----------------------
+   Discard the roles membership of an entry which is modified or deleted
+ */
+void
+roles_membership_forget(roles_membership_table *table, const char *uniqueid)
+{
+    roles_membership *cached = NULL;
+
+    slapi_lock_mutex(table->lock);
+    table->forgets++;
+    cached = (roles_membership *)PL_HashTableLookup(table->entries, uniqueid);
+    if (cached) {
+        PL_HashTableRemove(table->entries, uniqueid);
+        roles_membership_free(cached);
+    }
+    slapi_unlock_mutex(table->lock);
+}
+
+static void
+roles_membership_forget_entry(Slapi_Entry *entry)
+{
+    roles_cache_def *suffix_def = NULL;
+    const char *uniqueid = NULL;
+
+    if ((entry == NULL) || ((uniqueid = slapi_entry_get_uniqueid(entry)) == NULL)) {
+        return;
+    }
+
+    slapi_rwlock_rdlock(global_lock);
+    if (roles_cache_find_roles_in_suffix(slapi_entry_get_sdn(entry), &suffix_def) == 0) {
+        roles_membership_forget(suffix_def->membership, uniqueid);
+    }
+    slapi_rwlock_unlock(global_lock);
+}
+
+static void
+roles_membership_free(roles_membership *membership)
+{
+    if (membership == NULL) {
+        return;
+    }
+    slapi_ch_free_string(&membership->uniqueid);
+    slapi_ch_free_string(&membership->version);
+    slapi_ch_free((void **)&membership->evaluated);
+    slapi_ch_free((void **)&membership);
+}
+
+/* roles_membership_clear
+   ----------------------
+   Discard the roles membership of all the entries of a suffix
+ */
+void
+roles_membership_clear(roles_membership_table *table)
+{
+    slapi_lock_mutex(table->lock);
+    PL_HashTableEnumerateEntries(table->entries, roles_membership_free_entry, NULL);
+    slapi_unlock_mutex(table->lock);
+}
+
+/* roles_membership_count
+   ----------------------
+   Number of entries whose roles membership is recorded
+ */
+size_t
+roles_membership_count(roles_membership_table *table)
+{
+    size_t count;
+
+    slapi_lock_mutex(table->lock);
+    count = table->entries->nentries;
+    slapi_unlock_mutex(table->lock);
+    return count;
+}
+
+/* roles_membership_lookup
+   -----------------------
+   Return 1 and set present if the role with that bit index was already
+   evaluated for the entry, 0 otherwise.
+ */
+int
+roles_membership_lookup(const roles_membership *membership, int bit, int *present)
+{
+    if ((membership == NULL) || (bit >= membership->nb_roles) ||
+        !(membership->evaluated[bit / 64] & (1ULL << (bit % 64)))) {
+        return 0;
+    }
+    if (membership->member[bit / 64] & (1ULL << (bit % 64))) {
+        *present = 1;
+    }
+    return 1;
+}
+
+/* roles_membership_record
+   -----------------------
+   Record the evaluation of the role with that bit index for the entry
+ */
+void
+roles_membership_record(roles_membership *membership, int bit, int present)
+{
+    if ((membership == NULL) || (bit >= membership->nb_roles)) {
+        return;
+    }
+    membership->evaluated[bit / 64] |= 1ULL << (bit % 64);
+    if (present) {
+        membership->member[bit / 64] |= 1ULL << (bit % 64);
+    }
+}
+
+/* roles_membership_uncacheable
+   ----------------------------
+   The result of the evaluation depends on more than the entry and the
+   roles (e.g. the nesting path), don't record it
+ */
+void
+roles_membership_uncacheable(roles_membership *membership)
+{
+    if (membership) {
+        membership->cacheable = 0;
+    }
+}
+
 static void
 berval_set_string(struct berval *bv, const char *string)
 {
@@ -2031,6 +2455,7 @@ roles_cache_role_def_free(roles_cache_def *role_def)
     slapi_lock_mutex(role_def->stop_lock);
 
     avl_free(role_def->avl_tree, roles_cache_role_object_free);
+    roles_membership_table_free(&role_def->membership);
     slapi_sdn_free(&(role_def->suffix_dn));
     slapi_destroy_rwlock(role_def->cache_lock);
     role_def->cache_lock = NULL;
@@ -2154,13 +2579,101 @@ typedef struct {
     char *attrtype_to;
 } role_substitute_type_arg_t;
 
+static char *_nsrole_nested_filter(Slapi_Entry *nested_entry, int depth);
+
+/* Return the filter matching the members of a role (its scope is not
+ * checked, as for the rewritten managed/filtered roles)
+ * or NULL if the role can not be rewritten.
+ */
+static char *
+_nsrole_role_filter(Slapi_DN *sdn, int depth)
+{
+    char *attrs[4] = {SLAPI_ATTR_OBJECTCLASS, ROLE_FILTER_ATTR_NAME, ROLE_NESTED_ATTR_NAME, NULL};
+    Slapi_Entry *nsrole_entry = NULL;
+    char *rolefilter = NULL;
+    char *strfilter = NULL;
+    int rc;
+
+    rc = slapi_search_internal_get_entry(sdn, attrs, &nsrole_entry, roles_get_plugin_identity());
+    if (rc == LDAP_NO_SUCH_OBJECT) {
+        /* the nested role does not exist, no entry is member of it */
+        return slapi_ch_smprintf("(%s=-1)", SLAPI_ATTR_UNIQUEID);
+    } else if (rc != LDAP_SUCCESS) {
+        return NULL;
+    }
+
+    switch (roles_cache_determine_class(nsrole_entry)) {
+    case ROLE_TYPE_MANAGED:
+        strfilter = slapi_filter_escape_filter_value(ROLE_MANAGED_ATTR_NAME, (char *)slapi_sdn_get_ndn(sdn));
+        break;
+    case ROLE_TYPE_FILTERED:
+        rolefilter = slapi_entry_attr_get_charptr(nsrole_entry, ROLE_FILTER_ATTR_NAME);
+        if (rolefilter) {
+            strfilter = (*rolefilter == '(') ? slapi_ch_strdup(rolefilter) : slapi_ch_smprintf("(%s)", rolefilter);
+        }
+        break;
+    case ROLE_TYPE_NESTED:
+        strfilter = _nsrole_nested_filter(nsrole_entry, depth);
+        break;
+    default:
+        break;
+    }
+
+    slapi_ch_free_string(&rolefilter);
+    slapi_entry_free(nsrole_entry);
+    return strfilter;
+}
+
+/* Return the OR of the filters of the roles contained in a nested role
+ * or NULL if one of them can not be rewritten.
+ */
+static char *
+_nsrole_nested_filter(Slapi_Entry *nested_entry, int depth)
+{
+    char **roledns = NULL;
+    char *strfilter = NULL;
+
+    if (depth > MAX_NESTED_ROLES) {
+        /* probable circular definition, leave it to the evaluation of nsrole */
+        return NULL;
+    }
+
+    roledns = slapi_entry_attr_get_charray(nested_entry, ROLE_NESTED_ATTR_NAME);
+    if (roledns == NULL) {
+        return slapi_ch_smprintf("(%s=-1)", SLAPI_ATTR_UNIQUEID);
+    }
+    strfilter = slapi_ch_strdup("(|");
+    for (size_t i = 0; roledns[i]; i++) {
+        Slapi_DN *sdn = slapi_sdn_new_dn_byref(roledns[i]);
+        char *component = _nsrole_role_filter(sdn, depth + 1);
+        char *tmp = NULL;
+
+        slapi_sdn_free(&sdn);
+        if (component == NULL) {
+            slapi_ch_free_string(&strfilter);
+            break;
+        }
+        tmp = slapi_ch_smprintf("%s%s", strfilter, component);
+        slapi_ch_free_string(&strfilter);
+        slapi_ch_free_string(&component);
+        strfilter = tmp;
+    }
+    if (strfilter) {
+        char *tmp = slapi_ch_smprintf("%s)", strfilter);
+        slapi_ch_free_string(&strfilter);
+        strfilter = tmp;
+    }
+    slapi_ch_array_free(roledns);
+    return strfilter;
+}
+
 
 static void
 _rewrite_nsrole_component(Slapi_Filter *f, role_substitute_type_arg_t *substitute_arg)
 {
     char *type;
     struct berval *bval;
-    char *attrs[3] = {SLAPI_ATTR_OBJECTCLASS, ROLE_FILTER_ATTR_NAME, NULL};
+    char *attrs[4] = {SLAPI_ATTR_OBJECTCLASS, ROLE_FILTER_ATTR_NAME, ROLE_NESTED_ATTR_NAME, NULL};
     Slapi_Entry *nsrole_entry = NULL;
     Slapi_DN *sdn = NULL;
     char *rolefilter = NULL;
@@ -2225,7 +2738,17 @@ _rewrite_nsrole_component(Slapi_Filter *f, role_substitute_type_arg_t *substitut
             slapi_filter_replace_strfilter(f, rolefilter);
             goto bail;
         } else if (!strcasecmp(oc_values[i], (char *)"nsNestedRoleDefinition")) {
-            /* nested roles can not be rewritten */
+            /* nested role, rewrite it with the OR of the filters of
+             * the roles it contains, so that it is resolved with the
+             * indexes of their attributes
+             */
+            char *nested_filter = _nsrole_nested_filter(nsrole_entry, 1);
+            if (nested_filter) {
+                slapi_filter_replace_strfilter(f, nested_filter);
+                slapi_log_err(SLAPI_LOG_PLUGIN, ROLES_PLUGIN_SUBSYSTEM, "_rewrite_nsrole_component: replace (%s=%s) by %s\n",
+                              substitute_arg->attrtype_from, (char *)slapi_sdn_get_ndn(sdn), nested_filter);
+                slapi_ch_free_string(&nested_filter);
+            }
             goto bail;
         }
     }
@@ -2297,12 +2820,14 @@ role_substitute_type(Slapi_Filter *f, void *arg)
  * The role rewriter supports:
  *   - 'nsrole' attribute type
  *   - LDAP_FILTER_EQUALITY filter choice
- *   - assertion being a managed/filtered role DN
+ *   - assertion being a managed/filtered/nested role DN
  *
  *   - Input  '(nsrole=cn=admin1,dc=example,dc=com)'
  *     Output '(nsroleDN=cn=admin1,dc=example,dc=com)'
  *   - Input  '(nsrole=cn=SalesManagerFilter,ou=people,dc=example,dc=com)'
  *     Output '(manager=user008762)'
+ *   - Input  '(nsrole=cn=Sales,ou=people,dc=example,dc=com)'
+ *     Output '(|(nsroleDN=cn=admin1,dc=example,dc=com)(manager=user008762))'
  *
  * dn: cn=admin1,dc=example,dc=com
  * ...
@@ -2317,6 +2842,14 @@ role_substitute_type(Slapi_Filter *f, void *arg)
  * ...
  * nsRoleFilter: manager=user008762
  *
+ * dn: cn=Sales,ou=people,dc=example,dc=com
+ * ...
+ * objectclass: nsRoleDefinition
+ * objectclass: nsNestedRoleDefinition
+ * ...
+ * nsRoleDN: cn=admin1,dc=example,dc=com
+ * nsRoleDN: cn=SalesManagerFilter,ou=people,dc=example,dc=com
+ *
  * return code (from computed.c:compute_rewrite_search_filter):
  *   -1 : keep looking
  *    0 : rewrote OK
@@ -50,6 +50,23 @@ int roles_cache_listroles_ext(vattr_context *c, Slapi_Entry *entry, int return_v
 
 int roles_check(Slapi_Entry *entry_to_check, Slapi_DN *role_dn, int *present);
 
+/* Roles membership of the entries of a suffix, from roles_cache.c */
+/* Beyond that many entries, some membership bitmaps of a suffix are dropped */
+#define MAX_MEMBERSHIP_ENTRIES 100000
+#define MEMBERSHIP_EVICT_ENTRIES (MAX_MEMBERSHIP_ENTRIES / 16)
+typedef struct _roles_membership roles_membership;
+typedef struct _roles_membership_table roles_membership_table;
+roles_membership_table *roles_membership_table_new(void);
+void roles_membership_table_free(roles_membership_table **table);
+roles_membership *roles_membership_get(roles_membership_table *table, Slapi_Entry *entry, int nb_roles, uint64_t generation);
+void roles_membership_put(roles_membership_table *table, roles_membership *membership, uint64_t generation);
+void roles_membership_forget(roles_membership_table *table, const char *uniqueid);
+void roles_membership_clear(roles_membership_table *table);
+size_t roles_membership_count(roles_membership_table *table);
+int roles_membership_lookup(const roles_membership *membership, int bit, int *present);
+void roles_membership_record(roles_membership *membership, int bit, int present);
+void roles_membership_uncacheable(roles_membership *membership);
+
 /* From roles_plugin.c */
 int roles_init(Slapi_PBlock *pb);
 int roles_sp_get_value(vattr_sp_handle *handle, vattr_context *c, Slapi_Entry *e, char *type, Slapi_ValueSet **results, int *type_name_disposition, char **actual_type_name, int flags, int *free_flags, void *hint);
@@ -63,14 +63,21 @@ string_filter_ava(struct berval *bvfilter, Slapi_Value **bvals, int syntax, int
 
     for (i = 0; (bvals != NULL) && (bvals[i] != NULL); i++) {
         int norm_val = 1; /* normalize the first value only */
+        const struct berval *bvp = NULL;
         /* if the NORMALIZED flag is set, skip normalizing */
         if (slapi_value_get_flags(bvals[i]) & SLAPI_ATTR_FLAG_NORMALIZED) {
             norm_val = 0;
+        } else if ((bvp = value_normalized(bvals[i], syntax))) {
+            /* normalized form cached in the value */
+            norm_val = 0;
+        }
+        if (bvp == NULL) {
+            bvp = slapi_value_get_berval(bvals[i]);
         }
         /* note - do not return the normalized value in retVal - the
            caller will usually want the "raw" value, and can normalize it later
         */
-        rc = value_cmp((struct berval *)slapi_value_get_berval(bvals[i]), pbvfilter_norm, syntax, norm_val);
+        rc = value_cmp((struct berval *)bvp, pbvfilter_norm, syntax, norm_val);
         switch (ftype) {
         case LDAP_FILTER_GE:
             if (rc >= 0) {
@@ -186,21 +193,40 @@ string_filter_approx(struct berval *bvfilter, Slapi_Value **bvals, Slapi_Value *
     return (rc);
 }
 
+/* Copy and normalize a substring assertion component */
+static char *
+string_filter_sub_normalize(const char *comp, int syntax, int trim_spaces, int filter_normalized)
+{
+    char *norm = NULL;
+    char *alt = NULL;
+
+    if (comp == NULL) {
+        return NULL;
+    }
+    norm = slapi_ch_strdup(comp);
+    if (!filter_normalized) {
+        value_normalize_ext(norm, syntax, trim_spaces, &alt);
+        if (alt) {
+            slapi_ch_free_string(&norm);
+            norm = alt;
+        }
+    }
+    return norm;
+}
+
 int
 string_filter_sub(Slapi_PBlock *pb, char *initial, char **any, char * final, Slapi_Value **bvals, int syntax)
 {
-    int i, j, rc, size = 0;
-    char *p, *end, *realval, *tmpbuf = NULL, *bigpat = NULL;
+    int i, j, rc;
+    char *realval, *tmpbuf = NULL;
     size_t tmpbufsize;
-    char pat[BUFSIZ];
     char buf[BUFSIZ];
     struct timespec expire_time = {0};
     Operation *op = NULL;
-    Slapi_Regex *re = NULL;
-    char *re_result = NULL;
+    Slapi_Substr *ss = NULL;
     char *alt = NULL;
     int filter_normalized = 0;
-    int free_re = 1;
+    int free_ss = 1;
     struct subfilt *sf = NULL;
 
     slapi_log_err(SLAPI_LOG_TRACE, SYNTAX_PLUGIN_SUBSYSTEM, "=> string_filter_sub\n");
@@ -217,110 +243,28 @@ string_filter_sub(Slapi_PBlock *pb, char *initial, char **any, char * final, Sla
         slapi_pblock_get(pb, SLAPI_PLUGIN_SYNTAX_FILTER_DATA, &sf);
     }
     if (sf) {
-        re = (Slapi_Regex *)sf->sf_private;
-        if (re) {
-            free_re = 0;
+        ss = (Slapi_Substr *)sf->sf_private;
+        if (ss) {
+            free_ss = 0;
         }
     }
 
-    if (!re) {
+    if (!ss) {
         /*
-         * construct a regular expression corresponding to the
-         * filter and let regex do the work for each value
-         * XXX should do this once and save it somewhere XXX
+         * normalize the assertion once for all the values
+         * 3rd arg: 1 - trim leading blanks of initial only
          */
-        pat[0] = '\0';
-        p = pat;
-        end = pat + sizeof(pat) - 2; /* leave room for null */
-
-        if (initial != NULL) {
-            size = strlen(initial) + 1; /* add 1 for "^" */
-        }
-
-        if (any != NULL) {
-            i = 0;
-            while (any[i]) {
-                size += strlen(any[i++]) + 2; /* add 2 for ".*" */
-            }
-        }
-
-        if (final != NULL) {
-            size += strlen(final) + 3; /* add 3 for ".*" and "$" */
-        }
-
-        size *= 2; /* doubled in case all filter chars need escaping */
-        size++;    /* add 1 for null */
-
-        if (p + size > end) {
-            bigpat = slapi_ch_malloc(size);
-            p = bigpat;
-        }
+        char *ninitial = string_filter_sub_normalize(initial, syntax, 1, filter_normalized);
+        char **nany = NULL;
+        char *nfinal = string_filter_sub_normalize(final, syntax, 0, filter_normalized);
 
-        if (initial != NULL) {
-            /* 3rd arg: 1 - trim leading blanks */
-            if (!filter_normalized) {
-                value_normalize_ext(initial, syntax, 1, &alt);
-            }
-            *p++ = '^';
-            if (alt) {
-                filter_strcpy_special_ext(p, alt, FILTER_STRCPY_ESCAPE_RECHARS);
-                slapi_ch_free_string(&alt);
-            } else {
-                filter_strcpy_special_ext(p, initial, FILTER_STRCPY_ESCAPE_RECHARS);
-            }
-            p = strchr(p, '\0');
-        }
-        if (any != NULL) {
-            for (i = 0; any[i] != NULL; i++) {
-                /* 3rd arg: 0 - DO NOT trim leading blanks */
-                if (!filter_normalized) {
-                    value_normalize_ext(any[i], syntax, 0, &alt);
-                }
-                /* ".*" + value */
-                *p++ = '.';
-                *p++ = '*';
-                if (alt) {
-                    filter_strcpy_special_ext(p, alt, FILTER_STRCPY_ESCAPE_RECHARS);
-                    slapi_ch_free_string(&alt);
-                } else {
-                    filter_strcpy_special_ext(p, any[i], FILTER_STRCPY_ESCAPE_RECHARS);
-                }
-                p = strchr(p, '\0');
-            }
-        }
-        if (final != NULL) {
-            /* 3rd arg: 0 - DO NOT trim leading blanks */
-            if (!filter_normalized) {
-                value_normalize_ext(final, syntax, 0, &alt);
-            }
-            /* ".*" + value */
-            *p++ = '.';
-            *p++ = '*';
-            if (alt) {
-                filter_strcpy_special_ext(p, alt, FILTER_STRCPY_ESCAPE_RECHARS);
-                slapi_ch_free_string(&alt);
-            } else {
-                filter_strcpy_special_ext(p, final, FILTER_STRCPY_ESCAPE_RECHARS);
-            }
-            strcat(p, "$");
-        }
-
-        /* compile the regex */
-        p = (bigpat) ? bigpat : pat;
-        tmpbuf = NULL;
-        re = slapi_re_comp(p, &re_result);
-        if (NULL == re) {
-            slapi_log_err(SLAPI_LOG_ERR, SYNTAX_PLUGIN_SUBSYSTEM,
-                          "string_filter_sub - re_comp (%s) failed (%s): %s\n",
-                          pat, p, re_result ? re_result : "unknown");
-            slapi_ch_free_string(&re_result);
-            rc = LDAP_OPERATIONS_ERROR;
-            goto bailout;
-        } else if (slapi_is_loglevel_set(SLAPI_LOG_TRACE)) {
-            char ebuf[BUFSIZ];
-            slapi_log_err(SLAPI_LOG_TRACE, SYNTAX_PLUGIN_SUBSYSTEM,
-                          "string_filter_sub - re_comp (%s)\n", escape_string(p, ebuf));
+        for (i = 0; any && any[i]; i++) {
+            charray_add(&nany, string_filter_sub_normalize(any[i], syntax, 0, filter_normalized));
         }
+        ss = substr_match_new(ninitial, nany, nfinal);
+        slapi_ch_free_string(&ninitial);
+        charray_free(nany);
+        slapi_ch_free_string(&nfinal);
     }
 
     if (slapi_timespec_expire_check(&expire_time) == TIMER_EXPIRED) {
@@ -330,7 +274,7 @@ string_filter_sub(Slapi_PBlock *pb, char *initial, char **any, char * final, Sla
     }
 
     /*
-     * test the regex against each value
+     * test the assertion against each value
      */
     rc = -1;
     tmpbuf = NULL;
@@ -338,49 +282,51 @@ string_filter_sub(Slapi_PBlock *pb, char *initial, char **any, char * final, Sla
     for (j = 0; (bvals != NULL) && (bvals[j] != NULL); j++) {
         int tmprc;
         size_t len;
-        const struct berval *bvp = slapi_value_get_berval(bvals[j]);
-
-        len = bvp->bv_len;
-        if (len < sizeof(buf)) {
-            realval = buf;
-            memcpy(realval, bvp->bv_val, bvp->bv_len);
-            realval[bvp->bv_len] = 0;
-        } else if (len < tmpbufsize) {
-            realval = tmpbuf;
-            memcpy(realval, bvp->bv_val, bvp->bv_len);
-            realval[bvp->bv_len] = 0;
+        const struct berval *bvp = NULL;
+
+        if (!(slapi_value_get_flags(bvals[j]) & SLAPI_ATTR_FLAG_NORMALIZED) &&
+            (bvp = value_normalized(bvals[j], syntax))) {
+            /* normalized form cached in the value, no copy needed */
+            realval = bvp->bv_val;
         } else {
-            tmpbufsize = len + 1;
-            realval = tmpbuf = (char *)slapi_ch_realloc(tmpbuf, tmpbufsize);
-            memcpy(realval, bvp->bv_val, bvp->bv_len);
-            realval[bvp->bv_len] = 0;
+            bvp = slapi_value_get_berval(bvals[j]);
+            len = bvp->bv_len;
+            if (len < sizeof(buf)) {
+                realval = buf;
+                memcpy(realval, bvp->bv_val, bvp->bv_len);
+                realval[bvp->bv_len] = 0;
+            } else if (len < tmpbufsize) {
+                realval = tmpbuf;
+                memcpy(realval, bvp->bv_val, bvp->bv_len);
+                realval[bvp->bv_len] = 0;
+            } else {
+                tmpbufsize = len + 1;
+                realval = tmpbuf = (char *)slapi_ch_realloc(tmpbuf, tmpbufsize);
+                memcpy(realval, bvp->bv_val, bvp->bv_len);
+                realval[bvp->bv_len] = 0;
+            }
+            /* 3rd arg: 1 - trim leading blanks */
+            if (!(slapi_value_get_flags(bvals[j]) & SLAPI_ATTR_FLAG_NORMALIZED)) {
+                value_normalize_ext(realval, syntax, 1, &alt);
+            } else if (syntax & SYNTAX_DN) {
+                slapi_dn_ignore_case(realval);
+            }
         }
-        /* 3rd arg: 1 - trim leading blanks */
-        if (!(slapi_value_get_flags(bvals[j]) & SLAPI_ATTR_FLAG_NORMALIZED)) {
-            value_normalize_ext(realval, syntax, 1, &alt);
-        } else if (syntax & SYNTAX_DN) {
-            slapi_dn_ignore_case(realval);
+        if (slapi_timespec_expire_check(&expire_time) == TIMER_EXPIRED) {
+            slapi_log_err(SLAPI_LOG_TRACE, SYNTAX_PLUGIN_SUBSYSTEM, "LDAP_TIMELIMIT_EXCEEDED\n");
+            rc = LDAP_TIMELIMIT_EXCEEDED;
+            goto bailout;
         }
         if (alt) {
-            if (slapi_timespec_expire_check(&expire_time) == TIMER_EXPIRED) {
-                slapi_log_err(SLAPI_LOG_TRACE, SYNTAX_PLUGIN_SUBSYSTEM, "LDAP_TIMELIMIT_EXCEEDED\n");
-                rc = LDAP_TIMELIMIT_EXCEEDED;
-                goto bailout;
-            }
-            tmprc = slapi_re_exec_nt(re, alt);
+            tmprc = substr_match_exec(ss, alt);
             slapi_ch_free_string(&alt);
         } else {
-            if (slapi_timespec_expire_check(&expire_time) == TIMER_EXPIRED) {
-                slapi_log_err(SLAPI_LOG_TRACE, SYNTAX_PLUGIN_SUBSYSTEM, "LDAP_TIMELIMIT_EXCEEDED\n");
-                rc = LDAP_TIMELIMIT_EXCEEDED;
-                goto bailout;
-            }
-            tmprc = slapi_re_exec_nt(re, realval);
+            tmprc = substr_match_exec(ss, realval);
         }
 
         if (slapi_is_loglevel_set(SLAPI_LOG_TRACE)) {
             char ebuf[BUFSIZ];
-            slapi_log_err(SLAPI_LOG_TRACE, SYNTAX_PLUGIN_SUBSYSTEM, "re_exec (%s) %i\n",
+            slapi_log_err(SLAPI_LOG_TRACE, SYNTAX_PLUGIN_SUBSYSTEM, "substr_match_exec (%s) %i\n",
                           escape_string(realval, ebuf), tmprc);
         }
         if (tmprc == 1) {
@@ -392,12 +338,11 @@ string_filter_sub(Slapi_PBlock *pb, char *initial, char **any, char * final, Sla
         }
     }
 bailout:
-    if (free_re) {
-        slapi_re_free(re);
+    if (free_ss) {
+        substr_match_free(&ss);
     }
     slapi_ch_free_string(&alt);
     slapi_ch_free((void **)&tmpbuf); /* NULL is fine */
-    slapi_ch_free((void **)&bigpat); /* NULL is fine */
 
     slapi_log_err(SLAPI_LOG_TRACE, SYNTAX_PLUGIN_SUBSYSTEM, "<= string_filter_sub %d\n", rc);
     return (rc);
@@ -430,11 +375,18 @@ string_values2keys(Slapi_PBlock *pb, Slapi_Value **bvals, Slapi_Value ***ivals,
 
         for (bvlp = bvals, nbvlp = nbvals; bvlp && *bvlp; bvlp++, nbvlp++) {
             unsigned long value_flags = slapi_value_get_flags(*bvlp);
-            c = slapi_ch_strdup(slapi_value_get_string(*bvlp));
+            const struct berval *norm = NULL;
+            if (!(value_flags & SLAPI_ATTR_FLAG_NORMALIZED)) {
+                /* use the normalized form cached in the value */
+                norm = value_normalized(*bvlp, syntax);
+            }
+            c = slapi_ch_strdup(norm ? norm->bv_val : slapi_value_get_string(*bvlp));
             /* if the NORMALIZED flag is set, skip normalizing */
             if (!(value_flags & SLAPI_ATTR_FLAG_NORMALIZED)) {
-                /* 3rd arg: 1 - trim leading blanks */
-                value_normalize_ext(c, syntax, 1, &alt);
+                if (norm == NULL) {
+                    /* 3rd arg: 1 - trim leading blanks */
+                    value_normalize_ext(c, syntax, 1, &alt);
+                }
                 value_flags |= SLAPI_ATTR_FLAG_NORMALIZED;
             } else if ((syntax & SYNTAX_DN) &&
                        (value_flags & SLAPI_ATTR_FLAG_NORMALIZED_CES)) {
@@ -562,7 +514,11 @@ string_values2keys(Slapi_PBlock *pb, Slapi_Value **bvals, Slapi_Value ***ivals,
         for (bvlp = bvals; bvlp && *bvlp; bvlp++) {
             unsigned long value_flags = slapi_value_get_flags(*bvlp);
             /* 3rd arg: 1 - trim leading blanks */
-            if (!(value_flags & SLAPI_ATTR_FLAG_NORMALIZED)) {
+            if (!(value_flags & SLAPI_ATTR_FLAG_NORMALIZED) &&
+                (bvp = value_normalized(*bvlp, syntax))) {
+                /* normalized form cached in the value */
+                value_flags |= SLAPI_ATTR_FLAG_NORMALIZED;
+            } else if (!(value_flags & SLAPI_ATTR_FLAG_NORMALIZED)) {
                 c = slapi_ch_strdup(slapi_value_get_string(*bvlp));
                 value_normalize_ext(c, syntax, 1, &alt);
                 if (alt) {
@@ -689,6 +645,10 @@ string_assertion2keys_ava(
     case LDAP_FILTER_EQUALITY:
         (*ivals) = (Slapi_Value **)slapi_ch_malloc(2 * sizeof(Slapi_Value *));
         (*ivals)[0] = val ? slapi_value_dup(val) : NULL;
+        if (val) {
+            /* the key is normalized in place, do not keep the forms of val */
+            value_free_normalized((*ivals)[0]);
+        }
         if (val && !(flags & SLAPI_ATTR_FLAG_NORMALIZED)) {
             /* 3rd arg: 1 - trim leading blanks */
             value_normalize_ext((*ivals)[0]->bv.bv_val, syntax, 1, &alt);
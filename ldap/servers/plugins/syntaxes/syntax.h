@@ -84,6 +84,7 @@ int string_assertion2keys_sub(Slapi_PBlock *pb, char *initial, char **any, char
 int value_cmp(struct berval *v1, struct berval *v2, int syntax, int normalize);
 void value_normalize(char *s, int syntax, int trim_leading_blanks);
 void value_normalize_ext(char *s, int syntax, int trim_leading_blanks, char **alt);
+const struct berval *value_normalized(Slapi_Value *v, int syntax);
 
 char *first_word(char *s);
 char *next_word(char *s);
@@ -197,6 +197,39 @@ value_normalize_ext(
     }
 }
 
+/*
+ * Return the normalized form of a value (leading and trailing blanks
+ * trimmed) for a syntax.  The form is computed once and cached in the
+ * value, the next calls return the cached form.  Returns NULL if the
+ * value can not cache it (temporary value), the caller must then
+ * normalize a copy of the value.
+ */
+const struct berval *
+value_normalized(Slapi_Value *v, int syntax)
+{
+    const struct berval *bvp = slapi_value_get_berval(v);
+    const struct berval *norm = NULL;
+    char *s = NULL;
+    char *alt = NULL;
+
+    if (bvp->bv_val == NULL || !value_cache_normalized(v)) {
+        return NULL;
+    }
+    syntax &= ~SYNTAX_NORM_FILT; /* tells about the assertion, not the value */
+    if ((norm = value_get_normalized(v, syntax))) {
+        return norm;
+    }
+    s = slapi_ch_malloc(bvp->bv_len + 1);
+    memcpy(s, bvp->bv_val, bvp->bv_len);
+    s[bvp->bv_len] = '\0';
+    value_normalize_ext(s, syntax, 1, &alt);
+    if (alt) {
+        slapi_ch_free_string(&s);
+        s = alt;
+    }
+    return value_set_normalized(v, syntax, s);
+}
+
 void
 value_normalize(
     char *s __attribute__((unused)),
@@ -315,6 +315,7 @@ slapi_attr_init_locking_optional(Slapi_Attr *a, const char *type, PRBool use_loc
         }
         if (NULL == asi) {
             a->a_type = attr_syntax_normalize_no_lookup(type);
+            a->a_atom = attr_atom_get(a->a_type);
             /*
              * no syntax for this type... return Octet String
              * syntax.  we accomplish this by looking up a well known
@@ -331,6 +332,7 @@ slapi_attr_init_locking_optional(Slapi_Attr *a, const char *type, PRBool use_loc
 
             if (NULL == attroptions) {
                 a->a_type = slapi_ch_strdup(asi->asi_name);
+                a->a_atom = asi->asi_atom;
             } else {
                 /*
                  * If the original type includes any attribute options,
@@ -342,6 +344,7 @@ slapi_attr_init_locking_optional(Slapi_Attr *a, const char *type, PRBool use_loc
 
                 normalized_options = attr_syntax_normalize_no_lookup(attroptions);
                 a->a_type = slapi_ch_smprintf("%s%s", asi->asi_name, normalized_options);
+                a->a_atom = 0; /* subtypes are not interned */
                 slapi_ch_free_string(&normalized_options);
             }
         }
@@ -379,6 +382,7 @@ slapi_attr_init_nosyntax(Slapi_Attr *a, const char *type)
 {
 
     a->a_type = slapi_ch_strdup(type);
+    a->a_atom = attr_atom_get(type);
     slapi_valueset_init(&a->a_present_values);
     slapi_valueset_init(&a->a_deleted_values);
     a->a_listtofree = NULL;
@@ -416,6 +420,7 @@ attr_done(Slapi_Attr *a)
 {
     if (a != NULL) {
         slapi_ch_free((void **)&a->a_type);
+        a->a_atom = 0;
         csn_free(&a->a_deletioncsn);
         slapi_valueset_done(&a->a_present_values);
         slapi_valueset_done(&a->a_deleted_values);
@@ -614,6 +619,7 @@ slapi_attr_value_cmp(const Slapi_Attr *a, const struct berval *v1, const struct
     cvals[0]->v_csnset = NULL;
     cvals[0]->bv = *v1;
     cvals[0]->v_flags = 0;
+    cvals[0]->v_norm = NULL;
     cvals[1] = NULL;
     a2.a_present_values.va = cvals; /* JCM - PUKE */
     ava.ava_type = a->a_type;
@@ -795,6 +801,7 @@ slapi_attr_set_type(Slapi_Attr *a, const char *type)
     } else {
         slapi_ch_free_string(&a->a_type);
         a->a_type = slapi_ch_strdup(type);
+        a->a_atom = attr_atom_get(type);
     }
     return rc;
 }
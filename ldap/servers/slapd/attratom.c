@@ -0,0 +1,166 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * attratom.c - interned attribute type names
+ *
+ * Every name (and alias) of the attribute types of the schema is given a
+ * small integer, its atom, when the attribute type is loaded.  Two names
+ * have the same atom if and only if they are equal ignoring case, so once
+ * the atom of a name is known, finding an attribute in an entry compares
+ * integers (a_atom) instead of calling strcasecmp for each attribute.
+ *
+ * An atom is never reused nor removed, even if its attribute type is removed
+ * from the schema, so atoms stay valid across schema reloads and the entries
+ * in the caches keep their atoms.  The table only grows with the names of
+ * the schema, the names of the attributes of the entries and of the
+ * assertions are looked up but never added.
+ *
+ * Looking up a name takes no lock: the entries are never modified once
+ * published and a grown table replaces the previous one, which is kept
+ * since readers may still be using it.
+ */
+
+#include "slap.h"
+
+#define ATTR_ATOM_TABLE_MINSIZE 1024
+
+typedef struct attr_atom_entry
+{
+    uint64_t aae_hash;
+    uint32_t aae_atom;
+    char aae_name[1]; /* allocated with the entry */
+} attr_atom_entry;
+
+typedef struct attr_atom_table
+{
+    size_t aat_mask; /* number of slots - 1 */
+    size_t aat_count;
+    attr_atom_entry **aat_slots;
+    struct attr_atom_table *aat_prev; /* replaced tables, never freed */
+} attr_atom_table;
+
+static attr_atom_table *attr_atom_current = NULL;
+static uint32_t attr_atom_last = 0;
+static pthread_mutex_t attr_atom_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* FNV-1a of the lower cased name */
+static uint64_t
+attr_atom_hash(const char *name)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+        h ^= TOLOWER(*p);
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static attr_atom_entry *
+attr_atom_find(attr_atom_table *t, const char *name, uint64_t hash)
+{
+    attr_atom_entry *e;
+
+    for (size_t i = hash & t->aat_mask;
+         (e = __atomic_load_n(&t->aat_slots[i], __ATOMIC_ACQUIRE)) != NULL;
+         i = (i + 1) & t->aat_mask) {
+        if (e->aae_hash == hash && strcasecmp(e->aae_name, name) == 0) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+static attr_atom_table *
+attr_atom_table_new(size_t size)
+{
+    attr_atom_table *t = (attr_atom_table *)slapi_ch_calloc(1, sizeof(attr_atom_table));
+
+    t->aat_mask = size - 1;
+    t->aat_slots = (attr_atom_entry **)slapi_ch_calloc(size, sizeof(attr_atom_entry *));
+    return t;
+}
+
+static void
+attr_atom_table_put(attr_atom_table *t, attr_atom_entry *e)
+{
+    size_t i;
+
+    for (i = e->aae_hash & t->aat_mask; t->aat_slots[i] != NULL; i = (i + 1) & t->aat_mask)
+        ;
+    __atomic_store_n(&t->aat_slots[i], e, __ATOMIC_RELEASE);
+    t->aat_count++;
+}
+
+/*
+ * Return the atom of an attribute type name, 0 if the name is not interned.
+ * The name must not contain options: "cn;lang-fr" is never interned.
+ */
+uint32_t
+attr_atom_get(const char *name)
+{
+    attr_atom_table *t = __atomic_load_n(&attr_atom_current, __ATOMIC_ACQUIRE);
+    attr_atom_entry *e = NULL;
+
+    if (t == NULL || name == NULL) {
+        return 0;
+    }
+    e = attr_atom_find(t, name, attr_atom_hash(name));
+    return e ? e->aae_atom : 0;
+}
+
+/*
+ * Return the atom of an attribute type name, giving it one if needed.
+ * Only called for the names of the schema attribute types.
+ */
+uint32_t
+attr_atom_intern(const char *name)
+{
+    uint64_t hash;
+    attr_atom_table *t = NULL;
+    attr_atom_entry *e = NULL;
+    size_t len;
+
+    if (name == NULL) {
+        return 0;
+    }
+    hash = attr_atom_hash(name);
+    pthread_mutex_lock(&attr_atom_lock);
+    t = attr_atom_current;
+    if (t && (e = attr_atom_find(t, name, hash)) != NULL) {
+        pthread_mutex_unlock(&attr_atom_lock);
+        return e->aae_atom;
+    }
+    if (t == NULL || (t->aat_count + 1) * 2 > t->aat_mask + 1) {
+        /* keep the table at most half full */
+        attr_atom_table *newt = attr_atom_table_new(t ? (t->aat_mask + 1) * 2 : ATTR_ATOM_TABLE_MINSIZE);
+
+        for (size_t i = 0; t && i <= t->aat_mask; i++) {
+            if (t->aat_slots[i]) {
+                attr_atom_table_put(newt, t->aat_slots[i]);
+            }
+        }
+        newt->aat_prev = t;
+        __atomic_store_n(&attr_atom_current, newt, __ATOMIC_RELEASE);
+        t = newt;
+    }
+    len = strlen(name);
+    e = (attr_atom_entry *)slapi_ch_malloc(sizeof(attr_atom_entry) + len);
+    e->aae_hash = hash;
+    e->aae_atom = ++attr_atom_last;
+    memcpy(e->aae_name, name, len + 1);
+    attr_atom_table_put(t, e);
+    pthread_mutex_unlock(&attr_atom_lock);
+
+    return e->aae_atom;
+}
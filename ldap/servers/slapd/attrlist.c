@@ -14,6 +14,20 @@
 
 #include "slap.h"
 
+/*
+ * Compare the type of an attribute with a type name, atom is the atom of
+ * the name (0 if it is not interned, see attratom.c).  An attribute with an
+ * atom has an interned type so it can only match the same atom.
+ */
+static inline int
+attrlist_type_match(const Slapi_Attr *a, const char *type, uint32_t atom)
+{
+    if (a->a_atom) {
+        return a->a_atom == atom;
+    }
+    return strcasecmp(a->a_type, type) == 0;
+}
+
 void
 attrlist_free(Slapi_Attr *alist)
 {
@@ -41,8 +55,9 @@ attrlist_find_or_create_locking_optional(Slapi_Attr **alist, const char *type, S
 {
     int rc = 0; /* found */
     if (*a == NULL) {
+        uint32_t atom = attr_atom_get(type);
         for (*a = alist; **a != NULL; *a = &(**a)->a_next) {
-            if (strcasecmp((**a)->a_type, type) == 0) {
+            if (attrlist_type_match(**a, type, atom)) {
                 break;
             }
         }
@@ -108,8 +123,10 @@ attrlist_merge_valuearray(Slapi_Attr **alist, const char *type, Slapi_Value **va
 Slapi_Attr *
 attrlist_find(Slapi_Attr *a, const char *type)
 {
+    uint32_t atom = attr_atom_get(type);
+
     for (; a != NULL; a = a->a_next) {
-        if (strcasecmp(a->a_type, type) == 0) {
+        if (attrlist_type_match(a, type, atom)) {
             return (a);
         }
     }
@@ -205,8 +222,10 @@ attrlist_remove(Slapi_Attr **attrs, const char *type)
 {
     Slapi_Attr **a;
     Slapi_Attr *save = NULL;
+    uint32_t atom = attr_atom_get(type);
+
     for (a = attrs; *a != NULL; a = &(*a)->a_next) {
-        if (strcasecmp((*a)->a_type, type) == 0) {
+        if (attrlist_type_match(*a, type, atom)) {
             break;
         }
     }
@@ -236,9 +255,10 @@ attrlist_delete(Slapi_Attr **attrs, const char *type)
 {
     Slapi_Attr **a;
     Slapi_Attr *save;
+    uint32_t atom = attr_atom_get(type);
 
     for (a = attrs; *a != NULL; a = &(*a)->a_next) {
-        if (strcasecmp((*a)->a_type, type) == 0) {
+        if (attrlist_type_match(*a, type, atom)) {
             break;
         }
     }
@@ -84,6 +84,410 @@ static void attr_syntax_print(void);
 #endif
 static int attr_syntax_init(void);
 
+/*
+ * Lock free lookups.
+ *
+ * Looking up an attribute type used to take the name2asi read lock and to
+ * increment the reference count of the syntax info, then to take the lock
+ * again to drop the reference in attr_syntax_return().  Every operation
+ * does many lookups and on large servers the cache lines of the lock and
+ * of the reference counts of the common attribute types bounce between
+ * the cpus.
+ *
+ * The content of name2asi and oid2asi is now also published as an
+ * immutable snapshot, rebuilt by the first lookup following a change of
+ * the schema and swapped atomically.  Readers neither lock nor count
+ * references: a thread marks itself as reading in the current epoch until
+ * it returns the syntax info (asyntax_reader).  The syntax infos removed
+ * from the schema and the replaced snapshots are retired with a new epoch
+ * and freed once no thread reads in an older epoch.
+ *
+ * The hash tables and their locks are still used by the writers, to build
+ * the snapshots and for the schema reload (DSE_SCHEMA_LOCKED).
+ */
+typedef struct asyntax_snapshot_slot
+{
+    const char *asss_key; /* name, alias or oid, owned by the syntax info */
+    struct asyntaxinfo *asss_asi;
+} asyntax_snapshot_slot;
+
+typedef struct asyntax_snapshot_table
+{
+    size_t asst_mask; /* number of slots - 1 */
+    asyntax_snapshot_slot *asst_slots;
+} asyntax_snapshot_table;
+
+typedef struct asyntax_snapshot
+{
+    uint64_t ass_gen; /* asyntax_gen when the snapshot was built */
+    asyntax_snapshot_table ass_names;
+    asyntax_snapshot_table ass_oids;
+} asyntax_snapshot;
+
+typedef struct asyntax_reader
+{
+    uint64_t asr_epoch;             /* epoch the thread reads in, 0 if it holds no syntax info */
+    int32_t asr_depth;              /* syntax infos held by the thread */
+    int32_t asr_pinned;             /* attr_syntax_pin() nesting */
+    int32_t asr_locked;             /* attr_syntax_pin() took the read lock */
+    int32_t asr_free;               /* the thread exited, the record may be reused */
+    asyntax_snapshot *asr_snapshot; /* snapshot pinned by attr_syntax_pin() */
+    struct asyntax_reader *asr_next;
+} asyntax_reader;
+
+typedef struct asyntax_retired
+{
+    void *asre_ptr;
+    void (*asre_free)(void *);
+    uint64_t asre_epoch;
+    struct asyntax_retired *asre_next;
+} asyntax_retired;
+
+static asyntax_snapshot *asyntax_current = NULL;
+static uint64_t asyntax_gen = 1; /* incremented when name2asi or oid2asi change */
+static uint64_t asyntax_epoch = 1;
+static asyntax_reader *asyntax_readers = NULL;
+static asyntax_retired *asyntax_retired_list = NULL;
+/* protects asyntax_readers and asyntax_retired_list */
+static pthread_mutex_t asyntax_reader_lock = PTHREAD_MUTEX_INITIALIZER;
+/* serializes the snapshot builders */
+static pthread_mutex_t asyntax_snapshot_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t asyntax_reader_key;
+static pthread_once_t asyntax_reader_once = PTHREAD_ONCE_INIT;
+
+static void
+asyntax_reader_release(void *arg)
+{
+    asyntax_reader *r = (asyntax_reader *)arg;
+
+    /* the exiting thread cannot use its syntax infos anymore */
+    r->asr_depth = 0;
+    r->asr_pinned = 0;
+    r->asr_locked = 0;
+    r->asr_snapshot = NULL;
+    __atomic_store_n(&r->asr_epoch, 0, __ATOMIC_RELEASE);
+    pthread_mutex_lock(&asyntax_reader_lock);
+    r->asr_free = 1;
+    pthread_mutex_unlock(&asyntax_reader_lock);
+}
+
+static void
+asyntax_reader_key_create(void)
+{
+    if (pthread_key_create(&asyntax_reader_key, asyntax_reader_release) != 0) {
+        slapi_log_err(SLAPI_LOG_CRIT, "asyntax_reader_key_create",
+                      "Failed to create the attribute syntax reader thread key\n");
+    }
+}
+
+/* Return the reader record of the calling thread */
+static asyntax_reader *
+asyntax_reader_self(void)
+{
+    asyntax_reader *r = NULL;
+
+    pthread_once(&asyntax_reader_once, asyntax_reader_key_create);
+    r = (asyntax_reader *)pthread_getspecific(asyntax_reader_key);
+    if (r == NULL) {
+        pthread_mutex_lock(&asyntax_reader_lock);
+        for (r = asyntax_readers; r && !r->asr_free; r = r->asr_next)
+            ;
+        if (r) {
+            r->asr_free = 0;
+        } else {
+            r = (asyntax_reader *)slapi_ch_calloc(1, sizeof(asyntax_reader));
+            r->asr_next = asyntax_readers;
+            asyntax_readers = r;
+        }
+        pthread_mutex_unlock(&asyntax_reader_lock);
+        pthread_setspecific(asyntax_reader_key, r);
+    }
+    return r;
+}
+
+/* Free the retired objects no thread can still be reading */
+static void
+asyntax_reclaim(void)
+{
+    asyntax_retired *tofree = NULL;
+    asyntax_retired **prev = NULL;
+    uint64_t oldest = UINT64_MAX;
+
+    if (pthread_mutex_trylock(&asyntax_reader_lock) != 0) {
+        /* someone else is at it */
+        return;
+    }
+    for (asyntax_reader *r = asyntax_readers; r; r = r->asr_next) {
+        uint64_t epoch = __atomic_load_n(&r->asr_epoch, __ATOMIC_SEQ_CST);
+        if (epoch && epoch < oldest) {
+            oldest = epoch;
+        }
+    }
+    for (prev = &asyntax_retired_list; *prev;) {
+        asyntax_retired *re = *prev;
+        if (re->asre_epoch <= oldest) {
+            *prev = re->asre_next;
+            re->asre_next = tofree;
+            tofree = re;
+        } else {
+            prev = &re->asre_next;
+        }
+    }
+    pthread_mutex_unlock(&asyntax_reader_lock);
+
+    while (tofree) {
+        asyntax_retired *next = tofree->asre_next;
+        tofree->asre_free(tofree->asre_ptr);
+        slapi_ch_free((void **)&tofree);
+        tofree = next;
+    }
+}
+
+/*
+ * Free an object once the threads reading when it was removed are done.
+ * The object must not be reachable from the tables or the current
+ * snapshot anymore.
+ */
+static void
+asyntax_retire(void *ptr, void (*free_fn)(void *))
+{
+    asyntax_retired *re = (asyntax_retired *)slapi_ch_malloc(sizeof(asyntax_retired));
+
+    re->asre_ptr = ptr;
+    re->asre_free = free_fn;
+    pthread_mutex_lock(&asyntax_reader_lock);
+    re->asre_epoch = __atomic_add_fetch(&asyntax_epoch, 1, __ATOMIC_SEQ_CST);
+    re->asre_next = asyntax_retired_list;
+    asyntax_retired_list = re;
+    pthread_mutex_unlock(&asyntax_reader_lock);
+    asyntax_reclaim();
+}
+
+/*
+ * Number of retired syntax infos and snapshots not freed yet because a
+ * thread may still read them.
+ */
+size_t
+attr_syntax_retired_pending(void)
+{
+    size_t count = 0;
+
+    pthread_mutex_lock(&asyntax_reader_lock);
+    for (asyntax_retired *re = asyntax_retired_list; re; re = re->asre_next) {
+        count++;
+    }
+    pthread_mutex_unlock(&asyntax_reader_lock);
+    return count;
+}
+
+static void
+asyntax_free_asi(void *asi)
+{
+    attr_syntax_free((struct asyntaxinfo *)asi);
+}
+
+/* The thread starts holding a syntax info */
+static asyntax_reader *
+asyntax_read_begin(void)
+{
+    asyntax_reader *r = asyntax_reader_self();
+
+    if (r->asr_depth++ == 0) {
+        __atomic_store_n(&r->asr_epoch, __atomic_load_n(&asyntax_epoch, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    }
+    return r;
+}
+
+/* The thread gives back a syntax info */
+static void
+asyntax_read_end(asyntax_reader *r)
+{
+    if (r->asr_depth == 0) {
+        /* unbalanced attr_syntax_return() */
+        return;
+    }
+    if (--r->asr_depth == 0) {
+        __atomic_store_n(&r->asr_epoch, 0, __ATOMIC_RELEASE);
+        if (__atomic_load_n(&asyntax_retired_list, __ATOMIC_RELAXED)) {
+            asyntax_reclaim();
+        }
+    }
+}
+
+/* name2asi or oid2asi changed, the current snapshot is stale */
+static void
+asyntax_changed(void)
+{
+    __atomic_add_fetch(&asyntax_gen, 1, __ATOMIC_SEQ_CST);
+}
+
+/* FNV-1a of the lower cased key, the lookups are case insensitive like name2asi */
+static uint64_t
+asyntax_snapshot_hash(const char *key)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    for (const unsigned char *p = (const unsigned char *)key; *p; p++) {
+        h ^= TOLOWER(*p);
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static void
+asyntax_snapshot_table_init(asyntax_snapshot_table *t, size_t nentries)
+{
+    size_t size = 16;
+
+    while (size < nentries * 2) {
+        size <<= 1;
+    }
+    t->asst_mask = size - 1;
+    t->asst_slots = (asyntax_snapshot_slot *)slapi_ch_calloc(size, sizeof(asyntax_snapshot_slot));
+}
+
+static PRIntn
+asyntax_snapshot_table_add(PLHashEntry *he, PRIntn i __attribute__((unused)), void *arg)
+{
+    asyntax_snapshot_table *t = (asyntax_snapshot_table *)arg;
+    size_t slot;
+
+    for (slot = asyntax_snapshot_hash(he->key) & t->asst_mask; t->asst_slots[slot].asss_key; slot = (slot + 1) & t->asst_mask)
+        ;
+    t->asst_slots[slot].asss_key = (const char *)he->key;
+    t->asst_slots[slot].asss_asi = (struct asyntaxinfo *)he->value;
+    return HT_ENUMERATE_NEXT;
+}
+
+static struct asyntaxinfo *
+asyntax_snapshot_find(const asyntax_snapshot_table *t, const char *key)
+{
+    if (key == NULL) {
+        return NULL;
+    }
+    for (size_t slot = asyntax_snapshot_hash(key) & t->asst_mask; t->asst_slots[slot].asss_key; slot = (slot + 1) & t->asst_mask) {
+        if (strcasecmp(t->asst_slots[slot].asss_key, key) == 0) {
+            return t->asst_slots[slot].asss_asi;
+        }
+    }
+    return NULL;
+}
+
+static void
+asyntax_snapshot_free(void *arg)
+{
+    asyntax_snapshot *s = (asyntax_snapshot *)arg;
+
+    slapi_ch_free((void **)&s->ass_names.asst_slots);
+    slapi_ch_free((void **)&s->ass_oids.asst_slots);
+    slapi_ch_free((void **)&s);
+}
+
+/*
+ * Build and publish a snapshot of the tables if the current one is stale.
+ * The caller must not hold the attribute syntax locks.
+ */
+static asyntax_snapshot *
+asyntax_snapshot_refresh(void)
+{
+    asyntax_snapshot *s = NULL;
+    asyntax_snapshot *old = NULL;
+    uint64_t gen;
+
+    if (0 != attr_syntax_init()) {
+        return NULL;
+    }
+    /* the writers hold the write lock, the tables and gen cannot change */
+    AS_LOCK_READ(oid2asi_lock);
+    AS_LOCK_READ(name2asi_lock);
+    pthread_mutex_lock(&asyntax_snapshot_lock);
+    gen = __atomic_load_n(&asyntax_gen, __ATOMIC_SEQ_CST);
+    old = asyntax_current;
+    if (old && old->ass_gen == gen) {
+        /* built by another thread */
+        s = old;
+        old = NULL;
+    } else {
+        s = (asyntax_snapshot *)slapi_ch_calloc(1, sizeof(asyntax_snapshot));
+        s->ass_gen = gen;
+        asyntax_snapshot_table_init(&s->ass_names, name2asi->nentries);
+        PL_HashTableEnumerateEntries(name2asi, asyntax_snapshot_table_add, &s->ass_names);
+        asyntax_snapshot_table_init(&s->ass_oids, oid2asi->nentries);
+        PL_HashTableEnumerateEntries(oid2asi, asyntax_snapshot_table_add, &s->ass_oids);
+        __atomic_store_n(&asyntax_current, s, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&asyntax_snapshot_lock);
+    AS_UNLOCK_READ(name2asi_lock);
+    AS_UNLOCK_READ(oid2asi_lock);
+    if (old) {
+        asyntax_retire(old, asyntax_snapshot_free);
+    }
+    return s;
+}
+
+/*
+ * Return the snapshot to look up in, or NULL if the hash tables must be
+ * used.  use_lock is set if the caller does not hold the attribute syntax
+ * locks, a stale snapshot can then be rebuilt.
+ */
+static asyntax_snapshot *
+asyntax_snapshot_get(asyntax_reader *r, PRBool use_lock)
+{
+    asyntax_snapshot *s = __atomic_load_n(&asyntax_current, __ATOMIC_ACQUIRE);
+
+    if (s && s->ass_gen == __atomic_load_n(&asyntax_gen, __ATOMIC_ACQUIRE)) {
+        return s;
+    }
+    if (r->asr_snapshot) {
+        /* the caller pinned a view of the schema */
+        return r->asr_snapshot;
+    }
+    if (use_lock && oid2asi && name2asi) {
+        return asyntax_snapshot_refresh();
+    }
+    return NULL;
+}
+
+/*
+ * Pin the schema for a series of lookups (parsing an entry, checking a
+ * filter): until attr_syntax_unpin(), the lookups done without locking
+ * (use_lock set to PR_FALSE, attr_syntax_exist_by_name_nolock()) use the
+ * current snapshot.  Replaces attr_syntax_read_lock() for these callers.
+ */
+void
+attr_syntax_pin(void)
+{
+    asyntax_reader *r = asyntax_read_begin();
+
+    if (r->asr_pinned++ == 0) {
+        r->asr_snapshot = asyntax_snapshot_get(r, PR_TRUE);
+        if (r->asr_snapshot == NULL) {
+            /* no snapshot during the startup, lock the tables */
+            attr_syntax_read_lock();
+            r->asr_locked = 1;
+        }
+    }
+}
+
+void
+attr_syntax_unpin(void)
+{
+    asyntax_reader *r = asyntax_reader_self();
+
+    if (r->asr_pinned == 0) {
+        return;
+    }
+    if (--r->asr_pinned == 0) {
+        r->asr_snapshot = NULL;
+        if (r->asr_locked) {
+            r->asr_locked = 0;
+            attr_syntax_unlock_read();
+        }
+    }
+    asyntax_read_end(r);
+}
+
 struct asyntaxinfo *
 attr_syntax_get_global_at()
 {
@@ -183,11 +587,16 @@ attr_syntax_get_by_oid_locking_optional(const char *oid, PRBool use_lock, PRUint
     struct asyntaxinfo *asi = 0;
     PLHashTable *ht = oid2asi;
     int using_tmp_ht = 0;
+    asyntax_reader *r = asyntax_read_begin();
+    asyntax_snapshot *snap = NULL;
 
     if (schema_flags & DSE_SCHEMA_LOCKED) {
         ht = oid2asi_tmp;
         using_tmp_ht = 1;
         use_lock = 0;
+    } else if ((snap = asyntax_snapshot_get(r, use_lock)) != NULL) {
+        ht = NULL;
+        asi = asyntax_snapshot_find(&snap->ass_oids, oid);
     }
     if (ht) {
         if (use_lock) {
@@ -201,13 +610,13 @@ attr_syntax_get_by_oid_locking_optional(const char *oid, PRBool use_lock, PRUint
             ht = oid2asi;
         }
         asi = (struct asyntaxinfo *)PL_HashTableLookup_const(ht, oid);
-        if (asi) {
-            slapi_atomic_incr_64(&(asi->asi_refcnt), __ATOMIC_RELEASE);
-        }
         if (use_lock) {
             AS_UNLOCK_READ(oid2asi_lock);
         }
     }
+    if (asi == NULL) {
+        asyntax_read_end(r);
+    }
 
     return asi;
 }
@@ -233,6 +642,7 @@ attr_syntax_add_by_oid(const char *oid, struct asyntaxinfo *a, PRUint32 schema_f
         }
 
         PL_HashTableAdd(oid2asi, oid, a);
+        asyntax_changed();
 
         if (lock) {
             AS_UNLOCK_WRITE(oid2asi_lock);
@@ -280,11 +690,24 @@ attr_syntax_get_by_name_locking_optional(const char *name, PRBool use_lock, PRUi
     struct asyntaxinfo *asi = 0;
     PLHashTable *ht = name2asi;
     int using_tmp_ht = 0;
+    asyntax_reader *r = asyntax_read_begin();
+    asyntax_snapshot *snap = NULL;
 
     if (schema_flags & DSE_SCHEMA_LOCKED) {
         ht = name2asi_tmp;
         using_tmp_ht = 1;
         use_lock = 0;
+    } else if ((snap = asyntax_snapshot_get(r, use_lock)) != NULL) {
+        ht = NULL;
+        asi = asyntax_snapshot_find(&snap->ass_names, name);
+        if (asi == NULL) {
+            /* given name may be an OID */
+            asi = asyntax_snapshot_find(&snap->ass_oids, name);
+        }
+        if (asi == NULL) {
+            asyntax_read_end(r);
+        }
+        return asi;
     }
     if (ht) {
         if (use_lock) {
@@ -298,22 +721,22 @@ attr_syntax_get_by_name_locking_optional(const char *name, PRBool use_lock, PRUi
             ht = name2asi;
         }
         asi = (struct asyntaxinfo *)PL_HashTableLookup_const(ht, name);
-        if (NULL != asi) {
-            slapi_atomic_incr_64(&(asi->asi_refcnt), __ATOMIC_RELEASE);
-        }
         if (use_lock) {
             AS_UNLOCK_READ(name2asi_lock);
         }
     }
-    if (!asi) /* given name may be an OID */
+    if (!asi) { /* given name may be an OID */
+        asyntax_read_end(r);
         asi = attr_syntax_get_by_oid_locking_optional(name, use_lock, schema_flags);
+    }
 
     return asi;
 }
 
 /*
- * This assumes you have taken the attr_syntax read lock. Assert an attribute type
- * exists by name. 0 is false, 1 is true.
+ * This assumes you have taken the attr_syntax read lock or pinned the schema
+ * with attr_syntax_pin(). Assert an attribute type exists by name. 0 is false,
+ * 1 is true.
  *
  * The main reason to use this over attr_syntax_get_by_name_locking_optional is to
  * avoid the reference count increment/decrement cycle when we only need a boolean
@@ -324,6 +747,7 @@ attr_syntax_get_by_name_locking_optional(const char *name, PRBool use_lock, PRUi
 int32_t
 attr_syntax_exist_by_name_nolock(char *name) {
     struct asyntaxinfo *asi = NULL;
+    asyntax_reader *r = NULL;
     char *check_name = NULL;
     char *p = NULL;
     int free_attr = 0;
@@ -339,7 +763,12 @@ attr_syntax_exist_by_name_nolock(char *name) {
         check_name = name;
     }
 
-    asi = (struct asyntaxinfo *)PL_HashTableLookup_const(name2asi, check_name);
+    r = asyntax_reader_self();
+    if (r->asr_snapshot) {
+        asi = asyntax_snapshot_find(&r->asr_snapshot->ass_names, check_name);
+    } else {
+        asi = (struct asyntaxinfo *)PL_HashTableLookup_const(name2asi, check_name);
+    }
 
     if (free_attr) {
         slapi_ch_free_string(&check_name);
@@ -354,9 +783,8 @@ attr_syntax_exist_by_name_nolock(char *name) {
 
 /*
  * Give up a reference to an asi.
- * If the asi has been marked for delete, free it.  This would be a bit
- * easier if we could upgrade a read lock to a write one... but NSPR does
- * not support that paradigm.
+ * If the asi has been deleted from the schema meanwhile, it is freed once
+ * all the threads holding it have returned it (see asyntax_retire()).
  */
 void
 attr_syntax_return(struct asyntaxinfo *asi)
@@ -365,38 +793,11 @@ attr_syntax_return(struct asyntaxinfo *asi)
 }
 
 void
-attr_syntax_return_locking_optional(struct asyntaxinfo *asi, PRBool use_lock)
+attr_syntax_return_locking_optional(struct asyntaxinfo *asi, PRBool use_lock __attribute__((unused)))
 {
-    int locked = 0;
-    if (use_lock) {
-        AS_LOCK_READ(name2asi_lock);
-        locked = 1;
-    }
-    if (NULL != asi) {
-        PRBool delete_it = PR_FALSE;
-        if (0 == slapi_atomic_decr_64(&(asi->asi_refcnt), __ATOMIC_ACQ_REL)) {
-            delete_it = asi->asi_marked_for_delete;
-        }
-
-        if (delete_it) {
-            if (asi->asi_marked_for_delete) { /* one final check */
-                if (use_lock) {
-                    AS_UNLOCK_READ(name2asi_lock);
-                    AS_LOCK_WRITE(name2asi_lock);
-                }
-                /* ref count is 0 and it's flagged for
-                 * deletion, so it's safe to free now */
-                attr_syntax_remove(asi);
-                attr_syntax_free(asi);
-                if (use_lock) {
-                    AS_UNLOCK_WRITE(name2asi_lock);
-                    locked = 0;
-                }
-            }
-        }
-    }
-    if (locked) {
-        AS_UNLOCK_READ(name2asi_lock);
+    /* default_asi is never freed and not counted by attr_syntax_get_by_name_with_default() */
+    if (NULL != asi && asi != default_asi) {
+        asyntax_read_end(asyntax_reader_self());
     }
 }
 
@@ -442,6 +843,7 @@ attr_syntax_add_by_name(struct asyntaxinfo *a, PRUint32 schema_flags, int lock)
                 PL_HashTableAdd(name2asi, a->asi_aliases[i], a);
             }
         }
+        asyntax_changed();
 
         if (lock) {
             AS_UNLOCK_WRITE(name2asi_lock);
@@ -508,16 +910,12 @@ attr_syntax_delete_no_lock(struct asyntaxinfo *asi,
                 PL_HashTableRemove(ht, asi->asi_aliases[i]);
             }
         }
-        if (slapi_atomic_load_64(&(asi->asi_refcnt), __ATOMIC_ACQUIRE) > 0) {
-            asi->asi_marked_for_delete = PR_TRUE;
-        } else {
-            /* This is ok, but the correct thing is to call delete first,
-             * then to call return.  The last return will then take care of
-             * the free.  The only way this free would happen here is if
-             * you return the syntax before calling delete. */
-            attr_syntax_remove(asi);
-            attr_syntax_free(asi);
+        if (!using_tmp_ht) {
+            asyntax_changed();
         }
+        /* the threads holding the asi may still use it, it is freed once they returned it */
+        attr_syntax_remove(asi);
+        asyntax_retire(asi, asyntax_free_asi);
     }
 }
 
@@ -819,6 +1217,10 @@ attr_syntax_dup(struct asyntaxinfo *a)
     newas->asi_mr_ord_plugin = a->asi_mr_ord_plugin;
     newas->asi_mr_sub_plugin = a->asi_mr_sub_plugin;
     newas->asi_syntax_oid = slapi_ch_strdup(a->asi_syntax_oid);
+    newas->asi_atom = attr_atom_intern(newas->asi_name);
+    for (size_t i = 0; newas->asi_aliases && newas->asi_aliases[i]; i++) {
+        (void)attr_atom_intern(newas->asi_aliases[i]);
+    }
     newas->asi_next = NULL;
     newas->asi_prev = NULL;
 
@@ -1639,19 +2041,13 @@ attr_syntax_find(struct asyntaxinfo *at1, struct asyntaxinfo *at2)
 void
 attr_syntax_swap_ht()
 {
+    struct asyntaxinfo *old_at = global_at;
     struct asyntaxinfo *next;
 
     /* Remove the old hash tables */
     PL_HashTableDestroy(name2asi);
     PL_HashTableDestroy(oid2asi);
 
-    /* Free the global attr linked list */
-    while (global_at) {
-        next = global_at->asi_next;
-        attr_syntax_free(global_at);
-        global_at = next;
-    }
-
     /*
      * Swap the hash table/linked list pointers, and set the
      * temporary pointers to NULL
@@ -1662,4 +2058,17 @@ attr_syntax_swap_ht()
     oid2asi_tmp = NULL;
     global_at = global_at_tmp;
     global_at_tmp = NULL;
+    /*
+     * The current snapshot still refers to the old asi: make it stale
+     * before retiring them, so the threads starting to read after the
+     * retirement do not find them anymore.
+     */
+    asyntax_changed();
+
+    /* Free the old attr linked list, once the threads holding its asi returned them */
+    while (old_at) {
+        next = old_at->asi_next;
+        asyntax_retire(old_at, asyntax_free_asi);
+        old_at = next;
+    }
 }
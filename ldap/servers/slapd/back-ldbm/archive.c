@@ -264,6 +264,7 @@ ldbm_back_ldbm2archive(Slapi_PBlock *pb)
     struct ldbminfo *li;
     char *rawdirectory = NULL; /* -a <directory> */
     char *directory = NULL;    /* normalized */
+    char *base = NULL;         /* base archive of an incremental backup */
     char *dir_bak = NULL;
     int return_value = -1;
     int task_flags = 0;
@@ -311,6 +312,21 @@ ldbm_back_ldbm2archive(Slapi_PBlock *pb)
     /* Initialize directory */
     directory = rel2abspath(rawdirectory);
 
+    if (slapi_pblock_get_backup_base(pb)) {
+        base = rel2abspath(slapi_pblock_get_backup_base(pb));
+        /* the existing archive is renamed to .bak below */
+        if (slapd_comp_path(base, directory) == 0) {
+            slapi_log_err(SLAPI_LOG_ERR,
+                          "ldbm_back_ldbm2archive", "The base archive cannot be the archive directory.\n");
+            if (task) {
+                slapi_task_log_notice(task,
+                                      "The base archive cannot be the archive directory.");
+            }
+            return_value = -1;
+            goto out;
+        }
+    }
+
     if (stat(directory, &sbuf) == 0) {
         if (slapd_comp_path(directory, li->li_directory) == 0) {
             slapi_log_err(SLAPI_LOG_ERR,
@@ -406,7 +422,11 @@ ldbm_back_ldbm2archive(Slapi_PBlock *pb)
     }
 
     /* tell it to archive */
-    return_value = dblayer_backup(li, directory, task);
+    if (base) {
+        return_value = dblayer_backup_incremental(li, directory, base, task);
+    } else {
+        return_value = dblayer_backup(li, directory, task);
+    }
     if (return_value) {
         slapi_log_err(SLAPI_LOG_BACKLDBM,
                       "ldbm_back_ldbm2archive", "dblayer_backup failed (%d).\n", return_value);
@@ -481,6 +501,7 @@ out:
     }
 
     slapi_ch_free_string(&dir_bak);
+    slapi_ch_free_string(&base);
     slapi_ch_free_string(&directory);
     return return_value;
 }
@@ -662,6 +662,11 @@ struct ldbminfo
     int li_reslimit_allids_handle;        /* allids aka idlistscan */
     int li_pagedlookthroughlimit;
     int li_pagedallidsthreshold;
+    int li_pagedidlistbudget; /* max candidate IDs a paged search keeps between pages */
+    uint64_t li_sort_memory_limit; /* sort keys held in memory before spilling to disk */
+    int li_binary_entry_format;    /* write id2entry records in the binary entry format */
+    int li_id2entry_compression;   /* deflate id2entry records against a preset dictionary */
+    int li_scope_index;            /* scope subtree searches with the in memory scope index */
     int li_reslimit_pagedlookthrough_handle;
     int li_reslimit_pagedallids_handle; /* allids aka idlistscan */
     int li_rangelookthroughlimit;
@@ -836,6 +841,12 @@ typedef struct ldbm_instance
                                       * when they get added/removed from entry cache
                                       */
     Slapi_Regex *cache_debug_re;     /* Compiled version of cache_debug_pattern */
+    struct id2entry_dict *inst_id2entry_dict; /* preset dictionary of compressed id2entry records */
+    Slapi_Counter *inst_id2entry_rawbytes;    /* size of the compressed records before compression */
+    Slapi_Counter *inst_id2entry_packedbytes; /* size of the compressed records as stored */
+    Slapi_Counter *inst_id2entry_decodes;     /* number of records inflated */
+    Slapi_Counter *inst_id2entry_decode_ns;   /* time spent inflating them */
+    struct scope_index *inst_scope_index;     /* in memory tree of the ids, scopes subtree searches */
 } ldbm_instance;
 
 /*
@@ -856,8 +867,11 @@ typedef struct _back_search_result_set
     int sr_current_sizelimit;     /* Current sizelimit */
     Slapi_Filter *sr_norm_filter; /* search filter pre-normalized */
     Slapi_Filter *sr_norm_filter_intent; /* intended search filter pre-normalized */
+    ID sr_cursor_next;            /* paged results cursor: next ID to return */
+    struct sort_tail *sr_sort_tail; /* unsorted end of a partially sorted candidate list */
 } back_search_result_set;
 #define SR_FLAG_MUST_APPLY_FILTER_TEST 1 /* If set in sr_flags, means that we MUST apply the filter test */
+#define SR_FLAG_CURSOR 2                 /* candidates were released at a page end, rebuild them and resume at sr_cursor_next */
 
 #include "proto-back-ldbm.h"
 #include "ldbm_config.h"
@@ -1010,6 +1010,8 @@ cache_entry_size(struct backentry *e)
         size += slapi_entry_size(e->ep_vlventry);
     /* cannot size ep_mutexp (PRLock) */
     size += sizeof(struct backentry);
+    /* the normalized forms already attached are counted above */
+    value_normalized_uncharged();
     return size;
 }
 
@@ -1561,12 +1563,15 @@ entrycache_return(struct cache *cache, struct backentry **bep, PRBool locked)
     struct backentry *eflush = NULL;
     struct backentry *eflushtemp = NULL;
     struct backentry *e;
+    size_t norm_size;
 
     e = *bep;
     if (!e) {
         slapi_log_err(SLAPI_LOG_ERR, "entrycache_return", "Backentry is NULL\n");
         return;
     }
+    /* normalized forms attached to the values while the entry was used */
+    norm_size = value_normalized_uncharged();
     LOG("entrycache_return - (%s) entry count: %d, entry in cache:%ld\n",
         backentry_get_ndn(e), e->ep_refcnt, cache->c_stats.nentries);
 
@@ -1577,6 +1582,11 @@ entrycache_return(struct cache *cache, struct backentry **bep, PRBool locked)
         backentry_free(bep);
     } else {
         ASSERT(e->ep_refcnt > 0);
+        if (norm_size && !(e->ep_state & (ENTRY_STATE_DELETED | ENTRY_STATE_INVALID))) {
+            /* the entry is held, it is neither in the lru nor pinned */
+            e->ep_size += norm_size;
+            cache->c_stats.size += norm_size;
+        }
         if (!--e->ep_refcnt) {
             if (e->ep_state & (ENTRY_STATE_DELETED | ENTRY_STATE_INVALID)) {
                 const char *ndn = slapi_sdn_get_ndn(backentry_get_sdn(e));
@@ -995,14 +995,15 @@ bdb_index_producer(void *param)
 
         /* call post-entry plugin */
         plugin_call_entryfetch_plugins((char **)&data.dptr, &data.dsize);
+        id2entry_decompress_inplace(be, (char **)&data.dptr, &data.dsize);
 
         char *rdn = NULL;
 
-        /* rdn is allocated in get_value_from_string */
-        rc = get_value_from_string((const char *)data.dptr, "rdn", &rdn);
+        /* rdn is allocated in get_value_from_record */
+        rc = get_value_from_record((const char *)data.dptr, data.dsize, "rdn", &rdn);
         if (rc) {
             /* data.dptr may not include rdn: ..., try "dn: ..." */
-            e = slapi_str2entry(data.dptr, SLAPI_STR2ENTRY_NO_ENTRYDN);
+            e = slapi_record2entry(NULL, NULL, data.dptr, data.dsize, SLAPI_STR2ENTRY_NO_ENTRYDN);
             if (job->flags & FLAG_DN2RDN) {
                 int len = 0;
                 int options = SLAPI_DUMP_STATEINFO | SLAPI_DUMP_UNIQUEID |
@@ -1044,7 +1045,7 @@ bdb_index_producer(void *param)
                                   "bdb_index_producer", "entryrdn is not available; "
                                   "composing dn (rdn: %s, ID: %d)\n",
                                   rdn, temp_id);
-                    rc = get_value_from_string((const char *)data.dptr,
+                    rc = get_value_from_record((const char *)data.dptr, data.dsize,
                                                LDBM_PARENTID_STR, &pid_str);
                     if (rc) {
                         rc = 0; /* assume this is a suffix */
@@ -1091,8 +1092,8 @@ bdb_index_producer(void *param)
                               "and set to dn cache\n",
                               normdn);
             }
-            e = slapi_str2entry_ext(normdn, NULL, data.dptr,
-                                    SLAPI_STR2ENTRY_NO_ENTRYDN);
+            e = slapi_record2entry(normdn, NULL, data.dptr, data.dsize,
+                                   SLAPI_STR2ENTRY_NO_ENTRYDN);
             slapi_ch_free_string(&rdn);
             slapi_ch_free_string(&normdn);
         }
@@ -1560,6 +1561,7 @@ bdb_upgradedn_producer(void *param)
 
         /* call post-entry plugin */
         plugin_call_entryfetch_plugins((char **)&data.dptr, &data.dsize);
+        id2entry_decompress_inplace(be, (char **)&data.dptr, &data.dsize);
 
         slapi_ch_free_string(&ecopy);
         ecopy = (char *)slapi_ch_malloc(data.dsize + 1);
@@ -1571,12 +1573,12 @@ bdb_upgradedn_producer(void *param)
         rdn_bdb_has_spaces = 0;
         dn_in_cache = 0;
 
-        /* original rdn is allocated in get_value_from_string */
-        rc = get_value_from_string((const char *)data.dptr, "rdn", &rdn);
+        /* original rdn is allocated in get_value_from_record */
+        rc = get_value_from_record((const char *)data.dptr, data.dsize, "rdn", &rdn);
         if (rc) {
             /* data.dptr may not include rdn: ..., try "dn: ..." */
-            e = slapi_str2entry(data.dptr,
-                                SLAPI_STR2ENTRY_USE_OBSOLETE_DNFORMAT);
+            e = slapi_record2entry(NULL, NULL, data.dptr, data.dsize,
+                                   SLAPI_STR2ENTRY_USE_OBSOLETE_DNFORMAT);
         } else {
             bdn = dncache_find_id(&inst->inst_dncache, temp_id);
             if (bdn) {
@@ -1598,7 +1600,7 @@ bdb_upgradedn_producer(void *param)
                     slapi_log_err(SLAPI_LOG_TRACE, "bdb_upgradedn_producer",
                                   "entryrdn is not available; composing dn (rdn: %s, ID: %d)\n",
                                   rdn, temp_id);
-                    rc = get_value_from_string((const char *)data.dptr,
+                    rc = get_value_from_record((const char *)data.dptr, data.dsize,
                                                LDBM_PARENTID_STR, &pid_str);
                     if (rc) {
                         rc = 0; /* assume this is a suffix */
@@ -1656,8 +1658,8 @@ bdb_upgradedn_producer(void *param)
                     dn_in_cache = 1;
                 }
             }
-            e = slapi_str2entry_ext(normdn, NULL, data.dptr,
-                                    SLAPI_STR2ENTRY_USE_OBSOLETE_DNFORMAT);
+            e = slapi_record2entry(normdn, NULL, data.dptr, data.dsize,
+                                   SLAPI_STR2ENTRY_USE_OBSOLETE_DNFORMAT);
             slapi_ch_free_string(&rdn);
         }
 
@@ -1891,7 +1893,7 @@ bdb_upgradedn_producer(void *param)
                 }
 
                 /* dn syntax attr */
-                rc = get_values_from_string((const char *)ecopy,
+                rc = get_values_from_record((const char *)ecopy, data.dsize,
                                             a->a_type, &ud_vals);
                 if (rc || (NULL == ud_vals)) {
                     continue; /* empty; ignore it */
@@ -3695,8 +3697,9 @@ bdb_import_get_and_add_parent_rdns(ImportWorkerInfo *info,
                           "Failed to position at ID " ID_FMT "\n", id);
             return rc;
         }
-        /* rdn is allocated in get_value_from_string */
-        rc = get_value_from_string((const char *)data.dptr, "rdn", &rdn);
+        id2entry_decompress_inplace(inst->inst_be, (char **)&data.dptr, &data.dsize);
+        /* rdn is allocated in get_value_from_record */
+        rc = get_value_from_record((const char *)data.dptr, data.dsize, "rdn", &rdn);
         if (rc) {
             slapi_log_err(SLAPI_LOG_ERR, "bdb_import_get_and_add_parent_rdns",
                           "Failed to get rdn of entry " ID_FMT "\n", id);
@@ -3709,7 +3712,7 @@ bdb_import_get_and_add_parent_rdns(ImportWorkerInfo *info,
                           "Failed to add rdn %s of entry " ID_FMT "\n", rdn, id);
             goto bail;
         }
-        rc = get_value_from_string((const char *)data.dptr,
+        rc = get_value_from_record((const char *)data.dptr, data.dsize,
                                    LDBM_PARENTID_STR, &pid_str);
         if (rc) {
             rc = 0; /* assume this is a suffix */
@@ -3733,7 +3736,7 @@ bdb_import_get_and_add_parent_rdns(ImportWorkerInfo *info,
                           rdn, id);
             goto bail;
         }
-        e = slapi_str2entry_ext(normdn, NULL, data.dptr, SLAPI_STR2ENTRY_NO_ENTRYDN);
+        e = slapi_record2entry(normdn, NULL, data.dptr, data.dsize, SLAPI_STR2ENTRY_NO_ENTRYDN);
         (*curr_entry)++;
         rc = bdb_index_set_entry_to_fifo(info, e, id, total_id, *curr_entry);
         if (rc) {
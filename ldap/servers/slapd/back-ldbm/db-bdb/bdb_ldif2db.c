@@ -1055,17 +1055,18 @@ bdb_db2ldif(Slapi_PBlock *pb)
 
         /* call post-entry plugin */
         plugin_call_entryfetch_plugins((char **)&data.dptr, &data.dsize);
+        id2entry_decompress_inplace(be, (char **)&data.dptr, &data.dsize);
 
         ep = backentry_alloc();
 
         char *rdn = NULL;
 
-        /* rdn is allocated in get_value_from_string */
-        rc = get_value_from_string((const char *)data.dptr, "rdn", &rdn);
+        /* rdn is allocated in get_value_from_record */
+        rc = get_value_from_record((const char *)data.dptr, data.dsize, "rdn", &rdn);
         if (rc) {
             /* data.dptr may not include rdn: ..., try "dn: ..." */
-            ep->ep_entry = slapi_str2entry(data.dptr,
-                                           str2entry_options | SLAPI_STR2ENTRY_NO_ENTRYDN);
+            ep->ep_entry = slapi_record2entry(NULL, NULL, data.dptr, data.dsize,
+                                              str2entry_options | SLAPI_STR2ENTRY_NO_ENTRYDN);
         } else {
             char *pid_str = NULL;
             char *pdn = NULL;
@@ -1075,7 +1076,7 @@ bdb_db2ldif(Slapi_PBlock *pb)
             Slapi_RDN psrdn = {0};
 
             /* get a parent pid */
-            rc = get_value_from_string((const char *)data.dptr,
+            rc = get_value_from_record((const char *)data.dptr, data.dsize,
                                        LDBM_PARENTID_STR, &pid_str);
             if (rc) {
                 /* this could be a suffix or the RUV entry.
@@ -1195,8 +1196,8 @@ bdb_db2ldif(Slapi_PBlock *pb)
                                   dn);
                 }
             }
-            ep->ep_entry = slapi_str2entry_ext(dn, NULL, data.dptr,
-                                               str2entry_options | SLAPI_STR2ENTRY_NO_ENTRYDN);
+            ep->ep_entry = slapi_record2entry(dn, NULL, data.dptr, data.dsize,
+                                              str2entry_options | SLAPI_STR2ENTRY_NO_ENTRYDN);
             slapi_ch_free_string(&rdn);
         }
 
@@ -1627,17 +1628,18 @@ bdb_db2index(Slapi_PBlock *pb)
 
         /* call post-entry plugin */
         plugin_call_entryfetch_plugins((char **)&data.dptr, &data.dsize);
+        id2entry_decompress_inplace(be, (char **)&data.dptr, &data.dsize);
 
         ep = backentry_alloc();
         char *rdn = NULL;
         int rc = 0;
 
-        /* rdn is allocated in get_value_from_string */
-        rc = get_value_from_string((const char *)data.dptr, "rdn", &rdn);
+        /* rdn is allocated in get_value_from_record */
+        rc = get_value_from_record((const char *)data.dptr, data.dsize, "rdn", &rdn);
         if (rc) {
             /* data.dptr may not include rdn: ..., try "dn: ..." */
-            ep->ep_entry = slapi_str2entry(data.dptr,
-                                           SLAPI_STR2ENTRY_NO_ENTRYDN);
+            ep->ep_entry = slapi_record2entry(NULL, NULL, data.dptr, data.dsize,
+                                              SLAPI_STR2ENTRY_NO_ENTRYDN);
         } else {
             char *pid_str = NULL;
             char *pdn = NULL;
@@ -1647,7 +1649,7 @@ bdb_db2index(Slapi_PBlock *pb)
             Slapi_RDN psrdn = {0};
 
             /* get a parent pid */
-            rc = get_value_from_string((const char *)data.dptr,
+            rc = get_value_from_record((const char *)data.dptr, data.dsize,
                                        LDBM_PARENTID_STR, &pid_str);
             if (rc || !pid_str) {
                 /* see if this is a suffix or some entry without a parent id
@@ -1758,8 +1760,8 @@ bdb_db2index(Slapi_PBlock *pb)
                 }
             }
             slapi_rdn_done(&psrdn);
-            ep->ep_entry = slapi_str2entry_ext(dn, NULL, data.dptr,
-                                               SLAPI_STR2ENTRY_NO_ENTRYDN);
+            ep->ep_entry = slapi_record2entry(dn, NULL, data.dptr, data.dsize,
+                                              SLAPI_STR2ENTRY_NO_ENTRYDN);
             slapi_ch_free_string(&rdn);
         }
 
@@ -2769,8 +2771,9 @@ _get_and_add_parent_rdns(backend *be,
                           "Failed to position cursor at ID " ID_FMT "\n", id);
             goto bail;
         }
-        /* rdn is allocated in get_value_from_string */
-        rc = get_value_from_string((const char *)data.dptr, "rdn", &rdn);
+        id2entry_decompress_inplace(be, (char **)&data.dptr, &data.dsize);
+        /* rdn is allocated in get_value_from_record */
+        rc = get_value_from_record((const char *)data.dptr, data.dsize, "rdn", &rdn);
         if (rc) {
             slapi_log_err(SLAPI_LOG_ERR, "_get_and_add_parent_rdns",
                           "Failed to get rdn of entry " ID_FMT "\n", id);
@@ -2784,7 +2787,7 @@ _get_and_add_parent_rdns(backend *be,
             goto bail;
         }
         /* pid */
-        rc = get_value_from_string((const char *)data.dptr,
+        rc = get_value_from_record((const char *)data.dptr, data.dsize,
                                    LDBM_PARENTID_STR, &pid_str);
         if (rc) {
             rc = 0; /* assume this is a suffix */
@@ -2825,8 +2828,8 @@ _get_and_add_parent_rdns(backend *be,
                           rdn, id);
             goto bail;
         }
-        ep->ep_entry = slapi_str2entry_ext(dn, NULL, data.dptr,
-                                           SLAPI_STR2ENTRY_NO_ENTRYDN);
+        ep->ep_entry = slapi_record2entry(dn, NULL, data.dptr, data.dsize,
+                                          SLAPI_STR2ENTRY_NO_ENTRYDN);
         ep->ep_id = id;
         slapi_ch_free_string(&dn);
     }
@@ -118,6 +118,24 @@ bdb_monitor_instance_search(Slapi_PBlock *pb __attribute__((unused)),
     sprintf(buf, "%" PRId64, cstats.maxentries);
     MSET("maxDnCacheCount");
 
+    /* id2entry compression statistics */
+    {
+        uint64_t rawbytes = slapi_counter_get_value(inst->inst_id2entry_rawbytes);
+        uint64_t packedbytes = slapi_counter_get_value(inst->inst_id2entry_packedbytes);
+        uint64_t decodes = slapi_counter_get_value(inst->inst_id2entry_decodes);
+
+        sprintf(buf, "%" PRIu64, rawbytes);
+        MSET("id2entryUncompressedBytes");
+        sprintf(buf, "%" PRIu64, packedbytes);
+        MSET("id2entryCompressedBytes");
+        sprintf(buf, "%.2f", (double)rawbytes / (double)(packedbytes > 0 ? packedbytes : 1));
+        MSET("id2entryCompressionRatio");
+        sprintf(buf, "%" PRIu64, decodes);
+        MSET("id2entryDecompressions");
+        sprintf(buf, "%" PRIu64, slapi_counter_get_value(inst->inst_id2entry_decode_ns) / (decodes > 0 ? decodes : 1));
+        MSET("id2entryAverageDecompressTime");
+    }
+
 #ifdef DEBUG
     {
         /* debugging for hash statistics */
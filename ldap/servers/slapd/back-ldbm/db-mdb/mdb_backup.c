@@ -0,0 +1,639 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/* mdb_backup.c
+ *
+ * Streaming copy of the lmdb database used by the backups.
+ *
+ * mdb_env_copyfd() writes a consistent snapshot of the database in a
+ * pipe and the backup thread reads it back by chunks. The copy is not
+ * compacted so the stream has the same layout as data.mdb: chunk i is
+ * the database file at offset i * chunk size.
+ * Each chunk is hashed and the hashes are stored in the backup manifest.
+ * A full backup writes every chunk in data.mdb, an incremental backup
+ * only writes the chunks whose hash differs from the ones in the manifest
+ * of its base backup (the previous backup of the chain) in data.mdb.delta.
+ *
+ * The manifest of an incremental backup stores the path of its base
+ * backup relative to its own directory, so a chain of backups can be
+ * moved or copied elsewhere as a whole.
+ * The restore copies data.mdb from the full backup at the root of the
+ * chain then replays the deltas of the incremental backups in order.
+ *
+ * The read txn of mdb_env_copyfd() stays open for the whole copy, so the
+ * pages freed meanwhile can not be reused and data.mdb grows by the size
+ * of the updates done during the backup: a low nsslapd-mdb-backup-max-rate
+ * makes that window longer.
+ */
+
+#include "mdb_layer.h"
+#include <pk11pub.h>
+#include <hasht.h>
+
+#define BACKUP_MANIFEST_MAGIC "MDBBKMF1"
+#define BACKUP_DELTA_MAGIC "MDBBKDL1"
+#define BACKUP_BYTE_ORDER 0x01020304
+#define BACKUP_CHUNK_SIZE (64 * 1024)
+#define BACKUP_DIGEST_LEN 16 /* truncated sha256 */
+#define BACKUP_MAX_CHAIN 1000
+
+/* Header of both the manifest and the delta files */
+typedef struct
+{
+    char magic[8];
+    uint32_t byteorder;
+    uint32_t chunksize;
+    uint64_t size;     /* size of the database snapshot */
+    uint64_t id;       /* backup id */
+    uint64_t parentid; /* id of the base backup (0 for a full backup) */
+    uint32_t level;    /* 0 for a full backup, base backup level + 1 otherwise */
+    uint32_t parentlen; /* length of the base backup path (relative to the backup directory)
+                         * following the manifest header */
+} dbmdb_backup_hdr_t;
+
+typedef struct
+{
+    dbmdb_backup_hdr_t hdr;
+    char *parent;           /* base backup directory, relative to the backup directory */
+    unsigned char *digests; /* BACKUP_DIGEST_LEN bytes per chunk */
+    uint64_t nbchunks;
+} dbmdb_backup_manifest_t;
+
+typedef struct
+{
+    MDB_env *env;
+    int fd;
+    int rc;
+} dbmdb_backup_copier_t;
+
+
+static uint64_t
+dbmdb_backup_nbchunks(const dbmdb_backup_hdr_t *hdr)
+{
+    return (hdr->size + hdr->chunksize - 1) / hdr->chunksize;
+}
+
+/* read up to len bytes, returns the number of bytes read or -1 */
+static ssize_t
+dbmdb_backup_read_full(int fd, void *buf, size_t len)
+{
+    size_t done = 0;
+    ssize_t rc;
+
+    while (done < len) {
+        rc = read(fd, (char *)buf + done, len - done);
+        if (rc < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        if (rc == 0) {
+            break;
+        }
+        done += rc;
+    }
+    return done;
+}
+
+static int
+dbmdb_backup_write_full(int fd, const void *buf, size_t len)
+{
+    ssize_t rc;
+
+    while (len > 0) {
+        rc = write(fd, buf, len);
+        if (rc < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        buf = (const char *)buf + rc;
+        len -= rc;
+    }
+    return 0;
+}
+
+static void
+dbmdb_backup_manifest_free(dbmdb_backup_manifest_t *mf)
+{
+    slapi_ch_free_string(&mf->parent);
+    slapi_ch_free((void **)&mf->digests);
+    mf->nbchunks = 0;
+}
+
+static int
+dbmdb_backup_check_hdr(const dbmdb_backup_hdr_t *hdr, const char *magic)
+{
+    return (memcmp(hdr->magic, magic, sizeof hdr->magic) ||
+            hdr->byteorder != BACKUP_BYTE_ORDER ||
+            hdr->chunksize == 0) ? -1 : 0;
+}
+
+/*
+ * Read the manifest of a backup (the digests are only loaded if
+ * with_digests is set).
+ * Returns 0 if ok, 1 if the backup has no manifest and -1 on error.
+ */
+static int
+dbmdb_backup_read_manifest(const char *dir, dbmdb_backup_manifest_t *mf, int with_digests)
+{
+    char *path = slapi_ch_smprintf("%s/%s", dir, BACKUP_MANIFEST);
+    size_t len = 0;
+    int rc = -1;
+    int fd;
+
+    memset(mf, 0, sizeof *mf);
+    fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        rc = (errno == ENOENT) ? 1 : -1;
+        goto done;
+    }
+    if (dbmdb_backup_read_full(fd, &mf->hdr, sizeof mf->hdr) != sizeof mf->hdr ||
+        dbmdb_backup_check_hdr(&mf->hdr, BACKUP_MANIFEST_MAGIC)) {
+        goto done;
+    }
+    mf->parent = slapi_ch_calloc(1, mf->hdr.parentlen + 1);
+    if (dbmdb_backup_read_full(fd, mf->parent, mf->hdr.parentlen) != mf->hdr.parentlen) {
+        goto done;
+    }
+    if (with_digests) {
+        mf->nbchunks = dbmdb_backup_nbchunks(&mf->hdr);
+        len = mf->nbchunks * BACKUP_DIGEST_LEN;
+        mf->digests = (unsigned char *)slapi_ch_malloc(len ? len : 1);
+        if (dbmdb_backup_read_full(fd, mf->digests, len) != len) {
+            goto done;
+        }
+    }
+    rc = 0;
+done:
+    if (rc < 0) {
+        slapi_log_err(SLAPI_LOG_ERR, "dbmdb_backup_read_manifest",
+                      "Failed to read backup manifest %s.\n", path);
+        dbmdb_backup_manifest_free(mf);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    slapi_ch_free_string(&path);
+    return rc;
+}
+
+static int
+dbmdb_backup_write_manifest(struct ldbminfo *li, const char *dir, dbmdb_backup_manifest_t *mf)
+{
+    char *path = slapi_ch_smprintf("%s/%s", dir, BACKUP_MANIFEST);
+    int rc = -1;
+    int fd;
+
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, li->li_mode | 0400);
+    if (fd >= 0 &&
+        !dbmdb_backup_write_full(fd, &mf->hdr, sizeof mf->hdr) &&
+        !dbmdb_backup_write_full(fd, mf->parent, mf->hdr.parentlen) &&
+        !dbmdb_backup_write_full(fd, mf->digests, mf->nbchunks * BACKUP_DIGEST_LEN) &&
+        !fsync(fd)) {
+        rc = 0;
+    }
+    if (rc) {
+        slapi_log_err(SLAPI_LOG_ERR, "dbmdb_backup_write_manifest",
+                      "Failed to write backup manifest %s: %s.\n", path, strerror(errno));
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    slapi_ch_free_string(&path);
+    return rc;
+}
+
+/*
+ * Return the path of to_dir relative to from_dir (both existing
+ * directories), NULL if they can not be resolved.
+ */
+static char *
+dbmdb_backup_relpath(const char *from_dir, const char *to_dir)
+{
+    char from[PATH_MAX + 1];
+    char to[PATH_MAX + 1];
+    char *rel = NULL;
+    size_t common = 0;
+
+    if (realpath(from_dir, from) == NULL || realpath(to_dir, to) == NULL) {
+        return NULL;
+    }
+    /* the longest common leading components, '/' terminated */
+    if (strcmp(from, "/")) {
+        PL_strcatn(from, sizeof from, "/");
+    }
+    if (strcmp(to, "/")) {
+        PL_strcatn(to, sizeof to, "/");
+    }
+    for (size_t i = 0; from[i] && from[i] == to[i]; i++) {
+        if (from[i] == '/') {
+            common = i + 1;
+        }
+    }
+    rel = slapi_ch_strdup("");
+    for (const char *p = from + common; *p; p++) {
+        if (*p == '/') {
+            char *up = slapi_ch_smprintf("%s../", rel);
+            slapi_ch_free_string(&rel);
+            rel = up;
+        }
+    }
+    rel = slapi_ch_realloc(rel, strlen(rel) + strlen(to + common) + 2);
+    strcat(rel, to + common);
+    if (*rel == '\0') {
+        strcpy(rel, ".");
+    } else {
+        rel[strlen(rel) - 1] = '\0'; /* trailing '/' */
+    }
+    return rel;
+}
+
+/* Return the directory of the base backup of the backup in dir */
+static char *
+dbmdb_backup_parent_dir(const char *dir, const dbmdb_backup_manifest_t *mf)
+{
+    if (mf->parent[0] == '/') {
+        return slapi_ch_strdup(mf->parent);
+    }
+    return slapi_ch_smprintf("%s/%s", dir, mf->parent);
+}
+
+static void
+dbmdb_backup_copy_thread(void *arg)
+{
+    dbmdb_backup_copier_t *copier = (dbmdb_backup_copier_t *)arg;
+
+    copier->rc = mdb_env_copyfd(copier->env, copier->fd);
+    close(copier->fd);
+}
+
+/* Sleep enough to keep the backup below nsslapd-mdb-backup-max-rate */
+static void
+dbmdb_backup_throttle(uint64_t max_rate, uint64_t bytes, struct timespec *start)
+{
+    struct timespec now;
+    double elapsed;
+    double expected;
+
+    if (max_rate == 0) {
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    elapsed = (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+    expected = (double)bytes / (double)max_rate;
+    if (expected > elapsed) {
+        DS_Sleep(PR_MillisecondsToInterval((PRUint32)((expected - elapsed) * 1000)));
+    }
+}
+
+/*
+ * Copy the database in dest_dir: whole (data.mdb) if base_dir is NULL,
+ * or the chunks changed since the backup in base_dir (data.mdb.delta),
+ * then write the backup manifest.
+ */
+int
+dbmdb_backup_copy(struct ldbminfo *li, const char *dest_dir, const char *base_dir, Slapi_Task *task)
+{
+    dbmdb_ctx_t *ctx = MDB_CONFIG(li);
+    dbmdb_backup_manifest_t base = {0};
+    dbmdb_backup_manifest_t mf = {0};
+    dbmdb_backup_copier_t copier = {0};
+    PRThread *thread = NULL;
+    PK11Context *digestctx = NULL;
+    unsigned char digest[SHA256_LENGTH];
+    unsigned int digestlen = 0;
+    char *buf = NULL;
+    char *path = NULL;
+    uint64_t maxchunks = 0;
+    uint64_t nbwritten = 0;
+    uint64_t total = 0;
+    struct timespec start;
+    int pipefd[2] = {-1, -1};
+    int fd = -1;
+    int rc = 0;
+
+    if (base_dir) {
+        rc = dbmdb_backup_read_manifest(base_dir, &base, 1);
+        if (rc) {
+            slapi_log_err(SLAPI_LOG_ERR, "dbmdb_backup_copy",
+                          "%s is not a usable base backup (%s).\n", base_dir,
+                          rc > 0 ? "it has no backup manifest" : "unreadable backup manifest");
+            if (task) {
+                slapi_task_log_notice(task, "Backup: %s is not a usable base backup.", base_dir);
+            }
+            return -1;
+        }
+        mf.parent = dbmdb_backup_relpath(dest_dir, base_dir);
+        if (mf.parent == NULL) {
+            slapi_log_err(SLAPI_LOG_ERR, "dbmdb_backup_copy",
+                          "Failed to resolve the path of %s from %s: %s.\n",
+                          base_dir, dest_dir, strerror(errno));
+            dbmdb_backup_manifest_free(&base);
+            return -1;
+        }
+        mf.hdr.parentid = base.hdr.id;
+        mf.hdr.level = base.hdr.level + 1;
+        mf.hdr.parentlen = strlen(mf.parent);
+    }
+    memcpy(mf.hdr.magic, BACKUP_MANIFEST_MAGIC, sizeof mf.hdr.magic);
+    mf.hdr.byteorder = BACKUP_BYTE_ORDER;
+    mf.hdr.chunksize = BACKUP_CHUNK_SIZE;
+    mf.hdr.id = ((uint64_t)slapi_current_utc_time() << 32) | (uint32_t)slapi_rand();
+
+    path = slapi_ch_smprintf("%s/%s", dest_dir, base_dir ? DBDELTAFILE : DBMAPFILE);
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, li->li_mode | 0400);
+    if (fd < 0) {
+        slapi_log_err(SLAPI_LOG_ERR, "dbmdb_backup_copy", "Failed to open %s: %s.\n",
+                      path, strerror(errno));
+        rc = -1;
+        goto done;
+    }
+    if (base_dir) {
+        /* header is rewritten once the snapshot size is known */
+        dbmdb_backup_hdr_t hdr = mf.hdr;
+        memcpy(hdr.magic, BACKUP_DELTA_MAGIC, sizeof hdr.magic);
+        if (dbmdb_backup_write_full(fd, &hdr, sizeof hdr)) {
+            rc = -1;
+            goto done;
+        }
+    }
+    digestctx = PK11_CreateDigestContext(SEC_OID_SHA256);
+    if (digestctx == NULL || pipe(pipefd)) {
+        slapi_log_err(SLAPI_LOG_ERR, "dbmdb_backup_copy", "Failed to initialize the backup stream.\n");
+        rc = -1;
+        goto done;
+    }
+    copier.env = ctx->env;
+    copier.fd = pipefd[1];
+    thread = PR_CreateThread(PR_USER_THREAD, dbmdb_backup_copy_thread, &copier,
+                             PR_PRIORITY_NORMAL, PR_GLOBAL_THREAD,
+                             PR_JOINABLE_THREAD, SLAPD_DEFAULT_THREAD_STACKSIZE);
+    if (thread == NULL) {
+        PRErrorCode prerr = PR_GetError();
+        slapi_log_err(SLAPI_LOG_ERR, "dbmdb_backup_copy",
+                      "Unable to spawn backup thread, " SLAPI_COMPONENT_NAME_NSPR " error %d (%s)\n",
+                      prerr, slapd_pr_strerror(prerr));
+        close(pipefd[1]);
+        rc = -1;
+        goto done;
+    }
+
+    buf = slapi_ch_malloc(BACKUP_CHUNK_SIZE);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    while (1) {
+        ssize_t len = dbmdb_backup_read_full(pipefd[0], buf, BACKUP_CHUNK_SIZE);
+        uint64_t idx = mf.nbchunks;
+
+        if (len <= 0) {
+            if (len < 0 && !rc) {
+                rc = -1;
+            }
+            break;
+        }
+        total += len;
+        if (rc) {
+            /* keep draining the pipe so the copy thread can finish */
+            continue;
+        }
+        PK11_DigestBegin(digestctx);
+        PK11_DigestOp(digestctx, (unsigned char *)buf, len);
+        if (PK11_DigestFinal(digestctx, digest, &digestlen, sizeof digest) != SECSuccess) {
+            rc = -1;
+            continue;
+        }
+        if (mf.nbchunks >= maxchunks) {
+            maxchunks = maxchunks ? 2 * maxchunks : 1024;
+            mf.digests = (unsigned char *)slapi_ch_realloc((char *)mf.digests, maxchunks * BACKUP_DIGEST_LEN);
+        }
+        memcpy(&mf.digests[idx * BACKUP_DIGEST_LEN], digest, BACKUP_DIGEST_LEN);
+        mf.nbchunks++;
+
+        if (!base_dir) {
+            rc = dbmdb_backup_write_full(fd, buf, len);
+            nbwritten++;
+        } else if (idx >= base.nbchunks ||
+                   memcmp(&base.digests[idx * BACKUP_DIGEST_LEN], digest, BACKUP_DIGEST_LEN)) {
+            rc = dbmdb_backup_write_full(fd, &idx, sizeof idx) ||
+                 dbmdb_backup_write_full(fd, buf, len);
+            nbwritten++;
+        }
+        if (rc) {
+            slapi_log_err(SLAPI_LOG_ERR, "dbmdb_backup_copy", "Failed to write %s: %s.\n",
+                          path, strerror(errno));
+        }
+        dbmdb_backup_throttle(ctx->dsecfg.backup_max_rate, total, &start);
+    }
+    close(pipefd[0]);
+    pipefd[0] = -1;
+    PR_JoinThread(thread);
+    if (copier.rc) {
+        slapi_log_err(SLAPI_LOG_ERR, "dbmdb_backup_copy", "Failed to copy the database: %d: %s.\n",
+                      copier.rc, mdb_strerror(copier.rc));
+        rc = -1;
+    }
+    if (rc) {
+        goto done;
+    }
+
+    mf.hdr.size = total;
+    if (base_dir) {
+        dbmdb_backup_hdr_t hdr = mf.hdr;
+        memcpy(hdr.magic, BACKUP_DELTA_MAGIC, sizeof hdr.magic);
+        if (pwrite(fd, &hdr, sizeof hdr, 0) != sizeof hdr) {
+            rc = -1;
+            goto done;
+        }
+    }
+    if (fsync(fd)) {
+        rc = -1;
+        goto done;
+    }
+    rc = dbmdb_backup_write_manifest(li, dest_dir, &mf);
+    if (!rc) {
+        slapi_log_err(SLAPI_LOG_INFO, "dbmdb_backup_copy",
+                      "%s backup: wrote %" PRIu64 " of %" PRIu64 " chunks of %d bytes in %s.\n",
+                      base_dir ? "Incremental" : "Full", nbwritten, mf.nbchunks,
+                      BACKUP_CHUNK_SIZE, path);
+        if (task) {
+            slapi_task_log_notice(task, "%s backup: wrote %" PRIu64 " of %" PRIu64 " chunks of %d bytes.",
+                                  base_dir ? "Incremental" : "Full", nbwritten, mf.nbchunks,
+                                  BACKUP_CHUNK_SIZE);
+        }
+    }
+
+done:
+    if (pipefd[0] >= 0) {
+        close(pipefd[0]);
+    }
+    if (fd >= 0) {
+        close(fd);
+    }
+    if (digestctx) {
+        PK11_DestroyContext(digestctx, PR_TRUE);
+    }
+    slapi_ch_free_string(&buf);
+    slapi_ch_free_string(&path);
+    dbmdb_backup_manifest_free(&base);
+    dbmdb_backup_manifest_free(&mf);
+    return rc;
+}
+
+/* Replay the chunks of a delta file in the database file */
+static int
+dbmdb_restore_delta(struct ldbminfo *li, const char *src_dir, const dbmdb_backup_manifest_t *mf)
+{
+    char *src = slapi_ch_smprintf("%s/%s", src_dir, DBDELTAFILE);
+    char *dest = slapi_ch_smprintf("%s/%s", MDB_CONFIG(li)->home, DBMAPFILE);
+    dbmdb_backup_hdr_t hdr = {0};
+    char *buf = NULL;
+    uint64_t idx = 0;
+    ssize_t len = 0;
+    int srcfd = -1;
+    int destfd = -1;
+    int rc = -1;
+
+    srcfd = open(src, O_RDONLY);
+    destfd = open(dest, O_WRONLY);
+    if (srcfd < 0 || destfd < 0) {
+        slapi_log_err(SLAPI_LOG_ERR, "dbmdb_restore_delta", "Failed to open %s or %s: %s.\n",
+                      src, dest, strerror(errno));
+        goto done;
+    }
+    if (dbmdb_backup_read_full(srcfd, &hdr, sizeof hdr) != sizeof hdr ||
+        dbmdb_backup_check_hdr(&hdr, BACKUP_DELTA_MAGIC) ||
+        hdr.id != mf->hdr.id) {
+        slapi_log_err(SLAPI_LOG_ERR, "dbmdb_restore_delta",
+                      "%s does not match the backup manifest.\n", src);
+        goto done;
+    }
+    slapi_log_err(SLAPI_LOG_INFO, "dbmdb_restore_delta", "Applying %s\n", src);
+    buf = slapi_ch_malloc(hdr.chunksize);
+    while ((len = dbmdb_backup_read_full(srcfd, &idx, sizeof idx)) == sizeof idx) {
+        uint64_t offset = idx * hdr.chunksize;
+        size_t chunklen = hdr.chunksize;
+
+        if (offset >= hdr.size) {
+            len = -1;
+            break;
+        }
+        if (hdr.size - offset < chunklen) {
+            chunklen = hdr.size - offset;
+        }
+        if (dbmdb_backup_read_full(srcfd, buf, chunklen) != chunklen ||
+            pwrite(destfd, buf, chunklen, offset) != chunklen) {
+            len = -1;
+            break;
+        }
+    }
+    if (len != 0) {
+        slapi_log_err(SLAPI_LOG_ERR, "dbmdb_restore_delta", "Failed to apply %s: %s.\n",
+                      src, strerror(errno));
+        goto done;
+    }
+    if (ftruncate(destfd, hdr.size) || fsync(destfd)) {
+        slapi_log_err(SLAPI_LOG_ERR, "dbmdb_restore_delta", "Failed to resize %s: %s.\n",
+                      dest, strerror(errno));
+        goto done;
+    }
+    rc = 0;
+done:
+    if (srcfd >= 0) {
+        close(srcfd);
+    }
+    if (destfd >= 0) {
+        close(destfd);
+    }
+    slapi_ch_free_string(&buf);
+    slapi_ch_free_string(&src);
+    slapi_ch_free_string(&dest);
+    return rc;
+}
+
+static int
+dbmdb_restore_chain(struct ldbminfo *li, const char *src_dir, uint64_t expected_id, int depth, Slapi_Task *task)
+{
+    dbmdb_backup_manifest_t mf = {0};
+    char *parent = NULL;
+    char *src = NULL;
+    char *dest = NULL;
+    int rc = 0;
+
+    rc = dbmdb_backup_read_manifest(src_dir, &mf, 0);
+    if (rc < 0 || (expected_id && (rc > 0 || mf.hdr.id != expected_id))) {
+        slapi_log_err(SLAPI_LOG_ERR, "dbmdb_restore",
+                      "Backup %s is missing or does not match the incremental backup chain.\n", src_dir);
+        if (task) {
+            slapi_task_log_notice(task, "Restore: backup %s is missing or does not match the incremental backup chain.",
+                                  src_dir);
+        }
+        rc = -1;
+        goto done;
+    }
+    if (rc == 0 && mf.hdr.level > 0) {
+        /* incremental backup: restore its base then apply the delta */
+        if (depth >= BACKUP_MAX_CHAIN) {
+            slapi_log_err(SLAPI_LOG_ERR, "dbmdb_restore", "Incremental backup chain is too long.\n");
+            rc = -1;
+            goto done;
+        }
+        parent = dbmdb_backup_parent_dir(src_dir, &mf);
+        rc = dbmdb_restore_chain(li, parent, mf.hdr.parentid, depth + 1, task);
+        if (rc == 0) {
+            if (task) {
+                slapi_task_log_notice(task, "Restore: applying incremental backup %s", src_dir);
+            }
+            rc = dbmdb_restore_delta(li, src_dir, &mf);
+        }
+        goto done;
+    }
+
+    /* full backup */
+    src = slapi_ch_smprintf("%s/%s", src_dir, DBMAPFILE);
+    dest = slapi_ch_smprintf("%s/%s", MDB_CONFIG(li)->home, DBMAPFILE);
+    rc = dbmdb_copyfile(src, dest, PR_TRUE, li->li_mode);
+    if (rc) {
+        slapi_log_err(SLAPI_LOG_ERR,
+                      "dbmdb_restore", "Failed to copy database map file to %s.\n", dest);
+        if (task) {
+            slapi_task_log_notice(task, "Restore: Failed to copy database map file to %s.\n", dest);
+        }
+        rc = -1;
+    }
+done:
+    dbmdb_backup_manifest_free(&mf);
+    slapi_ch_free_string(&parent);
+    slapi_ch_free_string(&src);
+    slapi_ch_free_string(&dest);
+    return rc;
+}
+
+/* Restore the database file from a full or an incremental backup */
+int
+dbmdb_restore_mapfile(struct ldbminfo *li, const char *src_dir, Slapi_Task *task)
+{
+    return dbmdb_restore_chain(li, src_dir, 0, 0, task);
+}
+
+/* Tell whether src_dir contains an incremental backup */
+int
+dbmdb_backup_is_incremental(const char *src_dir)
+{
+    char *path = slapi_ch_smprintf("%s/%s", src_dir, DBDELTAFILE);
+    struct stat sbuf;
+    int rc = (stat(path, &sbuf) == 0);
+
+    slapi_ch_free_string(&path);
+    return rc;
+}
@@ -154,6 +154,8 @@ int mdb_init(struct ldbminfo *li, config_info *config_array)
     strncpy(conf->home, li->li_directory, MAXPATHLEN-1);
     pthread_mutex_init(&conf->dbis_lock, NULL);
     pthread_mutex_init(&conf->rcmutex, NULL);
+    pthread_mutex_init(&conf->gc_lock, NULL);
+    pthread_cond_init(&conf->gc_cv, NULL);
     pthread_rwlock_init(&conf->dbmdb_env_lock, NULL);
 
     dbmdb_ctx_t_setup_default(li);
@@ -167,6 +169,7 @@ int mdb_init(struct ldbminfo *li, config_info *config_array)
     priv->dblayer_close_fn = &dbmdb_close;
     priv->dblayer_instance_start_fn = &dbmdb_instance_start;
     priv->dblayer_backup_fn = &dbmdb_backup;
+    priv->dblayer_backup_incremental_fn = &dbmdb_backup_incremental;
     priv->dblayer_verify_fn = &dbmdb_verify;
     priv->dblayer_db_size_fn = &dbmdb_db_size;
     priv->dblayer_ldif2db_fn = &dbmdb_ldif2db;
@@ -178,6 +181,7 @@ int mdb_init(struct ldbminfo *li, config_info *config_array)
     priv->dblayer_restore_fn = &dbmdb_restore;
     priv->dblayer_txn_begin_fn = &dbmdb_txn_begin;
     priv->dblayer_txn_commit_fn = &dbmdb_txn_commit;
+    priv->dblayer_txn_sync_fn = &dbmdb_txn_sync;
     priv->dblayer_txn_abort_fn = &dbmdb_txn_abort;
     priv->dblayer_get_info_fn = &dbmdb_get_info;
     priv->dblayer_set_info_fn = &dbmdb_set_info;
@@ -499,6 +503,85 @@ dbmdb_ctx_t_db_import_stats_set(void *arg, void *value, char *errorbuf __attribu
     return retval;
 }
 
+static void *
+dbmdb_ctx_t_db_group_commit_get(void *arg)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+
+    return (void *)((uintptr_t)(MDB_CONFIG(li)->dsecfg.group_commit));
+}
+
+static int
+dbmdb_ctx_t_db_group_commit_set(void *arg, void *value, char *errorbuf __attribute__((unused)), int phase, int apply)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+    int retval = LDAP_SUCCESS;
+    int val = (int)((uintptr_t)value);
+
+    if (apply) {
+        MDB_CONFIG(li)->dsecfg.group_commit = val;
+        if (CONFIG_PHASE_RUNNING == phase) {
+            slapi_log_err(SLAPI_LOG_NOTICE, "dbmdb_ctx_t_db_group_commit_set",
+                          "New nsslapd-mdb-group-commit will not take effect until the server is restarted\n");
+        }
+    }
+
+    return retval;
+}
+
+static void *
+dbmdb_ctx_t_db_export_threads_get(void *arg)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+
+    return (void *)((uintptr_t)(MDB_CONFIG(li)->dsecfg.export_threads));
+}
+
+static int
+dbmdb_ctx_t_db_export_threads_set(void *arg, void *value, char *errorbuf, int phase __attribute__((unused)), int apply)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+    int retval = LDAP_SUCCESS;
+    int val = (int)((uintptr_t)value);
+
+    if (val < 0) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE,
+                              "Error: Invalid value for %s (%d). Must be 0 or greater\n",
+                              CONFIG_MDB_EXPORT_THREADS, val);
+        slapi_log_err(SLAPI_LOG_ERR, "dbmdb_ctx_t_db_export_threads_set",
+                      "Invalid value for %s (%d). Must be 0 or greater\n",
+                      CONFIG_MDB_EXPORT_THREADS, val);
+        return LDAP_UNWILLING_TO_PERFORM;
+    }
+    if (apply) {
+        MDB_CONFIG(li)->dsecfg.export_threads = val;
+    }
+
+    return retval;
+}
+
+static void *
+dbmdb_ctx_t_db_backup_max_rate_get(void *arg)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+
+    return (void *)((uintptr_t)(MDB_CONFIG(li)->dsecfg.backup_max_rate));
+}
+
+static int
+dbmdb_ctx_t_db_backup_max_rate_set(void *arg, void *value, char *errorbuf __attribute__((unused)), int phase __attribute__((unused)), int apply)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+    int retval = LDAP_SUCCESS;
+    uint64_t val = (uint64_t)((uintptr_t)value);
+
+    if (apply) {
+        MDB_CONFIG(li)->dsecfg.backup_max_rate = val;
+    }
+
+    return retval;
+}
+
 static int
 dbmdb_ctx_t_set_bypass_filter_test(void *arg,
                                    void *value,
@@ -612,6 +695,9 @@ static config_info dbmdb_ctx_t_param[] = {
     {CONFIG_MAXPASSBEFOREMERGE, CONFIG_TYPE_INT, "100", &dbmdb_ctx_t_maxpassbeforemerge_get, &dbmdb_ctx_t_maxpassbeforemerge_set, 0},
     {CONFIG_DB_DURABLE_TRANSACTIONS, CONFIG_TYPE_ONOFF, "on", &dbmdb_ctx_t_db_durable_transactions_get, &dbmdb_ctx_t_db_durable_transactions_set, CONFIG_FLAG_ALWAYS_SHOW},
     {CONFIG_MDB_IMPORT_STATS, CONFIG_TYPE_ONOFF, "off", &dbmdb_ctx_t_db_import_stats_get, &dbmdb_ctx_t_db_import_stats_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
+    {CONFIG_MDB_GROUP_COMMIT, CONFIG_TYPE_ONOFF, "off", &dbmdb_ctx_t_db_group_commit_get, &dbmdb_ctx_t_db_group_commit_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
+    {CONFIG_MDB_EXPORT_THREADS, CONFIG_TYPE_INT, "0", &dbmdb_ctx_t_db_export_threads_get, &dbmdb_ctx_t_db_export_threads_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
+    {CONFIG_MDB_BACKUP_MAX_RATE, CONFIG_TYPE_UINT64, "0", &dbmdb_ctx_t_db_backup_max_rate_get, &dbmdb_ctx_t_db_backup_max_rate_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
     {CONFIG_BYPASS_FILTER_TEST, CONFIG_TYPE_STRING, "on", &dbmdb_ctx_t_get_bypass_filter_test, &dbmdb_ctx_t_set_bypass_filter_test, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
     {CONFIG_SERIAL_LOCK, CONFIG_TYPE_ONOFF, "on", &dbmdb_ctx_t_serial_lock_get, &dbmdb_ctx_t_serial_lock_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
     {CONFIG_CACHE_AUTOSIZE, CONFIG_TYPE_INT, "25", &mdb_config_cache_autosize_get, &mdb_config_cache_autosize_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
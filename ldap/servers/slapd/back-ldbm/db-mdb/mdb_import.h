@@ -26,6 +26,7 @@
 typedef enum { IM_UNKNOWN, IM_IMPORT, IM_INDEX, IM_UPGRADE, IM_BULKIMPORT } ImportRole_t;
 
 typedef struct importctx ImportCtx_t;
+typedef struct dbmdb_bulkload dbmdb_bulkload_t;
 
 #define DNRC_IS_ENTRY(dnrc)  (((dnrc) & DNRC_ERROR) == 0)
 
@@ -150,6 +151,7 @@ struct importctx {
     ID idruv;
     int dupdn;
     int bulkq_state;
+    dbmdb_bulkload_t *bulkload; /* sorted runs of the naming records (entryrdn, ancestorid) */
 };
 
 /******************** Functions ********************/
@@ -181,3 +183,9 @@ void dbmdb_free_import_ctx(ImportJob *job);
 void dbmdb_build_import_index_list(ImportCtx_t *ctx);
 
 int is_reindexed_attr(const char *attrname, const ImportCtx_t *ctx, char **list);
+
+/* mdb_import_bulkload.c */
+dbmdb_bulkload_t *dbmdb_bulkload_new(ImportCtx_t *ctx);
+void dbmdb_bulkload_free(dbmdb_bulkload_t **bl);
+int dbmdb_bulkload_push(dbmdb_bulkload_t *bl, WriterQueueData_t *wqd);
+int dbmdb_bulkload_write(dbmdb_bulkload_t *bl);
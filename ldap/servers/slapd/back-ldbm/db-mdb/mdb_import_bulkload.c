@@ -0,0 +1,542 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/* mdb_import_bulkload.c
+ *
+ * Bulk loader for the entryrdn, redirect and ancestorid databases.
+ *
+ * These databases are truncated when an import (or a reindex of the
+ * naming attributes) starts, then they get one or more records per entry.
+ * The records come in entry id order which is random in the key order of
+ * the databases, so each put made by the writer thread lands on a
+ * different leaf page.
+ * Instead of going through the writer queue, the worker threads store
+ * these records in an in-memory run. When the run reaches the import
+ * index buffer size, it is sorted and spilled in a temporary file.
+ * Once all the entries are processed, the writer thread merges the runs
+ * and appends the records (MDB_APPEND/MDB_APPENDDUP) so that lmdb only
+ * fills the last leaf page of each database.
+ */
+
+#include "mdb_import.h"
+
+#define BULKLOAD_MIN_RUN_SIZE   (1024 * 1024)
+#define BULKLOAD_MAX_DBIS       3
+#define BULKLOAD_MAX_OPS_IN_TXN 100000
+
+/* Record header, followed by the key then the data */
+typedef struct
+{
+    uint32_t dbidx;
+    uint32_t keylen;
+    uint32_t datalen;
+} dbmdb_bulkload_hdr_t;
+
+/* A sorted run being merged: either a spilled file or the in-memory run */
+typedef struct
+{
+    FILE *fp;
+    const char *run;
+    const size_t *recs;
+    size_t nbrecs;
+    size_t pos;
+    char *buf;
+    size_t bufsize;
+    uint32_t dbidx;
+    MDB_val key;
+    MDB_val data;
+} dbmdb_bulkload_cursor_t;
+
+struct dbmdb_bulkload
+{
+    ImportCtx_t *ctx;
+    pthread_mutex_t mutex;
+    dbmdb_dbi_t *dbis[BULKLOAD_MAX_DBIS];
+    int nbdbis;
+    size_t maxsize;  /* memory used by a run before spilling it */
+    char *run;       /* records of the in-memory run */
+    size_t runsize;
+    size_t runalloc;
+    size_t *recs;    /* offset of the records in run */
+    size_t nbrecs;
+    size_t maxrecs;
+    FILE **files;    /* spilled runs */
+    int nbfiles;
+    uint64_t nbtotal;
+    int rc;
+};
+
+static int
+bulkload_rec_cmp(dbmdb_bulkload_t *bl, MDB_txn *txn, uint32_t idx1, MDB_val *key1, MDB_val *data1, uint32_t idx2, MDB_val *key2, MDB_val *data2)
+{
+    dbmdb_dbi_t *dbi = bl->dbis[idx1];
+    int rc;
+
+    if (idx1 != idx2) {
+        return (idx1 < idx2) ? -1 : 1;
+    }
+    rc = mdb_cmp(txn, dbi->dbi, key1, key2);
+    if (rc == 0 && (dbi->state.flags & MDB_DUPSORT)) {
+        rc = mdb_dcmp(txn, dbi->dbi, data1, data2);
+    }
+    return rc;
+}
+
+static void
+bulkload_get_rec(const char *run, size_t offset, uint32_t *dbidx, MDB_val *key, MDB_val *data)
+{
+    const dbmdb_bulkload_hdr_t *hdr = (const dbmdb_bulkload_hdr_t *)(run + offset);
+
+    *dbidx = hdr->dbidx;
+    key->mv_size = hdr->keylen;
+    key->mv_data = (void *)&hdr[1];
+    data->mv_size = hdr->datalen;
+    data->mv_data = ((char *)&hdr[1]) + hdr->keylen;
+}
+
+static int
+bulkload_offset_cmp(dbmdb_bulkload_t *bl, MDB_txn *txn, const char *run, size_t o1, size_t o2)
+{
+    MDB_val key1, data1, key2, data2;
+    uint32_t idx1, idx2;
+
+    bulkload_get_rec(run, o1, &idx1, &key1, &data1);
+    bulkload_get_rec(run, o2, &idx2, &key2, &data2);
+    return bulkload_rec_cmp(bl, txn, idx1, &key1, &data1, idx2, &key2, &data2);
+}
+
+/* Bottom-up merge sort of the record offsets of a run (using the dbi compare functions) */
+static void
+bulkload_sort_run(dbmdb_bulkload_t *bl, MDB_txn *txn, const char *run, size_t *recs, size_t nbrecs)
+{
+    size_t *tmp = (size_t *)slapi_ch_malloc(nbrecs * sizeof(size_t));
+    size_t *src = recs;
+    size_t *dst = tmp;
+    size_t width, lo, mid, hi, i, j, k;
+
+    for (width = 1; width < nbrecs; width *= 2) {
+        for (lo = 0; lo < nbrecs; lo += 2 * width) {
+            mid = (lo + width < nbrecs) ? lo + width : nbrecs;
+            hi = (lo + 2 * width < nbrecs) ? lo + 2 * width : nbrecs;
+            for (i = lo, j = mid, k = lo; k < hi; k++) {
+                if (i < mid && (j >= hi || bulkload_offset_cmp(bl, txn, run, src[i], src[j]) <= 0)) {
+                    dst[k] = src[i++];
+                } else {
+                    dst[k] = src[j++];
+                }
+            }
+        }
+        dst = src;
+        src = (src == recs) ? tmp : recs;
+    }
+    if (src != recs) {
+        memcpy(recs, src, nbrecs * sizeof(size_t));
+    }
+    slapi_ch_free((void **)&tmp);
+}
+
+static FILE *
+bulkload_tmpfile(dbmdb_bulkload_t *bl)
+{
+    char *path = slapi_ch_smprintf("%s/bulkload.XXXXXX", bl->ctx->ctx->home);
+    FILE *fp = NULL;
+    int fd = mkstemp(path);
+
+    if (fd >= 0) {
+        /* Nobody else needs the file so it is removed as soon as it is closed */
+        unlink(path);
+        fp = fdopen(fd, "w+");
+        if (!fp) {
+            close(fd);
+        }
+    }
+    slapi_ch_free_string(&path);
+    return fp;
+}
+
+/* Sort a run and write it in a temporary file */
+static int
+bulkload_spill_run(dbmdb_bulkload_t *bl, char *run, size_t *recs, size_t nbrecs, FILE **fpt)
+{
+    ImportJob *job = bl->ctx->job;
+    MDB_txn *txn = NULL;
+    FILE *fp = NULL;
+    const dbmdb_bulkload_hdr_t *hdr = NULL;
+    size_t i;
+    int rc;
+
+    *fpt = NULL;
+    rc = TXN_BEGIN(bl->ctx->ctx->env, NULL, MDB_RDONLY, &txn);
+    if (rc) {
+        import_log_notice(job, SLAPI_LOG_ERR, "bulkload_spill_run",
+                          "Failed to begin a database txn. Error %d: %s", rc, mdb_strerror(rc));
+        return rc;
+    }
+    bulkload_sort_run(bl, txn, run, recs, nbrecs);
+    TXN_ABORT(txn);
+
+    fp = bulkload_tmpfile(bl);
+    if (!fp) {
+        rc = errno;
+        import_log_notice(job, SLAPI_LOG_ERR, "bulkload_spill_run",
+                          "Failed to create a temporary file in %s. Error %d: %s",
+                          bl->ctx->ctx->home, rc, slapd_system_strerror(rc));
+        return rc ? rc : -1;
+    }
+    for (i = 0; i < nbrecs; i++) {
+        hdr = (const dbmdb_bulkload_hdr_t *)(run + recs[i]);
+        if (fwrite(hdr, sizeof(*hdr) + hdr->keylen + hdr->datalen, 1, fp) != 1) {
+            break;
+        }
+    }
+    if (i < nbrecs || fflush(fp)) {
+        rc = errno;
+        import_log_notice(job, SLAPI_LOG_ERR, "bulkload_spill_run",
+                          "Failed to write a temporary file in %s. Error %d: %s",
+                          bl->ctx->ctx->home, rc, slapd_system_strerror(rc));
+        fclose(fp);
+        return rc ? rc : -1;
+    }
+    *fpt = fp;
+    return 0;
+}
+
+dbmdb_bulkload_t *
+dbmdb_bulkload_new(ImportCtx_t *ctx)
+{
+    dbmdb_bulkload_t *bl = (dbmdb_bulkload_t *)slapi_ch_calloc(1, sizeof(dbmdb_bulkload_t));
+    MdbIndexInfo_t *mii[] = { ctx->entryrdn, ctx->redirect, ctx->ancestorid };
+    int i;
+
+    bl->ctx = ctx;
+    pthread_mutex_init(&bl->mutex, NULL);
+    for (i = 0; i < BULKLOAD_MAX_DBIS; i++) {
+        if (mii[i] && mii[i]->dbi) {
+            bl->dbis[bl->nbdbis++] = mii[i]->dbi;
+        }
+    }
+    bl->maxsize = ctx->job->job_index_buffer_size;
+    if (bl->maxsize < BULKLOAD_MIN_RUN_SIZE) {
+        bl->maxsize = BULKLOAD_MIN_RUN_SIZE;
+    }
+    return bl;
+}
+
+void
+dbmdb_bulkload_free(dbmdb_bulkload_t **bl)
+{
+    int i;
+
+    if (*bl) {
+        for (i = 0; i < (*bl)->nbfiles; i++) {
+            fclose((*bl)->files[i]);
+        }
+        slapi_ch_free((void **)&(*bl)->files);
+        slapi_ch_free((void **)&(*bl)->run);
+        slapi_ch_free((void **)&(*bl)->recs);
+        pthread_mutex_destroy(&(*bl)->mutex);
+        slapi_ch_free((void **)bl);
+    }
+}
+
+/*
+ * Store a record in the current run if it belongs to one of the bulk
+ * loaded databases.
+ * Returns 1 if the record is handled by the bulk loader and 0 if it should
+ * go through the writer queue.
+ */
+int
+dbmdb_bulkload_push(dbmdb_bulkload_t *bl, WriterQueueData_t *wqd)
+{
+    dbmdb_bulkload_hdr_t *hdr = NULL;
+    size_t len = sizeof(dbmdb_bulkload_hdr_t) + wqd->key.mv_size + wqd->data.mv_size;
+    char *run = NULL;
+    size_t *recs = NULL;
+    size_t nbrecs = 0;
+    FILE *fp = NULL;
+    int idx;
+    int rc;
+
+    for (idx = 0; idx < bl->nbdbis && bl->dbis[idx] != wqd->dbi; idx++);
+    if (idx >= bl->nbdbis) {
+        return 0;
+    }
+    len = LONGALIGN(len);
+
+    pthread_mutex_lock(&bl->mutex);
+    if (bl->rc) {
+        /* The import is going to fail anyway */
+        pthread_mutex_unlock(&bl->mutex);
+        return 1;
+    }
+    if (bl->runsize + len > bl->runalloc) {
+        bl->runalloc = bl->runalloc ? 2 * bl->runalloc : BULKLOAD_MIN_RUN_SIZE;
+        if (bl->runalloc < bl->runsize + len) {
+            bl->runalloc = bl->runsize + len;
+        }
+        bl->run = slapi_ch_realloc(bl->run, bl->runalloc);
+    }
+    if (bl->nbrecs >= bl->maxrecs) {
+        bl->maxrecs = bl->maxrecs ? 2 * bl->maxrecs : 1024;
+        bl->recs = (size_t *)slapi_ch_realloc((char *)bl->recs, bl->maxrecs * sizeof(size_t));
+    }
+    hdr = (dbmdb_bulkload_hdr_t *)(bl->run + bl->runsize);
+    hdr->dbidx = idx;
+    hdr->keylen = wqd->key.mv_size;
+    hdr->datalen = wqd->data.mv_size;
+    memcpy(&hdr[1], wqd->key.mv_data, wqd->key.mv_size);
+    memcpy(((char *)&hdr[1]) + wqd->key.mv_size, wqd->data.mv_data, wqd->data.mv_size);
+    bl->recs[bl->nbrecs++] = bl->runsize;
+    bl->runsize += len;
+    bl->nbtotal++;
+
+    if (bl->runsize + bl->nbrecs * sizeof(size_t) < bl->maxsize) {
+        pthread_mutex_unlock(&bl->mutex);
+        return 1;
+    }
+    /* The run is full: detach it and spill it without holding the lock */
+    run = bl->run;
+    recs = bl->recs;
+    nbrecs = bl->nbrecs;
+    bl->run = NULL;
+    bl->recs = NULL;
+    bl->runsize = bl->runalloc = 0;
+    bl->nbrecs = bl->maxrecs = 0;
+    pthread_mutex_unlock(&bl->mutex);
+
+    rc = bulkload_spill_run(bl, run, recs, nbrecs, &fp);
+    slapi_ch_free((void **)&run);
+    slapi_ch_free((void **)&recs);
+
+    pthread_mutex_lock(&bl->mutex);
+    if (rc) {
+        bl->rc = rc;
+    } else {
+        bl->files = (FILE **)slapi_ch_realloc((char *)bl->files, (bl->nbfiles + 1) * sizeof(FILE *));
+        bl->files[bl->nbfiles++] = fp;
+    }
+    pthread_mutex_unlock(&bl->mutex);
+    return 1;
+}
+
+/* Move a cursor to its next record. Returns 0 if positioned, MDB_NOTFOUND at the end of the run */
+static int
+bulkload_cursor_next(dbmdb_bulkload_cursor_t *cur)
+{
+    dbmdb_bulkload_hdr_t hdr = {0};
+    size_t len;
+
+    if (!cur->fp) {
+        if (cur->pos >= cur->nbrecs) {
+            return MDB_NOTFOUND;
+        }
+        bulkload_get_rec(cur->run, cur->recs[cur->pos++], &cur->dbidx, &cur->key, &cur->data);
+        return 0;
+    }
+    if (fread(&hdr, sizeof(hdr), 1, cur->fp) != 1) {
+        return ferror(cur->fp) ? (errno ? errno : -1) : MDB_NOTFOUND;
+    }
+    len = hdr.keylen + hdr.datalen;
+    if (len > cur->bufsize) {
+        cur->bufsize = len;
+        cur->buf = slapi_ch_realloc(cur->buf, len);
+    }
+    if (len && fread(cur->buf, len, 1, cur->fp) != 1) {
+        return ferror(cur->fp) ? (errno ? errno : -1) : EINVAL;
+    }
+    cur->dbidx = hdr.dbidx;
+    cur->key.mv_size = hdr.keylen;
+    cur->key.mv_data = cur->buf;
+    cur->data.mv_size = hdr.datalen;
+    cur->data.mv_data = cur->buf + hdr.keylen;
+    return 0;
+}
+
+static int
+bulkload_cursor_cmp(dbmdb_bulkload_t *bl, MDB_txn *txn, dbmdb_bulkload_cursor_t *c1, dbmdb_bulkload_cursor_t *c2)
+{
+    return bulkload_rec_cmp(bl, txn, c1->dbidx, &c1->key, &c1->data, c2->dbidx, &c2->key, &c2->data);
+}
+
+/* Restore the min-heap property from position i */
+static void
+bulkload_heap_down(dbmdb_bulkload_t *bl, MDB_txn *txn, dbmdb_bulkload_cursor_t **heap, int nb, int i)
+{
+    dbmdb_bulkload_cursor_t *cur = heap[i];
+    int child;
+
+    while ((child = 2 * i + 1) < nb) {
+        if (child + 1 < nb && bulkload_cursor_cmp(bl, txn, heap[child + 1], heap[child]) < 0) {
+            child++;
+        }
+        if (bulkload_cursor_cmp(bl, txn, cur, heap[child]) <= 0) {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
+    }
+    heap[i] = cur;
+}
+
+static int
+bulkload_put(dbmdb_bulkload_t *bl, MDB_txn *txn, dbmdb_bulkload_cursor_t *cur, int samekey)
+{
+    dbmdb_dbi_t *dbi = bl->dbis[cur->dbidx];
+    int flags = (samekey && (dbi->state.flags & MDB_DUPSORT)) ? MDB_APPENDDUP : MDB_APPEND;
+    int rc = MDB_PUT(txn, dbi->dbi, &cur->key, &cur->data, flags);
+
+    if (rc == MDB_KEYEXIST) {
+        /* Duplicate record (or a key replaced by a later one): use a normal put */
+        rc = MDB_PUT(txn, dbi->dbi, &cur->key, &cur->data, 0);
+    }
+    if (rc) {
+        slapi_log_err(SLAPI_LOG_ERR, "dbmdb_bulkload_write",
+                      "Failed to write record in dbi %s. Error is 0x%x: %s.\n",
+                      dbi->dbname, rc, mdb_strerror(rc));
+        slapi_log_hexadump(SLAPI_LOG_ERR, "dbmdb_bulkload_write:key",
+                           cur->key.mv_data, cur->key.mv_size);
+        slapi_log_hexadump(SLAPI_LOG_ERR, "dbmdb_bulkload_write:data",
+                           cur->data.mv_data, cur->data.mv_size);
+    }
+    return rc;
+}
+
+/*
+ * Merge the runs and append their records in the databases.
+ * Called by the writer thread once the writer queue is drained
+ * and the worker threads are finished.
+ */
+int
+dbmdb_bulkload_write(dbmdb_bulkload_t *bl)
+{
+    ImportJob *job = bl->ctx->job;
+    dbmdb_bulkload_cursor_t *cursors = NULL;
+    dbmdb_bulkload_cursor_t **heap = NULL;
+    dbmdb_bulkload_cursor_t *cur = NULL;
+    MDB_txn *txn = NULL;
+    char *lastkey = NULL;
+    size_t lastkeysize = 0;
+    size_t lastkeyalloc = 0;
+    uint32_t lastidx = BULKLOAD_MAX_DBIS;
+    MDB_val last = {0};
+    int samekey = 0;
+    int count = 0;
+    int nb = 0;
+    int i;
+    int rc = bl->rc;
+
+    if (rc || bl->nbtotal == 0) {
+        return rc;
+    }
+    import_log_notice(job, SLAPI_LOG_INFO, "dbmdb_bulkload_write",
+                      "Loading %" PRIu64 " naming records from %d sorted runs.",
+                      bl->nbtotal, bl->nbfiles + (bl->nbrecs ? 1 : 0));
+    rc = TXN_BEGIN(bl->ctx->ctx->env, NULL, 0, &txn);
+    if (rc) {
+        slapi_log_err(SLAPI_LOG_ERR, "dbmdb_bulkload_write",
+                      "Failed to begin a txn. Error is 0x%x: %s.\n", rc, mdb_strerror(rc));
+        return rc;
+    }
+    bulkload_sort_run(bl, txn, bl->run, bl->recs, bl->nbrecs);
+
+    cursors = (dbmdb_bulkload_cursor_t *)slapi_ch_calloc(bl->nbfiles + 1, sizeof(dbmdb_bulkload_cursor_t));
+    heap = (dbmdb_bulkload_cursor_t **)slapi_ch_calloc(bl->nbfiles + 1, sizeof(dbmdb_bulkload_cursor_t *));
+    for (i = 0; i <= bl->nbfiles; i++) {
+        cur = &cursors[i];
+        if (i < bl->nbfiles) {
+            cur->fp = bl->files[i];
+            rewind(cur->fp);
+        } else {
+            cur->run = bl->run;
+            cur->recs = bl->recs;
+            cur->nbrecs = bl->nbrecs;
+        }
+        rc = bulkload_cursor_next(cur);
+        if (rc == 0) {
+            heap[nb++] = cur;
+        } else if (rc != MDB_NOTFOUND) {
+            goto done;
+        }
+    }
+    rc = 0;
+    for (i = nb / 2 - 1; i >= 0; i--) {
+        bulkload_heap_down(bl, txn, heap, nb, i);
+    }
+
+    while (nb > 0) {
+        cur = heap[0];
+        samekey = (cur->dbidx == lastidx);
+        if (samekey) {
+            last.mv_data = lastkey;
+            last.mv_size = lastkeysize;
+            samekey = (mdb_cmp(txn, bl->dbis[lastidx]->dbi, &cur->key, &last) == 0);
+        }
+        if (!samekey) {
+            if (cur->key.mv_size > lastkeyalloc) {
+                lastkeyalloc = cur->key.mv_size;
+                lastkey = slapi_ch_realloc(lastkey, lastkeyalloc);
+            }
+            memcpy(lastkey, cur->key.mv_data, cur->key.mv_size);
+            lastkeysize = cur->key.mv_size;
+            lastidx = cur->dbidx;
+        }
+        rc = bulkload_put(bl, txn, cur, samekey);
+        if (rc) {
+            break;
+        }
+        rc = bulkload_cursor_next(cur);
+        if (rc == MDB_NOTFOUND) {
+            heap[0] = heap[--nb];
+            rc = 0;
+        } else if (rc) {
+            import_log_notice(job, SLAPI_LOG_ERR, "dbmdb_bulkload_write",
+                              "Failed to read a temporary file. Error %d: %s", rc, slapd_system_strerror(rc));
+            break;
+        }
+        if (nb > 0) {
+            bulkload_heap_down(bl, txn, heap, nb, 0);
+        }
+        if (++count >= BULKLOAD_MAX_OPS_IN_TXN) {
+            rc = TXN_COMMIT(txn);
+            txn = NULL;
+            if (!rc) {
+                rc = TXN_BEGIN(bl->ctx->ctx->env, NULL, 0, &txn);
+            }
+            if (rc) {
+                slapi_log_err(SLAPI_LOG_ERR, "dbmdb_bulkload_write",
+                              "Failed to commit the txn. Error is 0x%x: %s.\n", rc, mdb_strerror(rc));
+                break;
+            }
+            count = 0;
+        }
+    }
+    if (!rc && txn) {
+        rc = TXN_COMMIT(txn);
+        txn = NULL;
+        if (rc) {
+            slapi_log_err(SLAPI_LOG_ERR, "dbmdb_bulkload_write",
+                          "Failed to commit the txn. Error is 0x%x: %s.\n", rc, mdb_strerror(rc));
+        }
+    }
+
+done:
+    if (txn) {
+        TXN_ABORT(txn);
+    }
+    for (i = 0; i <= bl->nbfiles; i++) {
+        slapi_ch_free((void **)&cursors[i].buf);
+    }
+    slapi_ch_free((void **)&cursors);
+    slapi_ch_free((void **)&heap);
+    slapi_ch_free((void **)&lastkey);
+    return rc;
+}
@@ -438,155 +438,261 @@ dbmdb_import_workerq_push(ImportQueue_t *q, WorkerQueueData_t *data)
 /* like the function in libldif, except this one doesn't need to use
  * FILE (which breaks on various platforms for >4G files or large numbers
  * of open files)
+ * The file is read by large chunks and, for regular files, a read ahead
+ * thread fetches the next chunk while the producer handles the current one.
+ * Entries are split with memchr (which is vectorized by the libc) rather
+ * than by testing every char.
  */
-#define LDIF_BUFFER_SIZE 8192
+#define LDIF_BUFFER_SIZE (1024 * 1024)
 
 typedef struct
 {
     char *b;       /* buffer */
     size_t size;   /* how full the buffer is */
     size_t offset; /* where the current entry starts */
+    size_t bsize;  /* buffer allocated size */
+    int fd;        /* file being read */
+    int eof;       /* end of file (or read error) reached */
+    /* read ahead thread */
+    int readahead; /* read ahead thread is running */
+    pthread_t tid;
+    pthread_mutex_t mutex;
+    pthread_cond_t cv;
+    char *rb;      /* chunk read by the read ahead thread */
+    ssize_t rlen;  /* rb length (0 at end of file, -1 if read failed) */
+    int rerrno;    /* errno of the failed read */
+    int rready;    /* rb is waiting to be consumed */
+    int rstop;     /* read ahead thread is asked to stop */
 } ldif_context;
 
 static void
 dbmdb_import_init_ldif(ldif_context *c)
 {
+    memset(c, 0, sizeof *c);
+    c->fd = -1;
+    pthread_mutex_init(&c->mutex, NULL);
+    pthread_cond_init(&c->cv, NULL);
+}
+
+static ssize_t
+dbmdb_import_ldif_read(int fd, char *buf, size_t len)
+{
+    ssize_t rc;
+
+    do {
+        rc = read(fd, buf, len);
+    } while (rc < 0 && errno == EINTR);
+    return rc;
+}
+
+/* read ahead thread: read the next chunk while the previous one is parsed */
+static void *
+dbmdb_import_ldif_readahead(void *arg)
+{
+    ldif_context *c = arg;
+    char *buf = slapi_ch_malloc(LDIF_BUFFER_SIZE);
+    char *tmp = NULL;
+    ssize_t len = 0;
+    int stop = 0;
+    int err = 0;
+
+    slapi_set_thread_name("import-readahead");
+    while (!stop) {
+        len = dbmdb_import_ldif_read(c->fd, buf, LDIF_BUFFER_SIZE);
+        err = errno;
+        pthread_mutex_lock(&c->mutex);
+        while (c->rready && !c->rstop) {
+            pthread_cond_wait(&c->cv, &c->mutex);
+        }
+        if (!c->rstop) {
+            /* Hand over the chunk and get back the previous one to reuse it */
+            tmp = c->rb;
+            c->rb = buf;
+            buf = tmp ? tmp : slapi_ch_malloc(LDIF_BUFFER_SIZE);
+            c->rlen = len;
+            c->rerrno = err;
+            c->rready = 1;
+            pthread_cond_broadcast(&c->cv);
+        }
+        stop = c->rstop || (len <= 0);
+        pthread_mutex_unlock(&c->mutex);
+    }
+    slapi_ch_free((void **)&buf);
+    return NULL;
+}
+
+static void
+dbmdb_import_ldif_stop_readahead(ldif_context *c)
+{
+    if (c->readahead) {
+        pthread_mutex_lock(&c->mutex);
+        c->rstop = 1;
+        pthread_cond_broadcast(&c->cv);
+        pthread_mutex_unlock(&c->mutex);
+        pthread_join(c->tid, NULL);
+        c->readahead = 0;
+    }
+    c->rstop = 0;
+    c->rready = 0;
+    slapi_ch_free((void **)&c->rb);
+}
+
+/* Forget the current file (so a new file reusing the same fd is read from its start) */
+static void
+dbmdb_import_ldif_reset(ldif_context *c)
+{
+    dbmdb_import_ldif_stop_readahead(c);
+    c->fd = -1;
     c->size = c->offset = 0;
-    c->b = NULL;
+    c->eof = 0;
+}
+
+static void
+dbmdb_import_ldif_set_fd(ldif_context *c, int fd)
+{
+    struct stat st = {0};
+
+    dbmdb_import_ldif_reset(c);
+    c->fd = fd;
+    /* A blocking read on a pipe could not be interrupted when stopping the thread */
+    if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) &&
+        pthread_create(&c->tid, NULL, dbmdb_import_ldif_readahead, c) == 0) {
+        c->readahead = 1;
+    }
 }
 
 static void
 dbmdb_import_free_ldif(ldif_context *c)
 {
-    if (c->b)
-        FREE(c->b);
-    dbmdb_import_init_ldif(c);
+    dbmdb_import_ldif_reset(c);
+    slapi_ch_free((void **)&c->b);
+    c->bsize = 0;
+    pthread_mutex_destroy(&c->mutex);
+    pthread_cond_destroy(&c->cv);
+}
+
+/*
+ * Move the current entry at the start of the buffer then append the next
+ * chunk of the file. Returns the number of read bytes, 0 at the end of file
+ * and -1 if the read failed.
+ */
+static ssize_t
+dbmdb_import_ldif_fill(ldif_context *c)
+{
+    ssize_t len = 0;
+
+    if (c->offset > 0) {
+        memmove(c->b, c->b + c->offset, c->size - c->offset);
+        c->size -= c->offset;
+        c->offset = 0;
+    }
+    if (c->bsize - c->size < LDIF_BUFFER_SIZE) {
+        c->bsize = (c->bsize ? 2 * c->bsize : LDIF_BUFFER_SIZE);
+        if (c->bsize - c->size < LDIF_BUFFER_SIZE) {
+            c->bsize = c->size + LDIF_BUFFER_SIZE;
+        }
+        c->b = slapi_ch_realloc(c->b, c->bsize);
+    }
+    if (!c->readahead) {
+        len = dbmdb_import_ldif_read(c->fd, c->b + c->size, LDIF_BUFFER_SIZE);
+    } else {
+        pthread_mutex_lock(&c->mutex);
+        while (!c->rready) {
+            pthread_cond_wait(&c->cv, &c->mutex);
+        }
+        len = c->rlen;
+        if (len > 0) {
+            memcpy(c->b + c->size, c->rb, len);
+        } else {
+            errno = c->rerrno;
+        }
+        c->rready = 0;
+        pthread_cond_broadcast(&c->cv);
+        pthread_mutex_unlock(&c->mutex);
+    }
+    if (len > 0) {
+        c->size += len;
+    } else {
+        c->eof = 1;
+    }
+    return len;
 }
 
 static char *
 dbmdb_import_get_entry(ldif_context *c, int fd, int *lineno)
 {
-    int ret;
-    int done = 0, got_lf = 0;
-    size_t bufSize = 0, bufOffset = 0, i;
+    size_t n = 0;   /* length of the already scanned part of the entry */
+    size_t len = 0; /* entry length (including the final empty line) */
+    size_t avail;
     char *buf = NULL;
+    char *p, *end;
 
-    while (!done) {
-        /* If there's no data in the buffer, get some */
-        if ((c->size == 0) || (c->offset == c->size)) {
-            /* Do we even have a buffer ? */
-            if (!c->b) {
-                c->b = slapi_ch_malloc(LDIF_BUFFER_SIZE);
-                if (!c->b)
-                    return NULL;
-            }
-            ret = read(fd, c->b, LDIF_BUFFER_SIZE);
-            if (ret < 0) {
-                /* Must be error */
-                goto error;
-            } else if (ret == 0) {
-                /* eof */
-                if (buf) {
-                    /* last entry */
-                    buf[bufOffset] = 0;
-                    return buf;
-                }
-                return NULL;
-            } else {
-                /* read completed OK */
-                c->size = ret;
-                c->offset = 0;
-            }
-        }
+    if (fd != c->fd) {
+        dbmdb_import_ldif_set_fd(c, fd);
+    }
 
-        /* skip blank lines at start of entry */
-        if (bufOffset == 0) {
-            size_t n;
-            char *p;
+    /* skip blank lines at start of entry */
+    for (;;) {
+        for (p = c->b + c->offset, end = c->b + c->size; p < end; p++) {
+            if (!(*p == '\r' || *p == '\n' || *p == ' ' || *p == '\t'))
+                break;
+        }
+        c->offset = p - c->b;
+        if (c->offset < c->size) {
+            break;
+        }
+        if (c->eof || dbmdb_import_ldif_fill(c) <= 0) {
+            /* eof or error */
+            dbmdb_import_ldif_reset(c);
+            return NULL;
+        }
+    }
 
-            for (n = c->offset, p = c->b + n; n < c->size; n++, p++) {
-                if (!(*p == '\r' || *p == '\n' || *p == ' ' || *p == '\t'))
-                    break;
+    /* look for the end of the entry (an empty line) */
+    for (;;) {
+        p = memchr(c->b + c->offset + n, '\n', c->size - c->offset - n);
+        if (p) {
+            n = p - (c->b + c->offset);
+            avail = c->size - c->offset - n - 1;
+            if (avail >= 1 && p[1] == '\n') {
+                len = n + 2;
+                break;
             }
-            c->offset = n;
-            if (c->offset == c->size)
+            if (avail >= 2 && p[1] == '\r' && p[2] == '\n') {
+                /* (nt) */
+                len = n + 3;
+                break;
+            }
+            if (c->eof || avail >= 2 || (avail == 1 && p[1] != '\r')) {
+                /* not an empty line */
+                n++;
                 continue;
-        }
-
-        i = c->offset;
-        while (!done && (i < c->size)) {
-            /* scan forward in the buffer, looking for the end of the entry */
-            while ((i < c->size) && (c->b[i] != '\n'))
-                i++;
-
-            if ((i < c->size) && (c->b[i] == '\n')) {
-                if (got_lf && ((i == 0) || ((i == 1) && (c->b[0] == '\r')))) {
-                    /* saw an lf at the end of the last buffer */
-                    i++, (*lineno)++;
-                    done = 1;
-                    got_lf = 0;
-                    break;
-                }
-                got_lf = 0;
-                (*lineno)++;
-                /* is this the end?  (need another linefeed) */
-                if (++i < c->size) {
-                    if (c->b[i] == '\n') {
-                        /* gotcha! */
-                        i++, (*lineno)++;
-                        done = 1;
-                    } else if (c->b[i] == '\r') {
-                        if (++i < c->size) {
-                            if (c->b[i] == '\n') {
-                                /* gotcha! (nt) */
-                                i++, (*lineno)++;
-                                done = 1;
-                            }
-                        } else {
-                            got_lf = 1;
-                        }
-                    }
-                } else {
-                    /* lf at the very end of the buffer */
-                    got_lf = 1;
-                }
             }
-        }
-
-        /* copy what we did so far into the output buffer */
-        /* (first, make sure the output buffer is large enough) */
-        if (bufSize - bufOffset < i - c->offset + 1) {
-            char *newbuf = NULL;
-            size_t newsize = (buf ? bufSize * 2 : LDIF_BUFFER_SIZE);
-
-            newbuf = slapi_ch_malloc(newsize);
-            /* copy over the old data (if there was any) */
-            if (buf) {
-                memmove(newbuf, buf, bufOffset);
-                slapi_ch_free((void **)&buf);
+            /* lf at the very end of the buffer: need more data to decide */
+        } else {
+            n = c->size - c->offset;
+            if (c->eof) {
+                /* last entry */
+                len = n;
+                break;
             }
-            buf = newbuf;
-            bufSize = newsize;
         }
-        if (!buf) {
-            /* Test always false (buf get initialized in first iteration
-             * but it makes gcc -fanalyzer happy
-             */
+        if (dbmdb_import_ldif_fill(c) < 0) {
+            /* Must be error */
+            dbmdb_import_ldif_reset(c);
             return NULL;
         }
-        memmove(buf + bufOffset, c->b + c->offset, i - c->offset);
-        bufOffset += (i - c->offset);
-        c->offset = i;
     }
 
+    for (p = c->b + c->offset, end = p + len; (p = memchr(p, '\n', end - p)); p++) {
+        (*lineno)++;
+    }
+    buf = slapi_ch_malloc(len + 1);
+    memcpy(buf, c->b + c->offset, len);
     /* add terminating NUL char */
-    buf[bufOffset] = 0;
+    buf[len] = 0;
+    c->offset += len;
     return buf;
-
-error:
-    if (buf)
-        slapi_ch_free((void **)&buf);
-    return NULL;
 }
 
 
@@ -1061,14 +1167,14 @@ dbmdb_import_entry_info_by_rdn(mdb_privdb_t *db, WorkerQueueData_t *wqelmt)
     wqelmt->parent_info = NULL;
     wqelmt->entry_info = NULL;
     if (wqelmt->wait_id != 1) {
-        if (!get_value_from_string(wqelmt->data, "parentid", &pidstr)) {
+        if (!get_value_from_record(wqelmt->data, wqelmt->datalen, "parentid", &pidstr)) {
             pid = atoi(pidstr);
             slapi_ch_free_string(&pidstr);
         } else {
             pid = 1;
         }
     }
-    if (get_value_from_string(wqelmt->data, "rdn", &rdn)) {
+    if (get_value_from_record(wqelmt->data, wqelmt->datalen, "rdn", &rdn)) {
         return DNRC_NORDN;
     }
 
@@ -1374,10 +1480,10 @@ dbmdb_import_producer(void *param)
         slapi_task_set_warning(job->task, WARN_SKIPPED_IMPORT_ENTRY);
     }
 
+    dbmdb_import_free_ldif(&c);
     if (fd >= 0)
         close(fd);
     slapi_value_free(&(job->usn_value));
-    dbmdb_import_free_ldif(&c);
     info_set_state(info);
 }
 
@@ -1858,22 +1964,27 @@ dbmdb_import_index_prepare_worker_entry(WorkerQueueData_t *wqelmnt)
     Slapi_Entry *e = NULL;
     char *normdn = NULL;
     char *rdn = NULL;
+    char *plain = NULL;
 
     /* call post-entry plugin */
     plugin_call_entryfetch_plugins(&entry_str, &entry_len);
+    if (id2entry_decompress(wqelmnt->winfo.job->inst->inst_be, entry_str, entry_len, &plain, &entry_len) > 0) {
+        entry_str = plain;
+    }
 
     /*
      * dn is yet unknown so lets use the rdn instead.
-     * but slapi_str2entry_ext needs that entry is in the suffix
+     * but slapi_record2entry needs that entry is in the suffix
      * (to avoid error while processing tombstone)
      * if needed (upgrade case) dn could be recomputed when walking
      * the ancestors in process_entryrdn_byrdn
      */
-    if (get_value_from_string(entry_str, "rdn", &rdn)) {
+    if (get_value_from_record(entry_str, entry_len, "rdn", &rdn)) {
         slapi_log_err(SLAPI_LOG_ERR, "dbmdb_import_index_prepare_worker_entry",
                 "Invalid entry (no rdn) in database for id %d entry: %s\n",
                 id, entry_str);
         slapi_ch_free(&wqelmnt->data);
+        slapi_ch_free_string(&plain);
         thread_abort(info);
         return NULL;
     }
@@ -1882,7 +1993,7 @@ dbmdb_import_index_prepare_worker_entry(WorkerQueueData_t *wqelmnt)
     } else {
         normdn = slapi_ch_smprintf("%s,%s", rdn, suffix);
     }
-    e = slapi_str2entry_ext(normdn, NULL, entry_str, SLAPI_STR2ENTRY_NO_ENTRYDN);
+    e = slapi_record2entry(normdn, NULL, entry_str, entry_len, SLAPI_STR2ENTRY_NO_ENTRYDN);
     slapi_ch_free_string(&normdn);
     slapi_ch_free_string(&rdn);
     if (e==NULL) {
@@ -1891,6 +2002,7 @@ dbmdb_import_index_prepare_worker_entry(WorkerQueueData_t *wqelmnt)
                 id, entry_str);
     }
     slapi_ch_free(&wqelmnt->data);
+    slapi_ch_free_string(&plain);
     ep = dbmdb_import_make_backentry(e, id);
     if ((ep == NULL) || (ep->ep_entry == NULL)) {
         thread_abort(info);
@@ -2116,11 +2228,11 @@ dbmdb_upgrade_prepare_worker_entry(WorkerQueueData_t *wqelmnt)
         rdn_dbmdb_has_spaces = 0;
         dn_in_cache = 0;
 
-        /* original rdn is allocated in get_value_from_string */
-        rc = get_value_from_string(entry_str, "rdn", &rdn);
+        /* original rdn is allocated in get_value_from_record */
+        rc = get_value_from_record(entry_str, entry_len, "rdn", &rdn);
         if (rc) {
             /* data.dptr may not include rdn: ..., try "dn: ..." */
-            e = slapi_str2entry(entry_str, SLAPI_STR2ENTRY_USE_OBSOLETE_DNFORMAT);
+            e = slapi_record2entry(NULL, NULL, entry_str, entry_len, SLAPI_STR2ENTRY_USE_OBSOLETE_DNFORMAT);
         } else {
             bdn = dncache_find_id(&inst->inst_dncache, temp_id);
             if (bdn) {
@@ -2142,7 +2254,7 @@ dbmdb_upgrade_prepare_worker_entry(WorkerQueueData_t *wqelmnt)
                     slapi_log_err(SLAPI_LOG_TRACE, "dbmdb_upgradedn_producer",
                                   "entryrdn is not available; composing dn (rdn: %s, ID: %d)\n",
                                   rdn, temp_id);
-                    rc = get_value_from_string(entry_str, LDBM_PARENTID_STR, &pid_str);
+                    rc = get_value_from_record(entry_str, entry_len, LDBM_PARENTID_STR, &pid_str);
                     if (rc) {
                         rc = 0; /* assume this is a suffix */
                     } else {
@@ -2197,8 +2309,8 @@ dbmdb_upgrade_prepare_worker_entry(WorkerQueueData_t *wqelmnt)
                     dn_in_cache = 1;
                 }
             }
-            e = slapi_str2entry_ext(normdn, NULL, entry_str,
-                                    SLAPI_STR2ENTRY_USE_OBSOLETE_DNFORMAT);
+            e = slapi_record2entry(normdn, NULL, entry_str, entry_len,
+                                   SLAPI_STR2ENTRY_USE_OBSOLETE_DNFORMAT);
             slapi_ch_free_string(&rdn);
         }
 
@@ -2426,7 +2538,7 @@ dbmdb_upgrade_prepare_worker_entry(WorkerQueueData_t *wqelmnt)
                 }
 
                 /* dn syntax attr */
-                rc = get_values_from_string((const char *)ecopy,
+                rc = get_values_from_record((const char *)ecopy, entry_len,
                                             a->a_type, &ud_vals);
                 if (rc || (NULL == ud_vals)) {
                     continue; /* empty; ignore it */
@@ -2807,8 +2919,18 @@ int dbmdb_import_add_id2entry_add(ImportJob *job, backend *be, struct backentry
     {
         int options = SLAPI_DUMP_STATEINFO | SLAPI_DUMP_UNIQUEID | SLAPI_DUMP_RDN_ENTRY;
         Slapi_Entry *entry_to_use = encrypted_entry ? encrypted_entry->ep_entry : e->ep_entry;
-        wqd.data.mv_data = slapi_entry2str_with_options(entry_to_use, &len, options);
-        esize = (uint32_t)len+1;
+        char *packed = NULL;
+        if (job->inst->inst_li->li_binary_entry_format) {
+            wqd.data.mv_data = slapi_entry2bin(entry_to_use, &len);
+            esize = (uint32_t)len;
+        } else {
+            wqd.data.mv_data = slapi_entry2str_with_options(entry_to_use, &len, options);
+            esize = (uint32_t)len+1;
+        }
+        if (id2entry_compress(be, wqd.data.mv_data, esize, &packed, &esize)) {
+            slapi_ch_free(&wqd.data.mv_data);
+            wqd.data.mv_data = packed;
+        }
         plugin_call_entrystore_plugins((char **)&wqd.data.mv_data, &esize);
         wqd.data.mv_size = esize;
         dbmdb_import_writeq_push(ctx, &wqd);
@@ -3521,7 +3643,14 @@ dbmdb_build_import_index_list(ImportCtx_t *ctx)
         dbmdb_open_dbi_from_filename(&ctx->id2entry->dbi, job->inst->inst_be, ctx->id2entry->name,
                                  NULL, MDB_CREATE|MDB_MARK_DIRTY_DBI|MDB_OPEN_DIRTY_DBI|MDB_TRUNCATE_DBI);
     }
-
+    /*
+     * The naming dbis are truncated above so their records can be sorted
+     * and appended once all the entries are processed.
+     * (Upgrade dn still reads entryrdn while it rebuilds it)
+     */
+    if (ctx->entryrdn && ctx->role != IM_UPGRADE) {
+        ctx->bulkload = dbmdb_bulkload_new(ctx);
+    }
 }
 
 static int32_t
@@ -3748,10 +3877,10 @@ dbmdb_read_ldif_entries(struct ldbminfo *li, char *src_dir, char *file_name)
     backup_entries[nb_entries] = NULL;
 out:
     slapi_ch_free_string(&filename);
+    dbmdb_import_free_ldif(&c);
     if (fd >= 0) {
         close(fd);
     }
-    dbmdb_import_free_ldif(&c);
 
     return backup_entries;
 }
@@ -4015,6 +4144,10 @@ dbmdb_import_writer(void*param)
         txn = NULL;
     }
     MDB_STAT_STEP(stats, MDB_STAT_WRITE, stats_enabled);
+    if (!rc && ctx->bulkload && !info_is_finished(info)) {
+        /* Workers are finished: append the sorted naming records */
+        rc = dbmdb_bulkload_write(ctx->bulkload);
+    }
     if (!rc) {
         /* Ensure that all data are written on disk */
         rc = mdb_env_sync(ctx->ctx->env, 1);
@@ -4284,6 +4417,9 @@ dup_writer_queue_item(WriterQueueData_t *wqd)
 
 void dbmdb_import_writeq_push(ImportCtx_t *ctx, WriterQueueData_t *wqd)
 {
+    if (ctx->bulkload && dbmdb_bulkload_push(ctx->bulkload, wqd)) {
+        return;
+    }
     dbmdb_import_q_push(&ctx->writerq, wqd);
 }
 
@@ -4376,6 +4512,7 @@ dbmdb_free_import_ctx(ImportJob *job)
         dbmdb_import_q_destroy(&ctx->bulkq);
         slapi_ch_free((void**)&ctx->id2entry->name);
         slapi_ch_free((void**)&ctx->id2entry);
+        dbmdb_bulkload_free(&ctx->bulkload);
         avl_free(ctx->indexes, free_ii);
         ctx->indexes = NULL;
         charray_free(ctx->indexAttrs);
@@ -716,7 +716,13 @@ int dbmdb_make_env(dbmdb_ctx_t *ctx, int readOnly, mdb_mode_t mode)
     }
     if (readOnly) {
         flags = MDB_RDONLY;
+    } else if (ctx->startcfg.group_commit) {
+        /* commits flush the data pages but not the meta page: a crash may
+         * undo the last txns but never corrupts the db. dbmdb_txn_sync
+         * waits for a shared flush of the meta page instead */
+        flags = MDB_NOMETASYNC;
     }
+    ctx->group_commit = !readOnly && ctx->startcfg.group_commit;
 
     rc = mdb_env_create(&env);
     ctx->env = env;
@@ -786,6 +792,9 @@ void dbmdb_ctx_close(dbmdb_ctx_t *ctx)
          */
     }
     if (ctx->env) {
+        if (ctx->group_commit) {
+            mdb_env_sync(ctx->env, 1);
+        }
         dbmdb_set_is_env_open(false);
         mdb_env_close(ctx->env);
         ctx->env = NULL;
@@ -800,6 +809,8 @@ void dbmdb_ctx_close(dbmdb_ctx_t *ctx)
         dbi_nbslots = 0;
         pthread_mutex_destroy(&ctx->dbis_lock);
         pthread_mutex_destroy(&ctx->rcmutex);
+        pthread_mutex_destroy(&ctx->gc_lock);
+        pthread_cond_destroy(&ctx->gc_cv);
         pthread_rwlock_destroy(&ctx->dbmdb_env_lock);
     }
 }
@@ -83,6 +83,7 @@ static int dbmdb_force_checkpoint(struct ldbminfo *li);
 #define FLUSH_REMOTEOFF 0
 
 static const char *backupfilelists[] = { INFOFILE, DBMAPFILE, DSE_INSTANCE, DSE_INDEX, NULL };
+static const char *incrbackupfilelists[] = { BACKUP_MANIFEST, DBDELTAFILE, NULL };
 
 /*
  * if ATTRINFO_DEBUG_DELAY > 0
@@ -884,9 +885,13 @@ error:
     return return_value;
 }
 
-/* Destination Directory is an absolute pathname */
-int
-dbmdb_backup(struct ldbminfo *li, char *dest_dir, Slapi_Task *task)
+/*
+ * Destination Directory is an absolute pathname
+ * base_dir is the previous backup of an incremental backup chain
+ * (NULL for a full backup)
+ */
+static int
+dbmdb_backup_ext(struct ldbminfo *li, char *dest_dir, char *base_dir, Slapi_Task *task)
 {
     int return_value = LDAP_UNWILLING_TO_PERFORM;
     PRDirEntry *direntry = NULL;
@@ -914,7 +919,8 @@ dbmdb_backup(struct ldbminfo *li, char *dest_dir, Slapi_Task *task)
      * What are we doing here ?
      * check that destinantion is OK
      * We want to copy into the backup directory:
-     * The mdb database
+     * The mdb database (or the chunks changed since base_dir)
+     * and its manifest
      * The info file
      */
 
@@ -944,7 +950,7 @@ dbmdb_backup(struct ldbminfo *li, char *dest_dir, Slapi_Task *task)
         goto error_out;
     }
     /* Copy the mdb database */
-    return_value = mdb_env_copy(conf->env, dest_dir);
+    return_value = dbmdb_backup_copy(li, dest_dir, base_dir, task);
     if (return_value) {
         slapi_log_err(SLAPI_LOG_ERR, "dbmdb_backup", "Failed to backup mdb database to %s.\n", dest_dir);
         if (task) {
@@ -1001,12 +1007,29 @@ error_out:
         unlink(pathname2);
         slapi_ch_free_string(&pathname2);
     }
+    for (pt=incrbackupfilelists; *pt; pt++) {
+        pathname2 = slapi_ch_smprintf("%s/%s", dest_dir, *pt);
+        unlink(pathname2);
+        slapi_ch_free_string(&pathname2);
+    }
     rmdir(dest_dir);
     return_value = LDAP_UNWILLING_TO_PERFORM;
 bail:
     return return_value;
 }
 
+int
+dbmdb_backup(struct ldbminfo *li, char *dest_dir, Slapi_Task *task)
+{
+    return dbmdb_backup_ext(li, dest_dir, NULL, task);
+}
+
+int
+dbmdb_backup_incremental(struct ldbminfo *li, char *dest_dir, char *base_dir, Slapi_Task *task)
+{
+    return dbmdb_backup_ext(li, dest_dir, base_dir, task);
+}
+
 
 /*
  * Restore is pretty easy.
@@ -1047,6 +1070,7 @@ dbmdb_restore(struct ldbminfo *li, char *src_dir, Slapi_Task *task)
     struct stat sbuf;
     const char **pt;
     char *pathname;
+    int incremental = 0;
 
     PR_ASSERT(NULL != li);
     PR_ASSERT(NULL != li->li_dblayer_private);
@@ -1076,7 +1100,12 @@ dbmdb_restore(struct ldbminfo *li, char *src_dir, Slapi_Task *task)
     }
 
     /* Check that all files are present and not empty */
+    incremental = dbmdb_backup_is_incremental(src_dir);
     for (pt=backupfilelists; *pt; pt++) {
+        if (incremental && strcmp(*pt, DBMAPFILE) == 0) {
+            /* the map file comes from the base backups */
+            continue;
+        }
         pathname = slapi_ch_smprintf("%s/%s", src_dir, *pt);
         if (stat(pathname, &sbuf) < 0 || sbuf.st_size == 0) {
             slapi_log_err(SLAPI_LOG_ERR, "dbmdb_restore",
@@ -1108,8 +1137,8 @@ dbmdb_restore(struct ldbminfo *li, char *src_dir, Slapi_Task *task)
     dbmdb_ctx_close(li->li_dblayer_config);
     dbmdb_delete_db(li);
 
-    /* Copy db and info files */
-    if (dbmdb_restore_file(li, task, src_dir, DBMAPFILE) ||
+    /* Copy db (replaying the incremental backups chain) and info files */
+    if (dbmdb_restore_mapfile(li, src_dir, task) ||
         dbmdb_restore_file(li, task, src_dir, INFOFILE)) {
         return_value = -1;
         goto error_out;
@@ -42,6 +42,9 @@
 #define CONFIG_MDB_MAX_READERS    "nsslapd-mdb-max-readers"
 #define CONFIG_MDB_MAX_DBS        "nsslapd-mdb-max-dbs"
 #define CONFIG_MDB_IMPORT_STATS   "nsslapd-mdb-import-stats"
+#define CONFIG_MDB_GROUP_COMMIT   "nsslapd-mdb-group-commit"
+#define CONFIG_MDB_EXPORT_THREADS "nsslapd-mdb-export-threads"
+#define CONFIG_MDB_BACKUP_MAX_RATE "nsslapd-mdb-backup-max-rate"
 
 #define DBMDB_DB_MINSIZE             ( 4LL * MEGABYTE )
 #define DBMDB_DISK_RESERVE(disksize) ((disksize)*2ULL/1000ULL)
@@ -63,6 +66,8 @@
 #define DSE_INSTANCE        "dse_instance.ldif"     /* dse file in backup */
 #define DSE_INDEX           "dse_index.ldif"        /* dse file in backup */
 #define DBMAPFILE           "data.mdb"
+#define DBDELTAFILE         "data.mdb.delta"        /* incremental backup */
+#define BACKUP_MANIFEST     "backup.manifest"       /* chunk hashes of a backup */
 #define INFOFILE            "INFO.mdb"
 #define DBNAMES             "__DBNAMES"
 #define CHANGELOG_PATTERN   "changelog"   /* pattern in changelog dbi name */
@@ -78,6 +83,9 @@ typedef struct
     int max_dbs;
     uint64_t max_size;
     int import_stats;
+    int group_commit;
+    int export_threads;
+    uint64_t backup_max_rate;     /* bytes per second, 0 for no limit */
 } dbmdb_cfg_t;
 
 /* config parameters limits */
@@ -179,6 +187,15 @@ typedef struct dbmdb_ctx_t
     perfctrs_private *perf_private;  /* Performance counter data (shared memory) */
     dbmdb_perfctrs_txn_t perf_rotxn; /* Read Only Txn Performance counter */
     dbmdb_perfctrs_txn_t perf_rwtxn; /* Read Write Txn Performance counter */
+    /* group commit: env is open with MDB_NOMETASYNC and committed write txns
+     * wait for a shared mdb_env_sync (see dbmdb_txn_sync) */
+    int group_commit;              /* group commit is active in this env */
+    pthread_mutex_t gc_lock;       /* protects the gc_* fields */
+    pthread_cond_t gc_cv;          /* signaled when a flush completes */
+    uint64_t gc_committed;         /* number of write txns committed */
+    uint64_t gc_synced;            /* number of write txns known to be on disk */
+    int gc_syncing;                /* a thread is flushing the env */
+    uint64_t gc_nbsync;            /* number of flushes */
 } dbmdb_ctx_t;
 
 /*
@@ -289,6 +306,7 @@ int dbmdb_close(struct ldbminfo *li, int flags);
 int dbmdb_start(struct ldbminfo *li, int flags);
 int dbmdb_instance_start(backend *be, int flags);
 int dbmdb_backup(struct ldbminfo *li, char *dest_dir, Slapi_Task *task);
+int dbmdb_backup_incremental(struct ldbminfo *li, char *dest_dir, char *base_dir, Slapi_Task *task);
 int dbmdb_verify(Slapi_PBlock *pb);
 int dbmdb_db2ldif(Slapi_PBlock *pb);
 int dbmdb_db2index(Slapi_PBlock *pb);
@@ -301,6 +319,7 @@ int dbmdb_restore(struct ldbminfo *li, char *src_dir, Slapi_Task *task);
 int dbmdb_cleanup(struct ldbminfo *li);
 int dbmdb_txn_begin(struct ldbminfo *li, back_txnid parent_txn, back_txn *txn, PRBool use_lock);
 int dbmdb_txn_commit(struct ldbminfo *li, back_txn *txn, PRBool use_lock);
+int dbmdb_txn_sync(struct ldbminfo *li);
 int dbmdb_txn_abort(struct ldbminfo *li, back_txn *txn, PRBool use_lock);
 int dbmdb_get_db(backend *be, char *indexname, int open_flag, struct attrinfo *ai, dbi_db_t **ppDB);
 int dbmdb_rm_db_file(backend *be, struct attrinfo *a, PRBool use_lock, int no_force_chkpt);
@@ -438,6 +457,11 @@ int dbmdb_instance_add_instance_entry_callback(struct ldbminfo *li, struct ldbm_
 int dbmdb_instance_postadd_instance_entry_callback(struct ldbminfo *li, struct ldbm_instance *inst);
 void dbmdb_ctx_t_setup_default(struct ldbminfo *li);
 
+/* backup functions */
+int dbmdb_backup_copy(struct ldbminfo *li, const char *dest_dir, const char *base_dir, Slapi_Task *task);
+int dbmdb_restore_mapfile(struct ldbminfo *li, const char *src_dir, Slapi_Task *task);
+int dbmdb_backup_is_incremental(const char *src_dir);
+
 /* monitor functions */
 int dbmdb_monitor_instance_search(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_Entry *entryAfter, int *returncode, char *returntext, void *arg);
 int dbmdb_monitor_search(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_Entry *entryAfter, int *returncode, char *returntext, void *arg);
@@ -19,6 +19,7 @@
 
 #include "mdb_import.h"
 #include "../vlv_srch.h"
+#include <zlib.h>
 
 #define DB2INDEX_ANCESTORID 0x1   /* index ancestorid */
 #define DB2INDEX_ENTRYRDN 0x2     /* index entryrdn */
@@ -28,6 +29,8 @@
 
 #define LDIF2LDBM_EXTBITS(x) ((x)&0xf)
 
+#define EXPORT_ZBUF_SIZE (64 * 1024) /* gzip output buffer */
+
 typedef struct _export_args
 {
     struct backentry *ep;
@@ -47,6 +50,9 @@ typedef struct _export_args
                                  its children's ID.  It happens when an entry
                                  is added and existing entries are moved under
                                  the newly added entry. */
+    z_stream *zstream;          /* gzip stream if the ldif file name ends with .gz */
+    time_t starttime;           /* to report the export rate */
+    struct _export_pool *pool;  /* export workers (see dbmdb_export_worker) */
 } export_args;
 
 /* static functions */
@@ -414,52 +420,148 @@ dbmdb_fetch_subtrees(backend *be, char **include, int *err)
 }
 
 
+/*
+ * Write a chunk of the export output, deflating it first when the
+ * ldif file is gzipped.
+ */
 static int
-dbmdb_export_one_entry(struct ldbminfo *li,
-                 ldbm_instance *inst,
-                 export_args *expargs)
+dbmdb_export_write_fd(int fd, const char *buf, size_t len)
+{
+    ssize_t wrc;
+
+    while (len > 0) {
+        wrc = write(fd, buf, len);
+        if (wrc < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -1;
+        }
+        buf += wrc;
+        len -= wrc;
+    }
+    return 0;
+}
+
+static int
+dbmdb_export_deflate(export_args *eargs, const char *buf, size_t len, int flush)
+{
+    z_stream *zs = eargs->zstream;
+    unsigned char out[EXPORT_ZBUF_SIZE];
+    int zrc;
+
+    zs->next_in = (Bytef *)buf;
+    zs->avail_in = len;
+    do {
+        zs->next_out = out;
+        zs->avail_out = sizeof out;
+        zrc = deflate(zs, flush);
+        if (zrc == Z_STREAM_ERROR) {
+            return -1;
+        }
+        if (dbmdb_export_write_fd(eargs->fd, (char *)out, sizeof out - zs->avail_out)) {
+            return -1;
+        }
+    } while (zs->avail_out == 0);
+    return 0;
+}
+
+static int
+dbmdb_export_write(export_args *eargs, const char *buf, size_t len)
+{
+    if (eargs->zstream) {
+        return dbmdb_export_deflate(eargs, buf, len, Z_NO_FLUSH);
+    }
+    return dbmdb_export_write_fd(eargs->fd, buf, len);
+}
+
+/* Compress the output if the ldif file name ends with .gz */
+static int
+dbmdb_export_open_zstream(export_args *eargs, const char *fname)
+{
+    size_t len = strlen(fname);
+    z_stream *zs = NULL;
+
+    if (len <= 3 || strcasecmp(fname + len - 3, ".gz")) {
+        return 0;
+    }
+    zs = (z_stream *)slapi_ch_calloc(1, sizeof(z_stream));
+    /* windowBits 15 + 16: write a gzip header and trailer */
+    if (deflateInit2(zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+        slapi_ch_free((void **)&zs);
+        return -1;
+    }
+    eargs->zstream = zs;
+    return 0;
+}
+
+static int
+dbmdb_export_close_zstream(export_args *eargs, int flush)
+{
+    int rc = 0;
+
+    if (eargs->zstream) {
+        if (flush) {
+            rc = dbmdb_export_deflate(eargs, NULL, 0, Z_FINISH);
+        }
+        deflateEnd(eargs->zstream);
+        slapi_ch_free((void **)&eargs->zstream);
+    }
+    return rc;
+}
+
+/*
+ * Build the ldif text of an entry: apply the export filters, drop the
+ * excluded attributes, decrypt and flag clear passwords.
+ * Returns NULL if the entry must not be exported, otherwise the ldif
+ * text (terminated by an empty line) and its length in *len.
+ * Only reads expargs, so it may be called by the export workers.
+ */
+static char *
+dbmdb_export_format_entry(struct ldbminfo *li,
+                          ldbm_instance *inst,
+                          export_args *expargs,
+                          struct backentry *ep,
+                          int *len)
 {
     backend *be = inst->inst_be;
     int rc = 0;
-    int wrc = 0;
     Slapi_Attr *this_attr = NULL, *next_attr = NULL;
     char *type = NULL;
-    MDB_val data = {0};
-    int len = 0;
+    char *ldif = NULL;
 
-    if (!dbmdb_back_ok_to_dump(backentry_get_ndn(expargs->ep),
+    if (!dbmdb_back_ok_to_dump(backentry_get_ndn(ep),
                               expargs->include_suffix,
                               expargs->exclude_suffix)) {
-        goto bail; /* go to next loop */
+        return NULL;
     }
     if (!(expargs->options & SLAPI_DUMP_STATEINFO) &&
-        slapi_entry_flag_is_set(expargs->ep->ep_entry,
+        slapi_entry_flag_is_set(ep->ep_entry,
                                 SLAPI_ENTRY_FLAG_TOMBSTONE)) {
         /* We only dump the tombstones if the user needs to create
          * a replica from the ldif */
-        goto bail; /* go to next loop */
+        return NULL;
     }
-    (*expargs->cnt)++;
 
     /* do not output attributes that are in the "exclude" list */
     /* Also, decrypt any encrypted attributes, if we're asked to */
-    rc = slapi_entry_first_attr(expargs->ep->ep_entry, &this_attr);
+    rc = slapi_entry_first_attr(ep->ep_entry, &this_attr);
     while (0 == rc) {
         int dump_uniqueid = (expargs->options & SLAPI_DUMP_UNIQUEID) ? 1 : 0;
-        rc = slapi_entry_next_attr(expargs->ep->ep_entry,
+        rc = slapi_entry_next_attr(ep->ep_entry,
                                    this_attr, &next_attr);
         slapi_attr_get_type(this_attr, &type);
         if (dbmdb_ldbm_exclude_attr_from_export(li, type, dump_uniqueid)) {
-            slapi_entry_delete_values(expargs->ep->ep_entry, type, NULL);
+            slapi_entry_delete_values(ep->ep_entry, type, NULL);
         }
         this_attr = next_attr;
     }
     if (expargs->decrypt) {
         /* Decrypt in place */
-        rc = attrcrypt_decrypt_entry(be, expargs->ep);
+        rc = attrcrypt_decrypt_entry(be, ep);
         if (rc) {
-            slapi_log_err(SLAPI_LOG_ERR, "dbmdb_export_one_entry", "Failed to decrypt entry [%s] : %d\n",
-                          slapi_sdn_get_dn(&expargs->ep->ep_entry->e_sdn), rc);
+            slapi_log_err(SLAPI_LOG_ERR, "dbmdb_export_format_entry", "Failed to decrypt entry [%s] : %d\n",
+                          slapi_sdn_get_dn(&ep->ep_entry->e_sdn), rc);
         }
     }
     /*
@@ -467,7 +569,7 @@ dbmdb_export_one_entry(struct ldbminfo *li,
      * If it is not, put "{CLEAR}" in front of the password value.
      */
     {
-        char *pw = slapi_entry_attr_get_charptr(expargs->ep->ep_entry,
+        char *pw = slapi_entry_attr_get_charptr(ep->ep_entry,
                                                 "userpassword");
         if (pw && !slapi_is_encoded(pw)) {
             /* clear password does not have {CLEAR} storage scheme */
@@ -477,69 +579,354 @@ dbmdb_export_one_entry(struct ldbminfo *li,
             val.bv_len = strlen(val.bv_val);
             vals[0] = &val;
             vals[1] = NULL;
-            rc = slapi_entry_attr_replace(expargs->ep->ep_entry,
+            rc = slapi_entry_attr_replace(ep->ep_entry,
                                           "userpassword", vals);
             if (rc) {
                 slapi_log_err(SLAPI_LOG_ERR,
-                              "dbmdb_export_one_entry", "%s: Failed to add clear password storage scheme: %d\n",
-                              slapi_sdn_get_dn(&expargs->ep->ep_entry->e_sdn), rc);
+                              "dbmdb_export_format_entry", "%s: Failed to add clear password storage scheme: %d\n",
+                              slapi_sdn_get_dn(&ep->ep_entry->e_sdn), rc);
             }
             slapi_ch_free_string(&val.bv_val);
         }
         slapi_ch_free_string(&pw);
     }
-    data.mv_data = slapi_entry2str_with_options(expargs->ep->ep_entry,
-                                             &len, expargs->options);
-    data.mv_size = len + 1;
+    *len = 0;
+    ldif = slapi_entry2str_with_options(ep->ep_entry, len, expargs->options);
+    if (ldif) {
+        /* replace the terminating NUL by the entry separator */
+        ldif = slapi_ch_realloc(ldif, *len + 2);
+        ldif[(*len)++] = '\n';
+        ldif[*len] = '\0';
+    }
+    return ldif;
+}
+
+/*
+ * Write the ldif text of an entry (as built by dbmdb_export_format_entry)
+ * and report the progress.
+ */
+static int
+dbmdb_export_output_entry(ldbm_instance *inst,
+                          export_args *expargs,
+                          ID id,
+                          NIDS idindex,
+                          const char *ldif,
+                          int len)
+{
+    int wrc = 0;
 
     if (expargs->printkey & EXPORT_PRINTKEY) {
         char idstr[32];
 
-        sprintf(idstr, "# entry-id: %lu\n", (u_long)expargs->ep->ep_id);
-        wrc = write(expargs->fd, idstr, strlen(idstr));
+        sprintf(idstr, "# entry-id: %lu\n", (u_long)id);
+        wrc = dbmdb_export_write(expargs, idstr, strlen(idstr));
         if (wrc < 0) {
             goto bail;
         }
     }
-    wrc = write(expargs->fd, data.mv_data, len);
-    if (wrc < 0) {
-        goto bail;
-    }
-    wrc = write(expargs->fd, "\n", 1);
+    wrc = dbmdb_export_write(expargs, ldif, len);
     if (wrc < 0) {
         goto bail;
     }
-    slapi_ch_free(&data.mv_data);
-    data.mv_size = 0;
-    rc = 0;
+    (*expargs->cnt)++;
     if ((*expargs->cnt) % 1000 == 0) {
         int percent;
+        time_t elapsed = slapi_current_rel_time_t() - expargs->starttime;
+        double entries_per_second = elapsed ? (double)(*expargs->cnt) / (double)elapsed : 0;
 
         if (expargs->idl) {
-            percent = (expargs->idindex * 100 / expargs->idl->b_nids);
+            percent = (idindex * 100 / expargs->idl->b_nids);
         } else {
-            percent = (expargs->ep->ep_id * 100 / expargs->lastid);
+            percent = (id * 100 / expargs->lastid);
         }
         if (expargs->task) {
             slapi_task_log_status(expargs->task,
-                                  "%s: Processed %d entries (%d%%).",
-                                  inst->inst_name, *expargs->cnt, percent);
+                                  "%s: Processed %d entries (%d%%) (%.2f entries/sec).",
+                                  inst->inst_name, *expargs->cnt, percent, entries_per_second);
             slapi_task_log_notice(expargs->task,
-                                  "%s: Processed %d entries (%d%%).",
-                                  inst->inst_name, *expargs->cnt, percent);
+                                  "%s: Processed %d entries (%d%%) (%.2f entries/sec).",
+                                  inst->inst_name, *expargs->cnt, percent, entries_per_second);
         }
-        slapi_log_err(SLAPI_LOG_INFO, "dbmdb_export_one_entry", "export %s: Processed %d entries (%d%%).\n",
-                      inst->inst_name, *expargs->cnt, percent);
+        slapi_log_err(SLAPI_LOG_INFO, "dbmdb_export_output_entry", "export %s: Processed %d entries (%d%%) (%.2f entries/sec).\n",
+                      inst->inst_name, *expargs->cnt, percent, entries_per_second);
         *expargs->lastcnt = *expargs->cnt;
     }
 bail:
     if (wrc < 0) {
-        slapi_log_err(SLAPI_LOG_INFO, "dbmdb_export_one_entry", "export %s: Failed to write in export file. errno=%d\n", inst->inst_name, errno);
-        rc = wrc;
+        slapi_log_err(SLAPI_LOG_INFO, "dbmdb_export_output_entry", "export %s: Failed to write in export file. errno=%d\n", inst->inst_name, errno);
+    }
+    return wrc;
+}
+
+static int
+dbmdb_export_one_entry(struct ldbminfo *li,
+                 ldbm_instance *inst,
+                 export_args *expargs)
+{
+    char *ldif = NULL;
+    int len = 0;
+    int rc = 0;
+
+    ldif = dbmdb_export_format_entry(li, inst, expargs, expargs->ep, &len);
+    if (ldif) {
+        rc = dbmdb_export_output_entry(inst, expargs, expargs->ep->ep_id,
+                                       expargs->idindex, ldif, len);
+        slapi_ch_free_string(&ldif);
+    }
+    return rc;
+}
+
+/*
+ * Export workers (nsslapd-mdb-export-threads):
+ * The thread walking id2entry keeps deciding the entry order (parents
+ * first, RUV after the suffix) and resolving the dns, then queues the
+ * entries in a ring of slots. The workers decode and format the queued
+ * entries in parallel and the walking thread writes the formatted slots
+ * back in queue order, so the ldif is the same as a single threaded
+ * export.
+ */
+#define EXPORT_SLOT_FREE 0    /* slot can be reused */
+#define EXPORT_SLOT_QUEUED 1  /* waiting for a worker */
+#define EXPORT_SLOT_BUSY 2    /* a worker is formatting it */
+#define EXPORT_SLOT_READY 3   /* formatted, waiting to be written */
+#define EXPORT_SLOTS_PER_THREAD 64
+
+typedef struct _export_slot
+{
+    int state;
+    struct backentry *ep; /* entry to export ... */
+    char *dn;             /* ... or dn and id2entry record to decode */
+    char *data;           /* may be binary, see slapi_entry_is_bin() */
+    size_t datalen;
+    ID id;
+    NIDS idindex;
+    char *ldif; /* formatted entry (NULL if filtered out) */
+    int len;
+} export_slot_t;
+
+typedef struct _export_pool
+{
+    struct ldbminfo *li;
+    ldbm_instance *inst;
+    export_args *eargs;
+    int str2entry_options;
+    PRLock *lock;
+    PRCondVar *cv;
+    export_slot_t *slots;
+    uint64_t nbslots;
+    uint64_t queued;  /* number of slots queued so far */
+    uint64_t taken;   /* number of slots picked by the workers */
+    uint64_t written; /* number of slots written */
+    int nbthreads;
+    int running;      /* number of running workers */
+    int shutdown;
+} export_pool_t;
+
+static void
+dbmdb_export_worker(void *arg)
+{
+    export_pool_t *pool = (export_pool_t *)arg;
+    export_slot_t *slot = NULL;
+
+    PR_Lock(pool->lock);
+    while (1) {
+        while (!pool->shutdown && pool->taken == pool->queued) {
+            PR_WaitCondVar(pool->cv, PR_INTERVAL_NO_TIMEOUT);
+        }
+        if (pool->taken == pool->queued) {
+            break;
+        }
+        slot = &pool->slots[pool->taken++ % pool->nbslots];
+        slot->state = EXPORT_SLOT_BUSY;
+        PR_Unlock(pool->lock);
+
+        if (!slot->ep) {
+            slot->ep = backentry_alloc();
+            slot->ep->ep_entry = slapi_record2entry(slot->dn, NULL, slot->data, slot->datalen,
+                                                    pool->str2entry_options | SLAPI_STR2ENTRY_NO_ENTRYDN);
+            if (slot->ep->ep_entry) {
+                slot->ep->ep_id = slot->id;
+            } else {
+                slapi_log_err(SLAPI_LOG_WARNING, "dbmdb_export_worker",
+                              "Skipping badly formatted entry with id %lu\n",
+                              (u_long)slot->id);
+            }
+        }
+        if (slot->ep->ep_entry) {
+            slot->ldif = dbmdb_export_format_entry(pool->li, pool->inst, pool->eargs,
+                                                   slot->ep, &slot->len);
+        }
+        backentry_free(&slot->ep);
+        slapi_ch_free_string(&slot->dn);
+        slapi_ch_free_string(&slot->data);
+        slot->datalen = 0;
+
+        PR_Lock(pool->lock);
+        slot->state = EXPORT_SLOT_READY;
+        PR_NotifyAllCondVar(pool->cv);
     }
+    pool->running--;
+    PR_NotifyAllCondVar(pool->cv);
+    PR_Unlock(pool->lock);
+}
+
+static export_pool_t *
+dbmdb_export_pool_start(struct ldbminfo *li, ldbm_instance *inst, export_args *eargs,
+                        int nbthreads, int str2entry_options)
+{
+    export_pool_t *pool = (export_pool_t *)slapi_ch_calloc(1, sizeof(export_pool_t));
+    int i;
+
+    pool->li = li;
+    pool->inst = inst;
+    pool->eargs = eargs;
+    pool->str2entry_options = str2entry_options;
+    pool->nbthreads = nbthreads;
+    pool->nbslots = nbthreads * EXPORT_SLOTS_PER_THREAD;
+    pool->slots = (export_slot_t *)slapi_ch_calloc(pool->nbslots, sizeof(export_slot_t));
+    pool->lock = PR_NewLock();
+    pool->cv = PR_NewCondVar(pool->lock);
+
+    for (i = 0; i < nbthreads; i++) {
+        if (!PR_CreateThread(PR_USER_THREAD, dbmdb_export_worker, pool,
+                             PR_PRIORITY_NORMAL, PR_GLOBAL_BOUND_THREAD,
+                             PR_UNJOINABLE_THREAD, SLAPD_DEFAULT_THREAD_STACKSIZE)) {
+            PRErrorCode prerr = PR_GetError();
+            slapi_log_err(SLAPI_LOG_ERR, "dbmdb_export_pool_start",
+                          "Unable to spawn export thread, " SLAPI_COMPONENT_NAME_NSPR " error %d (%s)\n",
+                          prerr, slapd_pr_strerror(prerr));
+            break;
+        }
+        PR_Lock(pool->lock);
+        pool->running++;
+        PR_Unlock(pool->lock);
+    }
+    if (pool->running == 0) {
+        PR_DestroyCondVar(pool->cv);
+        PR_DestroyLock(pool->lock);
+        slapi_ch_free((void **)&pool->slots);
+        slapi_ch_free((void **)&pool);
+        return NULL;
+    }
+    return pool;
+}
+
+/*
+ * Write the formatted slots in queue order.
+ * If wait is set, wait until all queued slots are written; otherwise
+ * write what is ready and wait only if the next slot to queue is busy.
+ * Must be called with the pool lock held.
+ */
+static int
+dbmdb_export_pool_flush(export_pool_t *pool, int wait)
+{
+    int rc = 0;
+
+    while (pool->written < pool->queued) {
+        export_slot_t *slot = &pool->slots[pool->written % pool->nbslots];
+
+        if (slot->state != EXPORT_SLOT_READY) {
+            if (!wait && pool->queued - pool->written < pool->nbslots) {
+                break;
+            }
+            PR_WaitCondVar(pool->cv, PR_INTERVAL_NO_TIMEOUT);
+            continue;
+        }
+        if (slot->ldif && !rc) {
+            /* Formatting is done so the slot is not touched by the workers */
+            PR_Unlock(pool->lock);
+            rc = dbmdb_export_output_entry(pool->inst, pool->eargs, slot->id,
+                                           slot->idindex, slot->ldif, slot->len);
+            PR_Lock(pool->lock);
+        }
+        slapi_ch_free_string(&slot->ldif);
+        slot->state = EXPORT_SLOT_FREE;
+        pool->written++;
+    }
+    return rc;
+}
+
+/*
+ * Queue an entry: either an already built entry (*ep, the pool takes
+ * it over) or a dn and an id2entry record of datalen bytes that the
+ * worker will decode.
+ */
+static int
+dbmdb_export_pool_queue(export_pool_t *pool, struct backentry **ep,
+                        const char *dn, const char *data, size_t datalen,
+                        ID id, NIDS idindex)
+{
+    export_slot_t *slot = NULL;
+    int rc = 0;
+
+    PR_Lock(pool->lock);
+    rc = dbmdb_export_pool_flush(pool, 0);
+    slot = &pool->slots[pool->queued % pool->nbslots];
+    PR_ASSERT(slot->state == EXPORT_SLOT_FREE);
+    if (ep) {
+        slot->ep = *ep;
+        *ep = NULL;
+    } else {
+        slot->dn = slapi_ch_strdup(dn);
+        /* binary records hold NUL bytes, copy the whole record */
+        slot->data = (char *)slapi_ch_malloc(datalen + 1);
+        memcpy(slot->data, data, datalen);
+        slot->data[datalen] = '\0';
+        slot->datalen = datalen;
+    }
+    slot->id = id;
+    slot->idindex = idindex;
+    slot->state = EXPORT_SLOT_QUEUED;
+    pool->queued++;
+    PR_NotifyAllCondVar(pool->cv);
+    PR_Unlock(pool->lock);
+    return rc;
+}
+
+/* Write all pending entries then stop the workers */
+static int
+dbmdb_export_pool_stop(export_pool_t **ppool)
+{
+    export_pool_t *pool = *ppool;
+    int rc = 0;
+
+    if (!pool) {
+        return 0;
+    }
+    PR_Lock(pool->lock);
+    rc = dbmdb_export_pool_flush(pool, 1);
+    pool->shutdown = 1;
+    PR_NotifyAllCondVar(pool->cv);
+    while (pool->running > 0) {
+        PR_WaitCondVar(pool->cv, PR_INTERVAL_NO_TIMEOUT);
+    }
+    PR_Unlock(pool->lock);
+    PR_DestroyCondVar(pool->cv);
+    PR_DestroyLock(pool->lock);
+    slapi_ch_free((void **)&pool->slots);
+    slapi_ch_free((void **)ppool);
     return rc;
 }
 
+/*
+ * Export an entry built by the id2entry walk: the entry is either
+ * written now or handed over to the export workers (in which case *ep
+ * is reset to NULL).
+ */
+static int
+dbmdb_export_entry(struct ldbminfo *li,
+                   ldbm_instance *inst,
+                   export_args *expargs,
+                   struct backentry **ep)
+{
+    if (expargs->pool) {
+        return dbmdb_export_pool_queue(expargs->pool, ep, NULL, NULL, 0,
+                                       (*ep)->ep_id, expargs->idindex);
+    }
+    expargs->ep = *ep;
+    return dbmdb_export_one_entry(li, inst, expargs);
+}
+
 /*
  * dbmdb_db2ldif - backend routine to convert database to an
  * ldif file.
@@ -593,6 +980,7 @@ dbmdb_db2ldif(Slapi_PBlock *pb)
     int32_t skip_ruv = 0;
     dbmdb_cursor_t cur = {0};
     uint size = 0;
+    char *plain = NULL;
     int wrc = 0;
 
     slapi_log_err(SLAPI_LOG_TRACE, "dbmdb_db2ldif", "=>\n");
@@ -838,6 +1226,27 @@ dbmdb_db2ldif(Slapi_PBlock *pb)
         idindex = 0;
     }
 
+    eargs.decrypt = decrypt;
+    eargs.options = options;
+    eargs.printkey = printkey;
+    eargs.idl = idl;
+    eargs.lastid = lastid;
+    eargs.fd = fd;
+    eargs.task = task;
+    eargs.include_suffix = include_suffix;
+    eargs.exclude_suffix = exclude_suffix;
+    eargs.cnt = &cnt;
+    eargs.lastcnt = &lastcnt;
+    eargs.starttime = slapi_current_rel_time_t();
+
+    if (fd != STDOUT_FILENO && dbmdb_export_open_zstream(&eargs, fname)) {
+        slapi_task_log_notice(task, "%s: Failed to initialize the gzip compression.", inst->inst_name);
+        slapi_log_err(SLAPI_LOG_ERR, "dbmdb_db2ldif",
+                      "db2ldif: %s: Failed to initialize the gzip compression\n", inst->inst_name);
+        return_value = -1;
+        goto bye;
+    }
+
     /* When user has specifically asked not to print the version
      * or when this is not the first backend that is append into
      * this file : don't print the version
@@ -850,7 +1259,7 @@ dbmdb_db2ldif(Slapi_PBlock *pb)
                  */
 
         sprintf(vstr, "version: %d\n\n", myversion);
-        wrc = write(fd, vstr, strlen(vstr));
+        wrc = dbmdb_export_write(&eargs, vstr, strlen(vstr));
         if (wrc < 0) {
             goto bye;
         } else {
@@ -858,15 +1267,20 @@ dbmdb_db2ldif(Slapi_PBlock *pb)
         }
     }
 
-    eargs.decrypt = decrypt;
-    eargs.options = options;
-    eargs.printkey = printkey;
-    eargs.idl = idl;
-    eargs.lastid = lastid;
-    eargs.fd = fd;
-    eargs.task = task;
-    eargs.include_suffix = include_suffix;
-    eargs.exclude_suffix = exclude_suffix;
+    if (MDB_CONFIG(li)->dsecfg.export_threads > 1) {
+        eargs.pool = dbmdb_export_pool_start(li, inst, &eargs,
+                                             MDB_CONFIG(li)->dsecfg.export_threads,
+                                             str2entry_options);
+        if (eargs.pool) {
+            slapi_log_err(SLAPI_LOG_INFO, "dbmdb_db2ldif",
+                          "export %s: Using %d export threads.\n",
+                          inst->inst_name, eargs.pool->running);
+        } else {
+            slapi_log_err(SLAPI_LOG_WARNING, "dbmdb_db2ldif",
+                          "export %s: No export thread could be started, exporting from a single thread.\n",
+                          inst->inst_name);
+        }
+    }
 
     while (keepgoing) {
         /*
@@ -914,11 +1328,10 @@ dbmdb_db2ldif(Slapi_PBlock *pb)
                  * check if ruv is pending and write it
                  */
                 if (pending_ruv) {
-                    eargs.ep = pending_ruv;
                     eargs.idindex = idindex;
                     eargs.cnt = &cnt;
                     eargs.lastcnt = &lastcnt;
-                    wrc = dbmdb_export_one_entry(li, inst, &eargs);
+                    wrc = dbmdb_export_entry(li, inst, &eargs, &pending_ruv);
                     backentry_free(&pending_ruv);
                     if (wrc) {
                         break;
@@ -941,28 +1354,34 @@ dbmdb_db2ldif(Slapi_PBlock *pb)
         }
 
         /* call post-entry plugin */
+        size = data.mv_size;
         plugin_call_entryfetch_plugins((char **)&data.mv_data, &size);
         data.mv_size = size;
 
+        /* data points into the map: keep the inflated copy until the next entry */
+        slapi_ch_free_string(&plain);
+        if (id2entry_decompress(be, data.mv_data, size, &plain, &size) > 0) {
+            data.mv_data = plain;
+            data.mv_size = size;
+        }
+
         ep = backentry_alloc();
         char *rdn = NULL;
+        char *dn = NULL;
 
-        /* rdn is allocated in get_value_from_string */
-        rc = get_value_from_string((const char *)data.mv_data, "rdn", &rdn);
-        if (rc) {
-            /* data.mv_data may not include rdn: ..., try "dn: ..." */
-            ep->ep_entry = slapi_str2entry(data.mv_data,
-                                           str2entry_options | SLAPI_STR2ENTRY_NO_ENTRYDN);
-        } else {
+        /* rdn is allocated in get_value_from_record */
+        /* if data.mv_data does not include rdn: ..., dn stays NULL and
+         * the entry is decoded from its "dn: ..." */
+        rc = get_value_from_record((const char *)data.mv_data, data.mv_size, "rdn", &rdn);
+        if (0 == rc) {
             char *pid_str = NULL;
             char *pdn = NULL;
             ID pid = NOID;
-            char *dn = NULL;
             struct backdn *bdn = NULL;
             Slapi_RDN psrdn = {0};
 
             /* get a parent pid */
-            rc = get_value_from_string((const char *)data.mv_data,
+            rc = get_value_from_record((const char *)data.mv_data, data.mv_size,
                                        LDBM_PARENTID_STR, &pid_str);
             if (rc) {
                 /* this could be a suffix or the RUV entry.
@@ -1079,11 +1498,22 @@ dbmdb_db2ldif(Slapi_PBlock *pb)
                                   dn);
                 }
             }
-            ep->ep_entry = slapi_str2entry_ext(dn, NULL, data.mv_data,
-                                            str2entry_options | SLAPI_STR2ENTRY_NO_ENTRYDN);
             slapi_ch_free_string(&rdn);
         }
 
+        if (eargs.pool && !skip_ruv) {
+            /* let the export workers decode and format the entry */
+            backentry_free(&ep);
+            rc = dbmdb_export_pool_queue(eargs.pool, NULL, dn, data.mv_data,
+                                         data.mv_size, temp_id, idindex);
+            if (rc && !return_value) {
+                return_value = rc;
+            }
+            continue;
+        }
+        ep->ep_entry = slapi_record2entry(dn, NULL, data.mv_data, data.mv_size,
+                                          str2entry_options | SLAPI_STR2ENTRY_NO_ENTRYDN);
+
         if ((ep->ep_entry) != NULL) {
             ep->ep_id = temp_id;
         } else {
@@ -1104,11 +1534,10 @@ dbmdb_db2ldif(Slapi_PBlock *pb)
             continue;
         }
 
-        eargs.ep = ep;
         eargs.idindex = idindex;
         eargs.cnt = &cnt;
         eargs.lastcnt = &lastcnt;
-        rc = dbmdb_export_one_entry(li, inst, &eargs);
+        rc = dbmdb_export_entry(li, inst, &eargs, &ep);
         backentry_free(&ep);
         if (rc && !return_value) {
             return_value = rc;
@@ -1118,6 +1547,12 @@ dbmdb_db2ldif(Slapi_PBlock *pb)
     if (return_value == MDB_NOTFOUND)
         return_value = 0;
 
+    /* write the entries still queued to the export workers */
+    rc = dbmdb_export_pool_stop(&eargs.pool);
+    if (rc && !return_value) {
+        return_value = rc;
+    }
+
     /* done cycling thru entries to write */
     if (lastcnt != cnt) {
         if (task) {
@@ -1139,10 +1574,15 @@ dbmdb_db2ldif(Slapi_PBlock *pb)
     }
 
 bye:
+    dbmdb_export_pool_stop(&eargs.pool);
+    if (dbmdb_export_close_zstream(&eargs, !wrc) < 0 && !wrc) {
+        wrc = -1;
+    }
     if (idl) {
         idl_free(&idl);
     }
     dbmdb_close_cursor(&cur, 1);
+    slapi_ch_free_string(&plain);
 
     dblayer_release_id2entry(be, db);
 
@@ -1337,6 +1777,8 @@ _get_and_add_parent_rdns(backend *be,
     struct backentry *ep = NULL;
     char *rdn = NULL;
     MDB_val key, data;
+    char *plain = NULL;
+    uint32_t plainsize = 0;
     char *pid_str = NULL;
     ID storedid;
     ID temp_pid = NOID;
@@ -1399,8 +1841,12 @@ _get_and_add_parent_rdns(backend *be,
                           "Failed to position cursor at ID " ID_FMT "\n", id);
             goto bail;
         }
-        /* rdn is allocated in get_value_from_string */
-        rc = get_value_from_string((const char *)data.mv_data, "rdn", &rdn);
+        if (id2entry_decompress(be, data.mv_data, data.mv_size, &plain, &plainsize) > 0) {
+            data.mv_data = plain;
+            data.mv_size = plainsize;
+        }
+        /* rdn is allocated in get_value_from_record */
+        rc = get_value_from_record((const char *)data.mv_data, data.mv_size, "rdn", &rdn);
         if (rc) {
             slapi_log_err(SLAPI_LOG_ERR, "_get_and_add_parent_rdns",
                           "Failed to get rdn of entry " ID_FMT "\n", id);
@@ -1414,7 +1860,7 @@ _get_and_add_parent_rdns(backend *be,
             goto bail;
         }
         /* pid */
-        rc = get_value_from_string((const char *)data.mv_data,
+        rc = get_value_from_record((const char *)data.mv_data, data.mv_size,
                                    LDBM_PARENTID_STR, &pid_str);
         if (rc) {
             rc = 0; /* assume this is a suffix */
@@ -1455,8 +1901,8 @@ _get_and_add_parent_rdns(backend *be,
                           rdn, id);
             goto bail;
         }
-        ep->ep_entry = slapi_str2entry_ext(dn, NULL, data.mv_data,
-                                           SLAPI_STR2ENTRY_NO_ENTRYDN);
+        ep->ep_entry = slapi_record2entry(dn, NULL, data.mv_data, data.mv_size,
+                                          SLAPI_STR2ENTRY_NO_ENTRYDN);
         ep->ep_id = id;
         slapi_ch_free_string(&dn);
     }
@@ -1479,12 +1925,10 @@ _get_and_add_parent_rdns(backend *be,
             rc = -1;
             goto bail;
         }
-        eargs->ep = ep;
-        rc = dbmdb_export_one_entry(li, inst, eargs);
+        rc = dbmdb_export_entry(li, inst, eargs, &ep);
         if (rc) {
             slapi_log_err(SLAPI_LOG_ERR, "_get_and_add_parent_rdns",
-                          "Failed to export an entry %s\n",
-                          slapi_sdn_get_dn(slapi_entry_get_sdn(ep->ep_entry)));
+                          "Failed to export an entry (ID: %d)\n", id);
             goto bail;
         }
         rc = idl_append_extend(&(eargs->pre_exported_idl), id);
@@ -1498,6 +1942,7 @@ bail:
     backentry_free(&ep);
     slapi_rdn_done(&mysrdn);
     slapi_ch_free_string(&rdn);
+    slapi_ch_free_string(&plain);
     return rc;
 }
 
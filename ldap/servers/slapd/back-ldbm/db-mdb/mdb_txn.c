@@ -31,6 +31,7 @@ typedef struct dbmdb_txn_t {
 
 
 static PRUintn thread_private_mdb_txn_stack;
+static PRUintn thread_private_mdb_gc_seq;   /* last group committed txn of the thread */
 static dbmdb_ctx_t *g_ctx;  /* Global dbmdb context */
 
 static void
@@ -60,6 +61,7 @@ init_mdbtxn(dbmdb_ctx_t *ctx)
 {
     g_ctx = ctx;
     PR_NewThreadPrivateIndex(&thread_private_mdb_txn_stack, cleanup_mdbtxn_stack);
+    PR_NewThreadPrivateIndex(&thread_private_mdb_gc_seq, NULL);
 }
 
 static dbmdb_txn_t **get_mdbtxnanchor(void)
@@ -207,6 +209,67 @@ int dbmdb_start_txn(const char *funcname, dbi_txn_t *parent_txn, int flags, dbi_
     return rc;
 }
 
+/*
+ * Group commit: when the env is open with MDB_NOMETASYNC, committing a top
+ * level write txn flushes its data pages but not the meta page that makes
+ * it durable, so a crash may undo it (the db itself stays consistent).
+ * dbmdb_end_txn only numbers the commit and remembers that number in the
+ * thread; once the operation has released its locks, dbmdb_txn_sync waits
+ * until a flush started after that commit has completed.  The first waiter
+ * flushes the env for every txn committed so far while the others sleep,
+ * so writers that commit together share the meta page flush and the next
+ * writers already hold the write lock meanwhile.
+ */
+static void
+dbmdb_group_commit_register(void)
+{
+    uint64_t seq;
+
+    pthread_mutex_lock(&g_ctx->gc_lock);
+    seq = ++g_ctx->gc_committed;
+    pthread_mutex_unlock(&g_ctx->gc_lock);
+    PR_SetThreadPrivate(thread_private_mdb_gc_seq, (void *)(uintptr_t)seq);
+}
+
+int
+dbmdb_txn_sync(struct ldbminfo *li __attribute__((unused)))
+{
+    uint64_t mine = (uint64_t)(uintptr_t)PR_GetThreadPrivate(thread_private_mdb_gc_seq);
+    uint64_t target;
+    int rc = 0;
+
+    if (!g_ctx || !g_ctx->group_commit || mine == 0) {
+        return 0;
+    }
+    PR_SetThreadPrivate(thread_private_mdb_gc_seq, NULL);
+
+    pthread_mutex_lock(&g_ctx->gc_lock);
+    while (g_ctx->gc_synced < mine && rc == 0) {
+        if (g_ctx->gc_syncing) {
+            pthread_cond_wait(&g_ctx->gc_cv, &g_ctx->gc_lock);
+            continue;
+        }
+        g_ctx->gc_syncing = 1;
+        target = g_ctx->gc_committed;
+        pthread_mutex_unlock(&g_ctx->gc_lock);
+        rc = mdb_env_sync(g_ctx->env, 1);
+        pthread_mutex_lock(&g_ctx->gc_lock);
+        g_ctx->gc_syncing = 0;
+        g_ctx->gc_nbsync++;
+        if (rc == 0 && g_ctx->gc_synced < target) {
+            g_ctx->gc_synced = target;
+        }
+        pthread_cond_broadcast(&g_ctx->gc_cv);
+    }
+    pthread_mutex_unlock(&g_ctx->gc_lock);
+    if (rc) {
+        slapi_log_error(SLAPI_LOG_CRIT, "dbmdb_txn_sync",
+            "Failed to flush the database environment, the last committed txns may be lost on a crash. err=%d %s\n",
+            rc, mdb_strerror(rc));
+    }
+    return dbmdb_map_error(__FUNCTION__, rc);
+}
+
 int dbmdb_end_txn(const char *funcname, int rc, dbi_txn_t **txn)
 {
     dbmdb_txn_t *ltxn = (dbmdb_txn_t*)*txn;
@@ -224,6 +287,9 @@ int dbmdb_end_txn(const char *funcname, int rc, dbi_txn_t **txn)
             TXN_ABORT(ltxn->txn);
         } else {
             rc = TXN_COMMIT(ltxn->txn);
+            if (rc == 0 && g_ctx->group_commit && !ltxn->parent) {
+                dbmdb_group_commit_register();
+            }
         }
         GET_HRTIME(&hr_time_now);
         slapi_timespec_diff(&hr_time_now, &ltxn->hr_time_start, &hr_elapsed);
@@ -482,6 +482,9 @@ dblayer_instance_close(backend *be)
         cache_clear(&inst->inst_dncache, CACHE_TYPE_DN);
     }
 
+    /* the database may be replaced (import, restore): read it again when needed */
+    scope_index_reset(be);
+
     if (attrcrypt_cleanup_private(inst)) {
         slapi_log_err(SLAPI_LOG_ERR,
                       "dblayer_instance_close", "Failed to clean up attrcrypt system for %s\n",
@@ -803,6 +806,24 @@ dblayer_read_txn_commit(backend *be, back_txn *txn)
     return (dblayer_txn_commit_ext(li, txn, PR_FALSE));
 }
 
+/*
+ * Wait until the txns committed by this thread are on disk, for db
+ * implementations that delay the flush to share it between writers.
+ * Called once the backend lock is released so other writers can proceed.
+ * The txn is already committed at that point: a failed flush is logged
+ * by the db implementation but must not fail (and revert) the operation.
+ */
+static int
+dblayer_txn_sync(struct ldbminfo *li, int rc)
+{
+    dblayer_private *priv = (dblayer_private *)li->li_dblayer_private;
+
+    if (0 == rc && priv->dblayer_txn_sync_fn) {
+        (void)priv->dblayer_txn_sync_fn(li);
+    }
+    return rc;
+}
+
 int
 dblayer_txn_commit(backend *be, back_txn *txn)
 {
@@ -819,7 +840,7 @@ dblayer_txn_commit(backend *be, back_txn *txn)
             dblayer_unlock_backend(be);
         }
     }
-    return rc;
+    return dblayer_txn_sync(li, rc);
 }
 
 int
@@ -870,7 +891,7 @@ dblayer_txn_begin_all(struct ldbminfo *li, back_txnid parent_txn, back_txn *txn)
 int
 dblayer_txn_commit_all(struct ldbminfo *li, back_txn *txn)
 {
-    return (dblayer_txn_commit_ext(li, txn, PR_TRUE));
+    return dblayer_txn_sync(li, dblayer_txn_commit_ext(li, txn, PR_TRUE));
 }
 
 int
@@ -1237,6 +1258,25 @@ dblayer_backup(struct ldbminfo *li, char *dest_dir, Slapi_Task *task)
     return priv->dblayer_backup_fn(li, dest_dir, task);
 }
 
+/* Backup only what changed since the backup in base_dir */
+int
+dblayer_backup_incremental(struct ldbminfo *li, char *dest_dir, char *base_dir, Slapi_Task *task)
+{
+    dblayer_private *priv = (dblayer_private *)li->li_dblayer_private;
+
+    if (NULL == priv->dblayer_backup_incremental_fn) {
+        slapi_log_err(SLAPI_LOG_ERR, "dblayer_backup_incremental",
+                      "Incremental backups are not supported by the %s database implementation.\n",
+                      li->li_backend_implement);
+        if (task) {
+            slapi_task_log_notice(task, "Incremental backups are not supported by the %s database implementation.",
+                                  li->li_backend_implement);
+        }
+        return LDAP_UNWILLING_TO_PERFORM;
+    }
+    return priv->dblayer_backup_incremental_fn(li, dest_dir, base_dir, task);
+}
+
 
 /*
  * Restore is pretty easy.
@@ -63,6 +63,7 @@ typedef int dblayer_start_fn_t(struct ldbminfo *li, int flags);
 typedef int dblayer_close_fn_t(struct ldbminfo *li, int flags);
 typedef int dblayer_instance_start_fn_t(backend *be, int flags);
 typedef int dblayer_backup_fn_t(struct ldbminfo *li, char *dest_dir, Slapi_Task *task);
+typedef int dblayer_backup_incremental_fn_t(struct ldbminfo *li, char *dest_dir, char *base_dir, Slapi_Task *task);
 typedef int dblayer_verify_fn_t(Slapi_PBlock *pb);
 typedef int dblayer_db_size_fn_t(Slapi_PBlock *pb);
 typedef int dblayer_ldif2db_fn_t(Slapi_PBlock *pb);
@@ -75,6 +76,7 @@ typedef int dblayer_restore_fn_t(struct ldbminfo *li, char *src_dir, Slapi_Task
 typedef int dblayer_txn_begin_fn_t(struct ldbminfo *li, back_txnid parent_txn, back_txn *txn, PRBool use_lock);
 typedef int dblayer_txn_commit_fn_t(struct ldbminfo *li, back_txn *txn, PRBool use_lock);
 typedef int dblayer_txn_abort_fn_t(struct ldbminfo *li, back_txn *txn, PRBool use_lock);
+typedef int dblayer_txn_sync_fn_t(struct ldbminfo *li);
 typedef int dblayer_get_info_fn_t(Slapi_Backend *be, int cmd, void **info);
 typedef int dblayer_set_info_fn_t(Slapi_Backend *be, int cmd, void **info);
 typedef int dblayer_back_ctrl_fn_t(Slapi_Backend *be, int cmd, void *info);
@@ -146,6 +148,7 @@ struct dblayer_private
     dblayer_close_fn_t *dblayer_close_fn;
     dblayer_instance_start_fn_t *dblayer_instance_start_fn;
     dblayer_backup_fn_t *dblayer_backup_fn;
+    dblayer_backup_incremental_fn_t *dblayer_backup_incremental_fn; /* optional */
     dblayer_verify_fn_t *dblayer_verify_fn;
     dblayer_db_size_fn_t *dblayer_db_size_fn;
     dblayer_ldif2db_fn_t *dblayer_ldif2db_fn;
@@ -158,6 +161,7 @@ struct dblayer_private
     dblayer_txn_begin_fn_t *dblayer_txn_begin_fn;
     dblayer_txn_commit_fn_t *dblayer_txn_commit_fn;
     dblayer_txn_abort_fn_t *dblayer_txn_abort_fn;
+    dblayer_txn_sync_fn_t *dblayer_txn_sync_fn; /* optional: wait until the txns committed by the thread are durable */
     dblayer_get_info_fn_t *dblayer_get_info_fn;
     dblayer_set_info_fn_t *dblayer_set_info_fn;
     dblayer_back_ctrl_fn_t *dblayer_back_ctrl_fn;
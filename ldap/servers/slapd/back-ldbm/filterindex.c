@@ -292,6 +292,7 @@ ava_candidates(
         tmp.bv = *bval;
         tmp.v_csnset = NULL;
         tmp.v_flags = 0;
+        tmp.v_norm = NULL;
         fake.bv.bv_val = buf;
         fake.bv.bv_len = sizeof(buf);
         ptr[0] = &fake;
@@ -14,9 +14,351 @@
 /* id2entry.c - routines to deal with the id2entry index */
 
 #include "back-ldbm.h"
+#include <zlib.h>
 
 #define ID2ENTRY "id2entry"
 
+/*
+ * Compressed id2entry records
+ *
+ * When nsslapd-id2entry-compression is on, each record (text or binary
+ * format) is deflated against a preset dictionary before it is handed to
+ * the entry store plugins, so compression happens before encryption:
+ *
+ *   "\0EZ" version(1) dictid(u32) rawlen(u32) deflate-stream
+ *
+ * Integers are little endian.  The dictionary is built per backend from a
+ * fixed list of tokens that show up in nearly every entry, followed by the
+ * backend suffix, which zlib can reference most cheaply.  It is therefore
+ * derived rather than stored; dictid is its adler32 and lets the reader
+ * detect a record written against another dictionary (e.g. the backend
+ * suffix was renamed).  Records that do not shrink are stored as is, and
+ * readers accept both forms, so the option can be switched at any time.
+ */
+#define ID2ENTRY_Z_MAGIC "\0EZ"
+#define ID2ENTRY_Z_VERSION 1
+#define ID2ENTRY_Z_HDRLEN 12
+#define ID2ENTRY_Z_MINLEN 64 /* not worth it below that */
+/* deflate never expands more than that: 258 bytes out of 2 bits at best */
+#define ID2ENTRY_Z_MAXRATIO 1032
+
+static const char id2entry_dict_seed[] =
+    "userPassword: {PBKDF2-SHA512}"
+    "telephoneNumber: "
+    "description: "
+    "uniqueMember: "
+    "member: uid="
+    "memberOf: cn="
+    "homeDirectory: /home/"
+    "loginShell: /bin/bash"
+    "gidNumber: "
+    "uidNumber: "
+    "givenName: "
+    "displayName: "
+    "mail: "
+    "objectClass: nsTombstone"
+    "objectClass: groupOfUniqueNames"
+    "objectClass: groupOfNames"
+    "objectClass: organizationalUnit"
+    "objectClass: posixAccount"
+    "objectClass: inetUser"
+    "objectClass: nsPerson"
+    "objectClass: nsAccount"
+    "objectClass: nsOrgPerson"
+    "objectClass: inetOrgPerson"
+    "objectClass: organizationalPerson"
+    "objectClass: person"
+    "objectClass: top"
+    ";adcsn-;vucsn-;vdcsn-;mdcsn-"
+    "nsds5ReplConflict: "
+    "nscpEntryDN: "
+    "entryUSN: "
+    "modifiersName: cn=directory manager"
+    "creatorsName: cn=directory manager"
+    "modifyTimestamp: 20"
+    "createTimestamp: 20"
+    "nsUniqueId: "
+    "parentid: "
+    "entryid: "
+    "uid: "
+    "sn: "
+    "cn: "
+    "ou=People,"
+    "ou=Groups,"
+    "rdn: ";
+
+struct id2entry_dict
+{
+    char *dict;
+    size_t len;
+    uint32_t id;
+};
+
+static inline void
+id2entry_z_put32(unsigned char *p, uint32_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = (v >> 24) & 0xff;
+}
+
+static inline uint32_t
+id2entry_z_get32(const unsigned char *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) |
+           ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* suffix is the normalized suffix of the backend, or NULL */
+static struct id2entry_dict *
+id2entry_new_dict(const char *suffix)
+{
+    struct id2entry_dict *d = (struct id2entry_dict *)slapi_ch_calloc(1, sizeof(struct id2entry_dict));
+    size_t slen = suffix ? strlen(suffix) : 0;
+
+    d->len = sizeof(id2entry_dict_seed) - 1 + slen;
+    d->dict = slapi_ch_malloc(d->len);
+    memcpy(d->dict, id2entry_dict_seed, sizeof(id2entry_dict_seed) - 1);
+    if (slen) {
+        memcpy(d->dict + sizeof(id2entry_dict_seed) - 1, suffix, slen);
+    }
+    d->id = (uint32_t)adler32(adler32(0L, Z_NULL, 0), (const Bytef *)d->dict, (uInt)d->len);
+    return d;
+}
+
+static void
+id2entry_dict_free(struct id2entry_dict **d)
+{
+    if (*d) {
+        slapi_ch_free((void **)&(*d)->dict);
+        slapi_ch_free((void **)d);
+    }
+}
+
+static struct id2entry_dict *
+id2entry_get_dict(ldbm_instance *inst)
+{
+    struct id2entry_dict *d = __atomic_load_n(&inst->inst_id2entry_dict, __ATOMIC_ACQUIRE);
+    const char *suffix = NULL;
+
+    if (d) {
+        return d;
+    }
+    PR_Lock(inst->inst_config_mutex);
+    d = inst->inst_id2entry_dict;
+    if (d == NULL) {
+        if (inst->inst_be && inst->inst_be->be_suffix) {
+            suffix = slapi_sdn_get_ndn(inst->inst_be->be_suffix);
+        }
+        d = id2entry_new_dict(suffix);
+        __atomic_store_n(&inst->inst_id2entry_dict, d, __ATOMIC_RELEASE);
+    }
+    PR_Unlock(inst->inst_config_mutex);
+    return d;
+}
+
+void
+id2entry_free_dict(ldbm_instance *inst)
+{
+    id2entry_dict_free(&inst->inst_id2entry_dict);
+}
+
+int
+id2entry_is_compressed(const char *data, size_t size)
+{
+    return data && size > ID2ENTRY_Z_HDRLEN &&
+           memcmp(data, ID2ENTRY_Z_MAGIC, 3) == 0 &&
+           (unsigned char)data[3] == ID2ENTRY_Z_VERSION;
+}
+
+/*
+ * Deflate an id2entry record.  Returns 1 and sets *packed (to be freed by
+ * the caller) when compression is enabled and the record shrinks, 0 when
+ * the record should be stored as is.
+ */
+int
+id2entry_compress(backend *be, const char *data, uint32_t size, char **packed, uint32_t *packedsize)
+{
+    ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
+    struct id2entry_dict *d = NULL;
+    z_stream zs = {0};
+    uLong bound;
+    char *out = NULL;
+    int rc;
+
+    *packed = NULL;
+    if (!inst->inst_li->li_id2entry_compression || size < ID2ENTRY_Z_MINLEN) {
+        return 0;
+    }
+    d = id2entry_get_dict(inst);
+    if (deflateInit(&zs, Z_DEFAULT_COMPRESSION) != Z_OK) {
+        return 0;
+    }
+    if (deflateSetDictionary(&zs, (const Bytef *)d->dict, (uInt)d->len) != Z_OK) {
+        deflateEnd(&zs);
+        return 0;
+    }
+    bound = deflateBound(&zs, size);
+    out = slapi_ch_malloc(ID2ENTRY_Z_HDRLEN + bound);
+    zs.next_in = (Bytef *)data;
+    zs.avail_in = size;
+    zs.next_out = (Bytef *)out + ID2ENTRY_Z_HDRLEN;
+    zs.avail_out = (uInt)bound;
+    rc = deflate(&zs, Z_FINISH);
+    if (rc != Z_STREAM_END || ID2ENTRY_Z_HDRLEN + zs.total_out >= size) {
+        deflateEnd(&zs);
+        slapi_ch_free_string(&out);
+        return 0;
+    }
+    memcpy(out, ID2ENTRY_Z_MAGIC, 3);
+    out[3] = ID2ENTRY_Z_VERSION;
+    id2entry_z_put32((unsigned char *)out + 4, d->id);
+    id2entry_z_put32((unsigned char *)out + 8, size);
+    *packed = out;
+    *packedsize = ID2ENTRY_Z_HDRLEN + (uint32_t)zs.total_out;
+    deflateEnd(&zs);
+
+    slapi_counter_add(inst->inst_id2entry_rawbytes, size);
+    slapi_counter_add(inst->inst_id2entry_packedbytes, *packedsize);
+    return 1;
+}
+
+/*
+ * Inflate a compressed record against the dictionary d.  Returns 1 and sets
+ * *plain, -1 if the record was compressed with another dictionary, -2 if it
+ * can not be inflated.
+ */
+static int
+id2entry_inflate(const struct id2entry_dict *d, const char *data, uint32_t size, char **plain, uint32_t *plainsize, int *zrc, const char **zmsg)
+{
+    z_stream zs = {0};
+    uint32_t rawlen;
+    char *out = NULL;
+    int rc;
+
+    if (id2entry_z_get32((const unsigned char *)data + 4) != d->id) {
+        return -1;
+    }
+    rawlen = id2entry_z_get32((const unsigned char *)data + 8);
+    if ((uint64_t)rawlen > (uint64_t)(size - ID2ENTRY_Z_HDRLEN) * ID2ENTRY_Z_MAXRATIO) {
+        /* corrupted header: do not trust it to size the buffer */
+        *zrc = Z_DATA_ERROR;
+        *zmsg = "bad length";
+        return -2;
+    }
+    if (inflateInit(&zs) != Z_OK) {
+        return -2;
+    }
+    out = slapi_ch_malloc(rawlen + 1);
+    zs.next_in = (Bytef *)data + ID2ENTRY_Z_HDRLEN;
+    zs.avail_in = size - ID2ENTRY_Z_HDRLEN;
+    zs.next_out = (Bytef *)out;
+    zs.avail_out = rawlen;
+    rc = inflate(&zs, Z_FINISH);
+    if (rc == Z_NEED_DICT) {
+        if (inflateSetDictionary(&zs, (const Bytef *)d->dict, (uInt)d->len) == Z_OK) {
+            rc = inflate(&zs, Z_FINISH);
+        }
+    }
+    if (rc != Z_STREAM_END || zs.total_out != rawlen) {
+        *zrc = rc;
+        *zmsg = zs.msg ? zs.msg : "bad length";
+        inflateEnd(&zs);
+        slapi_ch_free_string(&out);
+        return -2;
+    }
+    inflateEnd(&zs);
+    out[rawlen] = '\0';
+    *plain = out;
+    *plainsize = rawlen;
+    return 1;
+}
+
+/*
+ * Inflate an id2entry record read from the database (after the entry fetch
+ * plugins ran).  Returns 0 if the record is not compressed, 1 if *plain was
+ * allocated with the original record, -1 if the record can not be decoded.
+ * The input buffer is left untouched in every case.
+ */
+int
+id2entry_decompress(backend *be, const char *data, uint32_t size, char **plain, uint32_t *plainsize)
+{
+    ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
+    struct id2entry_dict *d = NULL;
+    struct timespec start, end, delta;
+    const char *zmsg = NULL;
+    int zrc = 0;
+    int rc;
+
+    *plain = NULL;
+    if (!id2entry_is_compressed(data, size)) {
+        return 0;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    d = id2entry_get_dict(inst);
+    rc = id2entry_inflate(d, data, size, plain, plainsize, &zrc, &zmsg);
+    if (rc == -1) {
+        slapi_log_err(SLAPI_LOG_ERR, ID2ENTRY,
+                      "Backend %s: record was compressed with an unknown dictionary (%u, expected %u)\n",
+                      inst->inst_name, id2entry_z_get32((const unsigned char *)data + 4), d->id);
+        return -1;
+    } else if (rc < 0) {
+        slapi_log_err(SLAPI_LOG_ERR, ID2ENTRY,
+                      "Backend %s: failed to inflate id2entry record (%d: %s)\n",
+                      inst->inst_name, zrc, zmsg ? zmsg : "inflateInit");
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    slapi_timespec_diff(&end, &start, &delta);
+    slapi_counter_increment(inst->inst_id2entry_decodes);
+    slapi_counter_add(inst->inst_id2entry_decode_ns,
+                      (uint64_t)delta.tv_sec * 1000000000ULL + delta.tv_nsec);
+    return 1;
+}
+
+/*
+ * Same as id2entry_decompress for a record read by a tool which has no
+ * backend: suffix is the normalized suffix of the backend the record
+ * belongs to.  Nothing is logged.
+ */
+int
+id2entry_decompress_with_suffix(const char *suffix, const char *data, uint32_t size, char **plain, uint32_t *plainsize)
+{
+    struct id2entry_dict *d = NULL;
+    const char *zmsg = NULL;
+    int zrc = 0;
+    int rc;
+
+    *plain = NULL;
+    if (!id2entry_is_compressed(data, size)) {
+        return 0;
+    }
+    d = id2entry_new_dict(suffix);
+    rc = id2entry_inflate(d, data, size, plain, plainsize, &zrc, &zmsg);
+    id2entry_dict_free(&d);
+    return rc > 0 ? 1 : -1;
+}
+
+/*
+ * Same as id2entry_decompress for a malloc'ed record owned by the caller:
+ * the record is replaced by its inflated form.
+ */
+int
+id2entry_decompress_inplace(backend *be, char **data, uint32_t *size)
+{
+    char *plain = NULL;
+    int rc;
+
+    rc = id2entry_decompress(be, *data, *size, &plain, size);
+    if (rc > 0) {
+        slapi_ch_free_string(data);
+        *data = plain;
+    }
+    return rc;
+}
+
 /*
  * The caller MUST check for DBI_RC_RETRY and DBI_RC_RUNRECOVERY returned
  * If cache_res is not NULL, it stores the result of CACHE_ADD of the
@@ -34,6 +376,7 @@ id2entry_add_ext(backend *be, struct backentry *e, back_txn *txn, int encrypt, i
     char temp_id[sizeof(ID)];
     struct backentry *encrypted_entry = NULL;
     char *entrydn = NULL;
+    char *packed = NULL;
     uint32_t esize;
 
     slapi_log_err(SLAPI_LOG_TRACE, "id2entry_add_ext", "=> ( %lu, \"%s\" )\n",
@@ -97,8 +440,18 @@ id2entry_add_ext(backend *be, struct backentry *e, back_txn *txn, int encrypt, i
                       "id2entry_add_ext", "(dncache) ( %lu, \"%s\" )\n",
                       (u_long)e->ep_id, slapi_entry_get_dn_const(entry_to_use));
 
-        data.dptr = slapi_entry2str_with_options(entry_to_use, &len, options);
-        data.dsize = len + 1;
+        if (inst->inst_li->li_binary_entry_format) {
+            data.dptr = slapi_entry2bin(entry_to_use, &len);
+            data.dsize = len;
+        } else {
+            data.dptr = slapi_entry2str_with_options(entry_to_use, &len, options);
+            data.dsize = len + 1;
+        }
+        if (id2entry_compress(be, data.dptr, (uint32_t)data.dsize, &packed, &esize)) {
+            slapi_ch_free(&(data.dptr));
+            data.dptr = packed;
+            data.dsize = esize;
+        }
     }
 
     if (NULL != txn) {
@@ -266,6 +619,7 @@ id2entry(backend *be, ID id, back_txn *txn, int *err)
     struct backentry *e = NULL;
     Slapi_Entry *ee;
     char temp_id[sizeof(ID)];
+    char *plain = NULL;
     uint32_t esize;
     BackEntryWeightData t1 = {0};
 
@@ -333,14 +687,18 @@ id2entry(backend *be, ID id, back_txn *txn, int *err)
     plugin_call_entryfetch_plugins((char **)&data.dptr, &esize);
     data.dsize = esize;
 
+    if (id2entry_decompress(be, data.dptr, esize, &plain, &esize) > 0) {
+        dblayer_value_set(be, &data, plain, esize);
+    }
+
     char *rdn = NULL;
     int rc = 0;
 
-    /* rdn is allocated in get_value_from_string */
-    rc = get_value_from_string((const char *)data.dptr, "rdn", &rdn);
+    /* rdn is allocated in get_value_from_record */
+    rc = get_value_from_record((const char *)data.dptr, data.dsize, "rdn", &rdn);
     if (rc) {
         /* data.dptr may not include rdn: ..., try "dn: ..." */
-        ee = slapi_str2entry(data.dptr, SLAPI_STR2ENTRY_NO_ENTRYDN);
+        ee = slapi_record2entry(NULL, NULL, data.dptr, data.dsize, SLAPI_STR2ENTRY_NO_ENTRYDN);
     } else {
         char *normdn = NULL;
         Slapi_RDN *srdn = NULL;
@@ -353,7 +711,7 @@ id2entry(backend *be, ID id, back_txn *txn, int *err)
         } else {
             Slapi_DN *sdn = NULL;
             if (config_get_return_orig_dn() &&
-                !get_value_from_string((const char *)data.dptr, SLAPI_ATTR_DS_ENTRYDN, &normdn))
+                !get_value_from_record((const char *)data.dptr, data.dsize, SLAPI_ATTR_DS_ENTRYDN, &normdn))
             {
                 srdn = slapi_rdn_new_all_dn(normdn);
             } else {
@@ -388,8 +746,8 @@ id2entry(backend *be, ID id, back_txn *txn, int *err)
                               normdn, id);
             }
         }
-        ee = slapi_str2entry_ext((const char *)normdn, (const Slapi_RDN *)srdn, data.dptr,
-                                 SLAPI_STR2ENTRY_NO_ENTRYDN);
+        ee = slapi_record2entry((const char *)normdn, (const Slapi_RDN *)srdn, data.dptr, data.dsize,
+                                SLAPI_STR2ENTRY_NO_ENTRYDN);
         slapi_ch_free_string(&rdn);
         slapi_ch_free_string(&normdn);
         slapi_rdn_free(&srdn);
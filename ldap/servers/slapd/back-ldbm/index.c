@@ -2420,6 +2420,7 @@ index_get_allids(int *allids, const char *indextype, struct attrinfo *ai, const
         sval.bv.bv_len = val->bv_len;
         sval.v_csnset = NULL;
         sval.v_flags = SLAPI_ATTR_FLAG_NORMALIZED; /* the value must be a normalized key */
+        sval.v_norm = NULL;
     }
 
     /* loop through all of the idlistinfo objects to find the best match */
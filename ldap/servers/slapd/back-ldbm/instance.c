@@ -94,6 +94,14 @@ ldbm_instance_create(backend *be, char *name)
     /* Keeps track of how many operations are currently using this instance */
     inst->inst_ref_count = slapi_counter_new();
 
+    /* id2entry compression statistics */
+    inst->inst_id2entry_rawbytes = slapi_counter_new();
+    inst->inst_id2entry_packedbytes = slapi_counter_new();
+    inst->inst_id2entry_decodes = slapi_counter_new();
+    inst->inst_id2entry_decode_ns = slapi_counter_new();
+
+    inst->inst_scope_index = scope_index_new();
+
     inst->inst_be = be;
     inst->inst_li = li;
     be->be_instance_info = inst;
@@ -648,6 +656,12 @@ ldbm_instance_destructor(void **arg)
                   inst->inst_name);
 
     slapi_counter_destroy(&(inst->inst_ref_count));
+    slapi_counter_destroy(&(inst->inst_id2entry_rawbytes));
+    slapi_counter_destroy(&(inst->inst_id2entry_packedbytes));
+    slapi_counter_destroy(&(inst->inst_id2entry_decodes));
+    slapi_counter_destroy(&(inst->inst_id2entry_decode_ns));
+    id2entry_free_dict(inst);
+    scope_index_free(&inst->inst_scope_index);
     slapi_ch_free_string(&inst->inst_name);
     PR_DestroyLock(inst->inst_config_mutex);
     slapi_ch_free_string(&inst->inst_dir_name);
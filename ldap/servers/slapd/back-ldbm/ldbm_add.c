@@ -1245,8 +1245,14 @@ ldbm_back_add(Slapi_PBlock *pb)
         goto error_return;
     }
 
+    /* Let subtree searches find the entry before any child can be added below it.
+     * If the commit fails the id is only an extra candidate. */
+    scope_index_add(be, addingentry->ep_id,
+                    (ID)slapi_entry_attr_get_ulong(addingentry->ep_entry, LDBM_PARENTID_STR));
+
     /* Release SERIAL LOCK */
     retval = dblayer_txn_commit(be, &txn);
+    scope_index_add_done(be, addingentry->ep_id);
     /* after commit - txn is no longer valid - replace SLAPI_TXN with parent */
     slapi_pblock_set(pb, SLAPI_TXN, parent_txn);
     if (0 != retval) {
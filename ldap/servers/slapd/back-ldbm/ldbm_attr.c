@@ -319,6 +319,7 @@ attr_index_parse_idlistsize_values(Slapi_Attr *attr, struct index_idlistsizeinfo
             sval.bv.bv_len = filt->f_avvalue.bv_len;
             sval.v_flags = 0;
             sval.v_csnset = NULL;
+            sval.v_norm = NULL;
             (void)slapi_attr_assertion2keys_ava_sv(attr, &sval, (Slapi_Value ***)&ivals, LDAP_FILTER_EQUALITY);
         }
         /* don't need filter any more */
@@ -84,7 +84,14 @@ ldbm_back_bind(Slapi_PBlock *pb)
         }
         bvals = attr_get_present_values(attr);
         slapi_value_init_berval(&cv, cred);
-        if (slapi_pw_find_sv(bvals, &cv) != 0) {
+        rc = pw_bind_cache_find_sv(be, e->ep_id, bvals, &cv);
+        if (rc == PW_KDF_POOL_BUSY) {
+            slapi_send_ldap_result(pb, LDAP_BUSY, NULL, "Password verification queue is full", 0, NULL);
+            CACHE_RETURN(&inst->inst_cache, &e);
+            value_done(&cv);
+            rc = SLAPI_BIND_FAIL;
+            goto bail;
+        } else if (rc != 0) {
             slapi_pblock_set(pb, SLAPI_PB_RESULT_TEXT, "Invalid credentials");
             slapi_send_ldap_result(pb, LDAP_INVALID_CREDENTIALS, NULL, NULL, 0, NULL);
             CACHE_RETURN(&inst->inst_cache, &e);
@@ -93,6 +100,7 @@ ldbm_back_bind(Slapi_PBlock *pb)
             goto bail;
         }
         value_done(&cv);
+        rc = SLAPI_BIND_SUCCESS;
     } break;
 
     default:
@@ -415,6 +415,128 @@ ldbm_config_pagedallidsthreshold_set(void *arg, void *value, char *errorbuf __at
     return retval;
 }
 
+static void *
+ldbm_config_pagedidlistbudget_get(void *arg)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+
+    return (void *)((uintptr_t)(li->li_pagedidlistbudget));
+}
+
+static int
+ldbm_config_pagedidlistbudget_set(void *arg, void *value, char *errorbuf, int phase __attribute__((unused)), int apply)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+    int retval = LDAP_SUCCESS;
+    int val = (int)((uintptr_t)value);
+
+    /* value of 0 means paged searches always keep their candidate list */
+    if (val < 0) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE,
+                              "Invalid value for %s (%d). Must be 0 or greater",
+                              CONFIG_PAGEDIDLISTBUDGET, val);
+        return LDAP_UNWILLING_TO_PERFORM;
+    }
+
+    if (apply) {
+        li->li_pagedidlistbudget = val;
+    }
+
+    return retval;
+}
+
+static void *
+ldbm_config_sort_memory_limit_get(void *arg)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+
+    return (void *)((uintptr_t)li->li_sort_memory_limit);
+}
+
+static int
+ldbm_config_sort_memory_limit_set(void *arg, void *value, char *errorbuf __attribute__((unused)), int phase __attribute__((unused)), int apply)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+    uint64_t val = (uint64_t)((uintptr_t)value);
+
+    /* value of 0 means the sort keys are never spilled to disk */
+    if ((val > 0) && (val < 1048576)) {
+        val = 1048576;
+    }
+    if (apply) {
+        li->li_sort_memory_limit = val;
+    }
+    return LDAP_SUCCESS;
+}
+
+static void *
+ldbm_config_binary_entry_format_get(void *arg)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+
+    return (void *)((uintptr_t)li->li_binary_entry_format);
+}
+
+static int
+ldbm_config_binary_entry_format_set(void *arg, void *value, char *errorbuf __attribute__((unused)), int phase __attribute__((unused)), int apply)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+    int val = (int)((uintptr_t)value);
+
+    if (apply) {
+        li->li_binary_entry_format = val;
+    }
+    return LDAP_SUCCESS;
+}
+
+static void *
+ldbm_config_id2entry_compression_get(void *arg)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+
+    return (void *)((uintptr_t)li->li_id2entry_compression);
+}
+
+static int
+ldbm_config_id2entry_compression_set(void *arg, void *value, char *errorbuf __attribute__((unused)), int phase __attribute__((unused)), int apply)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+    int val = (int)((uintptr_t)value);
+
+    if (apply) {
+        li->li_id2entry_compression = val;
+    }
+    return LDAP_SUCCESS;
+}
+
+static void *
+ldbm_config_scope_index_get(void *arg)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+
+    return (void *)((uintptr_t)li->li_scope_index);
+}
+
+static int
+ldbm_config_scope_index_set(void *arg, void *value, char *errorbuf __attribute__((unused)), int phase __attribute__((unused)), int apply)
+{
+    struct ldbminfo *li = (struct ldbminfo *)arg;
+    int val = (int)((uintptr_t)value);
+
+    if (apply) {
+        li->li_scope_index = val;
+        if (!val && li->li_instance_set) {
+            /* release the memory now rather than on the next update */
+            for (Object *inst_obj = objset_first_obj(li->li_instance_set); inst_obj;
+                 inst_obj = objset_next_obj(li->li_instance_set, inst_obj)) {
+                ldbm_instance *inst = (ldbm_instance *)object_get_data(inst_obj);
+                scope_index_reset(inst->inst_be);
+            }
+        }
+    }
+    return LDAP_SUCCESS;
+}
+
 static void *
 ldbm_config_directory_get(void *arg)
 {
@@ -1082,6 +1204,11 @@ static config_info ldbm_config[] = {
     {CONFIG_USE_LEGACY_ERRORCODE, CONFIG_TYPE_ONOFF, "off", &ldbm_config_legacy_errcode_get, &ldbm_config_legacy_errcode_set, 0},
     {CONFIG_PAGEDLOOKTHROUGHLIMIT, CONFIG_TYPE_INT, "0", &ldbm_config_pagedlookthroughlimit_get, &ldbm_config_pagedlookthroughlimit_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
     {CONFIG_PAGEDIDLISTSCANLIMIT, CONFIG_TYPE_INT, "0", &ldbm_config_pagedallidsthreshold_get, &ldbm_config_pagedallidsthreshold_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
+    {CONFIG_BINARY_ENTRY_FORMAT, CONFIG_TYPE_ONOFF, "off", &ldbm_config_binary_entry_format_get, &ldbm_config_binary_entry_format_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
+    {CONFIG_ID2ENTRY_COMPRESSION, CONFIG_TYPE_ONOFF, "off", &ldbm_config_id2entry_compression_get, &ldbm_config_id2entry_compression_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
+    {CONFIG_SCOPE_INDEX, CONFIG_TYPE_ONOFF, "on", &ldbm_config_scope_index_get, &ldbm_config_scope_index_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
+    {CONFIG_SORT_MEMORY_LIMIT, CONFIG_TYPE_UINT64, "67108864", &ldbm_config_sort_memory_limit_get, &ldbm_config_sort_memory_limit_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
+    {CONFIG_PAGEDIDLISTBUDGET, CONFIG_TYPE_INT, "0", &ldbm_config_pagedidlistbudget_get, &ldbm_config_pagedidlistbudget_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
     {CONFIG_RANGELOOKTHROUGHLIMIT, CONFIG_TYPE_INT, "5000", &ldbm_config_rangelookthroughlimit_get, &ldbm_config_rangelookthroughlimit_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
     {CONFIG_BACKEND_OPT_LEVEL, CONFIG_TYPE_INT, "1", &ldbm_config_backend_opt_level_get, &ldbm_config_backend_opt_level_set, CONFIG_FLAG_ALWAYS_SHOW},
     {CONFIG_BACKEND_IMPLEMENT, CONFIG_TYPE_STRING, "bdb", &ldbm_config_backend_implement_get, &ldbm_config_backend_implement_set, CONFIG_FLAG_ALWAYS_SHOW | CONFIG_FLAG_ALLOW_RUNNING_CHANGE},
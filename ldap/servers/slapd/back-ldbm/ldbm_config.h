@@ -61,6 +61,11 @@ struct config_info
 #define CONFIG_PAGEDLOOKTHROUGHLIMIT "nsslapd-pagedlookthroughlimit"
 #define CONFIG_IDLISTSCANLIMIT "nsslapd-idlistscanlimit"
 #define CONFIG_PAGEDIDLISTSCANLIMIT "nsslapd-pagedidlistscanlimit"
+#define CONFIG_PAGEDIDLISTBUDGET "nsslapd-pagedidlistbudget"
+#define CONFIG_SORT_MEMORY_LIMIT "nsslapd-sort-memory-limit"
+#define CONFIG_BINARY_ENTRY_FORMAT "nsslapd-binary-entry-format"
+#define CONFIG_ID2ENTRY_COMPRESSION "nsslapd-id2entry-compression"
+#define CONFIG_SCOPE_INDEX "nsslapd-scope-index"
 #define CONFIG_DIRECTORY "nsslapd-directory"
 #define CONFIG_MODE "nsslapd-mode"
 #define CONFIG_DBCACHESIZE "nsslapd-dbcachesize"
@@ -1311,6 +1311,16 @@ commit_return:
         goto error_return;
     }
 
+    if (ep_id) {
+        pw_bind_cache_invalidate(be, ep_id);
+        /* Tombstones stay in the tree. Within a parent transaction the
+         * delete may still be aborted: keep the id, it is only an extra
+         * candidate for the subtree searches. */
+        if (!create_tombstone_entry && !not_an_error && !parent_txn) {
+            scope_index_delete(be, ep_id);
+        }
+    }
+
     /* delete from cache and clean up */
     if (e) {
         if (!create_tombstone_entry) {
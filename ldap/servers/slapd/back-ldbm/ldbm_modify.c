@@ -1050,6 +1050,9 @@ ldbm_back_modify(Slapi_PBlock *pb)
         goto error_return;
     }
 
+    slapi_pblock_get(pb, SLAPI_MODIFY_MODS, &mods);
+    pw_bind_cache_invalidate_mods(be, ec->ep_id, ec->ep_entry, mods);
+
     rc = 0;
     goto common_return;
 
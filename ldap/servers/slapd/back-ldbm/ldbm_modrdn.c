@@ -1243,6 +1243,15 @@ ldbm_back_modrdn(Slapi_PBlock *pb)
         goto error_return;
     }
 
+    if (newparententry != NULL) {
+        if (parent_txn) {
+            /* the move may still be aborted by the parent transaction */
+            scope_index_reset(be);
+        } else {
+            scope_index_move(be, ec->ep_id, newparententry->ep_id);
+        }
+    }
+
     if (children) {
         int i = 0;
         if (child_entries && *child_entries) {
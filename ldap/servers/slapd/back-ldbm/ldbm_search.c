@@ -34,6 +34,8 @@ static IDList *base_candidates(Slapi_PBlock *pb, struct backentry *e);
 static IDList *onelevel_candidates(Slapi_PBlock *pb, backend *be, const char *base, Slapi_Filter *filter, int *lookup_returned_allidsp, int *err);
 static back_search_result_set *new_search_result_set(IDList *idl, int vlv, int lookthroughlimit);
 static void delete_search_result_set(Slapi_PBlock *pb, back_search_result_set **sr);
+static void ldbm_search_cursor_park(Slapi_PBlock *pb, backend *be, back_search_result_set *sr);
+static int ldbm_search_cursor_resume(Slapi_PBlock *pb, backend *be, back_search_result_set *sr, back_txn *txn);
 static int can_skip_filter_test(Slapi_PBlock *pb, struct slapi_filter *f, int scope, IDList *idl);
 static void stat_add_srch_lookup(Op_stat *op_stat,  struct component_keys_lookup *key_stat, char * attribute_type, const char* index_type, char *key_value, int lookup_cnt);
 static bool dynamic_lists_filter_matches(Slapi_Filter *filter, struct ldbminfo *li);
@@ -360,72 +362,9 @@ ldbm_search_compile_filter(Slapi_Filter *f, void *arg __attribute__((unused)))
 {
     int rc = SLAPI_FILTER_SCAN_CONTINUE;
     if (f->f_choice == LDAP_FILTER_SUBSTRINGS) {
-        char pat[BUFSIZ];
-        char *p, *end, *bigpat = NULL;
-        size_t size = 0;
-        Slapi_Regex *re = NULL;
-        char *re_result = NULL;
-        int i = 0;
-
         PR_ASSERT(NULL == f->f_un.f_un_sub.sf_private);
-        /*
-         * construct a regular expression corresponding to the filter
-         */
-        pat[0] = '\0';
-        p = pat;
-        end = pat + sizeof(pat) - 2; /* leave room for null */
-
-        if (f->f_sub_initial != NULL) {
-            size = strlen(f->f_sub_initial) + 1; /* add 1 for "^" */
-        }
-
-        while (f->f_sub_any && f->f_sub_any[i]) {
-            size += strlen(f->f_sub_any[i++]) + 2; /* add 2 for ".*" */
-        }
-
-        if (f->f_sub_final != NULL) {
-            size += strlen(f->f_sub_final) + 3; /* add 3 for ".*" and "$" */
-        }
-
-        size *= 2; /* doubled in case all filter chars need escaping (regex special chars) */
-        size++;    /* add 1 for null */
-
-        if (p + size > end) {
-            bigpat = slapi_ch_malloc(size);
-            p = bigpat;
-        }
-        if (f->f_sub_initial != NULL) {
-            *p++ = '^';
-            p = filter_strcpy_special_ext(p, f->f_sub_initial, FILTER_STRCPY_ESCAPE_RECHARS);
-        }
-        for (i = 0; f->f_sub_any && f->f_sub_any[i]; i++) {
-            /* ".*" + value */
-            *p++ = '.';
-            *p++ = '*';
-            p = filter_strcpy_special_ext(p, f->f_sub_any[i], FILTER_STRCPY_ESCAPE_RECHARS);
-        }
-        if (f->f_sub_final != NULL) {
-            /* ".*" + value */
-            *p++ = '.';
-            *p++ = '*';
-            p = filter_strcpy_special_ext(p, f->f_sub_final, FILTER_STRCPY_ESCAPE_RECHARS);
-            strcat(p, "$");
-        }
-
-        /* compile the regex */
-        p = bigpat ? bigpat : pat;
-        re = slapi_re_comp(p, &re_result);
-        if (NULL == re) {
-            slapi_log_err(SLAPI_LOG_ERR, "ldbm_search_compile_filter", "re_comp (%s) failed (%s): %s\n",
-                          pat, p, re_result ? re_result : "unknown");
-            slapi_ch_free_string(&re_result);
-            rc = SLAPI_FILTER_SCAN_ERROR;
-        } else {
-            char ebuf[BUFSIZ];
-            slapi_log_err(SLAPI_LOG_TRACE, "ldbm_search_compile_filter", "re_comp (%s)\n",
-                          escape_string(p, ebuf));
-            f->f_un.f_un_sub.sf_private = (void *)re;
-        }
+        /* the filter values are already normalized */
+        f->f_un.f_un_sub.sf_private = (void *)substr_match_new(f->f_sub_initial, f->f_sub_any, f->f_sub_final);
     } else if (f->f_choice == LDAP_FILTER_EQUALITY) {
         /* store the flags in the ava_private - should be ok - points
            to itself - no dangling references */
@@ -440,8 +379,7 @@ ldbm_search_free_compiled_filter(Slapi_Filter *f, void *arg __attribute__((unuse
     int rc = SLAPI_FILTER_SCAN_CONTINUE;
     if ((f->f_choice == LDAP_FILTER_SUBSTRINGS) &&
         (f->f_un.f_un_sub.sf_private)) {
-        slapi_re_free((Slapi_Regex *)f->f_un.f_un_sub.sf_private);
-        f->f_un.f_un_sub.sf_private = NULL;
+        substr_match_free((Slapi_Substr **)&f->f_un.f_un_sub.sf_private);
     } else if (f->f_choice == LDAP_FILTER_EQUALITY) {
         /* clear the flags in the ava_private */
         f->f_un.f_un_ava.ava_private = NULL;
@@ -901,6 +839,8 @@ ldbm_back_search(Slapi_PBlock *pb)
 
                     char *sort_error_type = NULL;
                     int sort_return_value = 0;
+                    NIDS sort_limit = 0;
+                    struct sort_tail **sort_tail = NULL;
 
                     /* Don't log internal operations */
                     if (!operation_is_flag_set(operation, OP_FLAG_INTERNAL)) {
@@ -910,9 +850,26 @@ ldbm_back_search(Slapi_PBlock *pb)
                          * input to ldapsearch> <#candidates> | <unsortable> */
                         sort_log_access(pb, sort_control, candidates, PR_FALSE);
                     }
+                    /*
+                     * Only order what can be returned: the VLV window, or
+                     * the first sizelimit entries. In the latter case the
+                     * rest is sorted later if entries get filtered out.
+                     */
+                    if (virtual_list_view) {
+                        if (candidates->b_nids > 0) {
+                            sort_limit = vlv_trim_candidates_sort_limit(candidates->b_nids, &vlv_request_control);
+                        }
+                    } else if (!op_is_pagedresults(operation)) {
+                        int slimit = -1;
+                        slapi_pblock_get(pb, SLAPI_SEARCH_SIZELIMIT, &slimit);
+                        if (slimit > 0) {
+                            sort_limit = (NIDS)slimit;
+                            sort_tail = &sr->sr_sort_tail;
+                        }
+                    }
                     sort_return_value = sort_candidates(be, lookthrough_limit,
                                                         &expire_time, pb, candidates,
-                                                        sort_control,
+                                                        sort_control, sort_limit, sort_tail,
                                                         &sort_error_type);
                     /* Fix for bugid # 394184, SD, 20 Jul 00 */
                     /* replace the hard coded return value by the appropriate
@@ -958,6 +915,7 @@ ldbm_back_search(Slapi_PBlock *pb)
                     /* we were not actually returning unavailableCriticalExtension;
                  now fixed (hopefully !) */
                     if (is_sorting_critical && sort_return_value) {
+                        sort_tail_free(&sr->sr_sort_tail);
                         idl_free(&candidates);
                         candidates = idl_alloc(0);
                         tmp_err = sort_return_value;
@@ -1147,7 +1105,7 @@ ldbm_back_search(Slapi_PBlock *pb)
 
         /* step 1 - normalize all of the values used in the search filter */
         slapi_filter_normalize(sr->sr_norm_filter, PR_TRUE /* normalize values too */);
-        /* step 2 - pre-compile the substr regex and the equality flags */
+        /* step 2 - pre-compile the substr assertions and the equality flags */
         rc = slapi_filter_apply(sr->sr_norm_filter, ldbm_search_compile_filter,
                                 NULL, &filt_errs);
 
@@ -1538,7 +1496,16 @@ subtree_candidates(
 
         slapi_pblock_get(pb, SLAPI_TXN, &txn.back_txn_txn);
 
-        if (!has_tombstone_filter && !is_bulk_import) {
+        /*
+         * Outside of a transaction, scope the candidates with the in memory
+         * scope index: within one, it may not see the pending updates.
+         */
+        if (!has_tombstone_filter && !is_bulk_import && NULL == txn.back_txn_txn &&
+            NULL != (descendants = scope_index_subtree_candidates(be, e->ep_id, candidates))) {
+            candidates = descendants;
+            idl_free(&tmp);
+            *err = LDAP_SUCCESS;
+        } else if (!has_tombstone_filter && !is_bulk_import) {
             struct component_keys_lookup *key_stat;
 
             if (op_stat) {
@@ -1792,6 +1759,20 @@ ldbm_back_next_search_entry(Slapi_PBlock *pb)
         slapi_pblock_set(pb, SLAPI_TXN, txn.back_txn_txn);
     }
 
+    if (sr->sr_flags & SR_FLAG_CURSOR) {
+        /* The candidates were released at the end of the previous page */
+        if (ldbm_search_cursor_resume(pb, be, sr, &txn)) {
+            /* Error result sent by ldbm_search_cursor_resume */
+            slapi_pblock_set(pb, SLAPI_SEARCH_RESULT_ENTRY, NULL);
+            delete_search_result_set(pb, &sr);
+            rc = SLAPI_FAIL_GENERAL;
+            goto bail;
+        }
+        /* build_candidate_list set the executed and intended filters */
+        slapi_pblock_get(pb, SLAPI_SEARCH_FILTER, &filter);
+        slapi_pblock_get(pb, SLAPI_SEARCH_FILTER_INTENDED, &filter_intent);
+    }
+
     if (sr->sr_norm_filter) {
         filter = sr->sr_norm_filter;
     }
@@ -1889,6 +1870,13 @@ ldbm_back_next_search_entry(Slapi_PBlock *pb)
             goto bail;
         }
 
+        /* A partially sorted list is sorted further once we get there */
+        if (sr->sr_sort_tail &&
+            sort_candidates_tail(&sr->sr_sort_tail, sr->sr_candidates, sr->sr_current, pb, &expire_time) != LDAP_SUCCESS) {
+            /* abandoned or timed out, caught by the checks above */
+            continue;
+        }
+
         /*
          * Get the entry ID
          */
@@ -2218,10 +2206,169 @@ ldbm_back_prev_search_results(Slapi_PBlock *pb)
         }
         idl_iterator_decrement(&(sr->sr_current));
         --sr->sr_lookthroughcount;
+        ldbm_search_cursor_park(pb, be, sr);
     }
     return;
 }
 
+/*
+ * Paged results cursor.
+ *
+ * A paged search normally keeps its whole candidate list until the last
+ * page is sent. When the list is longer than nsslapd-pagedidlistbudget IDs,
+ * it is released at the end of each page and only the ID of the next entry
+ * to return is kept. The next page rebuilds the candidate list from the
+ * indexes and resumes from that ID, so between pages the search holds no
+ * more memory than its result set structure.
+ *
+ * This relies on the candidate list being in ID order, which is the case
+ * for any list coming straight from the indexes. Sorted, VLV and reverse
+ * order searches, and dynamic lists, keep the list as before.
+ *
+ * As entry IDs only grow, entries added between two pages are returned
+ * at the end of the search, and deleted ones are skipped.
+ */
+static void
+ldbm_search_cursor_park(Slapi_PBlock *pb, backend *be, back_search_result_set *sr)
+{
+    struct ldbminfo *li = (struct ldbminfo *)be->be_database->plg_private;
+    IDList *idl = sr->sr_candidates;
+    Slapi_Operation *op = NULL;
+    int budget = li->li_pagedidlistbudget;
+    ID next;
+
+    slapi_pblock_get(pb, SLAPI_OPERATION, &op);
+    if (budget <= 0 || NULL == idl || ALLIDS(idl) || idl->b_nids <= (NIDS)budget ||
+        !op_is_pagedresults(op) || sr->sr_virtuallistview || li->li_dynamic_lists_enabled ||
+        operation_is_flag_set(op, OP_FLAG_REVERSE_CANDIDATE_ORDER)) {
+        return;
+    }
+    for (NIDS i = 1; i < idl->b_nids; i++) {
+        if (idl->b_ids[i - 1] >= idl->b_ids[i]) {
+            /* not in ID order (sorted search), can't resume from an ID */
+            return;
+        }
+    }
+
+    next = idl_iterator_dereference(sr->sr_current, idl);
+    if (NOID == next) {
+        return;
+    }
+    slapi_log_err(SLAPI_LOG_BACKLDBM, "ldbm_search_cursor_park",
+                  "Releasing %lu candidates, next page resumes at ID %lu\n",
+                  (u_long)idl->b_nids, (u_long)next);
+    idl_free(&(sr->sr_candidates));
+    sr->sr_current = idl_iterator_init(NULL);
+    sr->sr_cursor_next = next;
+    sr->sr_flags |= SR_FLAG_CURSOR;
+}
+
+/*
+ * Rebuild the candidate list of a parked paged search and position the
+ * iterator on the first candidate not returned yet.
+ * Returns 0, or an error code once a result has been sent.
+ */
+static int
+ldbm_search_cursor_resume(Slapi_PBlock *pb, backend *be, back_search_result_set *sr, back_txn *txn)
+{
+    ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
+    struct backentry *e = NULL;
+    IDList *candidates = NULL;
+    Slapi_DN *basesdn = NULL;
+    entry_address *addr = NULL;
+    const char *base;
+    int scope = 0;
+    int rc;
+
+    slapi_pblock_get(pb, SLAPI_SEARCH_TARGET_SDN, &basesdn);
+    slapi_pblock_get(pb, SLAPI_TARGET_ADDRESS, &addr);
+    slapi_pblock_get(pb, SLAPI_SEARCH_SCOPE, &scope);
+    base = slapi_sdn_get_dn(basesdn);
+
+    if (*base != '\0') {
+        if ((e = find_entry(pb, be, addr, txn, NULL)) == NULL) {
+            /* error or referral sent by find_entry */
+            return SLAPI_FAIL_GENERAL;
+        }
+    }
+    rc = build_candidate_list(pb, be, e, base, scope, NULL, &candidates);
+    CACHE_RETURN(&inst->inst_cache, &e);
+    if (rc) {
+        /* Error result sent by build_candidate_list */
+        idl_free(&candidates);
+        return rc;
+    }
+
+    if (NULL != candidates && ALLIDS(candidates)) {
+        /*
+         * The indexes may have been removed since the first page: apply
+         * the same unindexed search checks as ldbm_back_search.
+         */
+        unsigned int opnote;
+        int ri = 0;
+        int rii = 0;
+        int pr_idx = -1;
+        Connection *pb_conn = NULL;
+        Operation *pb_op = NULL;
+        int32_t internal_op;
+
+        slapi_pblock_get(pb, SLAPI_OPERATION, &pb_op);
+        internal_op = operation_is_flag_set(pb_op, OP_FLAG_INTERNAL);
+        PR_Lock(inst->inst_config_mutex);
+        ri = inst->require_index;
+        rii = inst->require_internalop_index;
+        PR_Unlock(inst->inst_config_mutex);
+
+        if ((internal_op && rii) || (!internal_op && ri)) {
+            idl_free(&candidates);
+            slapi_send_ldap_result(pb, LDAP_UNWILLING_TO_PERFORM, NULL, "Search is not indexed", 0, NULL);
+            return LDAP_UNWILLING_TO_PERFORM;
+        }
+
+        opnote = slapi_pblock_get_operation_notes(pb);
+        opnote |= SLAPI_OP_NOTE_FULL_UNINDEXED;
+        opnote &= ~SLAPI_OP_NOTE_UNINDEXED;
+        slapi_pblock_set_operation_notes(pb, opnote);
+        slapi_pblock_get(pb, SLAPI_PAGED_RESULTS_INDEX, &pr_idx);
+        slapi_pblock_get(pb, SLAPI_CONNECTION, &pb_conn);
+        pagedresults_set_unindexed(pb_conn, pb_op, pr_idx);
+    }
+
+    sr->sr_candidates = candidates;
+    sr->sr_current = idl_iterator_init(candidates);
+    sr->sr_flags &= ~SR_FLAG_CURSOR;
+    /*
+     * The first page decided whether the filter test could be skipped on
+     * the candidate list of that time. The rebuilt list may come from other
+     * indexes, so always test the filter from now on.
+     */
+    sr->sr_flags |= SR_FLAG_MUST_APPLY_FILTER_TEST;
+    if (NULL == candidates) {
+        return 0;
+    }
+    if (ALLIDS(candidates)) {
+        /* an allids iterator is the ID minus one */
+        sr->sr_current = (idl_iterator)(sr->sr_cursor_next - 1);
+    } else {
+        /* first candidate >= sr_cursor_next */
+        NIDS lo = 0;
+        NIDS hi = candidates->b_nids;
+        while (lo < hi) {
+            NIDS mid = lo + (hi - lo) / 2;
+            if (candidates->b_ids[mid] < sr->sr_cursor_next) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        sr->sr_current = (idl_iterator)lo;
+    }
+    slapi_log_err(SLAPI_LOG_BACKLDBM, "ldbm_search_cursor_resume",
+                  "Rebuilt %lu candidates, resuming at ID %lu\n",
+                  (u_long)candidates->b_nids, (u_long)sr->sr_cursor_next);
+    return 0;
+}
+
 static back_search_result_set *
 new_search_result_set(IDList *idl, int vlv, int lookthroughlimit)
 {
@@ -2254,18 +2401,19 @@ delete_search_result_set(Slapi_PBlock *pb, back_search_result_set **sr)
     if (NULL != (*sr)->sr_candidates) {
         idl_free(&((*sr)->sr_candidates));
     }
+    sort_tail_free(&((*sr)->sr_sort_tail));
     rc = slapi_filter_apply((*sr)->sr_norm_filter, ldbm_search_free_compiled_filter,
                             NULL, &filt_errs);
     if (rc != SLAPI_FILTER_SCAN_NOMORE) {
         slapi_log_err(SLAPI_LOG_ERR, "delete_search_result_set",
-                      "Could not free the pre-compiled regexes in the search filter - error %d %d\n",
+                      "Could not free the pre-compiled substring assertions in the search filter - error %d %d\n",
                       rc, filt_errs);
     }
 
     rc = slapi_filter_apply((*sr)->sr_norm_filter_intent, ldbm_search_free_compiled_filter, NULL, &filt_errs);
     if (rc != SLAPI_FILTER_SCAN_NOMORE) {
         slapi_log_err(SLAPI_LOG_ERR, "delete_search_result_set",
-                      "Could not free the pre-compiled regexes in the intent search filter - error %d %d\n",
+                      "Could not free the pre-compiled substring assertions in the intent search filter - error %d %d\n",
                       rc, filt_errs);
     }
 
@@ -474,6 +474,19 @@ bail:
     return rc;
 }
 
+/*
+ * Same as get_value_from_string for a record of size bytes read from
+ * id2entry, in the text or the binary format.
+ */
+int
+get_value_from_record(const char *data, size_t size, char *type, char **value)
+{
+    if (slapi_entry_is_bin(data, size)) {
+        return slapi_entry_bin_get_value(data, size, type, value);
+    }
+    return get_value_from_string(data, type, value);
+}
+
 /*
  * Get value array of type from string.
  * multi-value support for get_value_from_string
@@ -562,6 +575,19 @@ bail:
     return rc;
 }
 
+/*
+ * Same as get_values_from_string for a record of size bytes read from
+ * id2entry, in the text or the binary format.
+ */
+int
+get_values_from_record(const char *data, size_t size, char *type, char ***valuearray)
+{
+    if (slapi_entry_is_bin(data, size)) {
+        return slapi_entry_bin_get_values(data, size, type, valuearray, 0);
+    }
+    return get_values_from_string(data, type, valuearray);
+}
+
 void
 normalize_dir(char *dir)
 {
@@ -108,6 +108,7 @@ int dblayer_plugin_begin(Slapi_PBlock *pb);
 int dblayer_plugin_commit(Slapi_PBlock *pb);
 int dblayer_plugin_abort(Slapi_PBlock *pb);
 int dblayer_backup(struct ldbminfo *li, char *destination_directory, Slapi_Task *task);
+int dblayer_backup_incremental(struct ldbminfo *li, char *destination_directory, char *base_directory, Slapi_Task *task);
 int dblayer_restore(struct ldbminfo *li, char *source_directory, Slapi_Task *task);
 int dblayer_delete_database(struct ldbminfo *li);
 int dblayer_close_indexes(backend *be);
@@ -184,6 +185,12 @@ int id2entry_add(backend *be, struct backentry *e, back_txn *txn);
 int id2entry_add_ext(backend *be, struct backentry *e, back_txn *txn, int encrypt, int *cache_res);
 int id2entry_delete(backend *be, struct backentry *e, back_txn *txn);
 struct backentry *id2entry(backend *be, ID id, back_txn *txn, int *err);
+int id2entry_is_compressed(const char *data, size_t size);
+int id2entry_compress(backend *be, const char *data, uint32_t size, char **packed, uint32_t *packedsize);
+int id2entry_decompress(backend *be, const char *data, uint32_t size, char **plain, uint32_t *plainsize);
+int id2entry_decompress_inplace(backend *be, char **data, uint32_t *size);
+int id2entry_decompress_with_suffix(const char *suffix, const char *data, uint32_t size, char **plain, uint32_t *plainsize);
+void id2entry_free_dict(ldbm_instance *inst);
 
 /*
  * idl.c
@@ -345,6 +352,8 @@ char get_sep(char *path);
 int ldbm_txn_ruv_modify_context(Slapi_PBlock *pb, modify_context *mc);
 int get_value_from_string(const char *string, char *type, char **value);
 int get_values_from_string(const char *string, char *type, char ***valuearray);
+int get_value_from_record(const char *data, size_t size, char *type, char **value);
+int get_values_from_record(const char *data, size_t size, char *type, char ***valuearray);
 void normalize_dir(char *dir);
 void ldbm_set_error(Slapi_PBlock *pb, int retval, int *ldap_result_code, char **ldap_result_message);
 char *convert_bytes_to_str(double bytes, char *buffer, int level);
@@ -417,7 +426,9 @@ typedef struct sort_spec_thing sort_spec_thing;
 typedef struct sort_spec_thing sort_spec;
 
 void sort_spec_free(sort_spec *s);
-int sort_candidates(backend *be, int lookthrough_limit, struct timespec *expire_time, Slapi_PBlock *pb, IDList *candidates, sort_spec_thing *sort_spec, char **sort_error_type);
+int sort_candidates(backend *be, int lookthrough_limit, struct timespec *expire_time, Slapi_PBlock *pb, IDList *candidates, sort_spec_thing *sort_spec, NIDS sort_limit, struct sort_tail **tail, char **sort_error_type);
+int sort_candidates_tail(struct sort_tail **tail, IDList *candidates, idl_iterator current, Slapi_PBlock *pb, struct timespec *expire_time);
+void sort_tail_free(struct sort_tail **tail);
 int make_sort_response_control(Slapi_PBlock *pb, int code, char *error_type);
 int parse_sort_spec(struct berval *sort_spec_ber, sort_spec **ps);
 struct berval *attr_value_lowest(struct berval **values, value_compare_fn_type compare_fn);
@@ -499,6 +510,7 @@ int vlv_update_all_indexes(back_txn *txn, backend *be, Slapi_PBlock *pb, struct
 int vlv_filter_candidates(backend *be, Slapi_PBlock *pb, const IDList *candidates, const Slapi_DN *base, int scope, Slapi_Filter *filter, IDList **filteredCandidates, int lookthrough_limit, struct timespec *expire_time);
 int vlv_trim_candidates_txn(backend *be, const IDList *candidates, const sort_spec *sort_control, const struct vlv_request *vlv_request_control, IDList **filteredCandidates, struct vlv_response *pResponse, back_txn *txn);
 int vlv_trim_candidates(backend *be, const IDList *candidates, const sort_spec *sort_control, const struct vlv_request *vlv_request_control, IDList **filteredCandidates, struct vlv_response *pResponse);
+PRUint32 vlv_trim_candidates_sort_limit(PRUint32 length, const struct vlv_request *vlv_request_control);
 int vlv_parse_request_control(backend *be, struct berval *vlv_spec_ber, struct vlv_request *vlvp);
 int vlv_make_response_control(Slapi_PBlock *pb, const struct vlv_response *vlvp);
 void vlv_getindices(int32_t (*callback_fn)(caddr_t, caddr_t),  void *param, backend *be);
@@ -605,6 +617,24 @@ int ldbm_ancestorid_move_subtree(
     IDList *subtree_idl,
     back_txn *txn);
 
+/*
+ * scopeindex.c
+ */
+struct scope_index *scope_index_new(void);
+void scope_index_free(struct scope_index **si);
+void scope_index_add(backend *be, ID id, ID pid);
+void scope_index_add_done(backend *be, ID id);
+void scope_index_delete(backend *be, ID id);
+void scope_index_move(backend *be, ID id, ID newpid);
+void scope_index_reset(backend *be);
+IDList *scope_index_subtree_candidates(backend *be, ID base, IDList *candidates);
+/* the backend independent part, for the tests */
+void scope_index_update_si(struct scope_index *si, int enabled, ID id, ID pid, int uncommitted);
+void scope_index_add_done_si(struct scope_index *si, ID id);
+int scope_index_build_begin_si(struct scope_index *si);
+int64_t scope_index_build_end_si(struct scope_index *si, int enabled, int rc, ID *parent, ID size);
+IDList *scope_index_subtree_ids(struct scope_index *si, ID base, IDList *candidates);
+
 /*
  * import.c
  */
@@ -0,0 +1,644 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/* scopeindex.c - in memory tree of the entry ids used to scope searches
+ *
+ * The scope index keeps the parent id of every entry of a backend in an
+ * array indexed by entry id, so that subtree searches can be scoped
+ * without reading the ancestorid index.
+ * It is read from the parent links of the entryrdn index the first time
+ * a search needs it, then kept up to date by add, delete and modrdn.
+ *
+ * A preorder walk of the tree numbers the entries so that the subtree of
+ * an entry is the range [si_pre[id], si_last[id]] of the walk: testing if
+ * an entry is in a subtree is then a range check, and the ids of a subtree
+ * are a slice of si_order. Any update invalidates the numbering; it is
+ * only rebuilt when a search needs the whole subtree, otherwise the scope
+ * is checked by following the parent links.
+ *
+ * An entry is added to the index before its transaction is committed, so
+ * the build may not see it in the database: the adds not committed yet are
+ * tracked (si_inflight) and replayed once the parent links are read.
+ *
+ * The candidate lists built from the scope index may contain extra ids
+ * (entries that are deleted or that are not committed yet) since every
+ * candidate scope is checked again against its dn by the search. They
+ * must never miss an entry of the subtree, so when the index cannot be
+ * trusted it is dropped and the searches fall back to the ancestorid index.
+ */
+
+#include "back-ldbm.h"
+
+#define SCOPE_INDEX_NONE ((ID)-1)   /* slot of an id that is not in the tree */
+#define SCOPE_INDEX_MAX_DEPTH 4096  /* longer parent walks are considered as loops */
+#define SCOPE_INDEX_MAX_PENDING 100000 /* updates kept while the index is built */
+#define SCOPE_INDEX_PARENT_KEY 'P'  /* prefix of the entryrdn parent link keys */
+
+typedef struct scope_index_op
+{
+    ID sio_id;
+    ID sio_parent; /* SCOPE_INDEX_NONE when sio_id is removed */
+} scope_index_op;
+
+struct scope_index
+{
+    Slapi_RWLock *si_lock;
+    int si_built;               /* si_parent reflects the database */
+    int si_building;            /* a search thread is reading the entryrdn index */
+    int si_build_stale;         /* the ongoing build must be discarded */
+    scope_index_op *si_pending; /* updates received while building */
+    size_t si_npending;
+    size_t si_maxpending;
+    scope_index_op *si_inflight; /* adds not committed yet */
+    size_t si_ninflight;
+    size_t si_maxinflight;
+    ID si_size;       /* number of slots in the arrays */
+    ID *si_parent;    /* parent id of each entry, 0 for a suffix */
+    int si_tour_valid; /* si_pre, si_last and si_order match si_parent */
+    ID *si_pre;       /* rank of each entry in the preorder walk */
+    ID *si_last;      /* rank of the last descendant of each entry */
+    ID *si_order;     /* entries in preorder */
+};
+
+struct scope_index *
+scope_index_new(void)
+{
+    struct scope_index *si = (struct scope_index *)slapi_ch_calloc(1, sizeof(struct scope_index));
+
+    si->si_lock = slapi_new_rwlock();
+    return si;
+}
+
+static void
+scope_index_free_tour(struct scope_index *si)
+{
+    slapi_ch_free((void **)&si->si_pre);
+    slapi_ch_free((void **)&si->si_last);
+    slapi_ch_free((void **)&si->si_order);
+    si->si_tour_valid = 0;
+}
+
+/* Drop the content of the index. Must be called with the write lock */
+static void
+scope_index_clear(struct scope_index *si)
+{
+    scope_index_free_tour(si);
+    slapi_ch_free((void **)&si->si_parent);
+    slapi_ch_free((void **)&si->si_pending);
+    si->si_npending = 0;
+    si->si_maxpending = 0;
+    si->si_size = 0;
+    si->si_built = 0;
+    if (si->si_building) {
+        si->si_build_stale = 1;
+    }
+}
+
+void
+scope_index_free(struct scope_index **si)
+{
+    if (si && *si) {
+        scope_index_clear(*si);
+        slapi_ch_free((void **)&(*si)->si_inflight);
+        slapi_destroy_rwlock((*si)->si_lock);
+        slapi_ch_free((void **)si);
+    }
+}
+
+/* Grow a parent array so that it has a slot for id */
+static ID *
+scope_index_grow(ID *parent, ID *size, ID id)
+{
+    ID newsize = *size ? *size : 1024;
+
+    if (id < *size) {
+        return parent;
+    }
+    while (newsize <= id) {
+        newsize *= 2;
+    }
+    parent = (ID *)slapi_ch_realloc((char *)parent, newsize * sizeof(ID));
+    for (ID i = *size; i < newsize; i++) {
+        parent[i] = SCOPE_INDEX_NONE;
+    }
+    *size = newsize;
+    return parent;
+}
+
+static void
+scope_index_apply(struct scope_index *si, ID id, ID pid)
+{
+    if (pid == SCOPE_INDEX_NONE) {
+        if (id < si->si_size) {
+            si->si_parent[id] = SCOPE_INDEX_NONE;
+        }
+    } else {
+        si->si_parent = scope_index_grow(si->si_parent, &si->si_size, id);
+        si->si_parent[id] = pid;
+    }
+    si->si_tour_valid = 0;
+}
+
+static void
+scope_index_push(scope_index_op **ops, size_t *nops, size_t *maxops, ID id, ID pid)
+{
+    if (*nops == *maxops) {
+        *maxops = *maxops ? 2 * *maxops : 64;
+        *ops = (scope_index_op *)slapi_ch_realloc((char *)*ops, *maxops * sizeof(scope_index_op));
+    }
+    (*ops)[*nops].sio_id = id;
+    (*ops)[*nops].sio_parent = pid;
+    (*nops)++;
+}
+
+/* Keep an update for the build to replay. Must be called with the write lock */
+static void
+scope_index_queue(struct scope_index *si, ID id, ID pid)
+{
+    if (si->si_npending == SCOPE_INDEX_MAX_PENDING) {
+        si->si_build_stale = 1;
+    } else if (!si->si_build_stale) {
+        scope_index_push(&si->si_pending, &si->si_npending, &si->si_maxpending, id, pid);
+    }
+}
+
+/*
+ * Record an update of the tree. enabled is the nsslapd-scope-index setting,
+ * uncommitted is set for an add whose transaction is not committed yet
+ * (see scope_index_add_done_si()).
+ */
+void
+scope_index_update_si(struct scope_index *si, int enabled, ID id, ID pid, int uncommitted)
+{
+    slapi_rwlock_wrlock(si->si_lock);
+    if (uncommitted) {
+        scope_index_push(&si->si_inflight, &si->si_ninflight, &si->si_maxinflight, id, pid);
+    }
+    if (!enabled) {
+        scope_index_clear(si);
+    } else if (si->si_built) {
+        scope_index_apply(si, id, pid);
+    } else if (si->si_building) {
+        /* replayed once the parent links are read */
+        scope_index_queue(si, id, pid);
+    }
+    slapi_rwlock_unlock(si->si_lock);
+}
+
+/* The transaction of an add recorded as uncommitted is over (committed or not) */
+void
+scope_index_add_done_si(struct scope_index *si, ID id)
+{
+    slapi_rwlock_wrlock(si->si_lock);
+    for (size_t i = si->si_ninflight; i-- > 0;) {
+        if (si->si_inflight[i].sio_id == id) {
+            si->si_inflight[i] = si->si_inflight[--si->si_ninflight];
+            break;
+        }
+    }
+    slapi_rwlock_unlock(si->si_lock);
+}
+
+static void
+scope_index_update(backend *be, ID id, ID pid, int uncommitted)
+{
+    ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
+    struct scope_index *si = inst ? inst->inst_scope_index : NULL;
+
+    if (si) {
+        scope_index_update_si(si, inst->inst_li->li_scope_index, id, pid, uncommitted);
+    }
+}
+
+/*
+ * Record a new entry. Called before the transaction is committed so that
+ * the entry is known before any of its children can be added: if the
+ * transaction is aborted the id is just an extra candidate.
+ * scope_index_add_done() must be called once the transaction is over.
+ */
+void
+scope_index_add(backend *be, ID id, ID pid)
+{
+    scope_index_update(be, id, pid, 1);
+}
+
+void
+scope_index_add_done(backend *be, ID id)
+{
+    ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
+
+    if (inst && inst->inst_scope_index) {
+        scope_index_add_done_si(inst->inst_scope_index, id);
+    }
+}
+
+/* Forget an entry once its removal is committed */
+void
+scope_index_delete(backend *be, ID id)
+{
+    scope_index_update(be, id, SCOPE_INDEX_NONE, 0);
+}
+
+/* Move an entry (and its subtree) once the modrdn is committed */
+void
+scope_index_move(backend *be, ID id, ID newpid)
+{
+    scope_index_update(be, id, newpid, 0);
+}
+
+/*
+ * Drop the index: it is read again from the database the next time a search
+ * needs it. Used when the database is replaced (import, restore) and when
+ * an update cannot be applied safely.
+ */
+void
+scope_index_reset(backend *be)
+{
+    ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
+    struct scope_index *si = inst ? inst->inst_scope_index : NULL;
+
+    if (si) {
+        slapi_rwlock_wrlock(si->si_lock);
+        scope_index_clear(si);
+        slapi_rwlock_unlock(si->si_lock);
+    }
+}
+
+/* Read the parent links of the entryrdn index */
+static int
+scope_index_read_entryrdn(backend *be, ID **parentp, ID *sizep)
+{
+    struct attrinfo *ai = NULL;
+    dbi_db_t *db = NULL;
+    dbi_cursor_t cursor = {0};
+    dbi_val_t key = {0};
+    dbi_val_t data = {0};
+    char keystr[2] = {SCOPE_INDEX_PARENT_KEY, 0};
+    ID *parent = NULL;
+    ID size = 0;
+    uint64_t count = 0;
+    int rc = 0;
+
+    ainfo_get(be, (char *)LDBM_ENTRYRDN_STR, &ai);
+    if (NULL == ai) {
+        return -1;
+    }
+    rc = dblayer_get_index_file(be, ai, &db, 0);
+    if (rc) {
+        return rc;
+    }
+    rc = dblayer_new_cursor(be, db, NULL, &cursor);
+    if (rc) {
+        dblayer_release_index_file(be, ai, db);
+        return rc;
+    }
+    dblayer_value_strdup(be, &key, keystr);
+    dblayer_value_init(be, &data);
+    for (rc = dblayer_cursor_op(&cursor, DBI_OP_MOVE_NEAR_KEY, &key, &data);
+         rc == 0;
+         rc = dblayer_cursor_op(&cursor, DBI_OP_NEXT_KEY, &key, &data)) {
+        const char *k = key.data;
+        ID id = 0;
+        ID pid = 0;
+        size_t i;
+
+        if (key.size < 2 || k[0] != SCOPE_INDEX_PARENT_KEY) {
+            break;
+        }
+        for (i = 1; i < key.size && k[i] >= '0' && k[i] <= '9'; i++) {
+            id = id * 10 + (k[i] - '0');
+        }
+        if (id == 0 || id == SCOPE_INDEX_NONE || data.data == NULL) {
+            continue;
+        }
+        /* the parent elem holds the parent id (even a redirected one) */
+        entryrdn_decode_data(be, data.data, &pid, NULL, NULL, NULL, NULL);
+        if (pid == SCOPE_INDEX_NONE) {
+            continue;
+        }
+        parent = scope_index_grow(parent, &size, (id > pid) ? id : pid);
+        parent[id] = pid;
+        if (parent[pid] == SCOPE_INDEX_NONE) {
+            /* a suffix unless its own parent link is read later */
+            parent[pid] = 0;
+        }
+        if ((++count % 4096) == 0 && slapi_is_shutting_down()) {
+            rc = -1;
+            break;
+        }
+    }
+    if (rc == DBI_RC_NOTFOUND) {
+        rc = 0;
+    }
+    dblayer_value_free(be, &key);
+    dblayer_value_free(be, &data);
+    dblayer_cursor_op(&cursor, DBI_OP_CLOSE, NULL, NULL);
+    dblayer_release_index_file(be, ai, db);
+
+    if (rc) {
+        slapi_ch_free((void **)&parent);
+        size = 0;
+    }
+    *parentp = parent;
+    *sizep = size;
+    return rc;
+}
+
+/*
+ * Start building the index. Returns 1 if the calling thread must read the
+ * parent links then call scope_index_build_end_si(), 0 if the index is
+ * already built or being built by another thread.
+ */
+int
+scope_index_build_begin_si(struct scope_index *si)
+{
+    slapi_rwlock_wrlock(si->si_lock);
+    if (si->si_built || si->si_building) {
+        slapi_rwlock_unlock(si->si_lock);
+        return 0;
+    }
+    si->si_building = 1;
+    si->si_build_stale = 0;
+    /* the adds not committed yet may not be read: replay them too */
+    for (size_t i = 0; i < si->si_ninflight; i++) {
+        scope_index_queue(si, si->si_inflight[i].sio_id, si->si_inflight[i].sio_parent);
+    }
+    slapi_rwlock_unlock(si->si_lock);
+    return 1;
+}
+
+/*
+ * Publish the parent links read (passed in) if rc is 0 and no update made
+ * the build stale. Returns the number of entries of the index, or -1 if it
+ * was not published.
+ */
+int64_t
+scope_index_build_end_si(struct scope_index *si, int enabled, int rc, ID *parent, ID size)
+{
+    int64_t count = -1;
+
+    slapi_rwlock_wrlock(si->si_lock);
+    si->si_building = 0;
+    if (rc == 0 && !si->si_build_stale && enabled) {
+        si->si_parent = parent;
+        si->si_size = size;
+        for (size_t i = 0; i < si->si_npending; i++) {
+            scope_index_apply(si, si->si_pending[i].sio_id, si->si_pending[i].sio_parent);
+        }
+        si->si_built = 1;
+        si->si_tour_valid = 0;
+        count = 0;
+        for (ID id = 0; id < si->si_size; id++) {
+            count += (si->si_parent[id] != SCOPE_INDEX_NONE);
+        }
+    } else {
+        slapi_ch_free((void **)&parent);
+    }
+    si->si_build_stale = 0;
+    slapi_ch_free((void **)&si->si_pending);
+    si->si_npending = 0;
+    si->si_maxpending = 0;
+    slapi_rwlock_unlock(si->si_lock);
+    return count;
+}
+
+/*
+ * Read the index from the database. Only one thread builds it, the
+ * searches that run meanwhile use the ancestorid index.
+ */
+static void
+scope_index_build(backend *be, struct scope_index *si)
+{
+    ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
+    struct timespec start;
+    struct timespec end;
+    ID *parent = NULL;
+    ID size = 0;
+    int64_t count;
+    int rc;
+
+    if (!scope_index_build_begin_si(si)) {
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    rc = scope_index_read_entryrdn(be, &parent, &size);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    count = scope_index_build_end_si(si, inst->inst_li->li_scope_index, rc, parent, size);
+    if (count >= 0) {
+        slapi_log_err(SLAPI_LOG_INFO, "scope_index_build",
+                      "Backend %s: scope index of %lu entries read in %ld ms\n",
+                      inst->inst_name, (u_long)count,
+                      (long)((end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1000000));
+    } else if (rc) {
+        slapi_log_err(SLAPI_LOG_WARNING, "scope_index_build",
+                      "Backend %s: failed to read the entryrdn index (%d), "
+                      "subtree searches use the ancestorid index.\n",
+                      inst->inst_name, rc);
+    }
+}
+
+/*
+ * Number the entries in preorder. Entries whose parent is unknown are walked
+ * as roots; entries in a parent loop are not reachable and keep
+ * SCOPE_INDEX_NONE as rank. Must be called with the write lock.
+ */
+static void
+scope_index_build_tour(struct scope_index *si)
+{
+    ID size = si->si_size;
+    ID *first = (ID *)slapi_ch_calloc(size + 1, sizeof(ID)); /* first child of each entry in children */
+    ID *children = (ID *)slapi_ch_malloc((size ? size : 1) * sizeof(ID));
+    ID *stack = (ID *)slapi_ch_malloc((size ? size : 1) * sizeof(ID));
+    ID *next = (ID *)slapi_ch_malloc((size ? size : 1) * sizeof(ID)); /* next child to walk, per stack level */
+    ID *fill = (ID *)slapi_ch_malloc((size ? size : 1) * sizeof(ID));
+    ID rank = 0;
+
+    scope_index_free_tour(si);
+    si->si_pre = (ID *)slapi_ch_malloc((size ? size : 1) * sizeof(ID));
+    si->si_last = (ID *)slapi_ch_malloc((size ? size : 1) * sizeof(ID));
+    si->si_order = (ID *)slapi_ch_malloc((size ? size : 1) * sizeof(ID));
+
+    /* group the children by parent (counting sort) */
+    for (ID id = 0; id < size; id++) {
+        ID pid = si->si_parent[id];
+
+        si->si_pre[id] = SCOPE_INDEX_NONE;
+        si->si_last[id] = SCOPE_INDEX_NONE;
+        if (pid != SCOPE_INDEX_NONE && pid != 0 && pid < size && si->si_parent[pid] != SCOPE_INDEX_NONE) {
+            first[pid + 1]++;
+        }
+    }
+    for (ID id = 0; id < size; id++) {
+        first[id + 1] += first[id];
+        fill[id] = first[id];
+    }
+    for (ID id = 0; id < size; id++) {
+        ID pid = si->si_parent[id];
+
+        if (pid != SCOPE_INDEX_NONE && pid != 0 && pid < size && si->si_parent[pid] != SCOPE_INDEX_NONE) {
+            children[fill[pid]++] = id;
+        }
+    }
+
+    /* walk the trees */
+    for (ID root = 0; root < size; root++) {
+        ID pid = si->si_parent[root];
+        ID depth = 0;
+
+        if (pid == SCOPE_INDEX_NONE ||
+            (pid != 0 && pid < size && si->si_parent[pid] != SCOPE_INDEX_NONE)) {
+            continue;
+        }
+        stack[0] = root;
+        next[0] = first[root];
+        si->si_pre[root] = rank;
+        si->si_order[rank++] = root;
+        depth = 1;
+        while (depth > 0) {
+            ID id = stack[depth - 1];
+
+            if (next[depth - 1] < first[id + 1]) {
+                ID child = children[next[depth - 1]++];
+
+                if (si->si_pre[child] != SCOPE_INDEX_NONE) {
+                    continue;
+                }
+                si->si_pre[child] = rank;
+                si->si_order[rank++] = child;
+                stack[depth] = child;
+                next[depth] = first[child];
+                depth++;
+            } else {
+                si->si_last[id] = rank - 1;
+                depth--;
+            }
+        }
+    }
+    slapi_ch_free((void **)&first);
+    slapi_ch_free((void **)&children);
+    slapi_ch_free((void **)&stack);
+    slapi_ch_free((void **)&next);
+    slapi_ch_free((void **)&fill);
+    si->si_tour_valid = 1;
+}
+
+/*
+ * Is id in the subtree of base ?
+ * Ids that the index does not know are kept: the search checks their scope.
+ * Must be called with the lock.
+ */
+static int
+scope_index_in_subtree(struct scope_index *si, ID base, ID id)
+{
+    if (id >= si->si_size || si->si_parent[id] == SCOPE_INDEX_NONE) {
+        return 1;
+    }
+    if (si->si_tour_valid && si->si_pre[base] != SCOPE_INDEX_NONE && si->si_pre[id] != SCOPE_INDEX_NONE) {
+        return (si->si_pre[base] <= si->si_pre[id] && si->si_pre[id] <= si->si_last[base]);
+    }
+    for (int depth = 0; depth < SCOPE_INDEX_MAX_DEPTH; depth++) {
+        if (id == base) {
+            return 1;
+        }
+        id = si->si_parent[id];
+        if (id == 0) {
+            return 0;
+        }
+        if (id >= si->si_size || si->si_parent[id] == SCOPE_INDEX_NONE) {
+            return 1;
+        }
+    }
+    return 1;
+}
+
+static int
+scope_index_idcmp(const void *a, const void *b)
+{
+    ID ida = *(const ID *)a;
+    ID idb = *(const ID *)b;
+
+    return (ida < idb) ? -1 : (ida > idb);
+}
+
+/*
+ * Restrict candidates to the subtree of base (base included) with a built
+ * index. Returns a new list, or NULL if the index cannot be used.
+ */
+IDList *
+scope_index_subtree_ids(struct scope_index *si, ID base, IDList *candidates)
+{
+    IDList *idl = NULL;
+
+    slapi_rwlock_rdlock(si->si_lock);
+    if (ALLIDS(candidates) && si->si_built && !si->si_tour_valid) {
+        /* the whole subtree is needed: number the entries */
+        slapi_rwlock_unlock(si->si_lock);
+        slapi_rwlock_wrlock(si->si_lock);
+        if (si->si_built && !si->si_tour_valid) {
+            scope_index_build_tour(si);
+        }
+        slapi_rwlock_unlock(si->si_lock);
+        slapi_rwlock_rdlock(si->si_lock);
+    }
+    if (!si->si_built || base >= si->si_size || si->si_parent[base] == SCOPE_INDEX_NONE) {
+        goto done;
+    }
+
+    if (ALLIDS(candidates)) {
+        ID pre;
+        NIDS nids;
+
+        if (!si->si_tour_valid || (pre = si->si_pre[base]) == SCOPE_INDEX_NONE) {
+            goto done;
+        }
+        nids = si->si_last[base] - pre + 1;
+        idl = idl_alloc(nids);
+        memcpy(idl->b_ids, &si->si_order[pre], nids * sizeof(ID));
+        qsort(idl->b_ids, nids, sizeof(ID), scope_index_idcmp);
+        idl->b_nids = nids;
+    } else {
+        idl = idl_alloc(candidates->b_nids);
+        for (NIDS i = 0; i < candidates->b_nids; i++) {
+            if (scope_index_in_subtree(si, base, candidates->b_ids[i])) {
+                idl->b_ids[idl->b_nids++] = candidates->b_ids[i];
+            }
+        }
+    }
+done:
+    slapi_rwlock_unlock(si->si_lock);
+    return idl;
+}
+
+/*
+ * Restrict candidates to the subtree of base (base included).
+ * Returns a new list, or NULL if the scope index cannot be used: the caller
+ * then scopes the candidates with the ancestorid index.
+ */
+IDList *
+scope_index_subtree_candidates(backend *be, ID base, IDList *candidates)
+{
+    ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
+    struct scope_index *si = inst->inst_scope_index;
+    int built;
+
+    if (NULL == si || !inst->inst_li->li_scope_index || NULL == candidates) {
+        return NULL;
+    }
+    slapi_rwlock_rdlock(si->si_lock);
+    built = si->si_built;
+    slapi_rwlock_unlock(si->si_lock);
+    if (!built) {
+        scope_index_build(be, si);
+    }
+    return scope_index_subtree_ids(si, base, candidates);
+}
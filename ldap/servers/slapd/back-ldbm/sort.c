@@ -17,6 +17,13 @@
 
 #define CHECK_INTERVAL 10 /* The frequency whith which we'll check the admin limits */
 
+/* What the comparison needs from each sort spec */
+typedef struct sort_key_spec
+{
+    value_compare_fn_type compare_fn;
+    int order; /* 0 == ascending, 1 == decending */
+} sort_key_spec;
+
 /* Structure to carry the things we need down the call stack */
 struct baggage_carrier
 {
@@ -25,10 +32,12 @@ struct baggage_carrier
     struct timespec *expire_time;
     int lookthrough_limit;
     int check_counter; /* Used to avoid checking every 100ns */
+    sort_key_spec *specs;
+    int nspecs;
 };
 typedef struct baggage_carrier baggage_carrier;
 
-static int slapd_qsort(baggage_carrier *bc, IDList *list, sort_spec *s);
+static int sort_by_keys(baggage_carrier *bc, IDList *list, sort_spec *s, NIDS sort_limit, struct sort_tail **tail);
 static int print_out_sort_spec(char *buffer, sort_spec *s, int *size);
 
 static void
@@ -152,7 +161,9 @@ sort_log_access(Slapi_PBlock *pb, sort_spec_thing *s, IDList *candidates, PRBool
  */
 /*
  * So here's the plan:
- * Plan A:  We do a regular quicksort on the entries.
+ * Plan A:  We do a regular quicksort on the entries' sort keys,
+ *            or only select the first sort_limit ones when the
+ *            caller does not need more.
  * Plan B:  Through some hint given us from on high, we
  *            determine that the entries are _already_
  *            sorted as requested, thus we do nothing !
@@ -160,7 +171,7 @@ sort_log_access(Slapi_PBlock *pb, sort_spec_thing *s, IDList *candidates, PRBool
  *            far too hard for us to even try, so we refuse.
  */
 int
-sort_candidates(backend *be, int lookthrough_limit, struct timespec *expire_time, Slapi_PBlock *pb, IDList *candidates, sort_spec_thing *s, char **sort_error_type)
+sort_candidates(backend *be, int lookthrough_limit, struct timespec *expire_time, Slapi_PBlock *pb, IDList *candidates, sort_spec_thing *s, NIDS sort_limit, struct sort_tail **tail, char **sort_error_type)
 {
     int return_value = LDAP_SUCCESS;
     baggage_carrier bc = {0};
@@ -209,8 +220,19 @@ sort_candidates(backend *be, int lookthrough_limit, struct timespec *expire_time
     bc.expire_time = expire_time;
     bc.lookthrough_limit = lookthrough_limit;
     bc.check_counter = 1;
+    for (this_s = s; this_s; this_s = this_s->next) {
+        bc.nspecs++;
+    }
+    bc.specs = (sort_key_spec *)slapi_ch_calloc(bc.nspecs, sizeof(sort_key_spec));
+    bc.nspecs = 0;
+    for (this_s = s; this_s; this_s = this_s->next) {
+        bc.specs[bc.nspecs].compare_fn = this_s->compare_fn;
+        bc.specs[bc.nspecs].order = this_s->order;
+        bc.nspecs++;
+    }
 
-    return_value = slapd_qsort(&bc, candidates, s);
+    return_value = sort_by_keys(&bc, candidates, s, sort_limit, tail);
+    slapi_ch_free((void **)&bc.specs);
     slapi_log_err(SLAPI_LOG_TRACE, "Sorting done", "<=\n");
 
     return return_value;
@@ -455,6 +477,57 @@ sort_attr_compare(struct berval **value_a, struct berval **value_b, value_compar
     return compare_fn(compare_value_a, compare_value_b);
 }
 
+/*
+ * Sort keys.
+ *
+ * Every candidate entry is fetched once and its sort keys (for each sort
+ * attribute, the lowest value or the lowest matching rule key) are copied
+ * into a compact record. The records are then sorted in memory, so the
+ * comparisons never go back to id2entry.
+ *
+ * A record is the entry ID followed by, for each sort spec, a 32 bit length
+ * (SORT_KEY_ABSENT when the entry lacks the attribute) and the key bytes.
+ * When the records outgrow nsslapd-sort-memory-limit, they are sorted and
+ * written to an unlinked temporary file (a run) in the same layout, and the
+ * runs are merged into the candidate list once all entries were read.
+ */
+#define SORT_KEY_ABSENT UINT32_MAX
+#define SORT_MAX_RUNS 128 /* beyond that many runs, the list is too large to sort */
+
+typedef struct sort_key
+{
+    ID id;
+    uint32_t size; /* of data */
+    unsigned char data[];
+} sort_key;
+
+typedef struct sort_ctx
+{
+    sort_key **keys;    /* records held in memory */
+    NIDS nkeys;
+    NIDS maxkeys;
+    uint64_t mem;       /* bytes used by the records */
+    uint64_t mem_limit; /* 0: never spill */
+    unsigned char *buf; /* record being built */
+    size_t buf_len;
+    size_t buf_size;
+    FILE *runs[SORT_MAX_RUNS];
+    int nruns;
+} sort_ctx;
+
+/*
+ * Order of the candidates after the first 'prefix' ones, sorted only if
+ * the search gets that far (see sort_candidates_tail).
+ */
+struct sort_tail
+{
+    sort_key_spec *specs;
+    int nspecs;
+    sort_key **keys;
+    NIDS nkeys;
+    NIDS prefix;
+};
+
 /* Comparison routine, called by qsort.
  * The job here is to return the correct value
  * for the operation a < b
@@ -464,125 +537,146 @@ sort_attr_compare(struct berval **value_a, struct berval **value_b, value_compar
  * >0 when a > b
  */
 static int
-compare_entries_sv(ID *id_a, ID *id_b, sort_spec *s, baggage_carrier *bc, int *error)
+compare_sort_keys(const sort_key *a, const sort_key *b, const sort_key_spec *specs, int nspecs)
 {
-    /* We get passed the IDs, but need to fetch the entries in order to
-     * perform the comparison .
-     */
-    struct backentry *a = NULL;
-    struct backentry *b = NULL;
-    int result = 0;
-    sort_spec_thing *this_one = NULL;
-    backend *be = bc->be;
-    ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
-    int err;
-    back_txn txn = {NULL};
-
-    slapi_pblock_get(bc->pb, SLAPI_TXN, &txn.back_txn_txn);
-    *error = 1;
-    a = id2entry(be, *id_a, &txn, &err);
-    if (NULL == a) {
-        if (0 != err) {
-            slapi_log_err(SLAPI_LOG_TRACE, "compare_entries_sv", "db err %d\n", err);
-        }
-        /* Were up a creek without paddle here */
-        /* Best to log error and set some flag */
-        return 0;
-    }
-    b = id2entry(be, *id_b, &txn, &err);
-    if (NULL == b) {
-        if (0 != err) {
-            slapi_log_err(SLAPI_LOG_TRACE, "compare_entries_sv", "db err %d\n", err);
-        }
-        CACHE_RETURN(&inst->inst_cache, &a);
-        return 0;
-    }
-    /* OK, now we have the entries, so we work our way down the attribute list comparing as we go */
-    for (this_one = (sort_spec_thing *)s; this_one; this_one = this_one->next) {
-
-        char *type = this_one->type;
-        int order = this_one->order;
-        Slapi_Attr *attr_a = NULL;
-        Slapi_Attr *attr_b = NULL;
-        struct berval **value_a = NULL;
-        struct berval **value_b = NULL;
-
-        /* Get the two attribute values from the entries */
-        slapi_entry_attr_find(a->ep_entry, type, &attr_a);
-        slapi_entry_attr_find(b->ep_entry, type, &attr_b);
+    const unsigned char *pa = a->data;
+    const unsigned char *pb = b->data;
+
+    for (int i = 0; i < nspecs; i++) {
+        struct berval value_a;
+        struct berval value_b;
+        uint32_t len_a;
+        uint32_t len_b;
+        int result;
+
+        memcpy(&len_a, pa, sizeof(len_a));
+        memcpy(&len_b, pb, sizeof(len_b));
+        pa += sizeof(len_a);
+        pb += sizeof(len_b);
         /* What do we do if one or more of the entries lacks this attribute ? */
-        /* if one lacks the attribute */
-        if (NULL == attr_a) {
+        if (SORT_KEY_ABSENT == len_a) {
             /* then if the other does too, they're equal */
-            if (NULL == attr_b) {
-                result = 0;
+            if (SORT_KEY_ABSENT == len_b) {
                 continue;
-            } else {
-                /* If one has the attribute, and the other
-                 * doesn't, the missing attribute is the
-                 * LARGER one.  (bug #108154)  -robey
-                 */
-                result = 1;
-                break;
             }
+            /* If one has the attribute, and the other
+             * doesn't, the missing attribute is the
+             * LARGER one.  (bug #108154)  -robey
+             */
+            return 1;
         }
-        if (NULL == attr_b) {
-            result = -1;
-            break;
+        if (SORT_KEY_ABSENT == len_b) {
+            return -1;
         }
-        /* Somewhere in here, we need to go sideways for match rule case
-         * we need to call the match rule plugin to get the attribute values
-         * converted into ordering keys. Then we proceed as usual to use those,
-         * but ensuring that we don't leak memory anywhere. This works as follows:
-         * the code assumes that the attrs are references into the entry, so
-         * doesn't try to free them. We need to note at the right place that
-         * we're on the matchrule path, and accordingly free the keys---this turns out
-         * to be when we free the indexer */
-        if (NULL == this_one->matchrule) {
-            /* Non-match rule case */
-            valuearray_get_bervalarray(valueset_get_valuearray(&attr_a->a_present_values), &value_a);
-            valuearray_get_bervalarray(valueset_get_valuearray(&attr_b->a_present_values), &value_b);
-        } else {
-            /* Match rule case */
-            Slapi_Value **va_a = valueset_get_valuearray(&attr_a->a_present_values);
-            Slapi_Value **va_b = valueset_get_valuearray(&attr_b->a_present_values);
-
-            matchrule_values_to_keys(this_one->mr_pb, va_a, &value_a);
-            /* Plugin owns the memory ==> duplicate the key before next call garble it */
-            value_a = slapi_ch_bvecdup(value_a);
-            matchrule_values_to_keys(this_one->mr_pb, va_b, &value_b);
-
-            if ((va_a && !value_a) || (va_b && !value_b)) {
-                result = 0;
-                goto bail;
-            }
-        }
-        /* Compare them */
-        if (!order) {
-            result = sort_attr_compare(value_a, value_b, this_one->compare_fn);
+        value_a.bv_len = len_a;
+        value_a.bv_val = (char *)pa;
+        value_b.bv_len = len_b;
+        value_b.bv_val = (char *)pb;
+        pa += len_a;
+        pb += len_b;
+        if (!specs[i].order) {
+            result = specs[i].compare_fn(&value_a, &value_b);
         } else {
             /* If reverse, invert the sense of the comparison */
-            result = sort_attr_compare(value_b, value_a, this_one->compare_fn);
+            result = specs[i].compare_fn(&value_b, &value_a);
         }
-        /* Time to free up the attributes allocated above */
-        if (NULL != this_one->matchrule) {
-            ber_bvecfree(value_a);
-        } else {
-            ber_bvecfree(value_a);
-            ber_bvecfree(value_b);
-        }
-        /* Are they equal ? */
         if (0 != result) {
-            /* If not, we're done */
-            break;
+            return result;
         }
-        /* If so, proceed to the next attribute for comparison */
     }
-    *error = 0;
-bail:
-    CACHE_RETURN(&inst->inst_cache, &a);
-    CACHE_RETURN(&inst->inst_cache, &b);
-    return result;
+    /* Equal keys: keep a stable order across searches */
+    return (a->id > b->id) - (a->id < b->id);
+}
+
+static void
+sort_key_append(sort_ctx *ctx, const struct berval *value)
+{
+    uint32_t len = value ? (uint32_t)value->bv_len : SORT_KEY_ABSENT;
+    size_t need = ctx->buf_len + sizeof(len) + (value ? value->bv_len : 0);
+
+    if (need > ctx->buf_size) {
+        ctx->buf_size = need * 2;
+        ctx->buf = (unsigned char *)slapi_ch_realloc((char *)ctx->buf, ctx->buf_size);
+    }
+    memcpy(ctx->buf + ctx->buf_len, &len, sizeof(len));
+    ctx->buf_len += sizeof(len);
+    if (value && value->bv_len) {
+        memcpy(ctx->buf + ctx->buf_len, value->bv_val, value->bv_len);
+        ctx->buf_len += value->bv_len;
+    }
+}
+
+/*
+ * Build the sort key record of an entry. A NULL entry (deleted since the
+ * candidate list was built) gets absent keys and sorts last.
+ * Returns NULL if a matching rule failed to generate keys.
+ */
+static sort_key *
+sort_key_extract(sort_ctx *ctx, sort_spec *s, ID id, struct backentry *e)
+{
+    sort_spec_thing *this_one = NULL;
+    sort_key *key = NULL;
+
+    ctx->buf_len = 0;
+    for (this_one = (sort_spec_thing *)s; this_one; this_one = this_one->next) {
+        Slapi_Attr *attr = NULL;
+        const struct berval *lowest = NULL;
+
+        if (e) {
+            slapi_entry_attr_find(e->ep_entry, this_one->type, &attr);
+        }
+        if (attr) {
+            Slapi_Value **va = valueset_get_valuearray(&attr->a_present_values);
+            /* Multi-valued attributes sort on their lowest value (X.511) */
+            if (NULL == this_one->matchrule) {
+                for (size_t i = 0; va && va[i]; i++) {
+                    const struct berval *bv = slapi_value_get_berval(va[i]);
+                    if (NULL == lowest || this_one->compare_fn(lowest, bv) > 0) {
+                        lowest = bv;
+                    }
+                }
+            } else {
+                /* The plugin owns the keys, they are copied before the next call */
+                struct berval **mr_keys = NULL;
+
+                matchrule_values_to_keys(this_one->mr_pb, va, &mr_keys);
+                if (va && !mr_keys) {
+                    return NULL;
+                }
+                for (size_t i = 0; mr_keys && mr_keys[i]; i++) {
+                    if (NULL == lowest || this_one->compare_fn(lowest, mr_keys[i]) > 0) {
+                        lowest = mr_keys[i];
+                    }
+                }
+            }
+        }
+        sort_key_append(ctx, lowest);
+    }
+
+    key = (sort_key *)slapi_ch_malloc(sizeof(sort_key) + ctx->buf_len);
+    key->id = id;
+    key->size = (uint32_t)ctx->buf_len;
+    memcpy(key->data, ctx->buf, ctx->buf_len);
+    return key;
+}
+
+static void
+sort_key_add(sort_ctx *ctx, sort_key *key)
+{
+    if (ctx->nkeys == ctx->maxkeys) {
+        ctx->maxkeys = ctx->maxkeys ? ctx->maxkeys * 2 : 1024;
+        ctx->keys = (sort_key **)slapi_ch_realloc((char *)ctx->keys, ctx->maxkeys * sizeof(sort_key *));
+    }
+    ctx->keys[ctx->nkeys++] = key;
+    ctx->mem += sizeof(sort_key *) + sizeof(sort_key) + key->size;
+}
+
+static void
+sort_keys_free(sort_key **keys, NIDS nkeys)
+{
+    for (NIDS i = 0; i < nkeys; i++) {
+        slapi_ch_free((void **)&keys[i]);
+    }
 }
 
 /* Fix for bug # 394184, SD, 20 Jul 00 */
@@ -630,8 +724,8 @@ sort_check(baggage_carrier *bc)
 /* End fix for bug # 394184 */
 
 /* prototypes for local routines */
-static void shortsort(baggage_carrier *bc, ID *lo, ID *hi, sort_spec *s);
-static void swap(ID *a, ID *b);
+static void shortsort(baggage_carrier *bc, sort_key **lo, sort_key **hi);
+static void swap(sort_key **a, sort_key **b);
 
 /* this parameter defines the cutoff between using quick sort and
    insertion sort for arrays; arrays with lengths shorter or equal to the
@@ -643,7 +737,7 @@ static void swap(ID *a, ID *b);
 /* Fix for bug # 394184, SD, 20 Jul 00 */
 /* replace the hard coded return value by the appropriate LDAP error code */
 /* Our qsort needs to police the client timeout and lookthrough limit ?
- * It knows how to compare entries, so we don't bother with all the void * stuff.
+ * It knows how to compare sort keys, so we don't bother with all the void * stuff.
  */
 /*
  * Returns:
@@ -656,17 +750,15 @@ static void swap(ID *a, ID *b);
  * -6: Abandoned             now is: LDAP_OTHER
  */
 static int
-slapd_qsort(baggage_carrier *bc, IDList *list, sort_spec *s)
+slapd_qsort(baggage_carrier *bc, sort_key **base, NIDS num)
 {
-    ID *lo, *hi;       /* ends of sub-array currently sorting */
-    ID *mid;           /* points to middle of subarray */
-    ID *loguy, *higuy; /* traveling pointers for partition step */
-    NIDS size;         /* size of the sub-array */
-    ID *lostk[30], *histk[30];
+    sort_key **lo, **hi;       /* ends of sub-array currently sorting */
+    sort_key **mid;            /* points to middle of subarray */
+    sort_key **loguy, **higuy; /* traveling pointers for partition step */
+    NIDS size;                 /* size of the sub-array */
+    sort_key **lostk[30], **histk[30];
     int stkptr; /* stack for saving sub-array to be processed */
-    NIDS num = list->b_nids;
     int return_value = LDAP_SUCCESS;
-    int error = 0;
 
     /* Note: the number of stack entries required is no more than
        1 + log2(size), so 30 is sufficient for any array */
@@ -675,14 +767,8 @@ slapd_qsort(baggage_carrier *bc, IDList *list, sort_spec *s)
 
     stkptr = 0; /* initialize stack */
 
-    lo = &(list->b_ids[0]);
-    hi = &(list->b_ids[num - 1]); /* initialize limits */
-
-    /* Fix for bugid #394184, SD, 20 Jul 00 */
-    if (bc->lookthrough_limit != -1 && (bc->lookthrough_limit <= (int)list->b_nids)) {
-        return LDAP_ADMINLIMIT_EXCEEDED;
-    }
-/* end Fix for bugid #394184 */
+    lo = &(base[0]);
+    hi = &(base[num - 1]); /* initialize limits */
 
 /* this entry point is for pseudo-recursion calling: setting
        lo and hi and jumping to here is like recursion, but stkptr is
@@ -693,7 +779,7 @@ recurse:
 
     /* below a certain size, it is faster to use a O(n^2) sorting method */
     if (size <= CUTOFF) {
-        shortsort(bc, lo, hi, s);
+        shortsort(bc, lo, hi);
     } else {
         /* First we pick a partititioning element.  The efficiency of the
            algorithm demands that we find one that is approximately the
@@ -724,19 +810,15 @@ recurse:
                A[i] >= A[lo] for higuy <= i <= hi */
 
             do {
-                if (error)
-                    return LDAP_OPERATIONS_ERROR;
                 loguy++;
-            } while (loguy <= hi && compare_entries_sv(loguy, lo, s, bc, &error) <= 0);
+            } while (loguy <= hi && compare_sort_keys(*loguy, *lo, bc->specs, bc->nspecs) <= 0);
 
             /* lo < loguy <= hi+1, A[i] <= A[lo] for lo <= i < loguy,
                either loguy > hi or A[loguy] > A[lo] */
 
             do {
-                if (error)
-                    return LDAP_OPERATIONS_ERROR;
                 higuy--;
-            } while (higuy > lo && compare_entries_sv(higuy, lo, s, bc, &error) >= 0);
+            } while (higuy > lo && compare_sort_keys(*higuy, *lo, bc->specs, bc->nspecs) >= 0);
 
             /* lo-1 <= higuy <= hi, A[i] >= A[lo] for higuy < i <= hi,
                either higuy <= lo or A[higuy] < A[lo] */
@@ -821,12 +903,10 @@ recurse:
 static void
 shortsort(
     baggage_carrier *bc,
-    ID *lo,
-    ID *hi,
-    sort_spec *s)
+    sort_key **lo,
+    sort_key **hi)
 {
-    ID *p, *max;
-    int error = 0;
+    sort_key **p, **max;
 
     /* Note: in assertions below, i and j are alway inside original bound of
        array to sort. */
@@ -836,7 +916,7 @@ shortsort(
         max = lo;
         for (p = lo + 1; p <= hi; p++) {
             /* A[i] <= A[max] for lo <= i < p */
-            if (compare_entries_sv(p, max, s, bc, &error) > 0) {
+            if (compare_sort_keys(*p, *max, bc->specs, bc->nspecs) > 0) {
                 max = p;
             }
             /* A[i] <= A[max] for lo <= i <= p */
@@ -857,9 +937,9 @@ shortsort(
 }
 
 static void
-swap(ID *a, ID *b)
+swap(sort_key **a, sort_key **b)
 {
-    ID tmp;
+    sort_key *tmp;
 
     if (a != b) {
         tmp = *a;
@@ -867,3 +947,345 @@ swap(ID *a, ID *b)
         *b = tmp;
     }
 }
+
+/* Restore the max-heap property of heap[0..n) below node i */
+static void
+sort_heap_down(baggage_carrier *bc, sort_key **heap, NIDS n, NIDS i)
+{
+    for (;;) {
+        NIDS largest = i;
+        NIDS l = 2 * i + 1;
+        NIDS r = l + 1;
+
+        if (l < n && compare_sort_keys(heap[l], heap[largest], bc->specs, bc->nspecs) > 0) {
+            largest = l;
+        }
+        if (r < n && compare_sort_keys(heap[r], heap[largest], bc->specs, bc->nspecs) > 0) {
+            largest = r;
+        }
+        if (largest == i) {
+            return;
+        }
+        swap(&heap[i], &heap[largest]);
+        i = largest;
+    }
+}
+
+/*
+ * Partial sort: move the k lowest keys to keys[0..k) in order, the
+ * others are left in keys[k..num) in no particular order.
+ */
+static int
+sort_select(baggage_carrier *bc, sort_key **keys, NIDS num, NIDS k)
+{
+    /* max-heap of the k lowest keys seen so far */
+    for (NIDS i = k / 2; i-- > 0;) {
+        sort_heap_down(bc, keys, k, i);
+    }
+    for (NIDS i = k; i < num; i++) {
+        if (compare_sort_keys(keys[i], keys[0], bc->specs, bc->nspecs) < 0) {
+            swap(&keys[i], &keys[0]);
+            sort_heap_down(bc, keys, k, 0);
+        }
+    }
+    return slapd_qsort(bc, keys, k);
+}
+
+/* Sort the records held in memory and write them to a new run */
+static int
+sort_spill(sort_ctx *ctx, baggage_carrier *bc)
+{
+    int return_value;
+    char *tmpdir = NULL;
+    char *path = NULL;
+    FILE *run = NULL;
+    int fd;
+
+    if (ctx->nruns == SORT_MAX_RUNS) {
+        slapi_log_err(SLAPI_LOG_ERR, "sort_spill",
+                      "Candidate list needs more than %d sort runs, increase nsslapd-sort-memory-limit\n",
+                      SORT_MAX_RUNS);
+        return LDAP_UNWILLING_TO_PERFORM;
+    }
+    if (LDAP_SUCCESS != (return_value = slapd_qsort(bc, ctx->keys, ctx->nkeys))) {
+        return return_value;
+    }
+
+    tmpdir = config_get_tmpdir();
+    path = slapi_ch_smprintf("%s/ldbm-sort-XXXXXX", tmpdir ? tmpdir : "/tmp");
+    slapi_ch_free_string(&tmpdir);
+    if ((fd = mkstemp(path)) < 0 || (run = fdopen(fd, "w+")) == NULL) {
+        slapi_log_err(SLAPI_LOG_ERR, "sort_spill",
+                      "Unable to create sort run file %s: error %d (%s)\n",
+                      path, errno, strerror(errno));
+        if (fd >= 0) {
+            close(fd);
+            unlink(path);
+        }
+        slapi_ch_free_string(&path);
+        return LDAP_OPERATIONS_ERROR;
+    }
+    /* Removed from the file system, it goes away when closed */
+    unlink(path);
+    slapi_ch_free_string(&path);
+
+    for (NIDS i = 0; i < ctx->nkeys; i++) {
+        sort_key *key = ctx->keys[i];
+        if (fwrite(key, sizeof(sort_key) + key->size, 1, run) != 1) {
+            break;
+        }
+    }
+    if (fflush(run) || ferror(run)) {
+        slapi_log_err(SLAPI_LOG_ERR, "sort_spill",
+                      "Unable to write sort run: error %d (%s)\n", errno, strerror(errno));
+        fclose(run);
+        return LDAP_OPERATIONS_ERROR;
+    }
+    sort_keys_free(ctx->keys, ctx->nkeys);
+    ctx->runs[ctx->nruns++] = run;
+    ctx->nkeys = 0;
+    ctx->mem = 0;
+    return LDAP_SUCCESS;
+}
+
+/* Read the next record of a run, NULL at the end of the run or on error */
+static sort_key *
+sort_run_read(FILE *run)
+{
+    sort_key head;
+    sort_key *key;
+
+    if (fread(&head, sizeof(head), 1, run) != 1) {
+        return NULL;
+    }
+    key = (sort_key *)slapi_ch_malloc(sizeof(sort_key) + head.size);
+    *key = head;
+    if (head.size && fread(key->data, head.size, 1, run) != 1) {
+        slapi_ch_free((void **)&key);
+    }
+    return key;
+}
+
+typedef struct sort_run_head
+{
+    sort_key *key;
+    FILE *run;
+} sort_run_head;
+
+/* Restore the min-heap property of heap[0..n) below node i */
+static void
+sort_merge_down(baggage_carrier *bc, sort_run_head *heap, int n, int i)
+{
+    for (;;) {
+        int lowest = i;
+        int l = 2 * i + 1;
+        int r = l + 1;
+        sort_run_head tmp;
+
+        if (l < n && compare_sort_keys(heap[l].key, heap[lowest].key, bc->specs, bc->nspecs) < 0) {
+            lowest = l;
+        }
+        if (r < n && compare_sort_keys(heap[r].key, heap[lowest].key, bc->specs, bc->nspecs) < 0) {
+            lowest = r;
+        }
+        if (lowest == i) {
+            return;
+        }
+        tmp = heap[i];
+        heap[i] = heap[lowest];
+        heap[lowest] = tmp;
+        i = lowest;
+    }
+}
+
+/* Merge the sorted runs into the candidate list */
+static int
+sort_merge_runs(sort_ctx *ctx, baggage_carrier *bc, IDList *list)
+{
+    sort_run_head heap[SORT_MAX_RUNS];
+    int n = 0;
+    NIDS out = 0;
+    int return_value = LDAP_SUCCESS;
+
+    for (int i = 0; i < ctx->nruns; i++) {
+        rewind(ctx->runs[i]);
+        heap[n].run = ctx->runs[i];
+        if ((heap[n].key = sort_run_read(ctx->runs[i])) != NULL) {
+            n++;
+        }
+    }
+    for (int i = n / 2; i-- > 0;) {
+        sort_merge_down(bc, heap, n, i);
+    }
+    while (n > 0) {
+        if (out == list->b_nids) {
+            /* can't happen unless a run is corrupted */
+            return_value = LDAP_OPERATIONS_ERROR;
+            break;
+        }
+        list->b_ids[out++] = heap[0].key->id;
+        slapi_ch_free((void **)&heap[0].key);
+        if ((heap[0].key = sort_run_read(heap[0].run)) == NULL) {
+            heap[0] = heap[--n];
+        }
+        sort_merge_down(bc, heap, n, 0);
+        if (LDAP_SUCCESS != (return_value = sort_check(bc))) {
+            break;
+        }
+    }
+    for (int i = 0; i < n; i++) {
+        slapi_ch_free((void **)&heap[i].key);
+    }
+    if (LDAP_SUCCESS == return_value && out != list->b_nids) {
+        slapi_log_err(SLAPI_LOG_ERR, "sort_merge_runs",
+                      "Sort runs returned %lu IDs out of %lu\n", (u_long)out, (u_long)list->b_nids);
+        return_value = LDAP_OPERATIONS_ERROR;
+    }
+    return return_value;
+}
+
+/*
+ * Sort the candidate list. When sort_limit is not 0, only the first
+ * sort_limit candidates need to be in order: if tail is not NULL, the
+ * remaining ones are sorted later by sort_candidates_tail if the search
+ * gets that far, otherwise they are left as they are.
+ */
+static int
+sort_by_keys(baggage_carrier *bc, IDList *list, sort_spec *s, NIDS sort_limit, struct sort_tail **tail)
+{
+    struct ldbminfo *li = (struct ldbminfo *)bc->be->be_database->plg_private;
+    ldbm_instance *inst = (ldbm_instance *)bc->be->be_instance_info;
+    sort_ctx ctx = {0};
+    back_txn txn = {NULL};
+    NIDS num = list->b_nids;
+    int return_value = LDAP_SUCCESS;
+
+    if (num < 2) {
+        return LDAP_SUCCESS; /* nothing to do */
+    }
+
+    /* Fix for bugid #394184, SD, 20 Jul 00 */
+    if (bc->lookthrough_limit != -1 && (bc->lookthrough_limit <= (int)num)) {
+        return LDAP_ADMINLIMIT_EXCEEDED;
+    }
+    /* end Fix for bugid #394184 */
+
+    ctx.mem_limit = li->li_sort_memory_limit;
+    slapi_pblock_get(bc->pb, SLAPI_TXN, &txn.back_txn_txn);
+
+    /* Fetch each entry once to extract its sort keys */
+    for (NIDS i = 0; i < num; i++) {
+        struct backentry *e = NULL;
+        sort_key *key = NULL;
+        int err = 0;
+
+        if (LDAP_SUCCESS != (return_value = sort_check(bc))) {
+            goto done;
+        }
+        e = id2entry(bc->be, list->b_ids[i], &txn, &err);
+        if (NULL == e && 0 != err && DBI_RC_NOTFOUND != err) {
+            slapi_log_err(SLAPI_LOG_ERR, "sort_by_keys", "db err %d\n", err);
+            return_value = LDAP_OPERATIONS_ERROR;
+            goto done;
+        }
+        key = sort_key_extract(&ctx, s, list->b_ids[i], e);
+        CACHE_RETURN(&inst->inst_cache, &e);
+        if (NULL == key) {
+            return_value = LDAP_OPERATIONS_ERROR;
+            goto done;
+        }
+        sort_key_add(&ctx, key);
+        if (ctx.mem_limit && ctx.mem > ctx.mem_limit) {
+            if (LDAP_SUCCESS != (return_value = sort_spill(&ctx, bc))) {
+                goto done;
+            }
+        }
+    }
+
+    if (ctx.nruns) {
+        /* External merge of the runs */
+        if (ctx.nkeys && LDAP_SUCCESS != (return_value = sort_spill(&ctx, bc))) {
+            goto done;
+        }
+        slapi_log_err(SLAPI_LOG_TRACE, "sort_by_keys", "Merging %d sort runs\n", ctx.nruns);
+        return_value = sort_merge_runs(&ctx, bc, list);
+        goto done;
+    }
+
+    if (sort_limit && sort_limit < num) {
+        return_value = sort_select(bc, ctx.keys, num, sort_limit);
+    } else {
+        return_value = slapd_qsort(bc, ctx.keys, num);
+    }
+    if (LDAP_SUCCESS == return_value) {
+        for (NIDS i = 0; i < num; i++) {
+            list->b_ids[i] = ctx.keys[i]->id;
+        }
+        if (sort_limit && sort_limit < num && tail) {
+            struct sort_tail *t = (struct sort_tail *)slapi_ch_calloc(1, sizeof(struct sort_tail));
+            t->nspecs = bc->nspecs;
+            t->specs = (sort_key_spec *)slapi_ch_malloc(bc->nspecs * sizeof(sort_key_spec));
+            memcpy(t->specs, bc->specs, bc->nspecs * sizeof(sort_key_spec));
+            t->prefix = sort_limit;
+            t->nkeys = num - sort_limit;
+            t->keys = (sort_key **)slapi_ch_malloc(t->nkeys * sizeof(sort_key *));
+            memcpy(t->keys, ctx.keys + sort_limit, t->nkeys * sizeof(sort_key *));
+            ctx.nkeys = sort_limit; /* the tail owns the others now */
+            *tail = t;
+        }
+    }
+
+done:
+    sort_keys_free(ctx.keys, ctx.nkeys);
+    slapi_ch_free((void **)&ctx.keys);
+    slapi_ch_free((void **)&ctx.buf);
+    for (int i = 0; i < ctx.nruns; i++) {
+        fclose(ctx.runs[i]);
+    }
+    return return_value;
+}
+
+/*
+ * Called by the search before it reads the candidate at position current.
+ * Sorts the end of the candidate list if a partial sort left it unsorted
+ * and the search got past the sorted part.
+ */
+int
+sort_candidates_tail(struct sort_tail **tail, IDList *candidates, idl_iterator current, Slapi_PBlock *pb, struct timespec *expire_time)
+{
+    baggage_carrier bc = {0};
+    struct sort_tail *t = *tail;
+    int return_value;
+
+    if (NULL == t || (NIDS)current < t->prefix) {
+        return LDAP_SUCCESS;
+    }
+
+    bc.pb = pb;
+    bc.expire_time = expire_time;
+    bc.check_counter = 1;
+    bc.specs = t->specs;
+    bc.nspecs = t->nspecs;
+    return_value = slapd_qsort(&bc, t->keys, t->nkeys);
+    if (LDAP_SUCCESS == return_value) {
+        for (NIDS i = 0; i < t->nkeys && t->prefix + i < candidates->b_nids; i++) {
+            candidates->b_ids[t->prefix + i] = t->keys[i]->id;
+        }
+        slapi_log_err(SLAPI_LOG_TRACE, "sort_candidates_tail",
+                      "Sorted the last %lu candidates\n", (u_long)t->nkeys);
+        sort_tail_free(tail);
+    }
+    return return_value;
+}
+
+void
+sort_tail_free(struct sort_tail **tail)
+{
+    if (NULL == tail || NULL == *tail) {
+        return;
+    }
+    sort_keys_free((*tail)->keys, (*tail)->nkeys);
+    slapi_ch_free((void **)&(*tail)->keys);
+    slapi_ch_free((void **)&(*tail)->specs);
+    slapi_ch_free((void **)tail);
+}
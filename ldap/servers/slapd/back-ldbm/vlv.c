@@ -1582,6 +1582,25 @@ vlv_trim_candidates_txn(backend *be, const IDList *candidates, const sort_spec *
     return return_value;
 }
 
+/*
+ * Number of leading entries of a sorted candidate list of this length a
+ * byIndex request can return. The candidates after them don't need to be
+ * sorted. A byValue request needs the whole list sorted.
+ */
+PRUint32
+vlv_trim_candidates_sort_limit(PRUint32 length, const struct vlv_request *vlv_request_control)
+{
+    PRUint32 start, stop;
+
+    if (0 == length || NULL == vlv_request_control || 0 != vlv_request_control->tag) {
+        return length;
+    }
+    determine_result_range(vlv_request_control,
+                           vlv_trim_candidates_byindex(length, vlv_request_control),
+                           length, &start, &stop);
+    return stop + 1;
+}
+
 int
 vlv_trim_candidates(backend *be, const IDList *candidates, const sort_spec *sort_control, const struct vlv_request *vlv_request_control, IDList **trimmedCandidates, struct vlv_response *vlv_response_control)
 {
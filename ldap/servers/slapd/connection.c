@@ -56,7 +56,7 @@ static int32_t *threads_indexes = NULL;
  * been handed off to an operation thread.
  */
 static void add_work_q(work_q_item *, struct Slapi_op_stack *);
-static work_q_item *get_work_q(struct Slapi_op_stack **);
+static work_q_item *get_work_q(int32_t node, struct Slapi_op_stack **);
 struct Slapi_work_q
 {
     PRStackElem stackelem; /* must be first in struct for PRStack to work */
@@ -65,15 +65,32 @@ struct Slapi_work_q
     struct Slapi_work_q *next_work_item;
 };
 
-static struct Slapi_work_q *head_work_q = NULL; /* global work queue head */
-static struct Slapi_work_q *tail_work_q = NULL; /* global work queue tail */
-static pthread_mutex_t work_q_lock;             /* protects head_conn_q and tail_conn_q */
-static pthread_cond_t work_q_cv;                /* used by operation threads to wait for work -
-                                                 * when there is a conn in the queue waiting
-                                                 * to be processed */
+/*
+ * The work queue has one list per NUMA node (a single one unless nsslapd-numa
+ * is on). A connection is queued on the list of its connection table list
+ * node and the operation threads first pick the work of their own node.
+ * A thread without local work takes the work of another node rather than
+ * staying idle, and work queued on a node without idle thread wakes up a
+ * thread of another node.
+ */
+struct Slapi_work_q_node
+{
+    struct Slapi_work_q *head; /* work queue head */
+    struct Slapi_work_q *tail; /* work queue tail */
+    pthread_cond_t cv;         /* used by the node operation threads to wait for work -
+                                * when there is a conn in the queue waiting
+                                * to be processed */
+    int32_t idle;              /* number of node operation threads waiting on cv */
+    int32_t signaled;          /* number of them already signaled but not awake yet */
+};
+static struct Slapi_work_q_node *work_q_nodes = NULL;
+static int32_t work_q_nb_nodes = 1;
+static pthread_mutex_t work_q_lock;             /* protects the work queue lists */
 static PRInt32 work_q_size;                     /* size of conn_q */
 static PRInt32 work_q_size_max;                 /* high water mark of work_q_size */
 #define WORK_Q_EMPTY (work_q_size == 0)
+/* the node has a waiting thread that no queued work has claimed yet */
+#define WORK_Q_NODE_IDLE(wqn) ((wqn)->idle > (wqn)->signaled)
 static PRStack *work_q_stack;         /* stack of work_q structs so we don't have to malloc/free every time */
 static PRInt32 work_q_stack_size;     /* size of work_q_stack */
 static PRInt32 work_q_stack_size_max; /* max size of work_q_stack */
@@ -478,11 +495,16 @@ init_op_threads()
                       "Cannot set condition attr clock.  error %d (%s)\n",
                       rc, strerror(rc));
         exit(-1);
-    } else if ((rc = pthread_cond_init(&work_q_cv, &condAttr)) != 0) {
-        slapi_log_err(SLAPI_LOG_ERR, "init_op_threads",
-                      "Cannot create new condition variable.  error %d (%s)\n",
-                      rc, strerror(rc));
-        exit(-1);
+    }
+    work_q_nb_nodes = slapd_numa_nb_nodes();
+    work_q_nodes = (struct Slapi_work_q_node *)slapi_ch_calloc(work_q_nb_nodes, sizeof(struct Slapi_work_q_node));
+    for (int32_t i = 0; i < work_q_nb_nodes; i++) {
+        if ((rc = pthread_cond_init(&work_q_nodes[i].cv, &condAttr)) != 0) {
+            slapi_log_err(SLAPI_LOG_ERR, "init_op_threads",
+                          "Cannot create new condition variable.  error %d (%s)\n",
+                          rc, strerror(rc));
+            exit(-1);
+        }
     }
     pthread_condattr_destroy(&condAttr); /* no longer needed */
 
@@ -1063,29 +1085,35 @@ connection_make_new_pb(Slapi_PBlock *pb, Connection *conn)
 }
 
 int
-connection_wait_for_new_work(Slapi_PBlock *pb, int32_t interval)
+connection_wait_for_new_work(Slapi_PBlock *pb, int32_t interval, int32_t node)
 {
     int ret = CONN_FOUND_WORK_TO_DO;
     work_q_item *wqitem = NULL;
     struct Slapi_op_stack *op_stack_obj = NULL;
+    struct Slapi_work_q_node *wqn = &work_q_nodes[node];
 
     pthread_mutex_lock(&work_q_lock);
 
     while (!op_shutdown && WORK_Q_EMPTY) {
+        wqn->idle++;
         if (interval == 0 ) {
-            pthread_cond_wait(&work_q_cv, &work_q_lock);
+            pthread_cond_wait(&wqn->cv, &work_q_lock);
         } else {
             struct timespec current_time = {0};
             clock_gettime(CLOCK_MONOTONIC, &current_time);
             current_time.tv_sec += interval;
-            pthread_cond_timedwait(&work_q_cv, &work_q_lock, &current_time);
+            pthread_cond_timedwait(&wqn->cv, &work_q_lock, &current_time);
+        }
+        wqn->idle--;
+        if (wqn->signaled > 0) {
+            wqn->signaled--;
         }
     }
 
     if (op_shutdown) {
         slapi_log_err(SLAPI_LOG_TRACE, "connection_wait_for_new_work", "shutdown\n");
         ret = CONN_SHUTDOWN;
-    } else if (NULL == (wqitem = get_work_q(&op_stack_obj))) {
+    } else if (NULL == (wqitem = get_work_q(node, &op_stack_obj))) {
         /* not sure how this can happen */
         slapi_log_err(SLAPI_LOG_TRACE, "connection_wait_for_new_work", "no work to do\n");
         ret = CONN_NOWORK;
@@ -1745,12 +1773,14 @@ connection_threadmain(void *arg)
     int maxthreads = 0;
     long bypasspollcnt = 0;
     bool is_busy = false;
+    int32_t numa_node = 0;
 
 #if defined(hpux)
     /* Arrange to ignore SIGPIPE signals. */
     SIGNAL(SIGPIPE, SIG_IGN);
 #endif
     thread_private_snmp_vars_set_idx(*snmp_vars_idx);
+    numa_node = slapd_numa_bind_worker_thread(*snmp_vars_idx - 1);
 
     while (1) {
         int is_timedout = 0;
@@ -1780,7 +1810,7 @@ connection_threadmain(void *arg)
                we should finish the op now.  Client might be thinking it's
                done sending the request and wait for the response forever.
                [blackflag 624234] */
-            ret = connection_wait_for_new_work(pb, interval);
+            ret = connection_wait_for_new_work(pb, interval, numa_node);
 
             switch (ret) {
             case CONN_NOWORK:
@@ -2249,6 +2279,8 @@ static void
 add_work_q(work_q_item *wqitem, struct Slapi_op_stack *op_stack_obj)
 {
     struct Slapi_work_q *new_work_q = NULL;
+    struct Slapi_work_q_node *wqn = NULL;
+    int32_t node = 0;
 
     slapi_log_err(SLAPI_LOG_TRACE, "add_work_q", "=>\n");
 
@@ -2256,20 +2288,35 @@ add_work_q(work_q_item *wqitem, struct Slapi_op_stack *op_stack_obj)
     new_work_q->work_item = wqitem;
     new_work_q->op_stack_obj = op_stack_obj;
     new_work_q->next_work_item = NULL;
+    if (work_q_nb_nodes > 1 && wqitem->c_ct_list >= 0) {
+        node = slapd_numa_node_of_list(wqitem->c_ct_list);
+    }
 
     pthread_mutex_lock(&work_q_lock);
-    if (tail_work_q == NULL) {
-        tail_work_q = new_work_q;
-        head_work_q = new_work_q;
+    wqn = &work_q_nodes[node];
+    if (wqn->tail == NULL) {
+        wqn->tail = new_work_q;
+        wqn->head = new_work_q;
     } else {
-        tail_work_q->next_work_item = new_work_q;
-        tail_work_q = new_work_q;
+        wqn->tail->next_work_item = new_work_q;
+        wqn->tail = new_work_q;
     }
     PR_AtomicIncrement(&work_q_size); /* increment q size */
     if (work_q_size > work_q_size_max) {
         work_q_size_max = work_q_size;
     }
-    pthread_cond_signal(&work_q_cv); /* notify waiters in connection_wait_for_new_work */
+    /* Wake up a thread of another node if all the threads of this node are busy */
+    for (int32_t i = 1; !WORK_Q_NODE_IDLE(wqn) && i < work_q_nb_nodes; i++) {
+        if (WORK_Q_NODE_IDLE(&work_q_nodes[(node + i) % work_q_nb_nodes])) {
+            wqn = &work_q_nodes[(node + i) % work_q_nb_nodes];
+        }
+    }
+    /* idle only drops once the waiter is awake: count the signal so that the
+     * next enqueue does not pick the same thread again */
+    if (WORK_Q_NODE_IDLE(wqn)) {
+        wqn->signaled++;
+    }
+    pthread_cond_signal(&wqn->cv); /* notify waiters in connection_wait_for_new_work */
     pthread_mutex_unlock(&work_q_lock);
 }
 
@@ -2278,22 +2325,32 @@ add_work_q(work_q_item *wqitem, struct Slapi_op_stack *op_stack_obj)
     with the work_q_lock held */
 
 static work_q_item *
-get_work_q(struct Slapi_op_stack **op_stack_obj)
+get_work_q(int32_t node, struct Slapi_op_stack **op_stack_obj)
 {
     struct Slapi_work_q *tmp = NULL;
+    struct Slapi_work_q_node *wqn = NULL;
     work_q_item *wqitem;
+    int32_t i;
 
     slapi_log_err(SLAPI_LOG_TRACE, "get_work_q", "=>\n");
-    if (head_work_q == NULL) {
+    /* Pick the work of our node first */
+    for (i = 0; i < work_q_nb_nodes; i++) {
+        wqn = &work_q_nodes[(node + i) % work_q_nb_nodes];
+        if (wqn->head != NULL) {
+            break;
+        }
+    }
+    if (i == work_q_nb_nodes) {
         slapi_log_err(SLAPI_LOG_TRACE, "get_work_q", "The work queue is empty.\n");
         return NULL;
     }
+    slapd_numa_op_picked(node, i != 0);
 
-    tmp = head_work_q;
-    if (head_work_q == tail_work_q) {
-        tail_work_q = NULL;
+    tmp = wqn->head;
+    if (wqn->head == wqn->tail) {
+        wqn->tail = NULL;
     }
-    head_work_q = tmp->next_work_item;
+    wqn->head = tmp->next_work_item;
 
     wqitem = tmp->work_item;
     *op_stack_obj = tmp->op_stack_obj;
@@ -2349,7 +2406,9 @@ op_thread_cleanup()
 
     PR_AtomicIncrement(&op_shutdown);
     pthread_mutex_lock(&work_q_lock);
-    pthread_cond_broadcast(&work_q_cv); /* tell any thread waiting in connection_wait_for_new_work to shutdown */
+    for (int32_t i = 0; i < work_q_nb_nodes; i++) {
+        pthread_cond_broadcast(&work_q_nodes[i].cv); /* tell any thread waiting in connection_wait_for_new_work to shutdown */
+    }
     pthread_mutex_unlock(&work_q_lock);
 }
 
@@ -160,6 +160,11 @@ connection_table_new(int table_size)
     pthread_mutexattr_init(&monitor_attr);
     pthread_mutexattr_settype(&monitor_attr, PTHREAD_MUTEX_RECURSIVE);
     for (ct_list = 0; ct_list < ct->list_num; ct_list++) {
+        /* In NUMA mode, run on the list node so its memory is allocated there (first touch) */
+        cpu_set_t oldcpus;
+        int32_t numa_bound = (slapd_numa_nb_nodes() > 1) &&
+                             (slapd_numa_bind_thread(slapd_numa_node_of_list(ct_list), &oldcpus) == 0);
+
         ct->c[ct_list] = (Connection *)slapi_ch_calloc(1, ct->list_size * sizeof(Connection));
         ct->fd[ct_list] = (struct POLL_STRUCT *)slapi_ch_calloc(1, ct->list_size * sizeof(struct POLL_STRUCT));
         /* We rely on the fact that we called calloc, which zeros the block, so we don't
@@ -221,6 +226,9 @@ connection_table_new(int table_size)
             /* Ready to rock, mark as such. */
             ct->c[ct_list][i].c_state = CONN_STATE_INIT;
         }
+        if (numa_bound) {
+            slapd_numa_restore_thread(&oldcpus);
+        }
     }
 
     /*
@@ -494,6 +502,7 @@ connection_table_move_connection_out_of_active_list(Connection_Table *ct, Connec
 
     /* Decrement the number of active connections on the ct list this connection was assigned. */
     (*(ct->num_active + c->c_ct_list))--;
+    slapd_numa_conn_removed(c->c_ct_list);
     c->c_ct_list = -1;
 
     c->c_prev->c_next = c->c_next;
@@ -552,6 +561,7 @@ connection_table_move_connection_on_to_active_list(Connection_Table *ct, Connect
     /* Get the least used ct list and incremant its number of active connections. */
     c->c_ct_list = connection_table_get_list(ct);
     (*(ct->num_active + c->c_ct_list))++;
+    slapd_numa_conn_added(c->c_ct_list);
 
     c->c_next = ct->c[c->c_ct_list][0].c_next;
     if (c->c_next != NULL) {
@@ -567,6 +577,36 @@ connection_table_move_connection_on_to_active_list(Connection_Table *ct, Connect
 #endif
 }
 
+/*
+ * In NUMA mode, find the node with the lowest number of connections then
+ * the list of that node with the lowest number of connections.
+ * (list i belongs to node i % nbnodes)
+ */
+static int
+connection_table_get_numa_list(Connection_Table *ct, int32_t nbnodes)
+{
+    int node_active[nbnodes];
+    int node = 0;
+    int list = -1;
+    size_t i;
+
+    memset(node_active, 0, sizeof(node_active));
+    for (i = 0; i < ct->list_num; i++) {
+        node_active[i % nbnodes] += ct->num_active[i];
+    }
+    for (i = 1; i < nbnodes && i < ct->list_num; i++) {
+        if (node_active[i] < node_active[node]) {
+            node = i;
+        }
+    }
+    for (i = node; i < ct->list_num; i += nbnodes) {
+        if (list < 0 || ct->num_active[i] < ct->num_active[list]) {
+            list = i;
+        }
+    }
+    return list;
+}
+
 /* Find a connection table list with the lowest number of connections. */
 int
 connection_table_get_list(Connection_Table *ct)
@@ -574,6 +614,11 @@ connection_table_get_list(Connection_Table *ct)
     size_t i;
     int list = 0;
     int lowest = ct->num_active[0];
+    int32_t nbnodes = slapd_numa_nb_nodes();
+
+    if (nbnodes > 1) {
+        return connection_table_get_numa_list(ct, nbnodes);
+    }
     for (i = 1; i < ct->list_num; i++) {
         if (*(ct->num_active + i) < lowest) {
             lowest = *(ct->num_active + i);
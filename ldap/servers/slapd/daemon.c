@@ -1183,6 +1183,8 @@ slapd_daemon(daemon_ports_t *ports)
     uint64_t threads;
     int in_referral_mode = config_check_referral_mode();
     int connection_table_size = get_connection_table_size();
+    /* The connection table lists are allocated on their NUMA node */
+    slapd_numa_init();
     the_connection_table = connection_table_new(connection_table_size);
 
     /*
@@ -1230,6 +1232,9 @@ slapd_daemon(daemon_ports_t *ports)
 
     init_ct_list_threads();
     init_op_threads();
+    if (pw_kdf_pool_init() != 0) {
+        slapi_log_err(SLAPI_LOG_ERR, "slapd_daemon", "Unable to start the password hashing threads\n");
+    }
 
     /* Start the SNMP collator if counters are enabled. */
     if (config_get_slapi_counters()) {
@@ -1521,6 +1526,7 @@ slapd_daemon(daemon_ports_t *ports)
 
     be_cleanupall();
     plugin_dependency_freeall();
+    pw_kdf_pool_destroy();
     connection_post_shutdown_cleanup();
     slapi_log_err(SLAPI_LOG_TRACE, "slapd_daemon", "slapd shutting down - backends closed down\n");
     referrals_free();
@@ -1539,6 +1545,7 @@ slapd_daemon(daemon_ports_t *ports)
     /* final cleanup for ASAN and other analyzers */
     PR_JoinThread(accept_thread_p);
     free_worker_thread_indexes();
+    slapd_numa_free();
     free_server_dataversion();
 }
 
@@ -1558,6 +1565,7 @@ ct_list_thread(uint64_t threadnum)
     char tname[16];
     snprintf(tname, sizeof(tname), "ct-list-%lu", (unsigned long)threadid);
     slapi_set_thread_name(tname);
+    slapd_numa_bind_list_thread(threadid);
 
     while (!slapi_is_shutting_down()) {
          int select_return = 0;
@@ -1127,10 +1127,11 @@ str2entry_dupcheck(const char *rawdn, const char *s, int flags, int read_statein
         goto free_and_return;
     }
 
-    /* get the read lock of name2asi for performance purpose.
-       It reduces read locking by per-entry lock, instead of per-attribute.
+    /* pin the schema snapshot for performance purpose.
+       The attribute types are looked up without locking, once per entry
+       instead of per-attribute.
     */
-    attr_syntax_read_lock();
+    attr_syntax_pin();
 
     /*
      * For each unique attribute in the array,
@@ -1190,8 +1191,8 @@ str2entry_dupcheck(const char *rawdn, const char *s, int flags, int read_statein
         }
     }
 
-    /* release read lock of name2asi, per-entry lock */
-    attr_syntax_unlock_read();
+    /* release the schema snapshot, per-entry pin */
+    attr_syntax_unpin();
 
     /* If this is a tombstone, it requires a special treatment for rdn. */
     if (e->e_flags & SLAPI_ENTRY_FLAG_TOMBSTONE) {
@@ -1816,6 +1817,811 @@ slapi_entry2str_with_options(Slapi_Entry *e, int *len, int options)
     return entry2str_internal_ext(e, len, options);
 }
 
+/*
+ * Binary entry format, used for the records of the ldbm id2entry database.
+ *
+ * The text form produced by slapi_entry2str_with_options() has to be split
+ * into lines, base64 decoded and have the state information parsed out of
+ * the attribute options every time an entry is read back from the database.
+ * The binary form holds the same content as the "rdn: ..." text form dumped
+ * with SLAPI_DUMP_STATEINFO | SLAPI_DUMP_UNIQUEID, as length prefixed fields
+ * which are copied straight into the entry:
+ *
+ *     header     "\0EB" <version>, u32 record length, u32 attribute count,
+ *                u32 rdn length, rdn
+ *     table      u32 offset of each attribute from the start of the record
+ *     attribute  u8 flags, u16 type length, type, [attribute deletion csn],
+ *                u32 present value count, u32 deleted value count, values
+ *     value      u32 length, value, u8 csn count, (u8 csn type, csn)*
+ *     csn        u32 time, u16 seqnum, u16 replica id, u16 subseqnum
+ *
+ * Integers are little endian.  A text entry never starts with a NUL byte,
+ * so both forms can live in the same database and slapi_record2entry()
+ * accepts either of them.  The attribute table lets
+ * slapi_entry_bin_get_value() pick a single attribute out of a record
+ * without decoding the rest of it.
+ *
+ * Binary records are not NUL terminated: every reader is given the size of
+ * the data read from the database and never goes past it, whatever the
+ * record length in the header says.
+ */
+#define ENTRY_BIN_VERSION 1
+#define ENTRY_BIN_HEADER_SIZE 16
+#define ENTRY_BIN_CSN_SIZE 10
+#define ENTRY_BIN_ATTR_DELETED 0x01 /* attribute is in e_deleted_attrs */
+#define ENTRY_BIN_ATTR_ADCSN 0x02   /* attribute deletion csn follows the type */
+
+typedef struct entry_bin_buf
+{
+    unsigned char *data;
+    size_t len;
+    size_t size;
+} entry_bin_buf;
+
+typedef struct entry_bin_reader
+{
+    const unsigned char *start;
+    const unsigned char *cur;
+    const unsigned char *end;
+    int err;
+} entry_bin_reader;
+
+static unsigned char *
+entry_bin_reserve(entry_bin_buf *buf, size_t len)
+{
+    unsigned char *p;
+
+    if (buf->len + len > buf->size) {
+        buf->size = (buf->size + len) * 2;
+        buf->data = (unsigned char *)slapi_ch_realloc((char *)buf->data, buf->size);
+    }
+    p = buf->data + buf->len;
+    buf->len += len;
+    return p;
+}
+
+static void
+entry_bin_set_u32(unsigned char *p, uint32_t v)
+{
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+    p[2] = (v >> 16) & 0xff;
+    p[3] = (v >> 24) & 0xff;
+}
+
+static void
+entry_bin_put_u8(entry_bin_buf *buf, uint8_t v)
+{
+    *entry_bin_reserve(buf, 1) = v;
+}
+
+static void
+entry_bin_put_u16(entry_bin_buf *buf, uint16_t v)
+{
+    unsigned char *p = entry_bin_reserve(buf, 2);
+    p[0] = v & 0xff;
+    p[1] = (v >> 8) & 0xff;
+}
+
+static void
+entry_bin_put_u32(entry_bin_buf *buf, uint32_t v)
+{
+    entry_bin_set_u32(entry_bin_reserve(buf, 4), v);
+}
+
+static void
+entry_bin_put_bytes(entry_bin_buf *buf, const void *data, size_t len)
+{
+    if (len) {
+        memcpy(entry_bin_reserve(buf, len), data, len);
+    }
+}
+
+static void
+entry_bin_put_csn(entry_bin_buf *buf, const CSN *csn)
+{
+    entry_bin_put_u32(buf, (uint32_t)csn->tstamp);
+    entry_bin_put_u16(buf, csn->seqnum);
+    entry_bin_put_u16(buf, csn->rid);
+    entry_bin_put_u16(buf, csn->subseqnum);
+}
+
+static void
+entry_bin_put_valueset(entry_bin_buf *buf, const Slapi_ValueSet *vs)
+{
+    Slapi_Value **va;
+
+    if (valueset_isempty(vs)) {
+        return;
+    }
+    va = valueset_get_valuearray(vs);
+    for (size_t i = 0; va[i]; i++) {
+        const struct berval *bvp = slapi_value_get_berval(va[i]);
+        uint8_t ncsn = 0;
+
+        entry_bin_put_u32(buf, (uint32_t)bvp->bv_len);
+        entry_bin_put_bytes(buf, bvp->bv_val, bvp->bv_len);
+        /* the csn count is patched once the csns are written */
+        entry_bin_reserve(buf, 1);
+        for (const CSNSet *n = va[i]->v_csnset; n && ncsn < UINT8_MAX; n = n->next, ncsn++) {
+            entry_bin_put_u8(buf, (uint8_t)n->type);
+            entry_bin_put_csn(buf, &n->csn);
+        }
+        buf->data[buf->len - 1 - (size_t)ncsn * (1 + ENTRY_BIN_CSN_SIZE)] = ncsn;
+    }
+}
+
+static int
+entry_bin_attr_is_dumped(const Slapi_Attr *a)
+{
+    return !is_type_protected(a->a_type);
+}
+
+static void
+entry_bin_put_attrlist(entry_bin_buf *buf, Slapi_Attr *attrlist, uint8_t flags, size_t *tableoff)
+{
+    for (Slapi_Attr *a = attrlist; a; a = a->a_next) {
+        size_t typelen;
+        uint8_t aflags = flags;
+
+        if (!entry_bin_attr_is_dumped(a)) {
+            continue;
+        }
+        if (valueset_isempty(&a->a_present_values) && valueset_isempty(&a->a_deleted_values)) {
+            /*
+             * Same as entry2str_internal_put_attrlist: keep an empty deleted
+             * value so the attribute, and its AD-csn, survive a reload.
+             */
+            valueset_add_string(a, (Slapi_ValueSet *)&a->a_deleted_values, "", CSN_TYPE_VALUE_DELETED, a->a_deletioncsn);
+        }
+        entry_bin_set_u32(buf->data + *tableoff, (uint32_t)buf->len);
+        *tableoff += 4;
+
+        if (a->a_deletioncsn) {
+            aflags |= ENTRY_BIN_ATTR_ADCSN;
+        }
+        typelen = strlen(a->a_type);
+        entry_bin_put_u8(buf, aflags);
+        entry_bin_put_u16(buf, (uint16_t)typelen);
+        entry_bin_put_bytes(buf, a->a_type, typelen);
+        if (a->a_deletioncsn) {
+            entry_bin_put_csn(buf, a->a_deletioncsn);
+        }
+        entry_bin_put_u32(buf, (uint32_t)slapi_valueset_count(&a->a_present_values));
+        entry_bin_put_u32(buf, (uint32_t)slapi_valueset_count(&a->a_deleted_values));
+        entry_bin_put_valueset(buf, &a->a_present_values);
+        entry_bin_put_valueset(buf, &a->a_deleted_values);
+    }
+}
+
+/*
+ * Convert an entry to the binary format described above, including the
+ * state information and the uniqueid.  The returned record is malloc'd and
+ * its size is stored in len.
+ */
+char *
+slapi_entry2bin(Slapi_Entry *e, int *len)
+{
+    entry_bin_buf buf = {0};
+    const char *rdn;
+    size_t rdnlen = 0;
+    size_t tableoff;
+    uint32_t nattrs = 0;
+
+    if (NULL == slapi_entry_get_rdn_const(e) &&
+        NULL != slapi_entry_get_dn_const(e)) {
+        /* e_srdn is not filled in, use e_sdn */
+        slapi_rdn_init_all_sdn(&e->e_srdn, slapi_entry_get_sdn_const(e));
+    }
+    rdn = slapi_entry_get_rdn_const(e);
+    if (rdn) {
+        rdnlen = strlen(rdn);
+    }
+    for (Slapi_Attr *a = e->e_attrs; a; a = a->a_next) {
+        nattrs += entry_bin_attr_is_dumped(a);
+    }
+    for (Slapi_Attr *a = e->e_deleted_attrs; a; a = a->a_next) {
+        nattrs += entry_bin_attr_is_dumped(a);
+    }
+
+    buf.size = slapi_entry_size(e) + ENTRY_BIN_HEADER_SIZE + rdnlen + nattrs * 4;
+    buf.data = (unsigned char *)slapi_ch_malloc(buf.size);
+
+    entry_bin_put_bytes(&buf, "\0EB", 3);
+    entry_bin_put_u8(&buf, ENTRY_BIN_VERSION);
+    entry_bin_put_u32(&buf, 0); /* record length, set below */
+    entry_bin_put_u32(&buf, nattrs);
+    entry_bin_put_u32(&buf, (uint32_t)rdnlen);
+    entry_bin_put_bytes(&buf, rdn, rdnlen);
+    tableoff = buf.len;
+    entry_bin_reserve(&buf, nattrs * 4);
+
+    entry_bin_put_attrlist(&buf, e->e_attrs, 0, &tableoff);
+    entry_bin_put_attrlist(&buf, e->e_deleted_attrs, ENTRY_BIN_ATTR_DELETED, &tableoff);
+
+    entry_bin_set_u32(buf.data + 4, (uint32_t)buf.len);
+    if (len) {
+        *len = (int)buf.len;
+    }
+    return (char *)buf.data;
+}
+
+/*
+ * Returns non-zero if the size bytes at s hold an entry in the binary format.
+ */
+int
+slapi_entry_is_bin(const char *s, size_t size)
+{
+    return s && size >= 3 && s[0] == '\0' && s[1] == 'E' && s[2] == 'B';
+}
+
+/*
+ * The reads are bounded by size, the amount of data actually available.
+ * A record length in the header larger than that means the record is
+ * truncated or corrupted.
+ */
+static void
+entry_bin_reader_init(entry_bin_reader *r, const char *s, size_t size)
+{
+    const unsigned char *p = (const unsigned char *)s;
+    uint32_t reclen;
+
+    r->start = r->cur = p;
+    r->end = p;
+    if (size < ENTRY_BIN_HEADER_SIZE) {
+        r->err = 1;
+        return;
+    }
+    reclen = p[4] | (p[5] << 8) | (p[6] << 16) | ((uint32_t)p[7] << 24);
+    r->err = (p[3] != ENTRY_BIN_VERSION || reclen < ENTRY_BIN_HEADER_SIZE || reclen > size);
+    if (!r->err) {
+        r->end = p + reclen;
+    }
+}
+
+static const unsigned char *
+entry_bin_get_bytes(entry_bin_reader *r, size_t len)
+{
+    const unsigned char *p = r->cur;
+
+    if (r->err || (size_t)(r->end - r->cur) < len) {
+        r->err = 1;
+        return NULL;
+    }
+    r->cur += len;
+    return p;
+}
+
+static uint8_t
+entry_bin_get_u8(entry_bin_reader *r)
+{
+    const unsigned char *p = entry_bin_get_bytes(r, 1);
+    return p ? p[0] : 0;
+}
+
+static uint16_t
+entry_bin_get_u16(entry_bin_reader *r)
+{
+    const unsigned char *p = entry_bin_get_bytes(r, 2);
+    return p ? (uint16_t)(p[0] | (p[1] << 8)) : 0;
+}
+
+static uint32_t
+entry_bin_get_u32(entry_bin_reader *r)
+{
+    const unsigned char *p = entry_bin_get_bytes(r, 4);
+    return p ? (uint32_t)(p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24)) : 0;
+}
+
+static void
+entry_bin_get_csn(entry_bin_reader *r, CSN *csn)
+{
+    csn->tstamp = (time_t)entry_bin_get_u32(r);
+    csn->seqnum = entry_bin_get_u16(r);
+    csn->rid = entry_bin_get_u16(r);
+    csn->subseqnum = entry_bin_get_u16(r);
+}
+
+static void
+entry_bin_seek(entry_bin_reader *r, uint32_t offset)
+{
+    if (r->err || offset > (size_t)(r->end - r->start)) {
+        r->err = 1;
+        return;
+    }
+    r->cur = r->start + offset;
+}
+
+/* skip the value and its csns */
+static void
+entry_bin_skip_value(entry_bin_reader *r)
+{
+    uint32_t len = entry_bin_get_u32(r);
+    entry_bin_get_bytes(r, len);
+    len = entry_bin_get_u8(r);
+    entry_bin_get_bytes(r, len * (1 + ENTRY_BIN_CSN_SIZE));
+}
+
+static char *
+entry_bin_strndup(const unsigned char *s, size_t len)
+{
+    char *p = (char *)slapi_ch_malloc(len + 1);
+    memcpy(p, s, len);
+    p[len] = '\0';
+    return p;
+}
+
+static void
+entry_bin_update_maxcsn(CSN **maxcsn, const CSN *csn)
+{
+    if (*maxcsn == NULL) {
+        *maxcsn = csn_dup(csn);
+    } else if (csn_compare(*maxcsn, csn) < 0) {
+        csn_init_by_csn(*maxcsn, csn);
+    }
+}
+
+/*
+ * Position the reader on the present values of type.  Returns the number of
+ * present values, or -1 if the entry has no such attribute.
+ */
+static int64_t
+entry_bin_find_attr(entry_bin_reader *r, const char *type)
+{
+    size_t typelen = strlen(type);
+    uint32_t nattrs;
+    uint32_t tableoff;
+
+    entry_bin_seek(r, 8);
+    nattrs = entry_bin_get_u32(r);
+    tableoff = ENTRY_BIN_HEADER_SIZE + entry_bin_get_u32(r);
+
+    for (uint32_t i = 0; i < nattrs && !r->err; i++) {
+        uint8_t flags;
+        const unsigned char *atype;
+        uint16_t atypelen;
+
+        entry_bin_seek(r, tableoff + i * 4);
+        entry_bin_seek(r, entry_bin_get_u32(r));
+        flags = entry_bin_get_u8(r);
+        atypelen = entry_bin_get_u16(r);
+        atype = entry_bin_get_bytes(r, atypelen);
+        if (r->err || (flags & ENTRY_BIN_ATTR_DELETED) ||
+            atypelen != typelen || PL_strncasecmp((const char *)atype, type, typelen)) {
+            continue;
+        }
+        if (flags & ENTRY_BIN_ATTR_ADCSN) {
+            entry_bin_get_bytes(r, ENTRY_BIN_CSN_SIZE);
+        }
+        int64_t npresent = entry_bin_get_u32(r);
+        entry_bin_get_u32(r); /* deleted values */
+        return r->err ? -1 : npresent;
+    }
+    return -1;
+}
+
+/*
+ * Binary format counterpart of get_value_from_string() and
+ * get_values_from_string(): returns 0 and the malloc'd, NUL terminated
+ * present values of type, "rdn" being the rdn of the entry.  At most
+ * maxvals values are returned, 0 meaning all of them.  size is the size
+ * of the record.
+ */
+int
+slapi_entry_bin_get_values(const char *s, size_t size, const char *type, char ***valuearray, size_t maxvals)
+{
+    entry_bin_reader r;
+    int64_t nvals;
+
+    *valuearray = NULL;
+    entry_bin_reader_init(&r, s, size);
+    if (PL_strcasecmp(type, SLAPI_ATTR_RDN) == 0) {
+        uint32_t rdnlen;
+        const unsigned char *rdn;
+
+        entry_bin_seek(&r, 12);
+        rdnlen = entry_bin_get_u32(&r);
+        rdn = entry_bin_get_bytes(&r, rdnlen);
+        if (r.err || rdnlen == 0) {
+            return -1;
+        }
+        *valuearray = (char **)slapi_ch_calloc(2, sizeof(char *));
+        (*valuearray)[0] = entry_bin_strndup(rdn, rdnlen);
+        return 0;
+    }
+
+    nvals = entry_bin_find_attr(&r, type);
+    if (nvals <= 0) {
+        return -1;
+    }
+    if (maxvals && (size_t)nvals > maxvals) {
+        nvals = maxvals;
+    }
+    *valuearray = (char **)slapi_ch_calloc(nvals + 1, sizeof(char *));
+    for (int64_t i = 0; i < nvals; i++) {
+        uint32_t len = entry_bin_get_u32(&r);
+        const unsigned char *val = entry_bin_get_bytes(&r, len);
+        uint8_t ncsn = entry_bin_get_u8(&r);
+
+        entry_bin_get_bytes(&r, ncsn * (1 + ENTRY_BIN_CSN_SIZE));
+        if (r.err) {
+            slapi_ch_array_free(*valuearray);
+            *valuearray = NULL;
+            return -1;
+        }
+        (*valuearray)[i] = entry_bin_strndup(val, len);
+    }
+    return 0;
+}
+
+int
+slapi_entry_bin_get_value(const char *s, size_t size, const char *type, char **value)
+{
+    char **vals = NULL;
+
+    *value = NULL;
+    if (slapi_entry_bin_get_values(s, size, type, &vals, 1)) {
+        return -1;
+    }
+    *value = vals[0];
+    slapi_ch_free((void **)&vals);
+    return 0;
+}
+
+/* Append the "type: value" line of a value to the text form being built */
+static void
+entry_bin_put_line(entry_bin_buf *buf, const char *type, const unsigned char *val, uint32_t vlen)
+{
+    size_t needed = LDIF_SIZE_NEEDED(strlen(type), vlen) + 1;
+    char *start = (char *)entry_bin_reserve(buf, needed);
+    char *p = start;
+
+    slapi_ldif_put_type_and_value_with_options(&p, type, (const char *)val, (int)vlen, LDIF_OPT_NOWRAP);
+    *p = '\0';
+    buf->len -= needed - (p - start);
+}
+
+/* Append the ";<type>csn-<csn>" option of the next csn to opts */
+static char *
+entry_bin_put_csn_option(entry_bin_reader *r, CSNType type, char *opts)
+{
+    CSN csn = {0};
+
+    entry_bin_get_csn(r, &csn);
+    switch (type) {
+    case CSN_TYPE_UNKNOWN:
+    case CSN_TYPE_NONE:
+    case CSN_TYPE_ATTRIBUTE_DELETED:
+    case CSN_TYPE_VALUE_UPDATED:
+    case CSN_TYPE_VALUE_DELETED:
+    case CSN_TYPE_VALUE_DISTINGUISHED:
+        csn_as_attr_option_string(type, &csn, opts);
+        return opts + strlen(opts);
+    default:
+        r->err = 1;
+        *opts = '\0';
+        return opts;
+    }
+}
+
+/*
+ * Return the text form of a binary record, as slapi_entry2str_with_options()
+ * would dump it with SLAPI_DUMP_STATEINFO | SLAPI_DUMP_NOWRAP but without
+ * building the entry, so that the tools can display a record without any
+ * server configuration.  *len is set to the length of the text.  Returns
+ * NULL if the record is truncated or corrupted.
+ */
+char *
+slapi_entry_bin_to_str(const char *s, size_t size, size_t *len)
+{
+    entry_bin_reader r;
+    entry_bin_buf buf = {0};
+    uint32_t nattrs, rdnlen;
+    const unsigned char *rdn;
+    char *type = NULL;
+
+    entry_bin_reader_init(&r, s, size);
+    entry_bin_seek(&r, 8);
+    nattrs = entry_bin_get_u32(&r);
+    rdnlen = entry_bin_get_u32(&r);
+    rdn = entry_bin_get_bytes(&r, rdnlen);
+    if (rdn && rdnlen) {
+        entry_bin_put_line(&buf, SLAPI_ATTR_RDN, rdn, rdnlen);
+    }
+    entry_bin_get_bytes(&r, (size_t)nattrs * 4); /* attribute table */
+
+    for (uint32_t i = 0; i < nattrs && !r.err; i++) {
+        uint8_t aflags = entry_bin_get_u8(&r);
+        uint16_t typelen = entry_bin_get_u16(&r);
+        const unsigned char *atype = entry_bin_get_bytes(&r, typelen);
+        char adcsn[1 + LDIF_CSNPREFIX_MAXLENGTH + CSN_STRSIZE] = "";
+        uint32_t nvals[2];
+
+        if (r.err) {
+            break;
+        }
+        if (aflags & ENTRY_BIN_ATTR_ADCSN) {
+            entry_bin_put_csn_option(&r, CSN_TYPE_ATTRIBUTE_DELETED, adcsn);
+        }
+        nvals[0] = entry_bin_get_u32(&r);
+        nvals[1] = entry_bin_get_u32(&r);
+        for (size_t state = 0; state < 2; state++) {
+            for (uint32_t j = 0; j < nvals[state] && !r.err; j++) {
+                uint32_t vlen = entry_bin_get_u32(&r);
+                const unsigned char *val = entry_bin_get_bytes(&r, vlen);
+                uint8_t ncsn = entry_bin_get_u8(&r);
+                char *opts;
+
+                if (r.err) {
+                    break;
+                }
+                /* type, the attribute deletion csn on the first value, value csns, states */
+                type = slapi_ch_realloc(type, typelen + sizeof(adcsn) * (1 + (size_t)ncsn) +
+                                                  DELETED_ATTR_STRSIZE + DELETED_VALUE_STRSIZE + 1);
+                memcpy(type, atype, typelen);
+                opts = type + typelen;
+                if (j == 0 && (state == 0 || nvals[0] == 0)) {
+                    opts += sprintf(opts, "%s", adcsn);
+                }
+                for (uint8_t k = 0; k < ncsn && !r.err; k++) {
+                    opts = entry_bin_put_csn_option(&r, entry_bin_get_u8(&r), opts);
+                }
+                sprintf(opts, "%s%s", (aflags & ENTRY_BIN_ATTR_DELETED) ? DELETED_ATTR_STRING : "",
+                        state ? DELETED_VALUE_STRING : "");
+                if (!r.err) {
+                    entry_bin_put_line(&buf, type, val, vlen);
+                }
+            }
+        }
+    }
+    slapi_ch_free_string(&type);
+    if (r.err) {
+        slapi_ch_free((void **)&buf.data);
+        return NULL;
+    }
+    *entry_bin_reserve(&buf, 1) = '\0';
+    *len = buf.len - 1;
+    return (char *)buf.data;
+}
+
+/* normdn is not consumed.  Caller needs to free it. */
+static Slapi_Entry *
+bin2entry(const char *normdn, const Slapi_RDN *srdn, const char *s, size_t size, int flags, int read_stateinfo)
+{
+    Slapi_Entry *e;
+    entry_bin_reader r;
+    uint32_t nattrs;
+    uint32_t tableoff;
+    CSN *maxcsn = NULL;
+    char *dn = NULL;
+
+    slapi_log_err(SLAPI_LOG_TRACE, "bin2entry", "==>\n");
+
+    if (NULL == normdn) {
+        /* like an "rdn: ..." text entry without the dn */
+        if (!(SLAPI_STR2ENTRY_INCLUDE_VERSION_STR & flags)) {
+            slapi_log_err(SLAPI_LOG_ERR, "bin2entry", "entry has no dn\n");
+        }
+        return NULL;
+    }
+
+    entry_bin_reader_init(&r, s, size);
+    entry_bin_seek(&r, 8);
+    nattrs = entry_bin_get_u32(&r);
+    tableoff = ENTRY_BIN_HEADER_SIZE + entry_bin_get_u32(&r);
+    if (r.err) {
+        slapi_log_err(SLAPI_LOG_ERR, "bin2entry", "Invalid entry header\n");
+        return NULL;
+    }
+
+    e = slapi_entry_alloc();
+    slapi_entry_init(e, NULL, NULL);
+
+    if (flags & SLAPI_STR2ENTRY_USE_OBSOLETE_DNFORMAT) {
+        dn = slapi_dn_normalize_original(slapi_ch_strdup(normdn));
+    } else if (flags & SLAPI_STR2ENTRY_DN_NORMALIZED) {
+        dn = slapi_ch_strdup(normdn);
+    } else {
+        dn = slapi_create_dn_string("%s", normdn);
+        if (NULL == dn) {
+            slapi_log_err(SLAPI_LOG_TRACE, "bin2entry", "Invalid DN: %s\n", normdn);
+            slapi_entry_free(e);
+            return NULL;
+        }
+    }
+    /* dn is consumed in e */
+    slapi_entry_set_normdn(e, dn);
+    if (srdn) {
+        /* we can use the rdn generated in entryrdn_lookup_dn */
+        slapi_entry_set_srdn(e, srdn);
+    } else {
+        slapi_entry_set_rdn(e, dn);
+    }
+
+    for (uint32_t i = 0; i < nattrs && !r.err; i++) {
+        uint8_t aflags;
+        uint16_t typelen;
+        const unsigned char *typep;
+        char *type;
+        uint32_t nvals[2];
+        CSN adcsn;
+        int has_adcsn;
+        int is_objectclass;
+        Slapi_Attr **a = NULL;
+
+        entry_bin_seek(&r, tableoff + i * 4);
+        entry_bin_seek(&r, entry_bin_get_u32(&r));
+        aflags = entry_bin_get_u8(&r);
+        typelen = entry_bin_get_u16(&r);
+        typep = entry_bin_get_bytes(&r, typelen);
+        has_adcsn = aflags & ENTRY_BIN_ATTR_ADCSN;
+        if (has_adcsn) {
+            entry_bin_get_csn(&r, &adcsn);
+        }
+        nvals[0] = entry_bin_get_u32(&r);
+        nvals[1] = entry_bin_get_u32(&r);
+        if (r.err) {
+            break;
+        }
+        if (!read_stateinfo && (aflags & ENTRY_BIN_ATTR_DELETED)) {
+            /* ignore deleted attributes */
+            continue;
+        }
+        type = entry_bin_strndup(typep, typelen);
+
+        if ((flags & SLAPI_STR2ENTRY_NO_ENTRYDN) && PL_strcasecmp(type, SLAPI_ATTR_ENTRYDN) == 0) {
+            slapi_ch_free_string(&type);
+            continue;
+        }
+        if (PL_strcasecmp(type, SLAPI_ATTR_UNIQUEID) == 0) {
+            /* only the value is kept, slapi_entry_set_uniqueid adds the attribute */
+            if (nvals[0] && e->e_uniqueid == NULL) {
+                uint32_t len = entry_bin_get_u32(&r);
+                const unsigned char *val = entry_bin_get_bytes(&r, len);
+                if (val) {
+                    slapi_entry_set_uniqueid(e, entry_bin_strndup(val, len));
+                }
+            }
+            slapi_ch_free_string(&type);
+            continue;
+        }
+        is_objectclass = (PL_strcasecmp(type, SLAPI_ATTR_OBJECTCLASS) == 0);
+
+        for (size_t state = 0; state < 2 && !r.err; state++) {
+            for (uint32_t j = 0; j < nvals[state] && !r.err; j++) {
+                Slapi_Value *svalue;
+                uint32_t len;
+                const unsigned char *val;
+                uint8_t ncsn;
+
+                if (state && !read_stateinfo) {
+                    /* ignore deleted values */
+                    entry_bin_skip_value(&r);
+                    continue;
+                }
+                len = entry_bin_get_u32(&r);
+                val = entry_bin_get_bytes(&r, len);
+                ncsn = entry_bin_get_u8(&r);
+                if (r.err) {
+                    break;
+                }
+                if (a == NULL) {
+                    Slapi_Attr **alist = (aflags & ENTRY_BIN_ATTR_DELETED) ? &e->e_deleted_attrs : &e->e_attrs;
+                    if (attrlist_append_nosyntax_init(alist, type, &a) == 0 /* Found */) {
+                        slapi_log_err(SLAPI_LOG_ERR, "bin2entry",
+                                      "Duplicate attribute %s\n", type);
+                        r.err = 1;
+                        break;
+                    }
+                }
+                if (state == 0 && is_objectclass) {
+                    if (len == SLAPI_ATTR_VALUE_SUBENTRY_LENGTH &&
+                        PL_strncasecmp((const char *)val, SLAPI_ATTR_VALUE_SUBENTRY, len) == 0) {
+                        e->e_flags |= SLAPI_ENTRY_FLAG_LDAPSUBENTRY;
+                    }
+                    if (len == SLAPI_ATTR_VALUE_TOMBSTONE_LENGTH &&
+                        PL_strncasecmp((const char *)val, SLAPI_ATTR_VALUE_TOMBSTONE, len) == 0) {
+                        e->e_flags |= SLAPI_ENTRY_FLAG_TOMBSTONE;
+                    }
+                }
+
+                svalue = value_new(NULL, CSN_TYPE_NONE, NULL);
+                slapi_value_set(svalue, (void *)val, len);
+                for (uint8_t k = 0; k < ncsn && !r.err; k++) {
+                    CSNType t = (CSNType)entry_bin_get_u8(&r);
+                    CSN csn;
+
+                    entry_bin_get_csn(&r, &csn);
+                    if (r.err || !read_stateinfo) {
+                        continue;
+                    }
+                    csnset_add_csn(&svalue->v_csnset, t, &csn);
+                    entry_bin_update_maxcsn(&maxcsn, &csn);
+                    if (t == CSN_TYPE_VALUE_DISTINGUISHED) {
+                        entry_add_dncsn_ext(e, &csn, ENTRY_DNCSN_INCREASING);
+                    }
+                }
+                /* consumes the value */
+                slapi_valueset_add_attr_value_ext(*a,
+                                                  state ? &(*a)->a_deleted_values : &(*a)->a_present_values,
+                                                  svalue, SLAPI_VALUE_FLAG_PASSIN);
+            }
+        }
+        if (a && has_adcsn && read_stateinfo) {
+            attr_set_deletion_csn(*a, &adcsn);
+            entry_bin_update_maxcsn(&maxcsn, &adcsn);
+        }
+        slapi_ch_free_string(&type);
+    }
+
+    if (r.err) {
+        slapi_log_err(SLAPI_LOG_ERR, "bin2entry", "Truncated or corrupted entry %s\n",
+                      slapi_entry_get_dn_const(e));
+        slapi_entry_free(e);
+        e = NULL;
+        goto done;
+    }
+    if (read_stateinfo && maxcsn) {
+        e->e_maxcsn = maxcsn;
+        maxcsn = NULL;
+    }
+
+    /* If this is a tombstone, it requires a special treatment for rdn. */
+    if (e->e_flags & SLAPI_ENTRY_FLAG_TOMBSTONE) {
+        if (_entry_set_tombstone_rdn(e, slapi_entry_get_dn_const(e))) {
+            slapi_log_err(SLAPI_LOG_TRACE, "bin2entry",
+                          "tombstone entry has badly formatted dn: %s\n",
+                          slapi_entry_get_dn_const(e));
+            slapi_entry_free(e);
+            e = NULL;
+        }
+    }
+
+done:
+    csn_free(&maxcsn);
+    slapi_log_err(SLAPI_LOG_TRACE, "bin2entry", "<== 0x%p\n", e);
+    return e;
+}
+
+/*
+ * Same as slapi_str2entry_ext() for a record read from id2entry, which may
+ * be in the text or the binary format.  size is the size of the record,
+ * normdn may be NULL if the record holds the dn.
+ */
+Slapi_Entry *
+slapi_record2entry(const char *normdn, const Slapi_RDN *srdn, char *s, size_t size, int flags)
+{
+    Slapi_Entry *e;
+    int read_stateinfo = ~(flags & SLAPI_STR2ENTRY_IGNORE_STATE);
+
+    if (!slapi_entry_is_bin(s, size)) {
+        return slapi_str2entry_ext(normdn, srdn, s, flags);
+    }
+
+    e = bin2entry(normdn, srdn, s, size,
+                  normdn ? flags | SLAPI_STR2ENTRY_DN_NORMALIZED : flags, read_stateinfo);
+    if (!e)
+        return e; /* e == NULL */
+
+    if (flags & SLAPI_STR2ENTRY_EXPAND_OBJECTCLASSES) {
+        if (flags & SLAPI_STR2ENTRY_NO_SCHEMA_LOCK) {
+            schema_expand_objectclasses_nolock(e);
+        } else {
+            slapi_schema_expand_objectclasses(e);
+        }
+    }
+
+    if (flags & SLAPI_STR2ENTRY_TOMBSTONE_CHECK) {
+        /*
+         * Check if the entry is a tombstone.
+         */
+        if (slapi_entry_attr_hasvalue(e, SLAPI_ATTR_OBJECTCLASS, SLAPI_ATTR_VALUE_TOMBSTONE)) {
+            e->e_flags |= SLAPI_ENTRY_FLAG_TOMBSTONE;
+        }
+    }
+    return e;
+}
+
 static int entry_type = -1; /* The type number assigned by the Factory for 'Entry' */
 
 int
@@ -2285,6 +3091,12 @@ slapi_entrycache_vattrcache_watermark_invalidate()
     }
 }
 
+int32_t
+slapi_entrycache_vattrcache_watermark_get()
+{
+    return slapi_atomic_load_32(&g_virtual_watermark, __ATOMIC_ACQUIRE);
+}
+
 /* The following functions control the virtual attribute cache
  * stored in each entry (e_virtual_attrs). Access to that cache
  * requires holding a lock (e_virtual_lock)
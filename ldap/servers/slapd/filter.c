@@ -771,6 +771,7 @@ slapi_filter_free(struct slapi_filter *f, int recurse)
         slapi_ch_free((void **)&f->f_sub_initial);
         charray_free(f->f_sub_any);
         slapi_ch_free((void **)&f->f_sub_final);
+        substr_match_free((Slapi_Substr **)&f->f_sub.sf_private);
         break;
 
     case LDAP_FILTER_PRESENT:
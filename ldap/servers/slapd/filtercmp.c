@@ -67,6 +67,7 @@ get_normalized_value(const Slapi_Attr *sattr, struct ava *ava)
     sv.bv = ava->ava_value;
     sv.v_csnset = NULL;
     sv.v_flags = 0;
+    sv.v_norm = NULL;
     svlist[0] = &sv;
     svlist[1] = NULL;
     if ((slapi_attr_values2keys_sv(sattr, svlist, &keylist,
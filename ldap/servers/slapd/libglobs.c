@@ -253,6 +253,7 @@ slapi_onoff_t init_ndn_cache_enabled;
 slapi_onoff_t init_sasl_mapping_fallback;
 slapi_onoff_t init_return_orig_type;
 slapi_onoff_t init_enable_turbo_mode;
+slapi_onoff_t init_numa;
 slapi_onoff_t init_connection_nocanon;
 slapi_onoff_t init_plugin_logging;
 slapi_int_t init_connection_buffer;
@@ -1198,6 +1199,22 @@ static struct config_get_and_set
      NULL, 0,
      (void **)&global_slapdFrontendConfig.ndn_cache_max_size,
      CONFIG_INT, (ConfigGetFunc)config_get_ndn_cache_size, SLAPD_DEFAULT_NDN_SIZE_STR, NULL},
+    {CONFIG_PW_BIND_CACHE_SIZE, config_set_pw_bind_cache_size,
+     NULL, 0,
+     (void **)&global_slapdFrontendConfig.pw_bind_cache_size,
+     CONFIG_INT, (ConfigGetFunc)config_get_pw_bind_cache_size, SLAPD_DEFAULT_PW_BIND_CACHE_SIZE_STR, NULL},
+    {CONFIG_PW_BIND_CACHE_TTL, config_set_pw_bind_cache_ttl,
+     NULL, 0,
+     (void **)&global_slapdFrontendConfig.pw_bind_cache_ttl,
+     CONFIG_INT, (ConfigGetFunc)config_get_pw_bind_cache_ttl, SLAPD_DEFAULT_PW_BIND_CACHE_TTL_STR, NULL},
+    {CONFIG_PW_KDF_THREADS, config_set_pw_kdf_threads,
+     NULL, 0,
+     (void **)&global_slapdFrontendConfig.pw_kdf_threads,
+     CONFIG_INT, (ConfigGetFunc)config_get_pw_kdf_threads, SLAPD_DEFAULT_PW_KDF_THREADS_STR, NULL},
+    {CONFIG_PW_KDF_QUEUE_DEPTH, config_set_pw_kdf_queue_depth,
+     NULL, 0,
+     (void **)&global_slapdFrontendConfig.pw_kdf_queue_depth,
+     CONFIG_INT, (ConfigGetFunc)config_get_pw_kdf_queue_depth, SLAPD_DEFAULT_PW_KDF_QUEUE_DEPTH_STR, NULL},
     /* The issue here is that we probably need "empty string" to be valid, rather than NULL for reset purposes */
     {CONFIG_ALLOWED_SASL_MECHS, config_set_allowed_sasl_mechs,
      NULL, 0,
@@ -1226,6 +1243,10 @@ static struct config_get_and_set
      NULL, 0,
      (void **)&global_slapdFrontendConfig.enable_turbo_mode,
      CONFIG_ON_OFF, (ConfigGetFunc)config_get_enable_turbo_mode, &init_enable_turbo_mode, NULL},
+    {CONFIG_NUMA, config_set_numa,
+     NULL, 0,
+     (void **)&global_slapdFrontendConfig.numa,
+     CONFIG_ON_OFF, (ConfigGetFunc)config_get_numa, &init_numa, NULL},
     {CONFIG_CONNECTION_BUFFER, config_set_connection_buffer,
      NULL, 0,
      (void **)&global_slapdFrontendConfig.connection_buffer,
@@ -2026,12 +2047,17 @@ FrontendConfig_init(void)
     init_disk_logging_critical = cfg->disk_logging_critical = LDAP_OFF;
     init_ndn_cache_enabled = cfg->ndn_cache_enabled = LDAP_ON;
     cfg->ndn_cache_max_size = SLAPD_DEFAULT_NDN_SIZE;
+    cfg->pw_bind_cache_size = SLAPD_DEFAULT_PW_BIND_CACHE_SIZE;
+    cfg->pw_bind_cache_ttl = SLAPD_DEFAULT_PW_BIND_CACHE_TTL;
+    cfg->pw_kdf_threads = SLAPD_DEFAULT_PW_KDF_THREADS;
+    cfg->pw_kdf_queue_depth = SLAPD_DEFAULT_PW_KDF_QUEUE_DEPTH;
     init_sasl_mapping_fallback = cfg->sasl_mapping_fallback = LDAP_OFF;
     init_ignore_vattrs = cfg->ignore_vattrs = LDAP_ON;
     cfg->sasl_max_bufsize = SLAPD_DEFAULT_SASL_MAXBUFSIZE;
     cfg->unhashed_pw_switch = SLAPD_DEFAULT_UNHASHED_PW_SWITCH;
     init_return_orig_type = cfg->return_orig_type = LDAP_OFF;
     init_enable_turbo_mode = cfg->enable_turbo_mode = LDAP_ON;
+    init_numa = cfg->numa = LDAP_OFF;
     init_connection_buffer = cfg->connection_buffer = CONNECTION_BUFFER_ON;
     init_connection_nocanon = cfg->connection_nocanon = LDAP_ON;
     init_plugin_logging = cfg->plugin_logging = LDAP_OFF;
@@ -2636,6 +2662,88 @@ config_set_ndn_cache_max_size(const char *attrname, char *value, char *errorbuf,
     return retVal;
 }
 
+int
+config_set_pw_bind_cache_size(const char *attrname, char *value, char *errorbuf, int apply)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    char *endp;
+    long size;
+
+    errno = 0;
+    size = strtol(value, &endp, 10);
+    if (*endp != '\0' || errno == ERANGE || size < 0 || size > INT32_MAX) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE, "(%s) value (%s) is invalid\n", attrname, value);
+        return LDAP_OPERATIONS_ERROR;
+    }
+    if (apply) {
+        slapi_atomic_store_32(&(slapdFrontendConfig->pw_bind_cache_size), (int32_t)size, __ATOMIC_RELEASE);
+    }
+
+    return LDAP_SUCCESS;
+}
+
+int
+config_set_pw_bind_cache_ttl(const char *attrname, char *value, char *errorbuf, int apply)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    char *endp;
+    long ttl;
+
+    errno = 0;
+    ttl = strtol(value, &endp, 10);
+    if (*endp != '\0' || errno == ERANGE || ttl < 0 || ttl > INT32_MAX) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE, "(%s) value (%s) is invalid\n", attrname, value);
+        return LDAP_OPERATIONS_ERROR;
+    }
+    if (apply) {
+        slapi_atomic_store_32(&(slapdFrontendConfig->pw_bind_cache_ttl), (int32_t)ttl, __ATOMIC_RELEASE);
+    }
+
+    return LDAP_SUCCESS;
+}
+
+int
+config_set_pw_kdf_threads(const char *attrname, char *value, char *errorbuf, int apply)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    char *endp;
+    long threads;
+
+    errno = 0;
+    threads = strtol(value, &endp, 10);
+    if (*endp != '\0' || errno == ERANGE || threads < 0 || threads > MAX_THREADS) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE,
+                              "(%s) value (%s) is invalid, must be between 0 and %d\n",
+                              attrname, value, MAX_THREADS);
+        return LDAP_OPERATIONS_ERROR;
+    }
+    if (apply) {
+        slapi_atomic_store_32(&(slapdFrontendConfig->pw_kdf_threads), (int32_t)threads, __ATOMIC_RELEASE);
+    }
+
+    return LDAP_SUCCESS;
+}
+
+int
+config_set_pw_kdf_queue_depth(const char *attrname, char *value, char *errorbuf, int apply)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    char *endp;
+    long depth;
+
+    errno = 0;
+    depth = strtol(value, &endp, 10);
+    if (*endp != '\0' || errno == ERANGE || depth < 1 || depth > INT32_MAX) {
+        slapi_create_errormsg(errorbuf, SLAPI_DSE_RETURNTEXT_SIZE, "(%s) value (%s) is invalid\n", attrname, value);
+        return LDAP_OPERATIONS_ERROR;
+    }
+    if (apply) {
+        slapi_atomic_store_32(&(slapdFrontendConfig->pw_kdf_queue_depth), (int32_t)depth, __ATOMIC_RELEASE);
+    }
+
+    return LDAP_SUCCESS;
+}
+
 int
 config_set_sasl_maxbufsize(const char *attrname, char *value, char *errorbuf, int apply)
 {
@@ -7880,6 +7988,34 @@ config_get_ndn_cache_size()
     return slapi_atomic_load_64(&(slapdFrontendConfig->ndn_cache_max_size), __ATOMIC_ACQUIRE);
 }
 
+int32_t
+config_get_pw_bind_cache_size()
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    return slapi_atomic_load_32(&(slapdFrontendConfig->pw_bind_cache_size), __ATOMIC_ACQUIRE);
+}
+
+int32_t
+config_get_pw_bind_cache_ttl()
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    return slapi_atomic_load_32(&(slapdFrontendConfig->pw_bind_cache_ttl), __ATOMIC_ACQUIRE);
+}
+
+int32_t
+config_get_pw_kdf_threads()
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    return slapi_atomic_load_32(&(slapdFrontendConfig->pw_kdf_threads), __ATOMIC_ACQUIRE);
+}
+
+int32_t
+config_get_pw_kdf_queue_depth()
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    return slapi_atomic_load_32(&(slapdFrontendConfig->pw_kdf_queue_depth), __ATOMIC_ACQUIRE);
+}
+
 int32_t
 config_get_ndn_cache_enabled()
 {
@@ -8930,6 +9066,13 @@ config_get_enable_turbo_mode(void)
     return slapi_atomic_load_32(&(slapdFrontendConfig->enable_turbo_mode), __ATOMIC_ACQUIRE);
 }
 
+int32_t
+config_get_numa(void)
+{
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+    return slapi_atomic_load_32(&(slapdFrontendConfig->numa), __ATOMIC_ACQUIRE);
+}
+
 int32_t
 config_get_connection_nocanon(void)
 {
@@ -8983,6 +9126,19 @@ config_set_enable_turbo_mode(const char *attrname, char *value, char *errorbuf,
     return retVal;
 }
 
+int32_t
+config_set_numa(const char *attrname, char *value, char *errorbuf, int apply)
+{
+    int32_t retVal = LDAP_SUCCESS;
+    slapdFrontendConfig_t *slapdFrontendConfig = getFrontendConfig();
+
+    /* Only read at startup, the change requires a restart */
+    retVal = config_set_onoff(attrname, value,
+                              &(slapdFrontendConfig->numa),
+                              errorbuf, apply);
+    return retVal;
+}
+
 int32_t
 config_set_connection_nocanon(const char *attrname, char *value, char *errorbuf, int apply)
 {
@@ -9640,6 +9796,12 @@ config_set(const char *attr, struct berval **values, char *errorbuf, int apply)
         break;
     }
 
+    if (apply && retval == LDAP_SUCCESS &&
+        (PL_strncasecmp(attr, "password", 8) == 0 || PL_strncasecmp(attr, "nsslapd-pwpolicy", 16) == 0)) {
+        /* The global password policy changed, previously verified binds must be checked again */
+        pw_bind_cache_flush();
+    }
+
     return retval;
 }
 
@@ -93,6 +93,7 @@ struct main_config
     char **db2index_attrs;
     int ldif_printkey;
     char *archive_name;
+    char *backup_base;
     int db2ldif_dump_replica;
     int db2ldif_dump_uniqueid;
     int ldif_include_changelog;
@@ -355,7 +356,7 @@ usage(char *name, char *extraname, int slapd_exemode)
                    "Note: either \"-n backend_instance_name\" or \"-s includesuffix\" is required.\n";
         break;
     case SLAPD_EXEMODE_DB2ARCHIVE:
-        usagestr = "usage: %s %s%s-D configdir [-q] [-d debuglevel] -a archivedir\n";
+        usagestr = "usage: %s %s%s-D configdir [-q] [-d debuglevel] -a archivedir [-b basearchivedir]\n";
         break;
     case SLAPD_EXEMODE_ARCHIVE2DB:
         usagestr = "usage: %s %s%s-D configdir [-q] [-d debuglevel] -a archivedir\n";
@@ -922,6 +923,13 @@ main(int argc, char **argv)
         goto cleanup;
     }
 
+    /* initialize the verified bind credential cache */
+    if (pw_bind_cache_init() != 0) {
+        slapi_log_err(SLAPI_LOG_EMERG, "main", "Unable to create bind credential cache\n");
+        return_value = 1;
+        goto cleanup;
+    }
+
     global_backend_lock_init();
 
     /*
@@ -1115,6 +1123,7 @@ cleanup:
     SSL_ClearSessionCache();
     slapd_ssl_destroy();
     ndn_cache_destroy();
+    pw_bind_cache_destroy();
     NSS_Shutdown();
 
     /*
@@ -1251,12 +1260,13 @@ process_command_line(int argc, char **argv, struct main_config *mcfg)
         {0, 0, 0}};
 
 
-    char *opts_db2archive = "vd:i:a:SD:qV";
+    char *opts_db2archive = "vd:i:a:b:SD:qV";
     struct opt_ext long_options_db2archive[] = {
         {"version", ArgNone, 'v'},
         {"debug", ArgRequired, 'd'},
         {"pidfile", ArgRequired, 'i'},
         {"archive", ArgRequired, 'a'},
+        {"backupBase", ArgRequired, 'b'},
         {"allowMultipleProcesses", ArgNone, 'S'},
         {"configDir", ArgRequired, 'D'},
         {"quiet", ArgNone, 'q'},
@@ -1672,6 +1682,14 @@ process_command_line(int argc, char **argv, struct main_config *mcfg)
             }
             break;
 
+        case 'b': /* base archive of an incremental db2archive */
+            if (mcfg->slapd_exemode != SLAPD_EXEMODE_DB2ARCHIVE) {
+                usage(mcfg->myname, mcfg->extraname, mcfg->slapd_exemode);
+                exit(1);
+            }
+            mcfg->backup_base = optarg_ext;
+            break;
+
         case 'Z':
             if (mcfg->slapd_exemode == SLAPD_EXEMODE_LDIF2DB) {
                 break;
@@ -2442,6 +2460,7 @@ slapd_exemode_db2archive(struct main_config *mcfg)
     slapi_pblock_set(pb, SLAPI_BACKEND, NULL);
     slapi_pblock_set(pb, SLAPI_PLUGIN, backend_plugin);
     slapi_pblock_set(pb, SLAPI_SEQ_VAL, mcfg->archive_name);
+    slapi_pblock_set_backup_base(pb, mcfg->backup_base);
     int32_t task_flags = SLAPI_TASK_RUNNING_FROM_COMMANDLINE;
     slapi_pblock_set(pb, SLAPI_TASK_FLAGS, &task_flags);
     return_value = (backend_plugin->plg_db2archive)(pb);
@@ -99,6 +99,30 @@ struct mt_suffix_ord
  */
 static Slapi_RWLock *myLock = NULL; /* global lock on the mapping tree structures */
 
+/*
+ * Index of the mapping tree nodes by subtree dn
+ *
+ * Finding the node of a dn used to scan the children of each node of its
+ * path with slapi_sdn_issuffix(), so the cost grew with the number of
+ * suffixes.  The index is a hash table of the nodes keyed by their
+ * normalized subtree dn: at each level the suffixes of the target dn are
+ * looked up, from the longest one, until one of them is a child of the
+ * current node.  The cost depends on the depth of the dn instead.
+ *
+ * An index is never modified once published.  Each change of the tree
+ * structure builds a new one and swaps it atomically, under the mapping
+ * tree lock in write mode.  The lookups, like the walk of the nodes they
+ * replace, run under the lock in read mode, so the replaced index is freed
+ * right away.
+ */
+#define MTN_DNSEPARATOR(c) (((c) == ',') || ((c) == ';'))
+
+typedef struct mtn_index
+{
+    PLHashTable *mti_nodes; /* subtree ndn -> mapping_tree_node */
+} mtn_index;
+
+static mtn_index *mapping_tree_index = NULL;
 
 static mapping_tree_node *mapping_tree_root = NULL;
 static int32_t mapping_tree_inited = 0;
@@ -139,6 +163,8 @@ static mapping_tree_node *mtn_get_first_node(mapping_tree_node *node,
 static mapping_tree_node *
 get_mapping_tree_node_by_name(mapping_tree_node *node, char *be_name);
 static int _mtn_update_config_param(int op, char *type, char *strvalue);
+static void mtn_index_rebuild(void);
+static void mtn_index_free(mtn_index **idx);
 
 #ifdef DEBUG
 #ifdef USE_DUMP_MAPPING_TREE
@@ -1062,6 +1088,7 @@ mapping_tree_entry_modify_callback(Slapi_PBlock *pb,
                 mtn_remove_node(node);
                 mapping_tree_node_add_child(parent_node, node);
                 node->mtn_parent = parent_node;
+                mtn_index_rebuild();
                 mtn_unlock();
             } else if ((strcasecmp(mods[i]->mod_type, "cn") == 0) &&
                        SLAPI_IS_MOD_ADD(mods[i]->mod_op)) {
@@ -1381,6 +1408,7 @@ mapping_tree_entry_add_callback(Slapi_PBlock *pb __attribute__((unused)),
       * the mapping tree root node with information from the add request.
       */
         mapping_tree_node_add_child(node->mtn_parent, node);
+        mtn_index_rebuild();
     }
     slapi_rwlock_unlock(myLock);
 
@@ -1499,6 +1527,7 @@ mapping_tree_entry_delete_callback(Slapi_PBlock *pb __attribute__((unused)),
 
     /* lets get the node out of the mapping tree */
     mtn_remove_node(node);
+    mtn_index_rebuild();
 
     result = SLAPI_DSE_CALLBACK_OK;
     removed = 1;
@@ -1707,6 +1736,7 @@ mapping_tree_init()
     }
 
     slapi_rwlock_wrlock(myLock);
+    mtn_index_rebuild();
     mtn_create_extension(mapping_tree_root);
     slapi_rwlock_unlock(myLock);
 
@@ -1768,6 +1798,8 @@ mtn_free_node(mapping_tree_node **node)
 void
 mapping_tree_free()
 {
+    mtn_index *idx = NULL;
+
     /* unregister dse callbacks */
     slapi_config_remove_callback(SLAPI_OPERATION_MODIFY, DSE_FLAG_PREOP, MAPPING_TREE_BASE_DN, LDAP_SCOPE_BASE, "(objectclass=*)", mapping_tree_entry_modify_callback);
     slapi_config_remove_callback(SLAPI_OPERATION_ADD, DSE_FLAG_PREOP, MAPPING_TREE_BASE_DN, LDAP_SCOPE_BASE, "(objectclass=*)", mapping_tree_entry_add_callback);
@@ -1781,6 +1813,8 @@ mapping_tree_free()
     /* recursively free tree nodes */
     mtn_free_node(&mapping_tree_root);
     slapi_atomic_store_32(&mapping_tree_freed, 1, __ATOMIC_RELAXED);
+    idx = __atomic_exchange_n(&mapping_tree_index, NULL, __ATOMIC_ACQ_REL);
+    mtn_index_free(&idx);
 }
 
 /* This function returns the first node to parse when a search is done
@@ -2811,6 +2845,155 @@ best_matching_child(mapping_tree_node *parent,
 }
 
 
+static void
+mtn_index_add_nodes(PLHashTable *nodes, mapping_tree_node *node)
+{
+    for (; node; node = node->mtn_brother) {
+        const char *ndn = slapi_sdn_get_ndn(node->mtn_subtree);
+
+        /* as in best_matching_child(), the first of two nodes with the same subtree wins */
+        if (ndn && (PL_HashTableLookupConst(nodes, ndn) == NULL)) {
+            PL_HashTableAdd(nodes, slapi_ch_strdup(ndn), node);
+        }
+        mtn_index_add_nodes(nodes, node->mtn_children);
+    }
+}
+
+static mtn_index *
+mtn_index_build(mapping_tree_node *root)
+{
+    mtn_index *idx = (mtn_index *)slapi_ch_calloc(1, sizeof(mtn_index));
+
+    idx->mti_nodes = PL_NewHashTable(64, hashNocaseString, hashNocaseCompare,
+                                     PL_CompareValues, NULL, NULL);
+    /* the root is never a child, it is not indexed */
+    if (root) {
+        mtn_index_add_nodes(idx->mti_nodes, root->mtn_children);
+    }
+    return idx;
+}
+
+static PRIntn
+mtn_index_free_key(PLHashEntry *he, PRIntn i __attribute__((unused)), void *arg __attribute__((unused)))
+{
+    slapi_ch_free((void **)&he->key);
+    return HT_ENUMERATE_NEXT;
+}
+
+static void
+mtn_index_free(mtn_index **idx)
+{
+    if (*idx == NULL) {
+        return;
+    }
+    PL_HashTableEnumerateEntries((*idx)->mti_nodes, mtn_index_free_key, NULL);
+    PL_HashTableDestroy((*idx)->mti_nodes);
+    slapi_ch_free((void **)idx);
+}
+
+/*
+ * Build the index of the current tree and publish it.
+ * Called with the mapping tree lock held in write mode: no lookup is
+ * using the replaced index.
+ */
+static void
+mtn_index_rebuild(void)
+{
+    mtn_index *idx = mtn_index_build(mapping_tree_root);
+
+    idx = __atomic_exchange_n(&mapping_tree_index, idx, __ATOMIC_ACQ_REL);
+    mtn_index_free(&idx);
+}
+
+/*
+ * Same walk as best_matching_child() from the root: the best matching
+ * child of a node is the child whose subtree is the longest suffix of
+ * the dn (the suffixes considered by slapi_sdn_issuffix()).
+ */
+static mapping_tree_node *
+mtn_index_find(mtn_index *idx, mapping_tree_node *root, const Slapi_DN *dn)
+{
+    const char *ndn = slapi_sdn_get_ndn(dn);
+    mapping_tree_node *current = root;
+    mapping_tree_node *next = NULL;
+
+    if (ndn == NULL) {
+        return current;
+    }
+    do {
+        next = NULL;
+        for (const char *p = ndn; *p; p++) {
+            mapping_tree_node *node;
+
+            if ((p != ndn) && !MTN_DNSEPARATOR(p[-1])) {
+                continue;
+            }
+            node = (mapping_tree_node *)PL_HashTableLookupConst(idx->mti_nodes, p);
+            if (node && (node->mtn_parent == current)) {
+                next = node;
+                break;
+            }
+        }
+        if (next) {
+            current = next;
+        }
+    } while (next);
+
+    return current;
+}
+
+/* The walk of the tree itself, before the index is built */
+static mapping_tree_node *
+mtn_walk(mapping_tree_node *root, const Slapi_DN *dn)
+{
+    mapping_tree_node *current_best_match = root;
+    mapping_tree_node *next_best_match = root;
+
+    while (next_best_match) {
+        current_best_match = next_best_match;
+        next_best_match = best_matching_child(current_best_match, dn);
+    }
+    return current_best_match;
+}
+
+/*
+ * For the unit tests: build a tree of the suffixes, each one below the
+ * node of the closest suffix listed before it (as the mapping tree entries
+ * are added), then look dn up in the index of this tree and by walking it.
+ * Returns the normalized subtree of the node found ("" for the root), or
+ * NULL when the two lookups disagree.
+ */
+char *
+mapping_tree_index_check(char **suffixes, const char *dn)
+{
+    mapping_tree_node *root = mapping_tree_node_new(slapi_sdn_new_dn_byval(""), NULL, NULL, NULL,
+                                                    0, 0, NULL, NULL, MTN_BACKEND, 0,
+                                                    NULL, NULL, NULL, 0);
+    Slapi_DN *sdn = slapi_sdn_new_dn_byval(dn);
+    mapping_tree_node *found = NULL;
+    mtn_index *idx = NULL;
+    char *subtree = NULL;
+
+    for (size_t i = 0; suffixes && suffixes[i]; i++) {
+        Slapi_DN *suffix = slapi_sdn_new_dn_byval(suffixes[i]);
+        mapping_tree_node *parent = mtn_walk(root, suffix);
+
+        mapping_tree_node_add_child(parent,
+                                    mapping_tree_node_new(suffix, NULL, NULL, NULL, 0, 0, NULL, parent,
+                                                          MTN_BACKEND, 0, NULL, NULL, NULL, 0));
+    }
+    idx = mtn_index_build(root);
+    found = mtn_index_find(idx, root, sdn);
+    if (found == mtn_walk(root, sdn)) {
+        subtree = slapi_ch_strdup(slapi_sdn_get_ndn(found->mtn_subtree));
+    }
+
+    mtn_index_free(&idx);
+    mtn_free_node(&root);
+    slapi_sdn_free(&sdn);
+    return subtree;
+}
+
 /*
  * look for the exact mapping tree node corresponding to a given entry dn
  */
@@ -2859,8 +3042,8 @@ mtn_get_mapping_tree_node_by_entry(mapping_tree_node *node, const Slapi_DN *dn)
 mapping_tree_node *
 slapi_get_mapping_tree_node_by_dn(const Slapi_DN *dn)
 {
-    mapping_tree_node *current_best_match = mapping_tree_root;
-    mapping_tree_node *next_best_match = mapping_tree_root;
+    mapping_tree_node *current_best_match = NULL;
+    mtn_index *idx = NULL;
 
     if (slapi_atomic_load_32(&mapping_tree_freed, __ATOMIC_RELAXED)) {
         /* shutdown detected */
@@ -2876,10 +3059,12 @@ slapi_get_mapping_tree_node_by_dn(const Slapi_DN *dn)
         return (mapping_tree_root);
     }
 
-    /* Start at the root and walk down the tree to find the best match. */
-    while (next_best_match) {
-        current_best_match = next_best_match;
-        next_best_match = best_matching_child(current_best_match, dn);
+    idx = __atomic_load_n(&mapping_tree_index, __ATOMIC_ACQUIRE);
+    if (idx) {
+        current_best_match = mtn_index_find(idx, mapping_tree_root, dn);
+    } else {
+        /* The tree is being built: start at the root and walk down the tree to find the best match. */
+        current_best_match = mtn_walk(mapping_tree_root, dn);
     }
 
     if (current_best_match == mapping_tree_root) {
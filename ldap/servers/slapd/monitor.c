@@ -132,6 +132,50 @@ monitor_info(Slapi_PBlock *pb __attribute__((unused)),
     val.bv_val = buf;
     attrlist_replace(&e->e_attrs, "maxbusyworkers", vals);
 
+    slapd_numa_as_entry(e);
+
+    {
+        uint64_t hits, tries, slots;
+        if (pw_bind_cache_get_stats(&hits, &tries, &slots)) {
+            val.bv_len = snprintf(buf, sizeof(buf), "%" PRIu64, hits);
+            val.bv_val = buf;
+            attrlist_replace(&e->e_attrs, "pwdbindcachehits", vals);
+
+            val.bv_len = snprintf(buf, sizeof(buf), "%" PRIu64, tries);
+            val.bv_val = buf;
+            attrlist_replace(&e->e_attrs, "pwdbindcachetries", vals);
+
+            val.bv_len = snprintf(buf, sizeof(buf), "%" PRIu64, slots);
+            val.bv_val = buf;
+            attrlist_replace(&e->e_attrs, "pwdbindcacheslots", vals);
+        }
+    }
+
+    {
+        uint64_t queue, queue_max, completed, rejected, wait_usec;
+        if (pw_kdf_pool_get_stats(&queue, &queue_max, &completed, &rejected, &wait_usec)) {
+            val.bv_len = snprintf(buf, sizeof(buf), "%" PRIu64, queue);
+            val.bv_val = buf;
+            attrlist_replace(&e->e_attrs, "pwdkdfqueue", vals);
+
+            val.bv_len = snprintf(buf, sizeof(buf), "%" PRIu64, queue_max);
+            val.bv_val = buf;
+            attrlist_replace(&e->e_attrs, "pwdkdfmaxqueue", vals);
+
+            val.bv_len = snprintf(buf, sizeof(buf), "%" PRIu64, completed);
+            val.bv_val = buf;
+            attrlist_replace(&e->e_attrs, "pwdkdfcompleted", vals);
+
+            val.bv_len = snprintf(buf, sizeof(buf), "%" PRIu64, rejected);
+            val.bv_val = buf;
+            attrlist_replace(&e->e_attrs, "pwdkdfrejected", vals);
+
+            val.bv_len = snprintf(buf, sizeof(buf), "%" PRIu64, completed ? wait_usec / completed : 0);
+            val.bv_val = buf;
+            attrlist_replace(&e->e_attrs, "pwdkdfavgwaitusec", vals);
+        }
+    }
+
     *returncode = LDAP_SUCCESS;
     return SLAPI_DSE_CALLBACK_OK;
 }
@@ -0,0 +1,304 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * numa.c
+ *
+ * Optional NUMA placement of the connection handling (nsslapd-numa).
+ *
+ * On multi-socket servers the connection table lists, the threads polling
+ * them and the worker threads processing their operations are spread over
+ * all the cpus, so a connection is typically read on one socket and
+ * processed on another one, and its Connection struct bounces between the
+ * sockets caches.
+ * When nsslapd-numa is on (and the host has more than one NUMA node) each
+ * connection table list is bound to a node (list i to node i % nbnodes):
+ *  - the list and its connection structs are initialized by a thread
+ *    running on that node so their memory is allocated locally,
+ *  - the list thread is pinned on the node cpus,
+ *  - the worker threads are dispatched round robin on the nodes and
+ *    preferably process the connections of their own node,
+ *  - new connections are balanced across the nodes then across the lists
+ *    of the chosen node.
+ * Memory allocated by the pinned threads (entries, operations, ...) is then
+ * placed on their node by the kernel first touch policy.
+ *
+ * The topology is read from sysfs so there is no libnuma dependency.
+ */
+
+#include "slap.h"
+#include <sched.h>
+
+#define NUMA_SYSFS_DIR "/sys/devices/system/node"
+#define NUMA_MAX_NODES 64
+
+typedef struct
+{
+    cpu_set_t cpus;
+    int32_t nbcpus;
+    int32_t ctlists;           /* connection table lists bound to the node */
+    int32_t workers;           /* worker threads bound to the node */
+    uint64_t currentconns;     /* connections currently handled by the node lists */
+    uint64_t totalconns;       /* connections handled since startup */
+    uint64_t ops;              /* operations picked by the node workers */
+    uint64_t stolenops;        /* operations of other nodes picked by the node workers */
+} slapd_numa_node;
+
+static slapd_numa_node *numa_nodes = NULL;
+static int32_t numa_nb_nodes = 0;   /* 0 when numa placement is disabled */
+
+/* Parse a sysfs cpu list like "0-15,32-47" */
+static int32_t
+numa_parse_cpulist(const char *list, cpu_set_t *cpus)
+{
+    const char *p = list;
+    char *end = NULL;
+    long first, last;
+    int32_t nb = 0;
+
+    CPU_ZERO(cpus);
+    while (*p && *p != '\n') {
+        first = strtol(p, &end, 10);
+        if (end == p || first < 0) {
+            return -1;
+        }
+        last = first;
+        p = end;
+        if (*p == '-') {
+            p++;
+            last = strtol(p, &end, 10);
+            if (end == p || last < first) {
+                return -1;
+            }
+            p = end;
+        }
+        for (; first <= last && first < CPU_SETSIZE; first++) {
+            CPU_SET(first, cpus);
+            nb++;
+        }
+        if (*p == ',') {
+            p++;
+        }
+    }
+    return nb;
+}
+
+static int32_t
+numa_read_node_cpus(int32_t node, cpu_set_t *cpus)
+{
+    char path[MAXPATHLEN];
+    char buf[BUFSIZ] = {0};
+    FILE *fp = NULL;
+    int32_t nb = -1;
+
+    snprintf(path, sizeof(path), NUMA_SYSFS_DIR "/node%d/cpulist", node);
+    if ((fp = fopen(path, "r")) == NULL) {
+        return -1;
+    }
+    if (fgets(buf, sizeof(buf), fp)) {
+        nb = numa_parse_cpulist(buf, cpus);
+    }
+    fclose(fp);
+    return nb;
+}
+
+/*
+ * Read the NUMA topology if nsslapd-numa is on.
+ * Must be called before the connection table is created.
+ */
+void
+slapd_numa_init(void)
+{
+    slapd_numa_node nodes[NUMA_MAX_NODES];
+    cpu_set_t allowed;
+    int32_t nb = 0;
+    int32_t node;
+
+    if (!config_get_numa()) {
+        return;
+    }
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        CPU_ZERO(&allowed);
+    }
+    memset(nodes, 0, sizeof(nodes));
+    for (node = 0; node < NUMA_MAX_NODES; node++) {
+        cpu_set_t cpus;
+        if (numa_read_node_cpus(node, &cpus) < 0) {
+            continue;
+        }
+        /* Only keep the cpus we are allowed to run on (cgroups, taskset) */
+        if (CPU_COUNT(&allowed)) {
+            CPU_AND(&cpus, &cpus, &allowed);
+        }
+        if (CPU_COUNT(&cpus) == 0) {
+            /* memory only node */
+            continue;
+        }
+        nodes[nb].cpus = cpus;
+        nodes[nb].nbcpus = CPU_COUNT(&cpus);
+        nb++;
+    }
+    if (nb < 2) {
+        slapi_log_err(SLAPI_LOG_INFO, "slapd_numa_init",
+                      "%s is on but the host has %d usable NUMA node, NUMA placement is disabled.\n",
+                      CONFIG_NUMA, nb);
+        return;
+    }
+    if (config_get_num_listeners() < nb) {
+        /* Nodes without list would only run workers handling the other nodes connections */
+        slapi_log_err(SLAPI_LOG_WARNING, "slapd_numa_init",
+                      "%s is on but %s (%d) is lower than the number of NUMA nodes (%d), NUMA placement is disabled.\n",
+                      CONFIG_NUMA, CONFIG_NUM_LISTENERS_ATTRIBUTE, config_get_num_listeners(), nb);
+        return;
+    }
+    numa_nodes = (slapd_numa_node *)slapi_ch_calloc(nb, sizeof(slapd_numa_node));
+    memcpy(numa_nodes, nodes, nb * sizeof(slapd_numa_node));
+    numa_nb_nodes = nb;
+    for (node = 0; node < nb; node++) {
+        slapi_log_err(SLAPI_LOG_INFO, "slapd_numa_init", "NUMA node %d: %d cpus.\n",
+                      node, numa_nodes[node].nbcpus);
+    }
+}
+
+void
+slapd_numa_free(void)
+{
+    numa_nb_nodes = 0;
+    slapi_ch_free((void **)&numa_nodes);
+}
+
+/* Number of nodes used for the placement (1 when NUMA placement is disabled) */
+int32_t
+slapd_numa_nb_nodes(void)
+{
+    return numa_nb_nodes ? numa_nb_nodes : 1;
+}
+
+int32_t
+slapd_numa_node_of_list(int32_t ct_list)
+{
+    return numa_nb_nodes ? ct_list % numa_nb_nodes : 0;
+}
+
+/*
+ * Pin the calling thread on the cpus of a node.
+ * The previous affinity is stored in oldcpus if it is not NULL.
+ */
+int32_t
+slapd_numa_bind_thread(int32_t node, cpu_set_t *oldcpus)
+{
+    int32_t rc;
+
+    if (numa_nb_nodes == 0) {
+        return 0;
+    }
+    if (oldcpus && (rc = pthread_getaffinity_np(pthread_self(), sizeof(cpu_set_t), oldcpus)) != 0) {
+        return rc;
+    }
+    rc = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &numa_nodes[node].cpus);
+    if (rc) {
+        slapi_log_err(SLAPI_LOG_WARNING, "slapd_numa_bind_thread",
+                      "Failed to bind thread on NUMA node %d. Error %d (%s)\n",
+                      node, rc, strerror(rc));
+    }
+    return rc;
+}
+
+void
+slapd_numa_restore_thread(cpu_set_t *oldcpus)
+{
+    if (numa_nb_nodes) {
+        (void)pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), oldcpus);
+    }
+}
+
+/* Bind a connection table list thread and account for it */
+void
+slapd_numa_bind_list_thread(int32_t ct_list)
+{
+    int32_t node = slapd_numa_node_of_list(ct_list);
+
+    if (numa_nb_nodes && slapd_numa_bind_thread(node, NULL) == 0) {
+        slapi_atomic_incr_32(&numa_nodes[node].ctlists, __ATOMIC_RELAXED);
+    }
+}
+
+/* Bind a worker thread (round robin on the nodes). Returns the worker node */
+int32_t
+slapd_numa_bind_worker_thread(int32_t worker)
+{
+    int32_t node = numa_nb_nodes ? worker % numa_nb_nodes : 0;
+
+    if (numa_nb_nodes && slapd_numa_bind_thread(node, NULL) == 0) {
+        slapi_atomic_incr_32(&numa_nodes[node].workers, __ATOMIC_RELAXED);
+    }
+    return node;
+}
+
+void
+slapd_numa_conn_added(int32_t ct_list)
+{
+    if (numa_nb_nodes) {
+        int32_t node = slapd_numa_node_of_list(ct_list);
+        slapi_atomic_incr_64(&numa_nodes[node].currentconns, __ATOMIC_RELAXED);
+        slapi_atomic_incr_64(&numa_nodes[node].totalconns, __ATOMIC_RELAXED);
+    }
+}
+
+void
+slapd_numa_conn_removed(int32_t ct_list)
+{
+    if (numa_nb_nodes) {
+        slapi_atomic_decr_64(&numa_nodes[slapd_numa_node_of_list(ct_list)].currentconns, __ATOMIC_RELAXED);
+    }
+}
+
+/* Account for an operation picked by a worker of the given node */
+void
+slapd_numa_op_picked(int32_t node, int32_t stolen)
+{
+    if (numa_nb_nodes) {
+        slapi_atomic_incr_64(&numa_nodes[node].ops, __ATOMIC_RELAXED);
+        if (stolen) {
+            slapi_atomic_incr_64(&numa_nodes[node].stolenops, __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/*
+ * Replace the numanode attribute of the cn=monitor entry: one value per node
+ *   node:cpus:ctlists:workers:currentconnections:totalconnections:opspicked:opsstolen
+ */
+void
+slapd_numa_as_entry(Slapi_Entry *e)
+{
+    char buf[BUFSIZ];
+    struct berval val;
+    struct berval *vals[2] = {&val, NULL};
+    int32_t node;
+
+    attrlist_delete(&e->e_attrs, "numanode");
+    for (node = 0; node < numa_nb_nodes; node++) {
+        slapd_numa_node *n = &numa_nodes[node];
+        val.bv_len = snprintf(buf, sizeof(buf),
+                              "%d:%d:%d:%d:%" PRIu64 ":%" PRIu64 ":%" PRIu64 ":%" PRIu64,
+                              node, n->nbcpus,
+                              slapi_atomic_load_32(&n->ctlists, __ATOMIC_RELAXED),
+                              slapi_atomic_load_32(&n->workers, __ATOMIC_RELAXED),
+                              slapi_atomic_load_64(&n->currentconns, __ATOMIC_RELAXED),
+                              slapi_atomic_load_64(&n->totalconns, __ATOMIC_RELAXED),
+                              slapi_atomic_load_64(&n->ops, __ATOMIC_RELAXED),
+                              slapi_atomic_load_64(&n->stolenops, __ATOMIC_RELAXED));
+        val.bv_val = buf;
+        attrlist_merge(&e->e_attrs, "numanode", vals);
+    }
+}
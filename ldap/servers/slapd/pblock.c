@@ -29,6 +29,7 @@
 #define SLAPI_PWDPOLICY 2004
 #define SLAPI_PW_ENTRY 2005
 #define SLAPI_TASK_WARNING 2006
+#define SLAPI_BACKUP_BASE 2007
 
 static PRLock *pblock_analytics_lock = NULL;
 
@@ -6535,6 +6536,28 @@ slapi_pblock_set_ldif_dump_replica(Slapi_PBlock *pb, int32_t dump_replica)
     pb->pb_task->ldif_dump_replica = dump_replica;
 }
 
+char *
+slapi_pblock_get_backup_base(Slapi_PBlock *pb)
+{
+#ifdef PBLOCK_ANALYTICS
+    pblock_analytics_record(pb, SLAPI_BACKUP_BASE);
+#endif
+    if (pb->pb_task != NULL) {
+        return pb->pb_task->backup_base;
+    }
+    return NULL;
+}
+
+void
+slapi_pblock_set_backup_base(Slapi_PBlock *pb, char *backup_base)
+{
+#ifdef PBLOCK_ANALYTICS
+    pblock_analytics_record(pb, SLAPI_BACKUP_BASE);
+#endif
+    _pblock_assert_pb_task(pb);
+    pb->pb_task->backup_base = backup_base;
+}
+
 int32_t
 slapi_pblock_get_task_warning(Slapi_PBlock *pb)
 {
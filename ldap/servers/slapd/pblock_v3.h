@@ -45,6 +45,7 @@ typedef struct _slapi_pblock_task
     Slapi_Task *task;
     char *seq_attrname;
     char *seq_val;
+    char *backup_base; /* db2archive: previous backup for an incremental backup */
     char *dbverify_dbdir;
     char *ldif_file;
     char **db2index_attrs;
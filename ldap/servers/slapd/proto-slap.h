@@ -63,6 +63,12 @@ int attr_get_value_cmp_fn(const Slapi_Attr *attr, value_compare_fn_type *compare
 const char *attr_get_syntax_oid(const Slapi_Attr *attr);
 
 
+/*
+ * attratom.c
+ */
+uint32_t attr_atom_get(const char *name);
+uint32_t attr_atom_intern(const char *name);
+
 /*
  * attrlist.c
  */
@@ -89,6 +95,9 @@ void attr_syntax_read_lock(void);
 void attr_syntax_write_lock(void);
 void attr_syntax_unlock_read(void);
 void attr_syntax_unlock_write(void);
+void attr_syntax_pin(void);
+void attr_syntax_unpin(void);
+size_t attr_syntax_retired_pending(void);
 int attr_syntax_exists(const char *attr_name);
 int32_t attr_syntax_exist_by_name_nolock(char *name);
 void attr_syntax_delete(struct asyntaxinfo *asip, PRUint32 schema_flags);
@@ -411,6 +420,10 @@ int config_set_errorlog_time_format(const char *attrname, char *value, char *err
 int config_set_external_libs_debug_enabled(const char *attrname, char *value, char *errorbuf, int apply);
 int config_set_ndn_cache_enabled(const char *attrname, char *value, char *errorbuf, int apply);
 int config_set_ndn_cache_max_size(const char *attrname, char *value, char *errorbuf, int apply);
+int config_set_pw_bind_cache_size(const char *attrname, char *value, char *errorbuf, int apply);
+int config_set_pw_bind_cache_ttl(const char *attrname, char *value, char *errorbuf, int apply);
+int config_set_pw_kdf_threads(const char *attrname, char *value, char *errorbuf, int apply);
+int config_set_pw_kdf_queue_depth(const char *attrname, char *value, char *errorbuf, int apply);
 int config_set_unhashed_pw_switch(const char *attrname, char *value, char *errorbuf, int apply);
 int config_set_return_orig_type_switch(const char *attrname, char *value, char *errorbuf, int apply);
 int config_set_sasl_maxbufsize(const char *attrname, char *value, char *errorbuf, int apply);
@@ -587,6 +600,10 @@ int config_get_disk_grace_period(void);
 int config_get_disk_logging_critical(void);
 int config_get_ndn_cache_count(void);
 uint64_t config_get_ndn_cache_size(void);
+int32_t config_get_pw_bind_cache_size(void);
+int32_t config_get_pw_bind_cache_ttl(void);
+int32_t config_get_pw_kdf_threads(void);
+int32_t config_get_pw_kdf_queue_depth(void);
 int config_get_ndn_cache_enabled(void);
 int config_get_return_orig_type_switch(void);
 char *config_get_allowed_sasl_mechs(void);
@@ -601,6 +618,8 @@ int config_get_unhashed_pw_switch(void);
 int config_get_sasl_maxbufsize(void);
 int config_get_enable_turbo_mode(void);
 int config_set_enable_turbo_mode(const char *attrname, char *value, char *errorbuf, int apply);
+int config_get_numa(void);
+int config_set_numa(const char *attrname, char *value, char *errorbuf, int apply);
 int config_get_connection_buffer(void);
 int config_set_connection_buffer(const char *attrname, char *value, char *errorbuf, int apply);
 int config_get_connection_nocanon(void);
@@ -750,6 +769,15 @@ char *filter_strcpy_special(char *d, char *s);
 char *filter_strcpy_special_ext(char *d, char *s, int flags);
 
 
+/*
+ * substrmatch.c
+ */
+Slapi_Substr *substr_match_new(const char *initial, char **any, const char *final);
+void substr_match_free(Slapi_Substr **ss);
+int substr_match_exec(const Slapi_Substr *ss, const char *value);
+void filter_compile_substrings(struct slapi_filter *f);
+
+
 /*
  * entry.c
  */
@@ -1347,6 +1375,28 @@ int config_set(const char *attr_name, struct berval **values, char *errorbuf, in
 
 void free_pw_scheme(struct pw_scheme *pwsp);
 
+/*
+ * numa.c
+ */
+void slapd_numa_init(void);
+void slapd_numa_free(void);
+int32_t slapd_numa_nb_nodes(void);
+int32_t slapd_numa_node_of_list(int32_t ct_list);
+int32_t slapd_numa_bind_thread(int32_t node, cpu_set_t *oldcpus);
+void slapd_numa_restore_thread(cpu_set_t *oldcpus);
+void slapd_numa_bind_list_thread(int32_t ct_list);
+int32_t slapd_numa_bind_worker_thread(int32_t worker);
+void slapd_numa_conn_added(int32_t ct_list);
+void slapd_numa_conn_removed(int32_t ct_list);
+void slapd_numa_op_picked(int32_t node, int32_t stolen);
+void slapd_numa_as_entry(Slapi_Entry *e);
+
+/*
+ * pw_kdf_pool.c
+ */
+int32_t pw_kdf_pool_cmp(struct pw_scheme *pwsp, char *userpwd, char *dbpwd, int *cmp_rc);
+char *pw_kdf_pool_enc(struct pw_scheme *pwsp, char *pwd);
+
 /*
  * rootdse.c
  */
@@ -157,6 +157,7 @@ ps_add(Slapi_PBlock *pb, ber_int_t changetypes, int send_entchg_controls)
 {
     PSearch *ps;
     PRThread *ps_tid;
+    Slapi_Filter *filter = NULL;
 
     if (PS_IS_INITIALIZED() && NULL != pb) {
         /* Create the new node */
@@ -167,6 +168,9 @@ ps_add(Slapi_PBlock *pb, ber_int_t changetypes, int send_entchg_controls)
         ps->ps_pblock = slapi_pblock_clone(pb);
         ps->ps_changetypes = changetypes;
         ps->ps_send_entchg_controls = send_entchg_controls;
+        /* Every modify tests the filter, compile its substring assertions once */
+        slapi_pblock_get(ps->ps_pblock, SLAPI_SEARCH_FILTER, &filter);
+        filter_compile_substrings(filter);
 
         /* Add it to the head of the list of persistent searches */
         ps_add_ps(ps);
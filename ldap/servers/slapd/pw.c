@@ -132,45 +132,36 @@ pw_send_ldap_result(
 }
 
 /*
- * Like slapi_value_find, except for passwords.
- * returns 0 if password "v" is found in "vals"; non-zero otherwise
+ * Compare v to the passwords in vals.  When the password hashing pool
+ * refuses the comparison because its queue is full, it is either run
+ * inline by the calling thread or, if refuse_when_busy is set, reported
+ * as PW_KDF_POOL_BUSY.  It is never reported as a mismatch.
  */
-SLAPI_DEPRECATED int
-slapi_pw_find(
-    struct berval **vals,
-    struct berval *v)
-{
-    int rc;
-    Slapi_Value **svin_vals = NULL;
-    Slapi_Value svin_v;
-    slapi_value_init_berval(&svin_v, v);
-    valuearray_init_bervalarray(vals, &svin_vals); /* JCM SLOW FUNCTION */
-    rc = slapi_pw_find_sv(svin_vals, &svin_v);
-    valuearray_free(&svin_vals);
-    value_done(&svin_v);
-    return rc;
-}
-
-/*
- * Like slapi_value_find, except for passwords.
- * returns 0 if password "v" is found in "vals"; non-zero otherwise
- */
-
-int
-slapi_pw_find_sv(
-    Slapi_Value **vals,
-    const Slapi_Value *v)
+static int
+pw_find_sv_internal(Slapi_Value **vals, const Slapi_Value *v, int refuse_when_busy)
 {
     struct pw_scheme *pwsp;
     char *valpwd;
+    int cmp_rc;
     int i;
 
     slapi_log_err(SLAPI_LOG_TRACE, "slapi_pw_find_sv", "=> \"%s\"\n", slapi_value_get_string(v));
 
     for (i = 0; vals && vals[i]; i++) {
         pwsp = pw_val2scheme((char *)slapi_value_get_string(vals[i]), &valpwd, 1);
-        if (pwsp != NULL &&
-            (*(pwsp->pws_cmp))((char *)slapi_value_get_string(v), valpwd) == 0) {
+        if (pwsp == NULL) {
+            continue;
+        }
+        if (pw_kdf_pool_cmp(pwsp, (char *)slapi_value_get_string(v), valpwd, &cmp_rc) != 0) {
+            if (refuse_when_busy) {
+                slapi_log_err(SLAPI_LOG_TRACE, "slapi_pw_find_sv",
+                              "<= Password hashing queue is full\n");
+                free_pw_scheme(pwsp);
+                return PW_KDF_POOL_BUSY;
+            }
+            cmp_rc = (*(pwsp->pws_cmp))((char *)slapi_value_get_string(v), valpwd);
+        }
+        if (cmp_rc == 0) {
             slapi_log_err(SLAPI_LOG_TRACE, "slapi_pw_find_sv",
                           "<= Matched \"%s\" using scheme \"%s\"\n",
                           valpwd, pwsp->pws_name);
@@ -185,6 +176,33 @@ slapi_pw_find_sv(
     return (1); /* no match */
 }
 
+/*
+ * Like slapi_value_find, except for passwords.
+ * returns 0 if password "v" is found in "vals"; non-zero otherwise
+ */
+
+int
+slapi_pw_find_sv(
+    Slapi_Value **vals,
+    const Slapi_Value *v)
+{
+    /* the answer must be exact (password history, root dn...), never refuse */
+    return pw_find_sv_internal(vals, v, 0);
+}
+
+/*
+ * Like slapi_pw_find_sv(), but returns PW_KDF_POOL_BUSY when the password
+ * hashing pool refused the comparison, for the callers that can reply
+ * LDAP_BUSY instead of hashing on the worker thread.
+ */
+int
+pw_find_sv_ext(
+    Slapi_Value **vals,
+    const Slapi_Value *v)
+{
+    return pw_find_sv_internal(vals, v, 1);
+}
+
 /* Checks if the specified value is encoded.
    Returns 1 if it is and 0 otherwise
  */
@@ -249,11 +267,12 @@ slapi_encode_ext(Slapi_PBlock *pb, const Slapi_DN *sdn, char *value, char *alg)
             }
             return NULL;
         }
-        pws_enc = enc_scheme->pws_enc;
+        hashedval = pw_kdf_pool_enc(enc_scheme, value);
         free_pw_scheme(enc_scheme);
+        return hashedval;
     }
 
-    hashedval = (*pws_enc)(value);
+    hashedval = pw_kdf_pool_enc(pwpolicy->pw_storagescheme, value);
 
     /* new_passwdPolicy registers the policy in the pblock so there is no leak */
     /* coverity[leaked_storage] */
@@ -422,7 +441,7 @@ pw_encodevals_ext(Slapi_PBlock *pb, const Slapi_DN *sdn, Slapi_Value **vals)
         }
         free_pw_scheme(pwsp);
 
-        if ((!enc) && ((enc = (*pws_enc)((char *)slapi_value_get_string(vals[i]))) == NULL)) {
+        if ((!enc) && ((enc = pw_kdf_pool_enc(pwpolicy->pw_storagescheme, (char *)slapi_value_get_string(vals[i]))) == NULL)) {
             return (-1);
         }
         slapi_value_free(&vals[i]);
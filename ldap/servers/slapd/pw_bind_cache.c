@@ -0,0 +1,345 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * pw_bind_cache.c
+ *
+ * A bounded cache of recently verified simple bind credentials.
+ *
+ * Password storage schemes such as PBKDF2 are deliberately expensive, so
+ * service accounts that re-bind many times per second spend most of their
+ * time in the KDF. This cache remembers, per (backend, entry ID), a keyed
+ * HMAC-SHA256 digest of the stored userPassword values and the credential
+ * that matched them. A later bind that produces the same digest is known to
+ * match without running the storage scheme again.
+ *
+ * The cache never holds the clear text password or anything that can be
+ * attacked offline: the HMAC key is random, generated per process and never
+ * leaves memory. Because the stored values are part of the digest, any
+ * password change (which always yields a new stored value, and thus a new
+ * value CSN) turns the cached slot into a miss. Slots are additionally
+ * scrubbed when the entry's password or a password policy changes, expire
+ * after nsslapd-pwd-bind-cache-ttl seconds, and the table is fixed to
+ * nsslapd-pwd-bind-cache-size slots (0 disables the cache).
+ *
+ * Only successful verifications are cached. Failures always take the full
+ * path so that lockout and retry accounting are unaffected.
+ */
+
+#include "slap.h"
+#include <pk11pub.h>
+
+/* Number of mutexes guarding the slot table. Slot i is guarded by lock i % N */
+#define PW_BIND_CACHE_LOCKS 64
+/* SHA-256 block size, used for the HMAC key */
+#define PW_BIND_CACHE_KEY_LEN 64
+#define PW_BIND_CACHE_DIGEST_LEN 32
+
+typedef struct pw_bind_cache_slot
+{
+    const Slapi_Backend *be;
+    uint64_t id;
+    uint64_t generation;
+    time_t expire;
+    unsigned char digest[PW_BIND_CACHE_DIGEST_LEN];
+} pw_bind_cache_slot;
+
+static pw_bind_cache_slot *bc_slots = NULL;
+static uint64_t bc_nslots = 0;
+static pthread_mutex_t bc_locks[PW_BIND_CACHE_LOCKS];
+static uint64_t bc_generation = 0;
+static unsigned char bc_key[PW_BIND_CACHE_KEY_LEN];
+static pthread_once_t bc_key_once = PTHREAD_ONCE_INIT;
+static Slapi_Counter *bc_hits = NULL;
+static Slapi_Counter *bc_tries = NULL;
+
+/* Overwrite sensitive memory in a way the compiler can not elide */
+static void
+pw_bind_cache_scrub(void *ptr, size_t len)
+{
+    volatile unsigned char *p = ptr;
+    while (len--) {
+        *p++ = 0;
+    }
+}
+
+static int32_t
+pw_bind_cache_digest_eq(const unsigned char *a, const unsigned char *b)
+{
+    unsigned char diff = 0;
+    for (size_t i = 0; i < PW_BIND_CACHE_DIGEST_LEN; i++) {
+        diff |= a[i] ^ b[i];
+    }
+    return diff == 0;
+}
+
+static void
+pw_bind_cache_key_init(void)
+{
+    /* NSS is only guaranteed to be up once we serve binds, so do this lazily */
+    slapi_rand_array(bc_key, sizeof(bc_key));
+}
+
+static uint64_t
+pw_bind_cache_slot_index(const Slapi_Backend *be, uint64_t id)
+{
+    uint64_t h = ((uint64_t)(uintptr_t)be >> 4) ^ (id * 0x9E3779B97F4A7C15ULL);
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    h ^= h >> 32;
+    return h % bc_nslots;
+}
+
+static void
+pw_bind_cache_digest_op(PK11Context *ctx, const struct berval *bv)
+{
+    uint32_t len = (uint32_t)bv->bv_len;
+    /* Length prefix every field so that value boundaries can not be shifted */
+    PK11_DigestOp(ctx, (unsigned char *)&len, sizeof(len));
+    if (len) {
+        PK11_DigestOp(ctx, (unsigned char *)bv->bv_val, len);
+    }
+}
+
+/*
+ * HMAC-SHA256(key, stored values || credential). Returns 0 on success.
+ */
+static int32_t
+pw_bind_cache_digest(Slapi_Value **vals, const Slapi_Value *cred, unsigned char *digest)
+{
+    unsigned char pad[PW_BIND_CACHE_KEY_LEN];
+    unsigned char inner[PW_BIND_CACHE_DIGEST_LEN];
+    unsigned int len = 0;
+    PK11Context *ctx = NULL;
+    int32_t rc = -1;
+
+    pthread_once(&bc_key_once, pw_bind_cache_key_init);
+
+    if ((ctx = PK11_CreateDigestContext(SEC_OID_SHA256)) == NULL) {
+        return rc;
+    }
+
+    for (size_t i = 0; i < sizeof(pad); i++) {
+        pad[i] = bc_key[i] ^ 0x36;
+    }
+    PK11_DigestBegin(ctx);
+    PK11_DigestOp(ctx, pad, sizeof(pad));
+    for (size_t i = 0; vals && vals[i]; i++) {
+        pw_bind_cache_digest_op(ctx, slapi_value_get_berval(vals[i]));
+    }
+    pw_bind_cache_digest_op(ctx, slapi_value_get_berval(cred));
+    if (PK11_DigestFinal(ctx, inner, &len, sizeof(inner)) != SECSuccess) {
+        goto done;
+    }
+
+    for (size_t i = 0; i < sizeof(pad); i++) {
+        pad[i] = bc_key[i] ^ 0x5c;
+    }
+    PK11_DigestBegin(ctx);
+    PK11_DigestOp(ctx, pad, sizeof(pad));
+    PK11_DigestOp(ctx, inner, sizeof(inner));
+    if (PK11_DigestFinal(ctx, digest, &len, PW_BIND_CACHE_DIGEST_LEN) == SECSuccess) {
+        rc = 0;
+    }
+
+done:
+    PK11_DestroyContext(ctx, PR_TRUE);
+    pw_bind_cache_scrub(pad, sizeof(pad));
+    pw_bind_cache_scrub(inner, sizeof(inner));
+    return rc;
+}
+
+int32_t
+pw_bind_cache_init(void)
+{
+    int64_t size = config_get_pw_bind_cache_size();
+
+    if (size <= 0) {
+        /* Disabled. Like the ndn cache, enabling it requires a restart. */
+        return 0;
+    }
+
+    for (size_t i = 0; i < PW_BIND_CACHE_LOCKS; i++) {
+        if (pthread_mutex_init(&bc_locks[i], NULL) != 0) {
+            slapi_log_err(SLAPI_LOG_ERR, "pw_bind_cache_init", "Failed to create lock\n");
+            return -1;
+        }
+    }
+    bc_hits = slapi_counter_new();
+    bc_tries = slapi_counter_new();
+    bc_nslots = (uint64_t)size;
+    bc_slots = (pw_bind_cache_slot *)slapi_ch_calloc(bc_nslots, sizeof(pw_bind_cache_slot));
+
+    slapi_log_err(SLAPI_LOG_INFO, "pw_bind_cache_init",
+                  "Bind credential cache enabled with %" PRIu64 " slots\n", bc_nslots);
+    return 0;
+}
+
+void
+pw_bind_cache_destroy(void)
+{
+    if (bc_slots == NULL) {
+        return;
+    }
+    pw_bind_cache_scrub(bc_slots, bc_nslots * sizeof(pw_bind_cache_slot));
+    slapi_ch_free((void **)&bc_slots);
+    pw_bind_cache_scrub(bc_key, sizeof(bc_key));
+    for (size_t i = 0; i < PW_BIND_CACHE_LOCKS; i++) {
+        pthread_mutex_destroy(&bc_locks[i]);
+    }
+    slapi_counter_destroy(&bc_hits);
+    slapi_counter_destroy(&bc_tries);
+    bc_nslots = 0;
+}
+
+/*
+ * Drop every cached credential, for example after a password policy change.
+ */
+void
+pw_bind_cache_flush(void)
+{
+    if (bc_slots == NULL) {
+        return;
+    }
+    /* In flight verifications started before this point must not be stored */
+    slapi_atomic_incr_64(&bc_generation, __ATOMIC_RELEASE);
+    for (size_t l = 0; l < PW_BIND_CACHE_LOCKS; l++) {
+        pthread_mutex_lock(&bc_locks[l]);
+        for (uint64_t i = l; i < bc_nslots; i += PW_BIND_CACHE_LOCKS) {
+            pw_bind_cache_scrub(&bc_slots[i], sizeof(pw_bind_cache_slot));
+        }
+        pthread_mutex_unlock(&bc_locks[l]);
+    }
+}
+
+/*
+ * Drop the cached credential of a single entry.
+ */
+void
+pw_bind_cache_invalidate(const Slapi_Backend *be, uint64_t id)
+{
+    if (bc_slots == NULL) {
+        return;
+    }
+    uint64_t idx = pw_bind_cache_slot_index(be, id);
+    pthread_mutex_t *lock = &bc_locks[idx % PW_BIND_CACHE_LOCKS];
+
+    pthread_mutex_lock(lock);
+    if (bc_slots[idx].be == be && bc_slots[idx].id == id) {
+        pw_bind_cache_scrub(&bc_slots[idx], sizeof(pw_bind_cache_slot));
+    }
+    pthread_mutex_unlock(lock);
+}
+
+/*
+ * Called by backends once a modify is committed. A change of the entry's
+ * password invalidates that entry, a change to a password policy entry
+ * invalidates everything as the policy may apply to any cached entry.
+ */
+void
+pw_bind_cache_invalidate_mods(const Slapi_Backend *be, uint64_t id, const Slapi_Entry *e, LDAPMod **mods)
+{
+    Slapi_Value target;
+    int32_t is_policy;
+
+    if (bc_slots == NULL || mods == NULL) {
+        return;
+    }
+    slapi_value_init_string(&target, "passwordpolicy");
+    is_policy = e && slapi_entry_attr_has_syntax_value(e, SLAPI_ATTR_OBJECTCLASS, &target) == 1;
+    value_done(&target);
+    if (is_policy) {
+        pw_bind_cache_flush();
+        return;
+    }
+    for (size_t i = 0; mods[i]; i++) {
+        if (slapi_attr_types_equivalent(mods[i]->mod_type, SLAPI_USERPWD_ATTR) ||
+            slapi_attr_types_equivalent(mods[i]->mod_type, "pwdpolicysubentry")) {
+            pw_bind_cache_invalidate(be, id);
+            return;
+        }
+    }
+}
+
+/*
+ * Same contract as pw_find_sv_ext(): returns 0 if cred matches one of vals,
+ * PW_KDF_POOL_BUSY if the hashing pool refused the comparison, 1 otherwise.
+ * be and id identify the entry that vals belong to.
+ */
+int
+pw_bind_cache_find_sv(const Slapi_Backend *be, uint64_t id, Slapi_Value **vals, const Slapi_Value *cred)
+{
+    unsigned char digest[PW_BIND_CACHE_DIGEST_LEN];
+    pw_bind_cache_slot *slot;
+    pthread_mutex_t *lock;
+    uint64_t generation;
+    uint64_t idx;
+    int32_t hit = 0;
+    time_t now;
+    int rc;
+
+    if (bc_slots == NULL) {
+        return pw_find_sv_ext(vals, cred);
+    }
+
+    generation = slapi_atomic_load_64(&bc_generation, __ATOMIC_ACQUIRE);
+    if (pw_bind_cache_digest(vals, cred, digest) != 0) {
+        return pw_find_sv_ext(vals, cred);
+    }
+
+    now = slapi_current_rel_time_t();
+    idx = pw_bind_cache_slot_index(be, id);
+    slot = &bc_slots[idx];
+    lock = &bc_locks[idx % PW_BIND_CACHE_LOCKS];
+
+    slapi_counter_increment(bc_tries);
+    pthread_mutex_lock(lock);
+    if (slot->be == be && slot->id == id && slot->generation == generation && slot->expire > now) {
+        hit = pw_bind_cache_digest_eq(slot->digest, digest);
+    }
+    pthread_mutex_unlock(lock);
+
+    if (hit) {
+        slapi_counter_increment(bc_hits);
+        pw_bind_cache_scrub(digest, sizeof(digest));
+        return 0;
+    }
+
+    rc = pw_find_sv_ext(vals, cred);
+    if (rc == 0) {
+        int32_t ttl = config_get_pw_bind_cache_ttl();
+        pthread_mutex_lock(lock);
+        if (ttl > 0 && generation == slapi_atomic_load_64(&bc_generation, __ATOMIC_ACQUIRE)) {
+            slot->be = be;
+            slot->id = id;
+            slot->generation = generation;
+            slot->expire = now + ttl;
+            memcpy(slot->digest, digest, sizeof(digest));
+        }
+        pthread_mutex_unlock(lock);
+    }
+    pw_bind_cache_scrub(digest, sizeof(digest));
+    return rc;
+}
+
+/* stats for monitor, returns 0 when the cache is disabled */
+int32_t
+pw_bind_cache_get_stats(uint64_t *hits, uint64_t *tries, uint64_t *slots)
+{
+    if (bc_slots == NULL) {
+        return 0;
+    }
+    *hits = slapi_counter_get_value(bc_hits);
+    *tries = slapi_counter_get_value(bc_tries);
+    *slots = bc_nslots;
+    return 1;
+}
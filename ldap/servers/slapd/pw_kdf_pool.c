@@ -0,0 +1,309 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * pw_kdf_pool.c
+ *
+ * A small, bounded thread pool dedicated to expensive password hashing
+ * (PBKDF2, crypt and yescrypt based schemes).
+ *
+ * Without it, a login storm against accounts using costly schemes keeps
+ * every LDAP worker thread busy in the KDF, and unrelated searches queue
+ * behind the binds. With nsslapd-pwd-kdf-threads set, the hashing runs on
+ * that many dedicated threads instead. The submitting worker sleeps until
+ * its job completes, so at most nsslapd-pwd-kdf-threads cores are spent on
+ * hashing and the remaining workers keep serving other operations.
+ *
+ * The queue is limited to nsslapd-pwd-kdf-queue-depth waiting jobs. When it
+ * is full, the comparisons of the ldbm simple binds are refused with
+ * PW_KDF_POOL_BUSY (the bind returns LDAP_BUSY) rather than tying up more
+ * worker threads. The other comparisons (slapi_pw_find_sv(): password
+ * history, root dn, password modify extop) and password encoding are never
+ * refused: if the queue is full they run inline, as a wrong answer or a
+ * rejected modify would be far more disruptive than a slow one.
+ *
+ * Cheap schemes (clear, salted SHA, MD5) always run inline as the hand off
+ * would cost more than the hash.
+ */
+
+#include "slap.h"
+
+typedef enum {
+    PW_KDF_JOB_CMP,
+    PW_KDF_JOB_ENC,
+} pw_kdf_job_type;
+
+typedef struct pw_kdf_job
+{
+    pw_kdf_job_type type;
+    struct pw_scheme *pwsp;
+    char *userpwd;
+    char *dbpwd;
+    int cmp_rc;
+    char *enc_rc;
+    int32_t done;
+    struct timespec queued;
+    pthread_cond_t done_cv;
+    struct pw_kdf_job *next;
+} pw_kdf_job;
+
+static pthread_mutex_t kdf_lock;
+static pthread_cond_t kdf_work_cv;
+static pw_kdf_job *kdf_head = NULL;
+static pw_kdf_job *kdf_tail = NULL;
+static PRThread **kdf_threads = NULL;
+static int32_t kdf_nthreads = 0;
+static int32_t kdf_shutdown = 0;
+
+/* stats, protected by kdf_lock */
+static uint64_t kdf_queue_len = 0;
+static uint64_t kdf_queue_max = 0;
+static uint64_t kdf_completed = 0;
+static uint64_t kdf_rejected = 0;
+static uint64_t kdf_wait_usec = 0;
+
+static int32_t
+pw_kdf_scheme_is_expensive(struct pw_scheme *pwsp)
+{
+    return PL_strncasecmp(pwsp->pws_name, "PBKDF2", 6) == 0 ||
+           PL_strncasecmp(pwsp->pws_name, "CRYPT", 5) == 0 ||
+           PL_strcasecmp(pwsp->pws_name, "GOST_YESCRYPT") == 0;
+}
+
+static void
+pw_kdf_job_run(pw_kdf_job *job)
+{
+    if (job->type == PW_KDF_JOB_CMP) {
+        job->cmp_rc = (*(job->pwsp->pws_cmp))(job->userpwd, job->dbpwd);
+    } else {
+        job->enc_rc = (*(job->pwsp->pws_enc))(job->userpwd);
+    }
+}
+
+static void
+pw_kdf_pool_thread(void *arg __attribute__((unused)))
+{
+    pw_kdf_job *job;
+    struct timespec now;
+
+    pthread_mutex_lock(&kdf_lock);
+    while (1) {
+        while (kdf_head == NULL && !kdf_shutdown) {
+            pthread_cond_wait(&kdf_work_cv, &kdf_lock);
+        }
+        if (kdf_head == NULL) {
+            /* shutting down and the queue is drained */
+            break;
+        }
+        job = kdf_head;
+        kdf_head = job->next;
+        if (kdf_head == NULL) {
+            kdf_tail = NULL;
+        }
+        kdf_queue_len--;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        kdf_wait_usec += (now.tv_sec - job->queued.tv_sec) * 1000000 +
+                         (now.tv_nsec - job->queued.tv_nsec) / 1000;
+        pthread_mutex_unlock(&kdf_lock);
+
+        pw_kdf_job_run(job);
+
+        pthread_mutex_lock(&kdf_lock);
+        kdf_completed++;
+        job->done = 1;
+        pthread_cond_signal(&job->done_cv);
+    }
+    pthread_mutex_unlock(&kdf_lock);
+}
+
+/*
+ * Queue the job and wait for a pool thread to complete it. Returns 0 once
+ * the job ran (on the pool or inline), or PW_KDF_POOL_BUSY if the queue is
+ * full and the caller asked not to fall back to running inline.
+ */
+static int32_t
+pw_kdf_pool_submit(pw_kdf_job *job, int32_t inline_when_full)
+{
+    int32_t depth = config_get_pw_kdf_queue_depth();
+
+    if (kdf_threads == NULL) {
+        pw_kdf_job_run(job);
+        return 0;
+    }
+
+    job->done = 0;
+    job->next = NULL;
+    pthread_mutex_lock(&kdf_lock);
+    if (kdf_nthreads == 0 || kdf_shutdown) {
+        pthread_mutex_unlock(&kdf_lock);
+        pw_kdf_job_run(job);
+        return 0;
+    }
+    if (kdf_queue_len >= (uint64_t)depth) {
+        if (!inline_when_full) {
+            kdf_rejected++;
+        }
+        pthread_mutex_unlock(&kdf_lock);
+        if (inline_when_full) {
+            pw_kdf_job_run(job);
+            return 0;
+        }
+        return PW_KDF_POOL_BUSY;
+    }
+
+    pthread_cond_init(&job->done_cv, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &job->queued);
+    if (kdf_tail) {
+        kdf_tail->next = job;
+    } else {
+        kdf_head = job;
+    }
+    kdf_tail = job;
+    kdf_queue_len++;
+    if (kdf_queue_len > kdf_queue_max) {
+        kdf_queue_max = kdf_queue_len;
+    }
+    pthread_cond_signal(&kdf_work_cv);
+
+    while (!job->done) {
+        pthread_cond_wait(&job->done_cv, &kdf_lock);
+    }
+    pthread_mutex_unlock(&kdf_lock);
+    pthread_cond_destroy(&job->done_cv);
+
+    return 0;
+}
+
+/*
+ * Run pwsp->pws_cmp(userpwd, dbpwd) and store its result in cmp_rc.
+ * Returns 0, or PW_KDF_POOL_BUSY if the comparison was refused because
+ * the queue is full, in which case cmp_rc is left untouched.
+ */
+int32_t
+pw_kdf_pool_cmp(struct pw_scheme *pwsp, char *userpwd, char *dbpwd, int *cmp_rc)
+{
+    pw_kdf_job job = {0};
+
+    if (!pw_kdf_scheme_is_expensive(pwsp)) {
+        *cmp_rc = (*(pwsp->pws_cmp))(userpwd, dbpwd);
+        return 0;
+    }
+
+    job.type = PW_KDF_JOB_CMP;
+    job.pwsp = pwsp;
+    job.userpwd = userpwd;
+    job.dbpwd = dbpwd;
+    if (pw_kdf_pool_submit(&job, 0) != 0) {
+        return PW_KDF_POOL_BUSY;
+    }
+    *cmp_rc = job.cmp_rc;
+    return 0;
+}
+
+/*
+ * Run pwsp->pws_enc(pwd), returns the malloc'd hashed value or NULL.
+ */
+char *
+pw_kdf_pool_enc(struct pw_scheme *pwsp, char *pwd)
+{
+    pw_kdf_job job = {0};
+
+    if (!pw_kdf_scheme_is_expensive(pwsp)) {
+        return (*(pwsp->pws_enc))(pwd);
+    }
+
+    job.type = PW_KDF_JOB_ENC;
+    job.pwsp = pwsp;
+    job.userpwd = pwd;
+    pw_kdf_pool_submit(&job, 1);
+    return job.enc_rc;
+}
+
+int32_t
+pw_kdf_pool_init(void)
+{
+    int32_t nthreads = config_get_pw_kdf_threads();
+    int32_t rc;
+
+    if (nthreads <= 0) {
+        /* hashing stays on the worker threads */
+        return 0;
+    }
+
+    if ((rc = pthread_mutex_init(&kdf_lock, NULL)) != 0) {
+        slapi_log_err(SLAPI_LOG_ERR, "pw_kdf_pool_init",
+                      "Cannot create new lock.  error %d (%s)\n", rc, strerror(rc));
+        return -1;
+    }
+    if ((rc = pthread_cond_init(&kdf_work_cv, NULL)) != 0) {
+        slapi_log_err(SLAPI_LOG_ERR, "pw_kdf_pool_init",
+                      "Cannot create new condition variable.  error %d (%s)\n", rc, strerror(rc));
+        return -1;
+    }
+
+    kdf_threads = (PRThread **)slapi_ch_calloc(nthreads, sizeof(PRThread *));
+    for (size_t i = 0; i < (size_t)nthreads; i++) {
+        kdf_threads[i] = PR_CreateThread(PR_USER_THREAD,
+                                         (VFP)(void *)pw_kdf_pool_thread, NULL,
+                                         PR_PRIORITY_NORMAL, PR_GLOBAL_THREAD,
+                                         PR_JOINABLE_THREAD,
+                                         SLAPD_DEFAULT_THREAD_STACKSIZE);
+        if (kdf_threads[i] == NULL) {
+            int prerr = PR_GetError();
+            slapi_log_err(SLAPI_LOG_ERR, "pw_kdf_pool_init",
+                          "PR_CreateThread failed, " SLAPI_COMPONENT_NAME_NSPR " error %d (%s)\n",
+                          prerr, slapd_pr_strerror(prerr));
+            break;
+        }
+        kdf_nthreads++;
+    }
+
+    slapi_log_err(SLAPI_LOG_INFO, "pw_kdf_pool_init",
+                  "Password hashing offloaded to %d threads\n", kdf_nthreads);
+    return 0;
+}
+
+void
+pw_kdf_pool_destroy(void)
+{
+    if (kdf_threads == NULL) {
+        return;
+    }
+
+    pthread_mutex_lock(&kdf_lock);
+    kdf_shutdown = 1;
+    pthread_cond_broadcast(&kdf_work_cv);
+    pthread_mutex_unlock(&kdf_lock);
+
+    for (size_t i = 0; i < (size_t)kdf_nthreads; i++) {
+        PR_JoinThread(kdf_threads[i]);
+    }
+    slapi_ch_free((void **)&kdf_threads);
+    kdf_nthreads = 0;
+}
+
+/* stats for monitor, returns 0 when the pool is disabled */
+int32_t
+pw_kdf_pool_get_stats(uint64_t *queue, uint64_t *queue_max, uint64_t *completed, uint64_t *rejected, uint64_t *wait_usec)
+{
+    if (kdf_threads == NULL) {
+        return 0;
+    }
+    pthread_mutex_lock(&kdf_lock);
+    *queue = kdf_queue_len;
+    *queue_max = kdf_queue_max;
+    *completed = kdf_completed;
+    *rejected = kdf_rejected;
+    *wait_usec = kdf_wait_usec;
+    pthread_mutex_unlock(&kdf_lock);
+    return 1;
+}
@@ -785,9 +785,9 @@ slapi_filter_schema_check(Slapi_PBlock *pb, Slapi_Filter *f, Slapi_Filter_Policy
      * Filters are nested, recursive structures, so we actually have to call an inner
      * function until we have a result!
      */
-    attr_syntax_read_lock();
+    attr_syntax_pin();
     Slapi_Filter_Result r = slapi_filter_schema_check_inner(f, flags);
-    attr_syntax_unlock_read();
+    attr_syntax_unpin();
 
     /* If any warning occured, ensure we fail it. */
     if (fp == FILTER_POLICY_STRICT && r != FILTER_SCHEMA_SUCCESS) {
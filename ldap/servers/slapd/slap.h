@@ -307,6 +307,15 @@ typedef void (*VFPV)(); /* takes undefined arguments */
 #define SLAPD_DEFAULT_NDN_SIZE     20971520
 #define SLAPD_DEFAULT_NDN_SIZE_STR "20971520"
 
+#define SLAPD_DEFAULT_PW_BIND_CACHE_SIZE     0
+#define SLAPD_DEFAULT_PW_BIND_CACHE_SIZE_STR "0"
+#define SLAPD_DEFAULT_PW_BIND_CACHE_TTL      300
+#define SLAPD_DEFAULT_PW_BIND_CACHE_TTL_STR  "300"
+#define SLAPD_DEFAULT_PW_KDF_THREADS         0
+#define SLAPD_DEFAULT_PW_KDF_THREADS_STR     "0"
+#define SLAPD_DEFAULT_PW_KDF_QUEUE_DEPTH     128
+#define SLAPD_DEFAULT_PW_KDF_QUEUE_DEPTH_STR "128"
+
 #define SLAPD_DEFAULT_DIRECTORY_MANAGER "cn=Directory Manager"
 #define SLAPD_DEFAULT_UIDNUM_TYPE       "uidNumber"
 #define SLAPD_DEFAULT_GIDNUM_TYPE       "gidNumber"
@@ -538,9 +547,11 @@ struct subfilt
     char *sf_initial;
     char **sf_any;
     char *sf_final;
-    void *sf_private; /* data private to syntax handler */
+    void *sf_private; /* data private to syntax handler (Slapi_Substr) */
 };
 
+typedef struct slapi_substr Slapi_Substr; /* compiled substring assertion - see substrmatch.c */
+
 #include "filter.h" /* mr_filter_t */
 
 #include "haproxy.h"
@@ -614,6 +625,7 @@ struct slapi_value
     struct berval bv;
     CSNSet *v_csnset;
     unsigned long v_flags;
+    struct slapi_value_norm *v_norm; /* cached normalized forms, see value.c */
 };
 
 /*
@@ -645,6 +657,7 @@ struct slapi_value_set
     size_t num;     /* The number of values in the array */
     size_t max;     /* The number of slots in the array */
     size_t *sorted; /* sorted array of indices, if NULL va is not sorted */
+    struct slapi_valueset_hash *hash; /* hash index of large valuesets, replaces sorted (see valueset.c) */
     struct slapi_value **va;
 };
 
@@ -678,6 +691,7 @@ struct slapi_attr
     struct slapdplugin *a_mr_eq_plugin;  /* for the attribute EQUALITY matching rule, if any */
     struct slapdplugin *a_mr_ord_plugin; /* for the attribute ORDERING matching rule, if any */
     struct slapdplugin *a_mr_sub_plugin; /* for the attribute SUBSTRING matching rule, if any */
+    uint32_t a_atom;                     /* atom of a_type, 0 if it is not interned (see attratom.c) */
 };
 
 typedef struct oid_item
@@ -712,11 +726,10 @@ typedef struct asyntaxinfo
     char *asi_syntax_oid;                  /* syntax oid */
     unsigned long asi_flags;               /* SLAPI_ATTR_FLAG_... */
     int asi_syntaxlength;                  /* length associated w/syntax */
-    uint64_t asi_refcnt;                   /* outstanding references */
-    PRBool asi_marked_for_delete;          /* delete at next opportunity */
     struct slapdplugin *asi_mr_eq_plugin;  /* EQUALITY matching rule plugin */
     struct slapdplugin *asi_mr_sub_plugin; /* SUBSTR matching rule plugin */
     struct slapdplugin *asi_mr_ord_plugin; /* ORDERING matching rule plugin */
+    uint32_t asi_atom;                     /* atom of asi_name */
     struct asyntaxinfo *asi_next;
     struct asyntaxinfo *asi_prev;
 } asyntaxinfo;
@@ -1940,6 +1953,9 @@ void slapi_pblock_set_pwdpolicy(Slapi_PBlock *pb, passwdPolicy *pwdpolicy);
 int32_t slapi_pblock_get_ldif_dump_replica(Slapi_PBlock *pb);
 void slapi_pblock_set_ldif_dump_replica(Slapi_PBlock *pb, int32_t dump_replica);
 
+char *slapi_pblock_get_backup_base(Slapi_PBlock *pb);
+void slapi_pblock_set_backup_base(Slapi_PBlock *pb, char *backup_base);
+
 void *slapi_pblock_get_vattr_context(Slapi_PBlock *pb);
 void slapi_pblock_set_vattr_context(Slapi_PBlock *pb, void *vattr_ctx);
 
@@ -2402,12 +2418,17 @@ typedef struct _slapdEntryPoints
 #define CONFIG_DISK_LOGGING_CRITICAL "nsslapd-disk-monitoring-logging-critical"
 #define CONFIG_NDN_CACHE "nsslapd-ndn-cache-enabled"
 #define CONFIG_NDN_CACHE_SIZE "nsslapd-ndn-cache-max-size"
+#define CONFIG_PW_BIND_CACHE_SIZE "nsslapd-pwd-bind-cache-size"
+#define CONFIG_PW_BIND_CACHE_TTL "nsslapd-pwd-bind-cache-ttl"
+#define CONFIG_PW_KDF_THREADS "nsslapd-pwd-kdf-threads"
+#define CONFIG_PW_KDF_QUEUE_DEPTH "nsslapd-pwd-kdf-queue-depth"
 #define CONFIG_ALLOWED_SASL_MECHS "nsslapd-allowed-sasl-mechanisms"
 #define CONFIG_IGNORE_VATTRS "nsslapd-ignore-virtual-attrs"
 #define CONFIG_SASL_MAPPING_FALLBACK "nsslapd-sasl-mapping-fallback"
 #define CONFIG_SASL_MAXBUFSIZE "nsslapd-sasl-max-buffer-size"
 #define CONFIG_SEARCH_RETURN_ORIGINAL_TYPE "nsslapd-search-return-original-type-switch"
 #define CONFIG_ENABLE_TURBO_MODE "nsslapd-enable-turbo-mode"
+#define CONFIG_NUMA "nsslapd-numa"
 #define CONFIG_CONNECTION_BUFFER "nsslapd-connection-buffer"
 #define CONFIG_CONNECTION_NOCANON "nsslapd-connection-nocanon"
 #define CONFIG_PLUGIN_LOGGING "nsslapd-plugin-logging"
@@ -2739,11 +2760,20 @@ typedef struct _slapdFrontendConfig
     slapi_onoff_t ndn_cache_enabled;
     uint64_t ndn_cache_max_size;
 
+    /* verified bind credential cache */
+    int32_t pw_bind_cache_size;
+    int32_t pw_bind_cache_ttl;
+
+    /* password hashing thread pool */
+    int32_t pw_kdf_threads;
+    int32_t pw_kdf_queue_depth;
+
     slapi_onoff_t return_orig_type; /* if on, search returns original type set in attr list */
     slapi_onoff_t sasl_mapping_fallback;
     slapi_onoff_t ignore_vattrs;
     slapi_onoff_t unhashed_pw_switch; /* switch to on/off/nolog unhashed pw */
     slapi_onoff_t enable_turbo_mode;
+    slapi_onoff_t numa;               /* bind connection lists and workers to NUMA nodes */
     slapi_int_t connection_buffer;    /* values are CONNECTION_BUFFER_* below */
     slapi_onoff_t connection_nocanon; /* if "on" sets LDAP_OPT_X_SASL_NOCANON */
     slapi_onoff_t plugin_logging;     /* log all internal plugin operations */
@@ -2336,6 +2336,18 @@ int slapi_entry_apply_mod_extension(Slapi_Entry *e, const LDAPMod *mod, int modc
  */
 void slapi_entrycache_vattrcache_watermark_invalidate(void);
 
+/**
+ * Get the current virtual attribute cache watermark.
+ *
+ * The watermark changes each time the whole virtual attribute cache is
+ * invalidated, so a service provider caching computed values outside of
+ * the entries may store it with them and check it is unchanged before
+ * using them.
+ *
+ * \return The current watermark.
+ */
+int32_t slapi_entrycache_vattrcache_watermark_get(void);
+
 
 /*
  * Slapi_DN routines
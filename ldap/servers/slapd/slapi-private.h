@@ -326,6 +326,12 @@ int is_type_protected(const char *type);
 int entry_apply_mods_ignore_error(Slapi_Entry *e, LDAPMod **mods, int ignore_error);
 int slapi_entries_diff(Slapi_Entry **old_entries, Slapi_Entry **new_entries, int testall, const char *logging_prestr, const int force_update, void *plg_id);
 void set_attr_to_protected_list(char *attr, int flag);
+char *slapi_entry2bin(Slapi_Entry *e, int *len);
+int slapi_entry_is_bin(const char *s, size_t size);
+int slapi_entry_bin_get_value(const char *s, size_t size, const char *type, char **value);
+int slapi_entry_bin_get_values(const char *s, size_t size, const char *type, char ***valuearray, size_t maxvals);
+char *slapi_entry_bin_to_str(const char *s, size_t size, size_t *len);
+Slapi_Entry *slapi_record2entry(const char *normdn, const Slapi_RDN *srdn, char *s, size_t size, int flags);
 
 /* entrywsi.c */
 int32_t entry_assign_operation_csn(Slapi_PBlock *pb, Slapi_Entry *e, Slapi_Entry *parententry, CSN **opcsn);
@@ -366,6 +372,11 @@ const CSNSet *value_get_csnset(const Slapi_Value *value);
 Slapi_Value *value_remove_csn(Slapi_Value *value, CSNType t);
 int value_contains_csn(const Slapi_Value *value, CSN *csn);
 int value_dn_normalize_value(Slapi_Value *value);
+int value_cache_normalized(const Slapi_Value *v);
+const struct berval *value_get_normalized(const Slapi_Value *v, int syntax);
+const struct berval *value_set_normalized(Slapi_Value *v, int syntax, char *norm);
+void value_free_normalized(Slapi_Value *v);
+size_t value_normalized_uncharged(void);
 
 /* dn.c */
 /* this functions should only be used for dns allocated on the stack */
@@ -744,6 +755,7 @@ void slapi_mtn_be_started(Slapi_Backend *be);
 void slapi_mtn_be_disable(Slapi_Backend *be);
 void slapi_mtn_be_enable(Slapi_Backend *be);
 const char *slapi_mtn_get_backend_name(const Slapi_DN *sdn);
+char *mapping_tree_index_check(char **suffixes, const char *dn);
 
 void slapi_be_stopping(Slapi_Backend *be);
 void slapi_be_free(Slapi_Backend **be);
@@ -854,6 +866,22 @@ int pw_rever_encode(Slapi_Value **vals, char *attr_name);
 int pw_rever_decode(char *cipher, char **plain, const char *attr_name);
 
 int32_t update_pw_encoding(Slapi_PBlock *orig_pb, Slapi_Entry *e, Slapi_DN *sdn, char *cleartextpassword);
+int pw_find_sv_ext(Slapi_Value **vals, const Slapi_Value *v);
+
+/* pw_bind_cache.c */
+int32_t pw_bind_cache_init(void);
+void pw_bind_cache_destroy(void);
+void pw_bind_cache_flush(void);
+void pw_bind_cache_invalidate(const Slapi_Backend *be, uint64_t id);
+void pw_bind_cache_invalidate_mods(const Slapi_Backend *be, uint64_t id, const Slapi_Entry *e, LDAPMod **mods);
+int pw_bind_cache_find_sv(const Slapi_Backend *be, uint64_t id, Slapi_Value **vals, const Slapi_Value *cred);
+int32_t pw_bind_cache_get_stats(uint64_t *hits, uint64_t *tries, uint64_t *slots);
+
+/* pw_kdf_pool.c */
+#define PW_KDF_POOL_BUSY -1
+int32_t pw_kdf_pool_init(void);
+void pw_kdf_pool_destroy(void);
+int32_t pw_kdf_pool_get_stats(uint64_t *queue, uint64_t *queue_max, uint64_t *completed, uint64_t *rejected, uint64_t *wait_usec);
 
 
 /* config routines */
@@ -0,0 +1,263 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#ifdef HAVE_CONFIG_H
+#include <config.h>
+#endif
+
+/*
+ * substrmatch.c - substring filter assertion matching
+ *
+ * A substring assertion (initial*any*...*final) used to be tested by
+ * building the equivalent regular expression ^initial.*any.*final$ and
+ * running pcre against every normalized value.  The assertion is now
+ * compiled once into a Slapi_Substr holding its (normalized) components
+ * and a value matches if it starts with initial, ends with final and
+ * contains the any components in order in between.  memmem() finds the
+ * any components (glibc uses a vectorized two-way search).
+ *
+ * In pcre "." does not match a newline so the regex did not let the
+ * components of a match span several lines.  Values containing a newline
+ * are rare, they are still tested against the regex to keep that behavior.
+ *
+ * A Slapi_Substr is never modified once built, so it may be shared by
+ * threads testing the same filter (acis, persistent searches).
+ */
+
+#include "slap.h"
+
+struct slapi_substr
+{
+    char *ss_initial;
+    size_t ss_initial_len;
+    char **ss_any;
+    size_t *ss_any_len;
+    char *ss_final;
+    size_t ss_final_len;
+    size_t ss_min_len; /* shortest value that can match */
+};
+
+/*
+ * Build a matcher for a substring assertion.  The components are copied
+ * and must already be normalized.
+ */
+Slapi_Substr *
+substr_match_new(const char *initial, char **any, const char *final)
+{
+    Slapi_Substr *ss = (Slapi_Substr *)slapi_ch_calloc(1, sizeof(Slapi_Substr));
+    size_t nb = 0;
+
+    if (initial) {
+        ss->ss_initial = slapi_ch_strdup(initial);
+        ss->ss_initial_len = strlen(initial);
+        ss->ss_min_len += ss->ss_initial_len;
+    }
+    while (any && any[nb]) {
+        nb++;
+    }
+    if (nb) {
+        ss->ss_any = (char **)slapi_ch_calloc(nb + 1, sizeof(char *));
+        ss->ss_any_len = (size_t *)slapi_ch_calloc(nb, sizeof(size_t));
+        for (size_t i = 0; i < nb; i++) {
+            ss->ss_any[i] = slapi_ch_strdup(any[i]);
+            ss->ss_any_len[i] = strlen(any[i]);
+            ss->ss_min_len += ss->ss_any_len[i];
+        }
+    }
+    if (final) {
+        ss->ss_final = slapi_ch_strdup(final);
+        ss->ss_final_len = strlen(final);
+        ss->ss_min_len += ss->ss_final_len;
+    }
+    return ss;
+}
+
+void
+substr_match_free(Slapi_Substr **ss)
+{
+    if (ss == NULL || *ss == NULL) {
+        return;
+    }
+    slapi_ch_free_string(&(*ss)->ss_initial);
+    charray_free((*ss)->ss_any);
+    slapi_ch_free((void **)&(*ss)->ss_any_len);
+    slapi_ch_free_string(&(*ss)->ss_final);
+    slapi_ch_free((void **)ss);
+}
+
+/* Test a value containing a newline with the ^initial.*any.*final$ regex */
+static int
+substr_match_regex(const Slapi_Substr *ss, const char *value)
+{
+    size_t size = 1;
+    char *pat = NULL;
+    char *p = NULL;
+    Slapi_Regex *re = NULL;
+    char *re_result = NULL;
+    int rc;
+
+    size += ss->ss_min_len * 2; /* doubled in case all chars need escaping */
+    for (size_t i = 0; ss->ss_any && ss->ss_any[i]; i++) {
+        size += 2; /* ".*" */
+    }
+    size += 4; /* "^", ".*" and "$" */
+    p = pat = slapi_ch_malloc(size);
+    *p = '\0';
+    if (ss->ss_initial) {
+        *p++ = '^';
+        p = filter_strcpy_special_ext(p, ss->ss_initial, FILTER_STRCPY_ESCAPE_RECHARS);
+    }
+    for (size_t i = 0; ss->ss_any && ss->ss_any[i]; i++) {
+        *p++ = '.';
+        *p++ = '*';
+        p = filter_strcpy_special_ext(p, ss->ss_any[i], FILTER_STRCPY_ESCAPE_RECHARS);
+    }
+    if (ss->ss_final) {
+        *p++ = '.';
+        *p++ = '*';
+        p = filter_strcpy_special_ext(p, ss->ss_final, FILTER_STRCPY_ESCAPE_RECHARS);
+        strcpy(p, "$");
+    }
+
+    re = slapi_re_comp(pat, &re_result);
+    if (NULL == re) {
+        slapi_log_err(SLAPI_LOG_ERR, "substr_match_regex", "re_comp (%s) failed: %s\n",
+                      pat, re_result ? re_result : "unknown");
+        slapi_ch_free_string(&re_result);
+        slapi_ch_free_string(&pat);
+        return LDAP_OPERATIONS_ERROR;
+    }
+    rc = slapi_re_exec_nt(re, value);
+    slapi_re_free(re);
+    slapi_ch_free_string(&pat);
+    return rc;
+}
+
+/*
+ * Test a normalized value against the assertion.
+ * Returns 1 if the value matches, 0 if it does not and an LDAP error code
+ * if the value could not be tested.
+ */
+int
+substr_match_exec(const Slapi_Substr *ss, const char *value)
+{
+    size_t len = strlen(value);
+    const char *p = value;
+    const char *end = value + len;
+
+    if (len < ss->ss_min_len) {
+        return 0;
+    }
+    if (memchr(value, '\n', len)) {
+        return substr_match_regex(ss, value);
+    }
+    if (ss->ss_initial) {
+        if (memcmp(p, ss->ss_initial, ss->ss_initial_len) != 0) {
+            return 0;
+        }
+        p += ss->ss_initial_len;
+    }
+    if (ss->ss_final) {
+        end -= ss->ss_final_len;
+        if (end < p || memcmp(end, ss->ss_final, ss->ss_final_len) != 0) {
+            return 0;
+        }
+    }
+    /* The leftmost occurrence of each any component leaves the most room to the next ones */
+    for (size_t i = 0; ss->ss_any && ss->ss_any[i]; i++) {
+        const char *found = memmem(p, end - p, ss->ss_any[i], ss->ss_any_len[i]);
+        if (found == NULL) {
+            return 0;
+        }
+        p = found + ss->ss_any_len[i];
+    }
+    return 1;
+}
+
+static Slapi_Substr *
+substr_match_new_normalize(struct subfilt *sf)
+{
+    Slapi_Substr *ss = NULL;
+    Slapi_Attr attr;
+    char *initial = NULL;
+    char **any = NULL;
+    char *final = NULL;
+    char *newval = NULL;
+
+    /* Same normalization as filter_normalize_subfilt(), on copies */
+    slapi_attr_init(&attr, sf->sf_type);
+    if (sf->sf_initial) {
+        initial = slapi_ch_strdup(sf->sf_initial);
+        slapi_attr_value_normalize_ext(NULL, &attr, NULL, initial, 1, &newval, LDAP_FILTER_SUBSTRINGS);
+        if (newval && newval != initial) {
+            slapi_ch_free_string(&initial);
+            initial = newval;
+        }
+    }
+    any = charray_dup(sf->sf_any);
+    for (size_t i = 0; any && any[i]; i++) {
+        newval = NULL;
+        slapi_attr_value_normalize_ext(NULL, &attr, NULL, any[i], 0, &newval, LDAP_FILTER_SUBSTRINGS);
+        if (newval && newval != any[i]) {
+            slapi_ch_free_string(&any[i]);
+            any[i] = newval;
+        }
+    }
+    if (sf->sf_final) {
+        newval = NULL;
+        final = slapi_ch_strdup(sf->sf_final);
+        slapi_attr_value_normalize_ext(NULL, &attr, NULL, final, 0, &newval, LDAP_FILTER_SUBSTRINGS);
+        if (newval && newval != final) {
+            slapi_ch_free_string(&final);
+            final = newval;
+        }
+    }
+    attr_done(&attr);
+
+    ss = substr_match_new(initial, any, final);
+    slapi_ch_free_string(&initial);
+    charray_free(any);
+    slapi_ch_free_string(&final);
+    return ss;
+}
+
+/*
+ * Attach a matcher to every substring component of a long lived filter
+ * (aci targetfilter, persistent search filter) so that testing entries
+ * against it does not normalize the assertion again for each entry.
+ * Must be called before the filter is shared between threads.
+ */
+void
+filter_compile_substrings(struct slapi_filter *f)
+{
+    struct slapi_filter *fl;
+
+    if (f == NULL) {
+        return;
+    }
+    switch (f->f_choice) {
+    case LDAP_FILTER_SUBSTRINGS:
+        if (f->f_sub.sf_private == NULL) {
+            if (f->f_flags & SLAPI_FILTER_NORMALIZED_VALUE) {
+                f->f_sub.sf_private = substr_match_new(f->f_sub_initial, f->f_sub_any, f->f_sub_final);
+            } else {
+                f->f_sub.sf_private = substr_match_new_normalize(&f->f_sub);
+            }
+        }
+        break;
+    case LDAP_FILTER_AND:
+    case LDAP_FILTER_OR:
+    case LDAP_FILTER_NOT:
+        for (fl = f->f_list; fl != NULL; fl = fl->f_next) {
+            filter_compile_substrings(fl);
+        }
+        break;
+    default:
+        break;
+    }
+}
@@ -1536,6 +1536,8 @@ task_backup_thread(void *arg)
     char *seq_val = NULL;
     slapi_pblock_get(pb, SLAPI_SEQ_VAL, &seq_val);
     slapi_ch_free((void **)&seq_val);
+    char *backup_base = slapi_pblock_get_backup_base(pb);
+    slapi_ch_free_string(&backup_base);
     slapi_pblock_destroy(pb);
     g_decr_active_threadcnt();
 }
@@ -1551,6 +1553,7 @@ task_backup_add(Slapi_PBlock *pb __attribute__((unused)),
     Slapi_Backend *be = NULL;
     PRThread *thread = NULL;
     const char *archive_dir = NULL;
+    const char *backup_base = NULL;
     const char *my_database_type = NULL;
     const char *database_type = "ldbm database";
     char *cookie = NULL;
@@ -1627,6 +1630,10 @@ task_backup_add(Slapi_PBlock *pb __attribute__((unused)),
     slapi_pblock_set(mypb, SLAPI_BACKEND_TASK, task);
     int32_t task_flags = SLAPI_TASK_RUNNING_AS_TASK;
     slapi_pblock_set(mypb, SLAPI_TASK_FLAGS, &task_flags);
+    /* incremental backup: only backup what changed since this backup */
+    if ((backup_base = slapi_entry_attr_get_ref(e, "nsBackupBaseDir")) != NULL) {
+        slapi_pblock_set_backup_base(mypb, slapi_ch_strdup(backup_base));
+    }
 
     /* start the backup as a separate thread */
     thread = PR_CreateThread(PR_USER_THREAD, task_backup_thread,
@@ -1638,6 +1645,8 @@ task_backup_add(Slapi_PBlock *pb __attribute__((unused)),
         *returncode = LDAP_OPERATIONS_ERROR;
         rv = SLAPI_DSE_CALLBACK_ERROR;
         slapi_ch_free((void **)&seq_val);
+        char *base_copy = slapi_pblock_get_backup_base(mypb);
+        slapi_ch_free_string(&base_copy);
         slapi_pblock_destroy(mypb);
         goto out;
     }
@@ -116,6 +116,9 @@ int dblayer_txn_commit(backend *be, back_txn *txn);
 int dblayer_txn_abort(backend *be, back_txn *txn);
 void dblayer_init_pvt_txn(void);
 void entryrdn_decode_data(backend *be, void *rdn_elem, ID *id, int *nrdnlen, char **nrdn, int *rdnlen, char **rdn);
+int id2entry_decompress_with_suffix(const char *suffix, const char *data, uint32_t size, char **plain, uint32_t *plainsize);
+int slapi_entry_is_bin(const char *s, size_t size);
+char *slapi_entry_bin_to_str(const char *s, size_t size, size_t *len);
 
 #define RDN_BULK_FETCH_BUFFER_SIZE (8 * 1024)
 
@@ -135,6 +138,7 @@ long allids_cnt = 0;
 long other_cnt = 0;
 char *dump_filename = NULL;
 int do_it = 0;
+char *entry_suffix = NULL; /* normalized suffix, to inflate compressed entries */
 
 static Slapi_Backend *be = NULL; /* Pseudo backend used to interact with db */
 
@@ -143,12 +147,14 @@ enum {
     OPT_FIRST = 0x1000,
     OPT_DO_IT,
     OPT_REMOVE,
+    OPT_SUFFIX,
 };
 
 static const struct option options[] = {
     /* Options without shortcut */
     { "do-it", no_argument, 0, OPT_DO_IT },
     { "remove", no_argument, 0, OPT_REMOVE },
+    { "suffix", required_argument, 0, OPT_SUFFIX },
     /* Options with shortcut */
     { "import", required_argument, 0, 'I' },
     { "export", required_argument, 0, 'X' },
@@ -318,10 +324,42 @@ format(unsigned char *s, int len, unsigned char *buf, int buflen)
     return format_raw(s, len, 0, buf, buflen);
 }
 
+/*
+ * An id2entry record may be compressed ("\0EZ") and may hold the entry in
+ * the binary format ("\0EB"): both are displayed as the text form.
+ */
 static char *
 format_entry(unsigned char *s, int len, unsigned char *buf, int buflen)
 {
-    return format_raw(s, len, FMT_LF_OK | FMT_SP_OK, buf, buflen);
+    char *plain = NULL;
+    uint32_t plainlen = 0;
+    char *text = NULL;
+    size_t textlen = 0;
+    char *formatted;
+
+    if (len > 3 && s[0] == '\0' && s[1] == 'E' && s[2] == 'Z') {
+        if (id2entry_decompress_with_suffix(entry_suffix, (const char *)s, (uint32_t)len, &plain, &plainlen) <= 0) {
+            snprintf((char *)buf, buflen, "[compressed entry: %s]",
+                     entry_suffix ? "can not be inflated, check --suffix" : "use --suffix to inflate it");
+            return (char *)buf;
+        }
+        s = (unsigned char *)plain;
+        len = (int)plainlen;
+    }
+    if (slapi_entry_is_bin((const char *)s, (size_t)len)) {
+        text = slapi_entry_bin_to_str((const char *)s, (size_t)len, &textlen);
+        if (text == NULL) {
+            snprintf((char *)buf, buflen, "[truncated or corrupted binary entry]");
+            slapi_ch_free_string(&plain);
+            return (char *)buf;
+        }
+        s = (unsigned char *)text;
+        len = (int)textlen;
+    }
+    formatted = format_raw(s, len, FMT_LF_OK | FMT_SP_OK, buf, buflen);
+    slapi_ch_free_string(&plain);
+    slapi_ch_free_string(&text);
+    return formatted;
 }
 
 static char *
@@ -976,6 +1014,7 @@ usage(char *argv0, int error)
 
     printf("  entry file options:\n");
     printf("    -K, --entry-id <entry_id>      lookup only a specific entry id\n");
+    printf("    --suffix <suffix>              suffix of the backend, needed to display compressed entries\n");
 
     printf("  index file options:\n");
     printf("    -G, --id-list-min-size <n>     only display index entries with more than <n> ids\n");
@@ -1386,6 +1425,13 @@ main(int argc, char **argv)
         case OPT_REMOVE:
             display_mode |= REMOVE;
             break;
+        case OPT_SUFFIX: {
+            /* the compression dictionary holds the normalized suffix */
+            Slapi_DN *sdn = slapi_sdn_new_dn_byval(optarg);
+            entry_suffix = slapi_ch_strdup(slapi_sdn_get_ndn(sdn));
+            slapi_sdn_free(&sdn);
+            break;
+        }
         case 'A':
             display_mode |= ASCIIDATA;
             break;
@@ -74,6 +74,62 @@ static void value_dump(const Slapi_Value *value, const char *text);
 #define VALUE_DUMP(value, name) ((void)0)
 #endif
 
+/*
+ * Normalized forms of a value.
+ *
+ * Filter tests, valueset lookups and index key generation used to
+ * normalize (case fold, trim spaces, ...) the same stored value again for
+ * each comparison.  The syntax plugins now cache the normalized form of a
+ * value in the value itself the first time they compute it.  As the
+ * normalization depends on the syntax doing the matching (an attribute may
+ * be matched with several matching rules), each cached form is tagged with
+ * the syntax flags that produced it.
+ *
+ * Values of cached entries are read by many threads, so a form is only
+ * ever pushed on the list with an atomic compare and swap and is never
+ * changed until the value itself is changed or freed.
+ *
+ * Only the values allocated by value_new() cache their normalized forms:
+ * their list ends with value_norm_end.  Values built on the stack or by
+ * hand have a NULL list, they are often not released with value_done().
+ */
+struct slapi_value_norm
+{
+    struct slapi_value_norm *vn_next;
+    int vn_syntax;
+    struct berval vn_bv;
+};
+
+static struct slapi_value_norm value_norm_end;
+
+/*
+ * The forms are attached after the entry cache sized the entry.  Each
+ * thread counts the bytes of the forms it attached, the entry cache
+ * charges them to the entry when the thread returns it (see
+ * value_normalized_uncharged()).
+ */
+static PRUintn value_norm_bytes_idx;
+static PRCallOnceType value_norm_bytes_once;
+
+static PRStatus
+value_norm_bytes_init(void)
+{
+    return PR_NewThreadPrivateIndex(&value_norm_bytes_idx, NULL);
+}
+
+static size_t
+value_norm_bytes_swap(size_t bytes)
+{
+    size_t old;
+
+    if (PR_CallOnce(&value_norm_bytes_once, value_norm_bytes_init) != PR_SUCCESS) {
+        return 0;
+    }
+    old = (size_t)(uintptr_t)PR_GetThreadPrivate(value_norm_bytes_idx);
+    PR_SetThreadPrivate(value_norm_bytes_idx, (void *)(uintptr_t)bytes);
+    return old;
+}
+
 static int counters_created = 0;
 PR_DEFINE_COUNTER(slapi_value_counter_created);
 PR_DEFINE_COUNTER(slapi_value_counter_deleted);
@@ -145,8 +201,14 @@ Slapi_Value *
 slapi_value_dup(const Slapi_Value *v)
 {
     Slapi_Value *newvalue = value_new(&v->bv, CSN_TYPE_UNKNOWN, NULL);
+    struct slapi_value_norm *vn;
+
     newvalue->v_csnset = csnset_dup(v->v_csnset);
     newvalue->v_flags = v->v_flags;
+    /* Entries are duplicated for each modify, keep the forms already computed */
+    for (vn = __atomic_load_n(&v->v_norm, __ATOMIC_ACQUIRE); vn && vn != &value_norm_end; vn = vn->vn_next) {
+        value_set_normalized(newvalue, vn->vn_syntax, slapi_ch_strdup(vn->vn_bv.bv_val));
+    }
     return newvalue;
 }
 
@@ -156,6 +218,7 @@ value_new(const struct berval *bval, CSNType t, const CSN *csn)
     Slapi_Value *v;
     v = (Slapi_Value *)slapi_ch_malloc(sizeof(Slapi_Value));
     value_init(v, bval, t, csn);
+    v->v_norm = &value_norm_end;
     if (!counters_created) {
         PR_CREATE_COUNTER(slapi_value_counter_created, "Slapi_Value", "created", "");
         PR_CREATE_COUNTER(slapi_value_counter_deleted, "Slapi_Value", "deleted", "");
@@ -224,10 +287,97 @@ value_done(Slapi_Value *v)
         if (NULL != v->v_csnset) {
             csnset_free(&(v->v_csnset));
         }
+        value_free_normalized(v);
         ber_bvdone(&v->bv);
     }
 }
 
+/* Can the normalized forms of the value be cached in the value */
+int
+value_cache_normalized(const Slapi_Value *v)
+{
+    return v->v_norm != NULL;
+}
+
+/*
+ * Return the cached normalized form of the value for a syntax,
+ * NULL if it was not computed yet.
+ */
+const struct berval *
+value_get_normalized(const Slapi_Value *v, int syntax)
+{
+    struct slapi_value_norm *vn;
+
+    for (vn = __atomic_load_n(&v->v_norm, __ATOMIC_ACQUIRE); vn && vn != &value_norm_end; vn = vn->vn_next) {
+        if (vn->vn_syntax == syntax) {
+            return &vn->vn_bv;
+        }
+    }
+    return NULL;
+}
+
+/*
+ * Cache the normalized form (passed in) of the value for a syntax and
+ * return the cached form.  If another thread cached it first, norm is
+ * freed and the form of the other thread is returned.
+ * The value must be able to cache it (see value_cache_normalized()).
+ */
+const struct berval *
+value_set_normalized(Slapi_Value *v, int syntax, char *norm)
+{
+    struct slapi_value_norm *vn = (struct slapi_value_norm *)slapi_ch_malloc(sizeof(struct slapi_value_norm));
+    struct slapi_value_norm *head = __atomic_load_n(&v->v_norm, __ATOMIC_ACQUIRE);
+    struct slapi_value_norm *p;
+
+    PR_ASSERT(head != NULL);
+    vn->vn_syntax = syntax;
+    vn->vn_bv.bv_val = norm;
+    vn->vn_bv.bv_len = strlen(norm);
+    do {
+        for (p = head; p != &value_norm_end; p = p->vn_next) {
+            if (p->vn_syntax == syntax) {
+                slapi_ch_free_string(&vn->vn_bv.bv_val);
+                slapi_ch_free((void **)&vn);
+                return &p->vn_bv;
+            }
+        }
+        vn->vn_next = head;
+    } while (!__atomic_compare_exchange_n(&v->v_norm, &head, vn, 0, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE));
+    value_norm_bytes_swap(value_norm_bytes_swap(0) + sizeof(struct slapi_value_norm) + vn->vn_bv.bv_len + 1);
+    return &vn->vn_bv;
+}
+
+/*
+ * Return the bytes of the normalized forms cached by the calling thread
+ * since the last call, and reset the count.  The entry cache adds them to
+ * the size of the entry the thread returns, and discards them when it
+ * computes the size of an entry (the forms are then counted by
+ * value_size()).
+ */
+size_t
+value_normalized_uncharged(void)
+{
+    return value_norm_bytes_swap(0);
+}
+
+/* Drop the cached normalized forms, the value must not be shared */
+void
+value_free_normalized(Slapi_Value *v)
+{
+    struct slapi_value_norm *vn = v->v_norm;
+
+    if (vn == NULL) {
+        return;
+    }
+    while (vn != &value_norm_end) {
+        struct slapi_value_norm *next = vn->vn_next;
+        slapi_ch_free_string(&vn->vn_bv.bv_val);
+        slapi_ch_free((void **)&vn);
+        vn = next;
+    }
+    v->v_norm = &value_norm_end;
+}
+
 const CSNSet *
 value_get_csnset(const Slapi_Value *value)
 {
@@ -317,6 +467,7 @@ Slapi_Value *
 slapi_value_set_berval(Slapi_Value *value, const struct berval *bval)
 {
     if (value != NULL) {
+        value_free_normalized(value);
         ber_bvdone(&value->bv);
         if (bval != NULL) {
             ber_bvcpy(&value->bv, bval);
@@ -336,6 +487,7 @@ slapi_value_set_string_passin(Slapi_Value *value, char *strVal)
 {
     int rc = -1;
     if (NULL != value) {
+        value_free_normalized(value);
         ber_bvdone(&value->bv);
         value->bv.bv_val = strVal;
         value->bv.bv_len = strlen(strVal);
@@ -350,6 +502,7 @@ slapi_value_set_int(Slapi_Value *value, int intVal)
     int rc = -1;
     if (NULL != value) {
         char valueBuf[80];
+        value_free_normalized(value);
         ber_bvdone(&value->bv);
         sprintf(valueBuf, "%d", intVal);
         value->bv.bv_val = slapi_ch_strdup(valueBuf);
@@ -540,8 +693,13 @@ size_t
 value_size(const Slapi_Value *v)
 {
     size_t s = v->bv.bv_len;
+    struct slapi_value_norm *vn;
+
     s += csnset_size(v->v_csnset);
     s += sizeof(Slapi_Value);
+    for (vn = __atomic_load_n(&v->v_norm, __ATOMIC_ACQUIRE); vn && vn != &value_norm_end; vn = vn->vn_next) {
+        s += sizeof(struct slapi_value_norm) + vn->vn_bv.bv_len + 1;
+    }
     return s;
 }
 
@@ -565,6 +723,7 @@ value_dn_normalize_value(Slapi_Value *value)
         return rc;
     }
 
+    value_free_normalized(value);
     sdn = slapi_sdn_new_dn_passin(value->bv.bv_val);
     if (slapi_sdn_get_dn(sdn)) {
         value->bv.bv_val = slapi_ch_strdup(slapi_sdn_get_dn(sdn));
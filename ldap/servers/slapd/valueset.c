@@ -442,6 +442,304 @@ valuearrayfast_add_value_passin(struct valuearrayfast *vaf, Slapi_Value *v)
 #define VALUESET_ARRAY_MINSIZE 2
 #define VALUESET_ARRAY_MAXINCREMENT 4096
 
+/*
+ * Hash index of large valuesets.
+ *
+ * Above VALUESET_ARRAY_HASH_THRESHOLD values (typically the member or
+ * uniquemember values of big groups) the sorted array is replaced by a
+ * hash index: keeping the array sorted costs a memmove and an index fixup
+ * for each added or removed value, and each comparison of the binary
+ * search normalizes both values.
+ *
+ * The index is an open addressing table (linear probing) of the hashes of
+ * the values and of their positions in va.  The values are compared like
+ * in the sorted array (valueset_value_cmp) so equal values must have the
+ * same hash:
+ *  - DN syntax (or no attribute): the values are compared case
+ *    insensitively, the hash is computed on the lower cased value,
+ *  - other syntaxes: the hash is computed on the equality key.
+ * Finding or adding a value normalizes the value once, removing k values
+ * costs a single compaction of va.
+ */
+#define VALUESET_ARRAY_HASH_THRESHOLD 512
+#define VALUESET_HASH_MINSIZE 16
+#define VALUESET_HASH_EMPTY ((size_t)-1)
+
+typedef struct valueset_hash_slot
+{
+    uint64_t vhs_hash;
+    size_t vhs_index; /* position of the value in va, VALUESET_HASH_EMPTY if the slot is free */
+} valueset_hash_slot;
+
+struct slapi_valueset_hash
+{
+    size_t vh_mask;  /* number of slots - 1, the number of slots is a power of 2 */
+    size_t vh_count; /* number of used slots */
+    int vh_casefold; /* the values are compared case insensitively */
+    valueset_hash_slot *vh_slots;
+};
+
+static int valueset_value_cmp(const Slapi_Attr *a, const Slapi_Value *v1, const Slapi_Value *v2);
+
+/* Same choice of comparison as valueset_value_cmp() */
+static int
+valueset_hash_casefold(const Slapi_Attr *a)
+{
+    return (a == NULL || slapi_attr_is_dn_syntax_attr((Slapi_Attr *)a));
+}
+
+/* FNV-1a */
+static uint64_t
+valueset_hash_bytes(const unsigned char *p, size_t len, int asciifold)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    for (size_t i = 0; i < len; i++) {
+        h ^= asciifold ? (unsigned char)tolower(p[i]) : p[i];
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static uint64_t
+valueset_value_hash(const Slapi_Attr *a, int casefold, const Slapi_Value *v)
+{
+    uint64_t h = 0;
+
+    if (casefold) {
+        /* Must follow slapi_utf8casecmp(): only values with 8 bit chars are lower cased */
+        unsigned char *s = (unsigned char *)v->bv.bv_val;
+        if (s == NULL) {
+            return valueset_hash_bytes(NULL, 0, 0);
+        }
+        if (slapi_has8thBit(s)) {
+            unsigned char *lower = slapi_utf8StrToLower(s);
+            if (lower && *lower) {
+                h = valueset_hash_bytes(lower, strlen((char *)lower), 0);
+                slapi_ch_free((void **)&lower);
+                return h;
+            }
+            slapi_ch_free((void **)&lower);
+        }
+        h = valueset_hash_bytes(s, strlen((char *)s), 1);
+    } else {
+        Slapi_Value *oneval[2] = {(Slapi_Value *)v, NULL};
+        Slapi_Value **keyvals = NULL;
+
+        if (slapi_attr_values2keys_sv(a, oneval, &keyvals, LDAP_FILTER_EQUALITY) == 0 &&
+            keyvals != NULL && keyvals[0] != NULL) {
+            h = valueset_hash_bytes((unsigned char *)keyvals[0]->bv.bv_val, keyvals[0]->bv.bv_len, 0);
+        }
+        valuearray_free(&keyvals);
+    }
+    return h;
+}
+
+static struct slapi_valueset_hash *
+valueset_hash_new(size_t nvalues, int casefold)
+{
+    struct slapi_valueset_hash *vh = (struct slapi_valueset_hash *)slapi_ch_calloc(1, sizeof(struct slapi_valueset_hash));
+    size_t size = VALUESET_HASH_MINSIZE;
+
+    while (size < nvalues * 2) {
+        size <<= 1;
+    }
+    vh->vh_mask = size - 1;
+    vh->vh_casefold = casefold;
+    vh->vh_slots = (valueset_hash_slot *)slapi_ch_malloc(size * sizeof(valueset_hash_slot));
+    for (size_t i = 0; i < size; i++) {
+        vh->vh_slots[i].vhs_index = VALUESET_HASH_EMPTY;
+    }
+    return vh;
+}
+
+static void
+valueset_hash_free(struct slapi_valueset_hash **vh)
+{
+    if (*vh) {
+        slapi_ch_free((void **)&(*vh)->vh_slots);
+        slapi_ch_free((void **)vh);
+    }
+}
+
+static struct slapi_valueset_hash *
+valueset_hash_dup(const struct slapi_valueset_hash *vh)
+{
+    struct slapi_valueset_hash *dup = (struct slapi_valueset_hash *)slapi_ch_malloc(sizeof(struct slapi_valueset_hash));
+
+    *dup = *vh;
+    dup->vh_slots = (valueset_hash_slot *)slapi_ch_malloc((vh->vh_mask + 1) * sizeof(valueset_hash_slot));
+    memcpy(dup->vh_slots, vh->vh_slots, (vh->vh_mask + 1) * sizeof(valueset_hash_slot));
+    return dup;
+}
+
+static void
+valueset_hash_put(struct slapi_valueset_hash *vh, uint64_t hash, size_t index)
+{
+    size_t i;
+
+    for (i = hash & vh->vh_mask; vh->vh_slots[i].vhs_index != VALUESET_HASH_EMPTY; i = (i + 1) & vh->vh_mask)
+        ;
+    vh->vh_slots[i].vhs_hash = hash;
+    vh->vh_slots[i].vhs_index = index;
+    vh->vh_count++;
+}
+
+/* Index the value at position index of va, the table is kept at most half full */
+static void
+valueset_hash_add(struct slapi_valueset_hash *vh, uint64_t hash, size_t index)
+{
+    if ((vh->vh_count + 1) * 2 > vh->vh_mask + 1) {
+        valueset_hash_slot *old = vh->vh_slots;
+        size_t oldsize = vh->vh_mask + 1;
+
+        vh->vh_mask = oldsize * 2 - 1;
+        vh->vh_count = 0;
+        vh->vh_slots = (valueset_hash_slot *)slapi_ch_malloc(oldsize * 2 * sizeof(valueset_hash_slot));
+        for (size_t i = 0; i < oldsize * 2; i++) {
+            vh->vh_slots[i].vhs_index = VALUESET_HASH_EMPTY;
+        }
+        for (size_t i = 0; i < oldsize; i++) {
+            if (old[i].vhs_index != VALUESET_HASH_EMPTY) {
+                valueset_hash_put(vh, old[i].vhs_hash, old[i].vhs_index);
+            }
+        }
+        slapi_ch_free((void **)&old);
+    }
+    valueset_hash_put(vh, hash, index);
+}
+
+/* Free a slot, the next slots of its cluster are moved back (no tombstones) */
+static void
+valueset_hash_del_slot(struct slapi_valueset_hash *vh, size_t i)
+{
+    size_t j = i;
+
+    vh->vh_slots[i].vhs_index = VALUESET_HASH_EMPTY;
+    vh->vh_count--;
+    while (1) {
+        size_t home;
+
+        j = (j + 1) & vh->vh_mask;
+        if (vh->vh_slots[j].vhs_index == VALUESET_HASH_EMPTY) {
+            break;
+        }
+        home = vh->vh_slots[j].vhs_hash & vh->vh_mask;
+        /* the entry can stay if its home slot is (cyclically) in ]i, j] */
+        if ((i <= j) ? (i < home && home <= j) : (i < home || home <= j)) {
+            continue;
+        }
+        vh->vh_slots[i] = vh->vh_slots[j];
+        vh->vh_slots[j].vhs_index = VALUESET_HASH_EMPTY;
+        i = j;
+    }
+}
+
+/* Return the slot of a value of the set equal to v, VALUESET_HASH_EMPTY if there is none */
+static size_t
+valueset_hash_lookup(const Slapi_Attr *a, const Slapi_ValueSet *vs, const Slapi_Value *v, uint64_t hash)
+{
+    const struct slapi_valueset_hash *vh = vs->hash;
+
+    for (size_t i = hash & vh->vh_mask; vh->vh_slots[i].vhs_index != VALUESET_HASH_EMPTY; i = (i + 1) & vh->vh_mask) {
+        if (vh->vh_slots[i].vhs_hash == hash &&
+            valueset_value_cmp(a, v, vs->va[vh->vh_slots[i].vhs_index]) == 0) {
+            return i;
+        }
+    }
+    return VALUESET_HASH_EMPTY;
+}
+
+/* (Re)build the hash index of the valueset, it replaces the sorted array */
+static void
+valueset_hash_build(const Slapi_Attr *a, Slapi_ValueSet *vs)
+{
+    int casefold = valueset_hash_casefold(a);
+
+    slapi_ch_free((void **)&vs->sorted);
+    valueset_hash_free(&vs->hash);
+    vs->hash = valueset_hash_new(vs->num, casefold);
+    for (size_t i = 0; i < vs->num; i++) {
+        valueset_hash_add(vs->hash, valueset_value_hash(a, casefold, vs->va[i]), i);
+    }
+}
+
+/*
+ * Return 1 if the hash index of the valueset can be used to compare values
+ * of attribute a, building or rebuilding it if needed.
+ */
+static int
+valueset_hash_check(const Slapi_Attr *a, Slapi_ValueSet *vs)
+{
+    if (vs->hash ? (vs->hash->vh_casefold != valueset_hash_casefold(a)) : (vs->num > VALUESET_ARRAY_HASH_THRESHOLD)) {
+        valueset_hash_build(a, vs);
+    }
+    return vs->hash != NULL;
+}
+
+/* Index the value at position vs->num of va, return -1 if dupcheck is set and the value is already in the set */
+static int
+valueset_hash_insert(const Slapi_Attr *a, Slapi_ValueSet *vs, int dupcheck)
+{
+    Slapi_Value *vi = vs->va[vs->num];
+    uint64_t hash = valueset_value_hash(a, vs->hash->vh_casefold, vi);
+
+    if (dupcheck && valueset_hash_lookup(a, vs, vi, hash) != VALUESET_HASH_EMPTY) {
+        return -1;
+    }
+    valueset_hash_add(vs->hash, hash, vs->num);
+    vs->num++;
+    return 0;
+}
+
+/*
+ * Find a value and remove it from the hash index.  Its place in va is set
+ * to NULL, valueset_hash_compact() must be called once the values are removed.
+ */
+static Slapi_Value *
+valueset_hash_take(const Slapi_Attr *a, Slapi_ValueSet *vs, const Slapi_Value *v)
+{
+    size_t slot = valueset_hash_lookup(a, vs, v, valueset_value_hash(a, vs->hash->vh_casefold, v));
+    Slapi_Value *r = NULL;
+
+    if (slot != VALUESET_HASH_EMPTY) {
+        size_t index = vs->hash->vh_slots[slot].vhs_index;
+        r = vs->va[index];
+        vs->va[index] = NULL;
+        valueset_hash_del_slot(vs->hash, slot);
+    }
+    return r;
+}
+
+/* Close the holes left in va by valueset_hash_take() */
+static void
+valueset_hash_compact(Slapi_ValueSet *vs)
+{
+    size_t *newindex = NULL;
+    size_t n = 0;
+
+    if (vs->num == 0) {
+        return;
+    }
+    newindex = (size_t *)slapi_ch_malloc(vs->num * sizeof(size_t));
+    for (size_t i = 0; i < vs->num; i++) {
+        if (vs->va[i] != NULL) {
+            newindex[i] = n;
+            vs->va[n++] = vs->va[i];
+        }
+    }
+    for (size_t i = n; i < vs->num; i++) {
+        vs->va[i] = NULL;
+    }
+    vs->num = n;
+    for (size_t i = 0; i <= vs->hash->vh_mask; i++) {
+        if (vs->hash->vh_slots[i].vhs_index != VALUESET_HASH_EMPTY) {
+            vs->hash->vh_slots[i].vhs_index = newindex[vs->hash->vh_slots[i].vhs_index];
+        }
+    }
+    slapi_ch_free((void **)&newindex);
+}
+
 Slapi_ValueSet *
 slapi_valueset_new()
 {
@@ -459,6 +757,7 @@ slapi_valueset_init(Slapi_ValueSet *vs)
     if (vs != NULL) {
         vs->va = NULL;
         vs->sorted = NULL;
+        vs->hash = NULL;
         vs->num = 0;
         vs->max = 0;
     }
@@ -477,6 +776,7 @@ slapi_valueset_done(Slapi_ValueSet *vs)
             slapi_ch_free((void **)&vs->sorted);
             vs->sorted = NULL;
         }
+        valueset_hash_free(&vs->hash);
         vs->num = 0;
         vs->max = 0;
     }
@@ -609,7 +909,12 @@ slapi_valueset_find(const Slapi_Attr *a, const Slapi_ValueSet *vs, const Slapi_V
 {
     Slapi_Value *r = NULL;
     if (vs && (vs->num > 0)) {
-        if (vs->sorted) {
+        if (vs->hash && vs->hash->vh_casefold == valueset_hash_casefold(a)) {
+            size_t slot = valueset_hash_lookup(a, vs, v, valueset_value_hash(a, vs->hash->vh_casefold, v));
+            if (slot != VALUESET_HASH_EMPTY) {
+                r = vs->va[vs->hash->vh_slots[slot].vhs_index];
+            }
+        } else if (vs->sorted) {
             r = valueset_find_sorted(a, vs, v, NULL);
         } else {
             int i = valuearray_find(a, vs->va, v);
@@ -656,7 +961,12 @@ Slapi_Value *
 valueset_remove_value(const Slapi_Attr *a, Slapi_ValueSet *vs, const Slapi_Value *v)
 {
     Slapi_Value *r = NULL;
-    if (vs->sorted) {
+    if (valueset_hash_check(a, vs)) {
+        r = valueset_hash_take(a, vs, v);
+        if (r) {
+            valueset_hash_compact(vs);
+        }
+    } else if (vs->sorted) {
         r = valueset_remove_value_sorted(a, vs, v);
     } else {
         if (!valuearray_isempty(vs->va)) {
@@ -684,6 +994,9 @@ valueset_array_purge(const Slapi_Attr *a, Slapi_ValueSet *vs, const CSN *csn)
     Slapi_Value **va2 = NULL;
     size_t *sorted2 = NULL;
 
+    /* the positions of the values change, the hash index is rebuilt at the end */
+    valueset_hash_free(&vs->hash);
+
     /* Loop over all the values freeing the old ones. */
     for(i = 0; i < vs->num; i++)
     {
@@ -808,8 +1121,10 @@ valueset_array_purge(const Slapi_Attr *a, Slapi_ValueSet *vs, const CSN *csn)
         slapi_valueset_done(vs);
     }
 
-    /* We still have values but not sorted array! rebuild it */
-    if(vs->num > VALUESET_ARRAY_SORT_THRESHOLD && vs->sorted == NULL) {
+    if (vs->num > VALUESET_ARRAY_HASH_THRESHOLD) {
+        valueset_hash_build(a, vs);
+    } else if(vs->num > VALUESET_ARRAY_SORT_THRESHOLD && vs->sorted == NULL) {
+        /* We still have values but not sorted array! rebuild it */
         vs->sorted = (size_t *) slapi_ch_malloc( vs->max* sizeof(size_t));
         valueset_array_to_sorted(a, vs);
     }
@@ -855,6 +1170,9 @@ valueset_size(const Slapi_ValueSet *vs)
     if (vs && !valuearray_isempty(vs->va)) {
         s = valuearray_size(vs->va);
     }
+    if (vs && vs->hash) {
+        s += sizeof(struct slapi_valueset_hash) + (vs->hash->vh_mask + 1) * sizeof(valueset_hash_slot);
+    }
     return s;
 }
 
@@ -1145,7 +1463,12 @@ slapi_valueset_add_attr_valuearray_ext(const Slapi_Attr *a, Slapi_ValueSet *vs,
         vs->max = allocate;
     }
 
-    if ((vs->num + naddvals > VALUESET_ARRAY_SORT_THRESHOLD || dupcheck) && !vs->sorted && vs->max > 0) {
+    if (vs->hash || vs->num + naddvals > VALUESET_ARRAY_HASH_THRESHOLD) {
+        /* large valueset, use the hash index */
+        if (vs->hash == NULL || vs->hash->vh_casefold != valueset_hash_casefold(a)) {
+            valueset_hash_build(a, vs);
+        }
+    } else if ((vs->num + naddvals > VALUESET_ARRAY_SORT_THRESHOLD || dupcheck) && !vs->sorted && vs->max > 0) {
         /* initialize sort array and do initial sort */
         vs->sorted = (size_t *)slapi_ch_malloc(vs->max * sizeof(size_t));
         valueset_array_to_sorted(a, vs);
@@ -1160,8 +1483,12 @@ slapi_valueset_add_attr_valuearray_ext(const Slapi_Attr *a, Slapi_ValueSet *vs,
                 /* We copy the values */
                 (vs->va)[vs->num] = slapi_value_dup(addvals[i]);
             }
-            if (vs->sorted) {
-                dup = valueset_insert_value_to_sorted(a, vs, (vs->va)[vs->num], dupcheck);
+            if (vs->hash || vs->sorted) {
+                if (vs->hash) {
+                    dup = valueset_hash_insert(a, vs, dupcheck);
+                } else {
+                    dup = valueset_insert_value_to_sorted(a, vs, (vs->va)[vs->num], dupcheck);
+                }
                 if (dup < 0) {
                     rc = LDAP_TYPE_OR_VALUE_EXISTS;
                     if (dup_index)
@@ -1255,6 +1582,11 @@ valueset_set_valueset(Slapi_ValueSet *vs1, const Slapi_ValueSet *vs2)
         } else {
             slapi_ch_free((void **)&vs1->sorted);
         }
+        valueset_hash_free(&vs1->hash);
+        if (vs2->hash) {
+            /* same positions in va */
+            vs1->hash = valueset_hash_dup(vs2->hash);
+        }
         /* post-condition */
         PR_ASSERT((vs1->sorted == NULL) || (vs1->num < VALUESET_ARRAY_SORT_THRESHOLD) || ((vs1->num >= VALUESET_ARRAY_SORT_THRESHOLD) && (vs1->sorted[0] < vs1->num)));
     }
@@ -1308,6 +1640,7 @@ valueset_remove_valuearray(Slapi_ValueSet *vs, const Slapi_Attr *a, Slapi_Value
     if (vs->num > 0) {
         int i;
         struct valuearrayfast vaf_out;
+        int hashed = valueset_hash_check(a, vs);
 
         if (va_out) {
             valuearrayfast_init(&vaf_out, *va_out);
@@ -1315,10 +1648,11 @@ valueset_remove_valuearray(Slapi_ValueSet *vs, const Slapi_Attr *a, Slapi_Value
 
         /*
          * For larger valuesets the valuarray is sorted, values can be deleted individually
-         *
+         * For the largest ones the values are found with the hash index and the
+         * valuearray is compacted once at the end
          */
         for (i = 0; rc == LDAP_SUCCESS && valuestodelete[i] != NULL; ++i) {
-            Slapi_Value *found = valueset_remove_value(a, vs, valuestodelete[i]);
+            Slapi_Value *found = hashed ? valueset_hash_take(a, vs, valuestodelete[i]) : valueset_remove_value(a, vs, valuestodelete[i]);
             if (found != NULL) {
                 if (va_out) {
                     if (found->v_csnset &&
@@ -1349,6 +1683,9 @@ valueset_remove_valuearray(Slapi_ValueSet *vs, const Slapi_Attr *a, Slapi_Value
                 }
             }
         }
+        if (hashed) {
+            valueset_hash_compact(vs);
+        }
         if (va_out) {
             *va_out = vaf_out.va;
             if (rc != LDAP_SUCCESS) {
@@ -1419,6 +1756,9 @@ valueset_replace_valuearray_ext(Slapi_Attr *a, Slapi_ValueSet *vs, Slapi_Value *
             vs_new->va = NULL;
             vs->sorted = vs_new->sorted;
             vs_new->sorted = NULL;
+            valueset_hash_free(&vs->hash);
+            vs->hash = vs_new->hash;
+            vs_new->hash = NULL;
             vs->num = vs_new->num;
             vs->max = vs_new->max;
             slapi_valueset_free(vs_new);
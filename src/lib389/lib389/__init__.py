@@ -3533,8 +3533,8 @@ class DirSrv(SimpleLDAPObject, object):
             self.log.debug("Delete entry children %s", ent.dn)
             self.delete_ext_s(ent.dn, serverctrls=serverctrls, clientctrls=clientctrls, escapehatch='i am sure')
 
-    def backup_online(self, archive=None, db_type=None):
-        """Creates a backup of the database"""
+    def backup_online(self, archive=None, db_type=None, base=None):
+        """Creates a backup of the database, incremental to base if set"""
 
         if archive is None:
             # Use the instance name and date/time as the default backup name
@@ -3552,6 +3552,10 @@ class DirSrv(SimpleLDAPObject, object):
         task_properties = {'nsArchiveDir': archive}
         if db_type is not None:
             task_properties['nsDatabaseType'] = db_type
+        if base is not None:
+            if base[0] != "/":
+                base = os.path.join(self.ds_paths.backup_dir, base)
+            task_properties['nsBackupBaseDir'] = base
         task.create(properties=task_properties)
 
         return task
@@ -573,7 +573,9 @@ class Backend(DSLdapObject):
         db_config = DatabaseConfig(self._instance)
         config_attrs = db_config.get()
 
-        mdb_only_attrs = ['nsslapd-mdb-max-size', 'nsslapd-mdb-max-readers', 'nsslapd-mdb-max-dbs']
+        mdb_only_attrs = ['nsslapd-mdb-max-size', 'nsslapd-mdb-max-readers', 'nsslapd-mdb-max-dbs',
+                          'nsslapd-mdb-group-commit', 'nsslapd-mdb-export-threads',
+                          'nsslapd-mdb-backup-max-rate']
         bdb_only_attrs = ['nsslapd-dbcachesize',
                           'nsslapd-dbncache',
                           'nsslapd-db-logdirectory',
@@ -1332,6 +1334,11 @@ class DatabaseConfig(DSLdapObject):
             'nsslapd-serial-lock',
             'nsslapd-pagedlookthroughlimit',
             'nsslapd-pagedidlistscanlimit',
+            'nsslapd-pagedidlistbudget',
+            'nsslapd-sort-memory-limit',
+            'nsslapd-binary-entry-format',
+            'nsslapd-id2entry-compression',
+            'nsslapd-scope-index',
             'nsslapd-rangelookthroughlimit',
             'nsslapd-backend-opt-level',
             'nsslapd-backend-implement',
@@ -1373,6 +1380,9 @@ class DatabaseConfig(DSLdapObject):
                     'nsslapd-mdb-max-size',
                     'nsslapd-mdb-max-readers',
                     'nsslapd-mdb-max-dbs',
+                    'nsslapd-mdb-group-commit',
+                    'nsslapd-mdb-export-threads',
+                    'nsslapd-mdb-backup-max-rate',
                     'nsslapd-cache-autosize',
                 ]
         }
@@ -61,6 +61,11 @@ arg_to_attr = {
         'exclude_from_export': 'nsslapd-exclude-from-export',
         'pagedlookthroughlimit': 'nsslapd-pagedlookthroughlimit',
         'pagedidlistscanlimit': 'nsslapd-pagedidlistscanlimit',
+        'pagedidlistbudget': 'nsslapd-pagedidlistbudget',
+        'sort_memory_limit': 'nsslapd-sort-memory-limit',
+        'binary_entry_format': 'nsslapd-binary-entry-format',
+        'id2entry_compression': 'nsslapd-id2entry-compression',
+        'scope_index': 'nsslapd-scope-index',
         'rangelookthroughlimit': 'nsslapd-rangelookthroughlimit',
         'backend_opt_level': 'nsslapd-backend-opt-level',
         'deadlock_policy': 'nsslapd-db-deadlock-policy',
@@ -69,6 +74,9 @@ arg_to_attr = {
         'mdb_max_size': 'nsslapd-mdb-max-size',
         'mdb_max_readers': 'nsslapd-mdb-max-readers',
         'mdb_max_dbs': 'nsslapd-mdb-max-dbs',
+        'mdb_group_commit': 'nsslapd-mdb-group-commit',
+        'mdb_export_threads': 'nsslapd-mdb-export-threads',
+        'mdb_backup_max_rate': 'nsslapd-mdb-backup-max-rate',
         # VLV attributes
         'search_base': 'vlvbase',
         'search_scope': 'vlvscope',
@@ -1111,6 +1119,18 @@ def create_parser(subparsers):
                                                                       'the simple paged results control')
     set_db_config_parser.add_argument('--pagedidlistscanlimit', help='Specifies the number of entry IDs that are searched, specifically, '
                                                                      'for a search operation using the simple paged results control.')
+    set_db_config_parser.add_argument('--pagedidlistbudget', help='Specifies the maximum number of candidate entry IDs a simple paged results '
+                                                                  'search keeps in memory between pages. Larger candidate lists are released '
+                                                                  'and rebuilt from the indexes on the next page. 0 keeps them all.')
+    set_db_config_parser.add_argument('--sort-memory-limit', help='Specifies the memory in bytes used to hold the sort keys of a server side '
+                                                                  'sort before they are spilled to temporary files. 0 never spills.')
+    set_db_config_parser.add_argument('--binary-entry-format', help='Set to "on" to store entries in the binary format, or "off" to store '
+                                                                    'them as text (default). Entries are converted when they are next written. '
+                                                                    'Older servers can not read binary entries.')
+    set_db_config_parser.add_argument('--id2entry-compression', help='Set to "on" to compress entries stored in the database. Entries '
+                                                                     'are compressed when they are next written.')
+    set_db_config_parser.add_argument('--scope-index', help='Set to "on" to scope subtree searches with an in memory tree of the entries '
+                                                            'instead of the ancestorid index.')
     set_db_config_parser.add_argument('--rangelookthroughlimit', help='Specifies the maximum number of entries that the server '
                                                                       'will check when examining candidate entries in response to a '
                                                                       'range search request.')
@@ -1122,6 +1142,14 @@ def create_parser(subparsers):
     set_db_config_parser.add_argument('--mdb-max-size', help='Sets the lmdb database maximum size (accepts bytes, or with unit suffix: k, m, g, t)')
     set_db_config_parser.add_argument('--mdb-max-readers', help='Sets the lmdb database maximum number of readers (Advanced setting)')
     set_db_config_parser.add_argument('--mdb-max-dbs', help='Sets the lmdb database maximum number of sub databases (Advanced setting)')
+    set_db_config_parser.add_argument('--mdb-group-commit', help='Set to "on" to let concurrent write operations share one flush of the lmdb '
+                                                                 'database. Requires a restart (Advanced setting)')
+    set_db_config_parser.add_argument('--mdb-export-threads', help='Sets the number of threads decoding and formatting entries during an lmdb '
+                                                                   'export. 0 or 1 exports with a single thread')
+    set_db_config_parser.add_argument('--mdb-backup-max-rate', help='Sets the maximum number of bytes per second an lmdb backup reads from '
+                                                                    'the database. 0 means no limit. The backup keeps a read snapshot '
+                                                                    'of the database open until it completes, so the database file '
+                                                                    'grows by the updates done meanwhile: a low rate makes it grow more')
     # Dynamic lists
     set_db_config_parser.add_argument('--enable-dynamic-lists', action='store_true', help='Enables dynamic lists')
     set_db_config_parser.add_argument('--disable-dynamic-lists', action='store_true', help='Disables dynamic lists')
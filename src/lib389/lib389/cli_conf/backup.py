@@ -11,7 +11,7 @@ from lib389.cli_base import CustomHelpFormatter
 def backup_create(inst, basedn, log, args):
     log = log.getChild('backup_create')
 
-    task = inst.backup_online(archive=args.archive, db_type=args.db_type)
+    task = inst.backup_online(archive=args.archive, db_type=args.db_type, base=args.base)
     task.wait(timeout=args.timeout)
     result = task.get_exit_code()
 
@@ -54,6 +54,9 @@ def create_parser(subparsers):
                                            "Default: /var/lib/dirsrv/slapd-instance/bak/ ")
     create_backup_parser.add_argument('-t', '--db-type', default="ldbm database",
                                       help="Sets the database type. Default: ldbm database")
+    create_backup_parser.add_argument('-b', '--base', default=None,
+                                      help="Creates an incremental backup holding only the changes since this "
+                                           "earlier backup (lmdb only)")
     create_backup_parser.add_argument('--timeout', type=int, default=120,
                                       help="Sets the task timeout.  Default is 120 seconds,")
 
@@ -206,6 +206,7 @@ class Monitor(DSLdapObject):
             'maxworkqueue',
             'currentbusyworkers',
             'maxbusyworkers',
+            'numanode',
         ])
         status.update(stats)
 
@@ -255,7 +256,8 @@ class MonitorLDBM(DSLdapObject):
             'dbenvlasttxnid', 'dbenvmaxreaders', 'dbenvnumreaders',
             'dbenvnumdbis', 'waitingrwtxn', 'activerwtxn',
             'abortrwtxn', 'commitrwtxn', 'granttimerwtxn',
-            'lifetimerwtxn', 'waitingrotxn', 'activerotxn',
+            'lifetimerwtxn', 'groupcommittxns', 'groupcommitflushes',
+            'waitingrotxn', 'activerotxn',
             'abortrotxn', 'commitrotxn', 'granttimerotxn',
             'lifetimerotxn'
         ]
@@ -352,6 +354,8 @@ class MonitorDatabase(DSLdapObject):
                 'commitrwtxn',
                 'granttimerwtxn',
                 'lifetimerwtxn',
+                'groupcommittxns',
+                'groupcommitflushes',
                 'waitingrotxn',
                 'activerotxn',
                 'abortrotxn',
@@ -398,6 +402,11 @@ class MonitorBackend(DSLdapObject):
                 'maxdncachesize',
                 'currentdncachecount',
                 'maxdncachecount',
+                'id2entryuncompressedbytes',
+                'id2entrycompressedbytes',
+                'id2entrycompressionratio',
+                'id2entrydecompressions',
+                'id2entryaveragedecompresstime',
             ]
             if ds_is_older("1.4.0", instance=self._instance):
                 self._backend_keys.extend([
@@ -419,6 +428,11 @@ class MonitorBackend(DSLdapObject):
                 'maxentrycachesize',
                 'currententrycachecount',
                 'maxentrycachecount',
+                'id2entryuncompressedbytes',
+                'id2entrycompressedbytes',
+                'id2entrycompressionratio',
+                'id2entrydecompressions',
+                'id2entryaveragedecompresstime',
             ]
 
 
@@ -0,0 +1,34 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#pragma once
+
+#include <config.h>
+#include <slapi-plugin.h>
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+/*
+ * Benchmarks are not part of the test suite: timings depend on the build
+ * machine.  Run bench_slapd by hand.  Each benchmark returns 0, or 1 if
+ * the code measured gave a wrong result.
+ */
+
+static inline uint64_t
+bench_elapsed_nsec(const struct timespec *start, const struct timespec *finish)
+{
+    return (finish->tv_sec - start->tv_sec) * 1000000000 + finish->tv_nsec - start->tv_nsec;
+}
+
+/* libslapd-filter-substr */
+int bench_libslapd_filter_substr(void);
+
+/* plugin-pwdstorage-pbkdf2 */
+int bench_plugin_pwdstorage_pbkdf2_mb(void);
@@ -0,0 +1,20 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#include "bench.h"
+
+int
+main(int argc __attribute__((unused)), char **argv __attribute__((unused)))
+{
+    int result = 0;
+    result += bench_libslapd_filter_substr();
+    result += bench_plugin_pwdstorage_pbkdf2_mb();
+
+    PR_Cleanup();
+    return result;
+}
@@ -0,0 +1,64 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#include "bench.h"
+
+#include <nss.h>
+#include <pwdstorage.h>
+
+int
+bench_plugin_pwdstorage_pbkdf2_mb(void)
+{
+    int result = 0;
+#if (NSS_VMAJOR * 100 + NSS_VMINOR) > 328
+    /* Same shape as our stored hashes: 64 byte salt, 256 byte output */
+    const size_t rounds = 10000;
+    const size_t loops = 8;
+    char salt[64] = {0};
+    char dk[256];
+    SECItem pwdItem = {siBuffer, (unsigned char *)"Eequee9mutheuchiehe4", 20};
+    SECItem saltItem = {siBuffer, (unsigned char *)salt, sizeof(salt)};
+    struct timespec start;
+    struct timespec finish;
+    uint64_t nss_nsec;
+    uint64_t mb_nsec;
+
+    if (NSS_Initialize(NULL, "", "", SECMOD_DB, NSS_INIT_READONLY | NSS_INIT_NOCERTDB | NSS_INIT_NOMODDB)) {
+        fprintf(stderr, "PBKDF2_SHA256: can not initialize NSS\n");
+        return 1;
+    }
+
+    /* NSS caches derived keys, so every loop uses a different salt */
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i = 0; i < loops && result == 0; i++) {
+        salt[0] = (char)i;
+        if (pbkdf2_sha256_hash_nss(dk, sizeof(dk), &pwdItem, &saltItem, rounds) != SECSuccess) {
+            fprintf(stderr, "PBKDF2_SHA256: nss hash failed\n");
+            result = 1;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+    nss_nsec = bench_elapsed_nsec(&start, &finish);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t i = 0; i < loops; i++) {
+        pbkdf2_mb_job job = {pwdItem.data, pwdItem.len, (unsigned char *)salt, sizeof(salt), rounds, (unsigned char *)dk, sizeof(dk)};
+        salt[0] = (char)(i + loops);
+        pbkdf2_sha256_mb(&job, 1);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+    mb_nsec = bench_elapsed_nsec(&start, &finish);
+
+    if (result == 0) {
+        printf("PBKDF2_SHA256 %zu rounds: nss %.1f hashes/sec, multi-buffer %.1f hashes/sec\n",
+               rounds, loops * 1e9 / nss_nsec, loops * 1e9 / mb_nsec);
+    }
+    NSS_Shutdown();
+#endif
+    return result;
+}
@@ -0,0 +1,78 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#include "bench.h"
+#include <inttypes.h>
+
+/* To access the substring matcher */
+#include <slap.h>
+
+int
+bench_libslapd_filter_substr(void)
+{
+    /* (cn=*smith*) against 100000 distinct cn values, a few of them matching */
+    const size_t nvalues = 100000;
+    const size_t loops = 10;
+    char *any[] = {"smith", NULL};
+    char **values = (char **)slapi_ch_calloc(nvalues, sizeof(char *));
+    struct timespec start;
+    struct timespec finish;
+    uint64_t re_nsec;
+    uint64_t ss_nsec;
+    size_t re_matches = 0;
+    size_t ss_matches = 0;
+    char *re_result = NULL;
+    Slapi_Regex *re = slapi_re_comp(".*smith", &re_result);
+    Slapi_Substr *ss = substr_match_new(NULL, any, NULL);
+    int result = 0;
+
+    if (re == NULL) {
+        fprintf(stderr, "substring match: can not compile the regex: %s\n", re_result);
+        result = 1;
+        goto done;
+    }
+    for (size_t i = 0; i < nvalues; i++) {
+        values[i] = slapi_ch_smprintf("user%zu %s", i, (i % 1000) ? "jones" : "smith");
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t l = 0; l < loops; l++) {
+        for (size_t i = 0; i < nvalues; i++) {
+            re_matches += slapi_re_exec_nt(re, values[i]);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+    re_nsec = bench_elapsed_nsec(&start, &finish);
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (size_t l = 0; l < loops; l++) {
+        for (size_t i = 0; i < nvalues; i++) {
+            ss_matches += substr_match_exec(ss, values[i]);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &finish);
+    ss_nsec = bench_elapsed_nsec(&start, &finish);
+
+    if (re_matches != loops * nvalues / 1000 || ss_matches != re_matches) {
+        fprintf(stderr, "substring match: %zu regex matches, %zu substr_match matches, %zu expected\n",
+                re_matches, ss_matches, loops * nvalues / 1000);
+        result = 1;
+    } else {
+        printf("substring match of %zu values: regex %" PRIu64 " ms, substr_match %" PRIu64 " ms\n",
+               loops * nvalues, re_nsec / 1000000, ss_nsec / 1000000);
+    }
+
+done:
+    for (size_t i = 0; i < nvalues; i++) {
+        slapi_ch_free_string(&values[i]);
+    }
+    slapi_ch_free((void **)&values);
+    slapi_re_free(re);
+    substr_match_free(&ss);
+    return result;
+}
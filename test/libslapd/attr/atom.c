@@ -0,0 +1,41 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#include "../../test_slapd.h"
+
+/* To access the attribute type atoms */
+#include <slap.h>
+
+void
+test_libslapd_attr_atom(void **state __attribute__((unused)))
+{
+    uint32_t cn = attr_atom_intern("testAtomCn");
+    uint32_t cn_alias = attr_atom_intern("testAtomCommonName");
+    char name[64];
+
+    /* Case insensitive and stable */
+    assert_int_not_equal(cn, 0);
+    assert_int_not_equal(cn_alias, 0);
+    assert_int_not_equal(cn, cn_alias);
+    assert_int_equal(attr_atom_get("TESTATOMCN"), cn);
+    assert_int_equal(attr_atom_intern("testatomcn"), cn);
+
+    /* Looking up does not intern */
+    assert_int_equal(attr_atom_get("testAtomUnknown"), 0);
+    assert_int_equal(attr_atom_get("testAtomUnknown"), 0);
+    assert_int_equal(attr_atom_get("testAtomCn;lang-fr"), 0);
+
+    /* Atoms survive the growth of the table */
+    for (size_t i = 0; i < 5000; i++) {
+        snprintf(name, sizeof(name), "testAtom%zu", i);
+        assert_int_not_equal(attr_atom_intern(name), 0);
+    }
+    assert_int_equal(attr_atom_get("testAtomCN"), cn);
+    assert_int_equal(attr_atom_get("testAtomCommonName"), cn_alias);
+    assert_int_equal(attr_atom_get("TestAtom4999"), attr_atom_intern("testatom4999"));
+}
@@ -0,0 +1,94 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#include "../../test_slapd.h"
+
+#include <slap.h>
+
+#define TEST_DN "uid=binary,dc=example,dc=com"
+
+static char *
+binary_record(int *len)
+{
+    Slapi_Entry *e = slapi_entry_alloc();
+    char *record = NULL;
+
+    slapi_entry_init(e, slapi_ch_strdup(TEST_DN), NULL);
+    slapi_entry_add_string(e, "objectclass", "top");
+    slapi_entry_add_string(e, "uid", "binary");
+    slapi_entry_add_string(e, "description", "first");
+    slapi_entry_add_string(e, "description", "second");
+    record = slapi_entry2bin(e, len);
+    slapi_entry_free(e);
+    return record;
+}
+
+/* A record is decoded from the data actually read */
+void
+test_libslapd_entry_binary_roundtrip(void **state __attribute__((unused)))
+{
+    int len = 0;
+    char *record = binary_record(&len);
+    Slapi_Entry *e = NULL;
+    char *value = NULL;
+    char **values = NULL;
+    char *text = NULL;
+    size_t textlen = 0;
+
+    assert_true(slapi_entry_is_bin(record, len));
+    assert_false(slapi_entry_is_bin(record, 2));
+    assert_false(slapi_entry_is_bin("rdn: uid=binary", 16));
+
+    e = slapi_record2entry(TEST_DN, NULL, record, len, 0);
+    assert_non_null(e);
+    assert_string_equal(slapi_entry_get_dn_const(e), TEST_DN);
+    assert_int_equal(slapi_entry_attr_hasvalue(e, "description", "second"), 1);
+    slapi_entry_free(e);
+
+    assert_int_equal(slapi_entry_bin_get_value(record, len, "rdn", &value), 0);
+    assert_string_equal(value, "uid=binary");
+    slapi_ch_free_string(&value);
+    assert_int_equal(slapi_entry_bin_get_values(record, len, "description", &values, 0), 0);
+    assert_string_equal(values[0], "first");
+    assert_string_equal(values[1], "second");
+    assert_null(values[2]);
+    slapi_ch_array_free(values);
+
+    /* the text form displayed by the tools */
+    text = slapi_entry_bin_to_str(record, len, &textlen);
+    assert_non_null(text);
+    assert_int_equal(strlen(text), textlen);
+    assert_non_null(strstr(text, "rdn: uid=binary\n"));
+    assert_non_null(strstr(text, "objectclass: top\n"));
+    assert_non_null(strstr(text, "description: first\ndescription: second\n"));
+    slapi_ch_free_string(&text);
+
+    slapi_ch_free_string(&record);
+}
+
+/* A truncated record is rejected, whatever its header says */
+void
+test_libslapd_entry_binary_truncated(void **state __attribute__((unused)))
+{
+    int len = 0;
+    char *record = binary_record(&len);
+    char *value = NULL;
+    char **values = NULL;
+    size_t textlen = 0;
+
+    for (int size = len - 1; size >= 3; size--) {
+        assert_null(slapi_record2entry(TEST_DN, NULL, record, size, 0));
+        assert_int_equal(slapi_entry_bin_get_values(record, size, "description", &values, 0), -1);
+        assert_null(values);
+        assert_null(slapi_entry_bin_to_str(record, size, &textlen));
+    }
+    assert_int_equal(slapi_entry_bin_get_value(record, 15, "rdn", &value), -1);
+    assert_null(value);
+
+    slapi_ch_free_string(&record);
+}
@@ -0,0 +1,111 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#include "../../test_slapd.h"
+#include <string.h>
+
+/* To access the substring matcher */
+#include <slap.h>
+
+typedef struct test_substr {
+    char *initial;
+    char *any[3];
+    char *final;
+} test_substr;
+
+static test_substr test_asserts[] = {
+    {"smith", {NULL}, NULL},
+    {NULL, {"smith", NULL}, NULL},
+    {NULL, {NULL}, "smith"},
+    {"j", {"smi", NULL}, "th"},
+    {"john", {NULL}, "smith"},
+    {"a", {"a", "a", NULL}, "a"},
+    {NULL, {"ab", "ba", NULL}, NULL},
+    {"abc", {NULL}, "cde"},
+    {"x.y", {"[z]", NULL}, "$"},
+    {NULL, {"(a|b)", NULL}, "?"},
+    {"", {"", NULL}, ""},
+};
+
+static char *test_values[] = {
+    "",
+    "a",
+    "aa",
+    "aaaa",
+    "aaaaa",
+    "abc",
+    "abcde",
+    "abcdecde",
+    "abba",
+    "ababab",
+    "smith",
+    "john smith",
+    "smithson",
+    "jsmith",
+    "johnsmith",
+    "x.y[z]$",
+    "xay[z]$",
+    "x.y z $",
+    "(a|b)?",
+    "a|?",
+    "john\nsmith",
+    "smith\n",
+    "john smith\n",
+    "abc\ncde",
+    "a\na\naa",
+    "jxsmith\nth",
+    NULL
+};
+
+/* The regex string_filter_sub() used to build for an assertion */
+static int
+test_substr_regex(test_substr *t, char *value)
+{
+    char pat[BUFSIZ];
+    char *p = pat;
+    char *re_result = NULL;
+    Slapi_Regex *re;
+    int rc;
+
+    *p = '\0';
+    if (t->initial) {
+        *p++ = '^';
+        p = filter_strcpy_special_ext(p, t->initial, FILTER_STRCPY_ESCAPE_RECHARS);
+    }
+    for (size_t i = 0; t->any[i]; i++) {
+        *p++ = '.';
+        *p++ = '*';
+        p = filter_strcpy_special_ext(p, t->any[i], FILTER_STRCPY_ESCAPE_RECHARS);
+    }
+    if (t->final) {
+        *p++ = '.';
+        *p++ = '*';
+        p = filter_strcpy_special_ext(p, t->final, FILTER_STRCPY_ESCAPE_RECHARS);
+        strcat(p, "$");
+    }
+    re = slapi_re_comp(pat, &re_result);
+    assert_non_null(re);
+    rc = slapi_re_exec_nt(re, value);
+    slapi_re_free(re);
+    return rc;
+}
+
+void
+test_libslapd_filter_substr_match(void **state __attribute__((unused)))
+{
+    for (size_t t = 0; t < sizeof(test_asserts) / sizeof(test_asserts[0]); t++) {
+        Slapi_Substr *ss = substr_match_new(test_asserts[t].initial, test_asserts[t].any, test_asserts[t].final);
+
+        for (size_t v = 0; test_values[v]; v++) {
+            assert_int_equal(substr_match_exec(ss, test_values[v]),
+                             test_substr_regex(&test_asserts[t], test_values[v]));
+        }
+        substr_match_free(&ss);
+        assert_null(ss);
+    }
+}
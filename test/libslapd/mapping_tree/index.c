@@ -0,0 +1,61 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#include "../../test_slapd.h"
+
+/* To build private mapping trees */
+#include <slap.h>
+
+static void
+index_check(char **suffixes, const char *dn, const char *expected)
+{
+    char *subtree = mapping_tree_index_check(suffixes, dn);
+
+    /* NULL when the index and the walk of the tree disagree */
+    assert_non_null(subtree);
+    assert_string_equal(subtree, expected);
+    slapi_ch_free_string(&subtree);
+}
+
+void
+test_libslapd_mapping_tree_index(void **state __attribute__((unused)))
+{
+    char *nested[] = {
+        "dc=com",
+        "dc=example,dc=com",
+        "ou=people,dc=example,dc=com",
+        "o=sub,ou=people,dc=example,dc=com",
+        "dc=example,dc=org",
+        NULL};
+    /* a suffix added after the suffixes below it stays their sibling */
+    char *reversed[] = {
+        "ou=people,dc=example,dc=com",
+        "dc=example,dc=com",
+        NULL};
+
+    ndn_cache_init();
+
+    index_check(nested, "uid=a,ou=people,dc=example,dc=com", "ou=people,dc=example,dc=com");
+    index_check(nested, "UID=A,OU=People,DC=Example,DC=Com", "ou=people,dc=example,dc=com");
+    index_check(nested, "uid=a,o=sub,ou=people,dc=example,dc=com", "o=sub,ou=people,dc=example,dc=com");
+    index_check(nested, "ou=people,dc=example,dc=com", "ou=people,dc=example,dc=com");
+    index_check(nested, "ou=groups,dc=example,dc=com", "dc=example,dc=com");
+    index_check(nested, "uid=a,ou=peoplex,dc=example,dc=com", "dc=example,dc=com");
+    index_check(nested, "dc=test,dc=com", "dc=com");
+    index_check(nested, "cn=a,dc=example,dc=org", "dc=example,dc=org");
+    index_check(nested, "dc=example,dc=net", "");
+    index_check(nested, "", "");
+
+    index_check(reversed, "uid=a,ou=people,dc=example,dc=com", "ou=people,dc=example,dc=com");
+    index_check(reversed, "ou=groups,dc=example,dc=com", "dc=example,dc=com");
+    index_check(reversed, "dc=com", "");
+
+    index_check(NULL, "dc=example,dc=com", "");
+
+    ndn_cache_destroy();
+}
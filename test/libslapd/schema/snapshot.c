@@ -0,0 +1,117 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2025 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#include "../../test_slapd.h"
+
+#include <slap.h>
+#include <proto-slap.h>
+#include <string.h>
+
+static struct asyntaxinfo *
+snapshot_add_attr(char *name, char *oid)
+{
+    char *names[2] = {0};
+    struct asyntaxinfo *asi = NULL;
+
+    names[0] = name;
+    attr_syntax_create(oid, names, "testing attribute type",
+                       NULL, NULL, NULL, NULL, NULL,
+                       DIRSTRING_SYNTAX_OID, SLAPI_SYNTAXLENGTH_NONE,
+                       SLAPI_ATTR_FLAG_STD_ATTR | SLAPI_ATTR_FLAG_OPATTR, &asi);
+    assert_true(attr_syntax_add(asi, 0) == 0);
+    return asi;
+}
+
+/* A lookup following a schema change sees the change */
+void
+test_libslapd_schema_snapshot_refresh(void **state __attribute__((unused)))
+{
+    struct asyntaxinfo *a = snapshot_add_attr("test_snap_a", "1.1.0.0.0.1.1");
+    struct asyntaxinfo *asi = NULL;
+
+    /* builds the snapshot */
+    asi = attr_syntax_get_by_name("test_snap_a", 0);
+    assert_ptr_equal(asi, a);
+    attr_syntax_return(asi);
+    asi = attr_syntax_get_by_name("Test_Snap_A", 0);
+    assert_ptr_equal(asi, a);
+    attr_syntax_return(asi);
+
+    /* an added type is found by name and by oid */
+    struct asyntaxinfo *b = snapshot_add_attr("test_snap_b", "1.1.0.0.0.1.2");
+    asi = attr_syntax_get_by_name("test_snap_b", 0);
+    assert_ptr_equal(asi, b);
+    attr_syntax_return(asi);
+    asi = attr_syntax_get_by_name("1.1.0.0.0.1.2", 0);
+    assert_ptr_equal(asi, b);
+    attr_syntax_return(asi);
+    asi = attr_syntax_get_by_oid("1.1.0.0.0.1.2", 0);
+    assert_ptr_equal(asi, b);
+    attr_syntax_return(asi);
+
+    /* a pinned view does not change until it is unpinned */
+    attr_syntax_pin();
+    struct asyntaxinfo *c = snapshot_add_attr("test_snap_c", "1.1.0.0.0.1.3");
+    assert_int_equal(attr_syntax_exist_by_name_nolock("test_snap_a"), 1);
+    assert_int_equal(attr_syntax_exist_by_name_nolock("test_snap_c"), 0);
+    attr_syntax_unpin();
+    attr_syntax_pin();
+    assert_int_equal(attr_syntax_exist_by_name_nolock("test_snap_c"), 1);
+    attr_syntax_unpin();
+
+    /* a deleted type is not found anymore */
+    attr_syntax_delete(a, 0);
+    assert_null(attr_syntax_get_by_name("test_snap_a", 0));
+    assert_null(attr_syntax_get_by_oid("1.1.0.0.0.1.1", 0));
+    assert_int_equal(attr_syntax_exists("test_snap_a"), 0);
+    assert_int_equal(attr_syntax_exists("test_snap_b"), 1);
+
+    attr_syntax_delete(b, 0);
+    attr_syntax_delete(c, 0);
+    assert_int_equal(attr_syntax_retired_pending(), 0);
+}
+
+/* A deleted type is freed once no thread holds it */
+void
+test_libslapd_schema_snapshot_reclaim(void **state __attribute__((unused)))
+{
+    struct asyntaxinfo *a = snapshot_add_attr("test_reclaim_a", "1.1.0.0.0.2.1");
+    struct asyntaxinfo *b = snapshot_add_attr("test_reclaim_b", "1.1.0.0.0.2.2");
+    struct asyntaxinfo *held_a = NULL;
+    struct asyntaxinfo *held_b = NULL;
+
+    /* nobody reads, the deletion frees at once */
+    attr_syntax_delete(b, 0);
+    assert_int_equal(attr_syntax_retired_pending(), 0);
+
+    /* the reader keeps the deleted type alive */
+    held_a = attr_syntax_get_by_name("test_reclaim_a", 0);
+    assert_ptr_equal(held_a, a);
+    attr_syntax_delete(a, 0);
+    assert_true(attr_syntax_retired_pending() > 0);
+    assert_string_equal(held_a->asi_name, "test_reclaim_a");
+    assert_string_equal(held_a->asi_oid, "1.1.0.0.0.2.1");
+    assert_null(attr_syntax_get_by_name("test_reclaim_a", 0));
+
+    /* nested lookups: freed when the outermost one is returned */
+    b = snapshot_add_attr("test_reclaim_b", "1.1.0.0.0.2.2");
+    held_b = attr_syntax_get_by_name("test_reclaim_b", 0);
+    assert_ptr_equal(held_b, b);
+    attr_syntax_return(held_b);
+    assert_true(attr_syntax_retired_pending() > 0);
+    attr_syntax_return(held_a);
+    assert_int_equal(attr_syntax_retired_pending(), 0);
+
+    /* a pinned schema keeps the snapshot it looks up in alive */
+    attr_syntax_pin();
+    attr_syntax_delete(b, 0);
+    assert_true(attr_syntax_retired_pending() > 0);
+    assert_int_equal(attr_syntax_exist_by_name_nolock("test_reclaim_b"), 1);
+    attr_syntax_unpin();
+    assert_int_equal(attr_syntax_retired_pending(), 0);
+}
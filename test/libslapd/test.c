@@ -27,10 +27,19 @@ run_libslapd_tests(void)
         cmocka_unit_test(test_libslapd_pblock_v3c_original_target_dn),
         cmocka_unit_test(test_libslapd_pblock_v3c_target_uniqueid),
         cmocka_unit_test(test_libslapd_schema_filter_validate_simple),
+        cmocka_unit_test(test_libslapd_schema_snapshot_refresh),
+        cmocka_unit_test(test_libslapd_schema_snapshot_reclaim),
         cmocka_unit_test(test_libslapd_operation_v3c_target_spec),
         cmocka_unit_test(test_libslapd_counters_atomic_usage),
         cmocka_unit_test(test_libslapd_counters_atomic_overflow),
+        cmocka_unit_test(test_libslapd_attr_atom),
+        cmocka_unit_test(test_libslapd_entry_binary_roundtrip),
+        cmocka_unit_test(test_libslapd_entry_binary_truncated),
         cmocka_unit_test(test_libslapd_filter_optimise),
+        cmocka_unit_test(test_libslapd_filter_substr_match),
+        cmocka_unit_test(test_libslapd_mapping_tree_index),
+        cmocka_unit_test(test_libslapd_value_normalized),
+        cmocka_unit_test(test_libslapd_valueset_hash),
         cmocka_unit_test(test_libslapd_pal_meminfo),
         cmocka_unit_test(test_libslapd_util_cachesane),
         /* HAProxy header parsing tests */
@@ -0,0 +1,66 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#include "../../test_slapd.h"
+
+/* To access the cached normalized forms */
+#include <slap.h>
+
+void
+test_libslapd_value_normalized(void **state __attribute__((unused)))
+{
+    Slapi_Value *v = slapi_value_new_string("  John   SMITH ");
+    Slapi_Value *dup = NULL;
+    Slapi_Value stackv;
+    const struct berval *norm = NULL;
+    size_t size = value_size(v);
+
+    /* Start counting the forms attached by this thread */
+    value_normalized_uncharged();
+
+    /* Nothing cached yet */
+    assert_true(value_cache_normalized(v));
+    assert_null(value_get_normalized(v, 1));
+
+    /* Cached per syntax, the first form set wins */
+    norm = value_set_normalized(v, 1, slapi_ch_strdup("john smith"));
+    assert_string_equal(norm->bv_val, "john smith");
+    assert_int_equal(norm->bv_len, 10);
+    assert_ptr_equal(value_get_normalized(v, 1), norm);
+    assert_ptr_equal(value_set_normalized(v, 1, slapi_ch_strdup("other")), norm);
+    assert_null(value_get_normalized(v, 2));
+    norm = value_set_normalized(v, 2, slapi_ch_strdup("John SMITH"));
+    assert_string_equal(value_get_normalized(v, 2)->bv_val, "John SMITH");
+    assert_string_equal(value_get_normalized(v, 1)->bv_val, "john smith");
+    assert_true(value_size(v) > size);
+
+    /* The bytes attached are charged once, the rejected form is not */
+    assert_int_equal(value_normalized_uncharged(), value_size(v) - size);
+    assert_int_equal(value_normalized_uncharged(), 0);
+
+    /* Kept by a copy of the value */
+    dup = slapi_value_dup(v);
+    assert_string_equal(value_get_normalized(dup, 1)->bv_val, "john smith");
+    assert_string_equal(value_get_normalized(dup, 2)->bv_val, "John SMITH");
+    assert_ptr_not_equal(value_get_normalized(dup, 1), value_get_normalized(v, 1));
+
+    /* Dropped when the value changes */
+    slapi_value_set_string(v, "Jane");
+    assert_null(value_get_normalized(v, 1));
+    assert_null(value_get_normalized(v, 2));
+    assert_true(value_cache_normalized(v));
+    assert_int_equal(value_size(v), size - strlen("  John   SMITH ") + strlen("Jane"));
+
+    /* Values on the stack do not cache */
+    slapi_value_init_string(&stackv, "John");
+    assert_false(value_cache_normalized(&stackv));
+    value_done(&stackv);
+
+    slapi_value_free(&v);
+    slapi_value_free(&dup);
+}
@@ -0,0 +1,80 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#include "../../test_slapd.h"
+
+/* To access valueset_remove_valuearray */
+#include <slap.h>
+
+#define TEST_VALUESET_NB 2000
+
+void
+test_libslapd_valueset_hash(void **state __attribute__((unused)))
+{
+    Slapi_ValueSet *vs = slapi_valueset_new();
+    Slapi_Value **vals = (Slapi_Value **)slapi_ch_calloc(TEST_VALUESET_NB + 1, sizeof(Slapi_Value *));
+    Slapi_Value **dels = (Slapi_Value **)slapi_ch_calloc(TEST_VALUESET_NB / 2 + 1, sizeof(Slapi_Value *));
+    Slapi_Value *v = NULL;
+    char *s = NULL;
+    int dup_index = -1;
+
+    /* Without attribute the values are compared case insensitively, like DNs */
+    for (size_t i = 0; i < TEST_VALUESET_NB; i++) {
+        s = slapi_ch_smprintf("uid=user%zu,ou=people,dc=example,dc=com", i);
+        vals[i] = slapi_value_new_string_passin(s);
+    }
+    assert_int_equal(slapi_valueset_add_attr_valuearray_ext(NULL, vs, vals, TEST_VALUESET_NB, SLAPI_VALUE_FLAG_DUPCHECK, NULL), LDAP_SUCCESS);
+    assert_int_equal(slapi_valueset_count(vs), TEST_VALUESET_NB);
+    assert_non_null(vs->hash);
+    assert_null(vs->sorted);
+
+    /* Membership */
+    v = slapi_value_new_string("UID=USER1234,OU=People,DC=example,DC=com");
+    assert_non_null(slapi_valueset_find(NULL, vs, v));
+    slapi_value_free(&v);
+    v = slapi_value_new_string("uid=user2000,ou=people,dc=example,dc=com");
+    assert_null(slapi_valueset_find(NULL, vs, v));
+
+    /* Duplicates are refused, new values are indexed */
+    assert_int_equal(slapi_valueset_add_attr_valuearray_ext(NULL, vs, &vals[10], 1, SLAPI_VALUE_FLAG_DUPCHECK, &dup_index), LDAP_TYPE_OR_VALUE_EXISTS);
+    assert_int_equal(dup_index, 0);
+    assert_int_equal(slapi_valueset_add_attr_valuearray_ext(NULL, vs, &v, 1, SLAPI_VALUE_FLAG_DUPCHECK, NULL), LDAP_SUCCESS);
+    assert_non_null(slapi_valueset_find(NULL, vs, v));
+    assert_int_equal(slapi_valueset_count(vs), TEST_VALUESET_NB + 1);
+    slapi_value_free(&v);
+
+    /* Remove the even values */
+    for (size_t i = 0; i < TEST_VALUESET_NB / 2; i++) {
+        dels[i] = slapi_value_dup(vals[i * 2]);
+    }
+    assert_int_equal(valueset_remove_valuearray(vs, NULL, dels, 0, NULL), LDAP_SUCCESS);
+    assert_int_equal(slapi_valueset_count(vs), TEST_VALUESET_NB / 2 + 1);
+    for (size_t i = 0; i < TEST_VALUESET_NB; i++) {
+        if (i % 2) {
+            assert_ptr_not_equal(slapi_valueset_find(NULL, vs, vals[i]), NULL);
+        } else {
+            assert_null(slapi_valueset_find(NULL, vs, vals[i]));
+        }
+    }
+    for (size_t i = 0; i < slapi_valueset_count(vs); i++) {
+        assert_non_null(vs->va[i]);
+    }
+    assert_null(vs->va[slapi_valueset_count(vs)]);
+
+    /* A single value */
+    v = valueset_remove_value(NULL, vs, vals[1]);
+    assert_non_null(v);
+    slapi_value_free(&v);
+    assert_null(slapi_valueset_find(NULL, vs, vals[1]));
+    assert_non_null(slapi_valueset_find(NULL, vs, vals[3]));
+    assert_int_equal(slapi_valueset_count(vs), TEST_VALUESET_NB / 2);
+
+    valuearray_free(&dels);
+    valuearray_free(&vals);
+    slapi_valueset_free(vs);
+}
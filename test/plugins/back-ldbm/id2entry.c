@@ -0,0 +1,139 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#include "../../test_slapd.h"
+
+#include <back-ldbm.h>
+
+static const char id2entry_record[] =
+    "rdn: uid=member\n"
+    "objectClass: top\n"
+    "objectClass: person\n"
+    "objectClass: organizationalPerson\n"
+    "objectClass: inetOrgPerson\n"
+    "uid: member\n"
+    "cn: Member\n"
+    "sn: Member\n"
+    "mail: member@example.com\n"
+    "creatorsName: cn=directory manager\n"
+    "modifiersName: cn=directory manager\n"
+    "createTimestamp: 20260101000000Z\n"
+    "modifyTimestamp: 20260101000000Z\n"
+    "nsUniqueId: 11111111-22222222-33333333-44444444\n"
+    "parentid: 1\n"
+    "entryid: 2\n";
+
+/* A backend without suffix and with id2entry compression on */
+static backend *
+id2entry_test_backend(void)
+{
+    backend *be = (backend *)slapi_ch_calloc(1, sizeof(backend));
+    ldbm_instance *inst = (ldbm_instance *)slapi_ch_calloc(1, sizeof(ldbm_instance));
+    struct ldbminfo *li = (struct ldbminfo *)slapi_ch_calloc(1, sizeof(struct ldbminfo));
+
+    li->li_id2entry_compression = 1;
+    inst->inst_li = li;
+    inst->inst_be = be;
+    inst->inst_name = "userroot";
+    inst->inst_config_mutex = PR_NewLock();
+    inst->inst_id2entry_rawbytes = slapi_counter_new();
+    inst->inst_id2entry_packedbytes = slapi_counter_new();
+    inst->inst_id2entry_decodes = slapi_counter_new();
+    inst->inst_id2entry_decode_ns = slapi_counter_new();
+    be->be_instance_info = inst;
+    return be;
+}
+
+static void
+id2entry_test_backend_free(backend *be)
+{
+    ldbm_instance *inst = (ldbm_instance *)be->be_instance_info;
+
+    id2entry_free_dict(inst);
+    slapi_counter_destroy(&inst->inst_id2entry_rawbytes);
+    slapi_counter_destroy(&inst->inst_id2entry_packedbytes);
+    slapi_counter_destroy(&inst->inst_id2entry_decodes);
+    slapi_counter_destroy(&inst->inst_id2entry_decode_ns);
+    PR_DestroyLock(inst->inst_config_mutex);
+    slapi_ch_free((void **)&inst->inst_li);
+    slapi_ch_free((void **)&inst);
+    slapi_ch_free((void **)&be);
+}
+
+void
+test_plugin_back_ldbm_id2entry_roundtrip(void **state __attribute__((unused)))
+{
+    backend *be = id2entry_test_backend();
+    uint32_t size = sizeof(id2entry_record) - 1;
+    char *packed = NULL;
+    char *plain = NULL;
+    uint32_t packedsize = 0;
+    uint32_t plainsize = 0;
+
+    assert_int_equal(id2entry_compress(be, id2entry_record, size, &packed, &packedsize), 1);
+    assert_true(packedsize < size);
+    assert_true(id2entry_is_compressed(packed, packedsize));
+    assert_false(id2entry_is_compressed(id2entry_record, size));
+
+    assert_int_equal(id2entry_decompress(be, packed, packedsize, &plain, &plainsize), 1);
+    assert_int_equal(plainsize, size);
+    assert_memory_equal(plain, id2entry_record, size);
+    assert_int_equal(plain[size], '\0');
+    slapi_ch_free_string(&plain);
+
+    /* the tools derive the same dictionary from the suffix */
+    assert_int_equal(id2entry_decompress_with_suffix(NULL, packed, packedsize, &plain, &plainsize), 1);
+    assert_memory_equal(plain, id2entry_record, size);
+    slapi_ch_free_string(&plain);
+    /* and another suffix gives another dictionary */
+    assert_int_equal(id2entry_decompress_with_suffix("dc=example,dc=com", packed, packedsize, &plain, &plainsize), -1);
+    assert_null(plain);
+
+    /* a plain record is left as is */
+    assert_int_equal(id2entry_decompress(be, id2entry_record, size, &plain, &plainsize), 0);
+    assert_null(plain);
+
+    /* short records are not compressed */
+    assert_int_equal(id2entry_compress(be, id2entry_record, 32, &plain, &plainsize), 0);
+    assert_null(plain);
+
+    slapi_ch_free_string(&packed);
+    id2entry_test_backend_free(be);
+}
+
+void
+test_plugin_back_ldbm_id2entry_truncated(void **state __attribute__((unused)))
+{
+    backend *be = id2entry_test_backend();
+    uint32_t size = sizeof(id2entry_record) - 1;
+    char *packed = NULL;
+    char *plain = NULL;
+    uint32_t packedsize = 0;
+    uint32_t plainsize = 0;
+
+    assert_int_equal(id2entry_compress(be, id2entry_record, size, &packed, &packedsize), 1);
+
+    /* every truncation of the deflate stream (after the 12 bytes header) is rejected */
+    for (uint32_t len = packedsize - 1; len > 12; len--) {
+        assert_int_equal(id2entry_decompress(be, packed, len, &plain, &plainsize), -1);
+        assert_null(plain);
+    }
+
+    /* a raw length that does not match the stream is rejected */
+    packed[8]--;
+    assert_int_equal(id2entry_decompress(be, packed, packedsize, &plain, &plainsize), -1);
+    assert_null(plain);
+
+    /* so is one the stream can not expand to, without allocating it */
+    packed[8] = packed[9] = packed[10] = packed[11] = (char)0xff;
+    assert_int_equal(id2entry_decompress(be, packed, packedsize, &plain, &plainsize), -1);
+    assert_null(plain);
+
+    slapi_ch_free_string(&packed);
+    id2entry_test_backend_free(be);
+}
@@ -0,0 +1,224 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#include "../../test_slapd.h"
+
+#include <ftw.h>
+#include <db-mdb/mdb_layer.h>
+
+/*
+ * Layout of the backup manifest header (see mdb_backup.c): magic,
+ * u32 byte order, u32 chunk size, u64 snapshot size, u64 id, u64 base
+ * backup id, u32 level, u32 base backup path length, base backup path.
+ */
+#define MANIFEST_ID_OFFSET 24
+#define MANIFEST_PARENTID_OFFSET 32
+#define MANIFEST_LEVEL_OFFSET 40
+#define MANIFEST_PARENTLEN_OFFSET 44
+#define MANIFEST_HDR_SIZE 48
+
+typedef struct
+{
+    char top[64];
+    struct ldbminfo li;
+    dbmdb_ctx_t ctx;
+} mdbbackup_test;
+
+static char *
+mdbbackup_path(mdbbackup_test *t, const char *dir)
+{
+    return slapi_ch_smprintf("%s/%s", t->top, dir);
+}
+
+static void
+mdbbackup_mkdir(mdbbackup_test *t, const char *dir)
+{
+    char *path = mdbbackup_path(t, dir);
+
+    assert_int_equal(mkdir(path, 0700), 0);
+    slapi_ch_free_string(&path);
+}
+
+static MDB_env *
+mdbbackup_open(mdbbackup_test *t, const char *dir)
+{
+    char *path = mdbbackup_path(t, dir);
+    MDB_env *env = NULL;
+
+    assert_int_equal(mdb_env_create(&env), 0);
+    assert_int_equal(mdb_env_set_mapsize(env, 64 * 1024 * 1024), 0);
+    assert_int_equal(mdb_env_open(env, path, 0, 0600), 0);
+    slapi_ch_free_string(&path);
+    return env;
+}
+
+/* Add the keys [from, to[ with 1KB values, so that they span many chunks */
+static void
+mdbbackup_put(MDB_env *env, int from, int to)
+{
+    char key[16];
+    char data[1024];
+    MDB_txn *txn = NULL;
+    MDB_dbi dbi;
+
+    assert_int_equal(mdb_txn_begin(env, NULL, 0, &txn), 0);
+    assert_int_equal(mdb_dbi_open(txn, NULL, 0, &dbi), 0);
+    for (int i = from; i < to; i++) {
+        MDB_val k = {snprintf(key, sizeof key, "key%06d", i), key};
+        MDB_val v = {sizeof data, data};
+
+        memset(data, 'a' + i % 26, sizeof data);
+        assert_int_equal(mdb_put(txn, dbi, &k, &v, 0), 0);
+    }
+    assert_int_equal(mdb_txn_commit(txn), 0);
+}
+
+/* Return the number of keys of the database restored in dir */
+static size_t
+mdbbackup_count(mdbbackup_test *t, const char *dir)
+{
+    MDB_env *env = mdbbackup_open(t, dir);
+    MDB_stat st = {0};
+
+    assert_int_equal(mdb_env_stat(env, &st), 0);
+    mdb_env_close(env);
+    return st.ms_entries;
+}
+
+static int
+mdbbackup_backup(mdbbackup_test *t, const char *dest, const char *base)
+{
+    char *dest_dir = mdbbackup_path(t, dest);
+    char *base_dir = base ? mdbbackup_path(t, base) : NULL;
+    int rc;
+
+    mdbbackup_mkdir(t, dest);
+    rc = dbmdb_backup_copy(&t->li, dest_dir, base_dir, NULL);
+    slapi_ch_free_string(&dest_dir);
+    slapi_ch_free_string(&base_dir);
+    return rc;
+}
+
+static int
+mdbbackup_restore(mdbbackup_test *t, const char *src, const char *dest)
+{
+    char *src_dir = mdbbackup_path(t, src);
+    int rc;
+
+    mdbbackup_mkdir(t, dest);
+    PR_snprintf(t->ctx.home, sizeof t->ctx.home, "%s/%s", t->top, dest);
+    rc = dbmdb_restore_mapfile(&t->li, src_dir, NULL);
+    slapi_ch_free_string(&src_dir);
+    return rc;
+}
+
+/* Read the manifest header of the backup in dir, returns the base backup path */
+static char *
+mdbbackup_manifest(mdbbackup_test *t, const char *dir, unsigned char *hdr)
+{
+    char *path = slapi_ch_smprintf("%s/%s/%s", t->top, dir, BACKUP_MANIFEST);
+    char *parent = NULL;
+    uint32_t parentlen;
+    FILE *f = fopen(path, "r");
+
+    assert_non_null(f);
+    assert_int_equal(fread(hdr, 1, MANIFEST_HDR_SIZE, f), MANIFEST_HDR_SIZE);
+    assert_memory_equal(hdr, "MDBBKMF1", 8);
+    memcpy(&parentlen, hdr + MANIFEST_PARENTLEN_OFFSET, sizeof parentlen);
+    parent = slapi_ch_calloc(1, parentlen + 1);
+    assert_int_equal(fread(parent, 1, parentlen, f), parentlen);
+    fclose(f);
+    slapi_ch_free_string(&path);
+    return parent;
+}
+
+static int
+mdbbackup_rm(const char *path, const struct stat *sb __attribute__((unused)),
+             int flag __attribute__((unused)), struct FTW *ftw __attribute__((unused)))
+{
+    return remove(path);
+}
+
+void
+test_plugin_back_ldbm_mdbbackup_chain(void **state __attribute__((unused)))
+{
+    mdbbackup_test t = {0};
+    unsigned char hdr[3][MANIFEST_HDR_SIZE];
+    unsigned char delta[MANIFEST_HDR_SIZE];
+    char *parent = NULL;
+    char *path = NULL;
+    uint32_t level;
+    MDB_env *env = NULL;
+    FILE *f = NULL;
+
+    strcpy(t.top, "/tmp/mdbbackup.XXXXXX");
+    assert_non_null(mkdtemp(t.top));
+    t.li.li_dblayer_config = &t.ctx;
+    t.li.li_mode = 0600;
+    mdbbackup_mkdir(&t, "db");
+    mdbbackup_mkdir(&t, "bak");
+    env = mdbbackup_open(&t, "db");
+    t.ctx.env = env;
+
+    /* a full backup then two incremental ones */
+    mdbbackup_put(env, 0, 1000);
+    assert_int_equal(mdbbackup_backup(&t, "bak/full", NULL), 0);
+    mdbbackup_put(env, 1000, 1500);
+    assert_int_equal(mdbbackup_backup(&t, "bak/inc1", "bak/full"), 0);
+    mdbbackup_put(env, 1500, 2000);
+    assert_int_equal(mdbbackup_backup(&t, "bak/inc2", "bak/inc1"), 0);
+    mdb_env_close(env);
+
+    /* the manifests link each backup to its base with a relative path */
+    parent = mdbbackup_manifest(&t, "bak/full", hdr[0]);
+    assert_string_equal(parent, "");
+    slapi_ch_free_string(&parent);
+    parent = mdbbackup_manifest(&t, "bak/inc1", hdr[1]);
+    assert_string_equal(parent, "../full");
+    slapi_ch_free_string(&parent);
+    parent = mdbbackup_manifest(&t, "bak/inc2", hdr[2]);
+    assert_string_equal(parent, "../inc1");
+    slapi_ch_free_string(&parent);
+    for (int i = 0; i < 3; i++) {
+        memcpy(&level, hdr[i] + MANIFEST_LEVEL_OFFSET, sizeof level);
+        assert_int_equal(level, i);
+    }
+    assert_memory_equal(hdr[1] + MANIFEST_PARENTID_OFFSET, hdr[0] + MANIFEST_ID_OFFSET, 8);
+    assert_memory_equal(hdr[2] + MANIFEST_PARENTID_OFFSET, hdr[1] + MANIFEST_ID_OFFSET, 8);
+
+    /* the delta has the same header, with its own magic */
+    path = slapi_ch_smprintf("%s/bak/inc2/%s", t.top, DBDELTAFILE);
+    f = fopen(path, "r");
+    assert_non_null(f);
+    assert_int_equal(fread(delta, 1, sizeof delta, f), sizeof delta);
+    fclose(f);
+    slapi_ch_free_string(&path);
+    assert_memory_equal(delta, "MDBBKDL1", 8);
+    assert_memory_equal(delta + 8, hdr[2] + 8, MANIFEST_HDR_SIZE - 8);
+
+    /* the chain is restored after it was moved as a whole */
+    path = mdbbackup_path(&t, "bak");
+    parent = mdbbackup_path(&t, "moved");
+    assert_int_equal(rename(path, parent), 0);
+    slapi_ch_free_string(&path);
+    slapi_ch_free_string(&parent);
+    assert_int_equal(mdbbackup_restore(&t, "moved/inc2", "restore2"), 0);
+    assert_int_equal(mdbbackup_count(&t, "restore2"), 2000);
+    assert_int_equal(mdbbackup_restore(&t, "moved/inc1", "restore1"), 0);
+    assert_int_equal(mdbbackup_count(&t, "restore1"), 1500);
+    assert_int_equal(mdbbackup_restore(&t, "moved/full", "restore0"), 0);
+    assert_int_equal(mdbbackup_count(&t, "restore0"), 1000);
+
+    /* but not without one of its links */
+    path = slapi_ch_smprintf("%s/moved/inc1/%s", t.top, BACKUP_MANIFEST);
+    assert_int_equal(unlink(path), 0);
+    slapi_ch_free_string(&path);
+    assert_int_equal(mdbbackup_restore(&t, "moved/inc2", "restore3"), -1);
+
+    assert_int_equal(nftw(t.top, mdbbackup_rm, 16, FTW_DEPTH | FTW_PHYS), 0);
+}
@@ -0,0 +1,114 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#include "../../test_slapd.h"
+
+#include <back-ldbm.h>
+
+/*
+ * The parent links read from the database: suffix 1 with children 2 and 3,
+ * 4 below 3.
+ */
+static ID *
+scopeindex_read(ID *size)
+{
+    ID *parent = (ID *)slapi_ch_malloc(8 * sizeof(ID));
+
+    for (ID id = 0; id < 8; id++) {
+        parent[id] = (ID)-1;
+    }
+    parent[1] = 0;
+    parent[2] = 1;
+    parent[3] = 1;
+    parent[4] = 3;
+    *size = 8;
+    return parent;
+}
+
+static IDList *
+scopeindex_allids(void)
+{
+    IDList *idl = idl_alloc(1);
+
+    idl->b_nmax = ALLIDSBLOCK;
+    return idl;
+}
+
+static void
+scopeindex_assert_subtree(struct scope_index *si, ID base, const ID *expected, NIDS nexpected)
+{
+    IDList *all = scopeindex_allids();
+    IDList *idl = scope_index_subtree_ids(si, base, all);
+
+    assert_non_null(idl);
+    assert_int_equal(idl->b_nids, nexpected);
+    for (NIDS i = 0; i < nexpected; i++) {
+        assert_int_equal(idl->b_ids[i], expected[i]);
+    }
+    idl_free(&idl);
+    idl_free(&all);
+}
+
+/* An add not committed when the first build reads the database is not lost */
+void
+test_plugin_back_ldbm_scopeindex_add_race(void **state __attribute__((unused)))
+{
+    struct scope_index *si = scope_index_new();
+    const ID tree[] = {1, 2, 3, 4, 5, 6};
+    const ID subtree[] = {3, 4, 6};
+    ID *parent;
+    ID size = 0;
+
+    /* 5 is added below 2 before the build starts, its commit is not done */
+    scope_index_update_si(si, 1, 5, 2, 1);
+    /* the first subtree search builds the index */
+    assert_int_equal(scope_index_build_begin_si(si), 1);
+    assert_int_equal(scope_index_build_begin_si(si), 0);
+    parent = scopeindex_read(&size);
+    /* 5 is committed while the build reads, 6 is added below 4 */
+    scope_index_add_done_si(si, 5);
+    scope_index_update_si(si, 1, 6, 4, 1);
+    assert_int_equal(scope_index_build_end_si(si, 1, 0, parent, size), 6);
+    scope_index_add_done_si(si, 6);
+
+    scopeindex_assert_subtree(si, 1, tree, 6);
+    scopeindex_assert_subtree(si, 3, subtree, 3);
+
+    scope_index_free(&si);
+    assert_null(si);
+}
+
+/* The updates received before the build are only kept while uncommitted */
+void
+test_plugin_back_ldbm_scopeindex_committed(void **state __attribute__((unused)))
+{
+    struct scope_index *si = scope_index_new();
+    const ID tree[] = {1, 2, 3, 4};
+    ID *parent;
+    ID size = 0;
+
+    /* 7 is added and its transaction aborted before the build */
+    scope_index_update_si(si, 1, 7, 2, 1);
+    scope_index_add_done_si(si, 7);
+    assert_int_equal(scope_index_build_begin_si(si), 1);
+    parent = scopeindex_read(&size);
+    assert_int_equal(scope_index_build_end_si(si, 1, 0, parent, size), 4);
+    scopeindex_assert_subtree(si, 1, tree, 4);
+
+    /* a failed read or a disabled index is not published */
+    scope_index_free(&si);
+    si = scope_index_new();
+    assert_int_equal(scope_index_build_begin_si(si), 1);
+    parent = scopeindex_read(&size);
+    assert_int_equal(scope_index_build_end_si(si, 1, -1, parent, size), -1);
+    assert_int_equal(scope_index_build_begin_si(si), 1);
+    parent = scopeindex_read(&size);
+    assert_int_equal(scope_index_build_end_si(si, 0, 0, parent, size), -1);
+
+    scope_index_free(&si);
+}
@@ -0,0 +1,226 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#include "../../test_slapd.h"
+
+#include <slap.h>
+#include <cb.h>
+
+static cb_backend_instance *
+searchcache_inst(int ttl, int maxentries)
+{
+    cb_backend_instance *inst = (cb_backend_instance *)slapi_ch_calloc(1, sizeof(cb_backend_instance));
+
+    inst->rwl_config_lock = slapi_new_rwlock();
+    inst->searchcache_ttl = ttl;
+    inst->searchcache_maxentries = maxentries;
+    cb_search_cache_init(inst);
+    return inst;
+}
+
+static void
+searchcache_inst_free(cb_backend_instance *inst)
+{
+    cb_search_cache_free(inst);
+    slapi_destroy_rwlock(inst->rwl_config_lock);
+    slapi_ch_free((void **)&inst);
+}
+
+/* A subtree search of dc=example,dc=com sent with the given controls */
+static Slapi_PBlock *
+searchcache_pb(LDAPControl **controls)
+{
+    Slapi_PBlock *pb = slapi_pblock_new();
+    Slapi_Operation *op = slapi_operation_new(SLAPI_OP_FLAG_INTERNAL);
+    int scope = LDAP_SCOPE_SUBTREE;
+    int zero = 0;
+
+    assert_int_equal(slapi_pblock_set(pb, SLAPI_OPERATION, op), 0);
+    slapi_pblock_set(pb, SLAPI_REQUESTOR_DN, "uid=reader,dc=example,dc=com");
+    slapi_pblock_set(pb, SLAPI_SEARCH_TARGET_SDN, slapi_sdn_new_dn_byval("dc=example,dc=com"));
+    slapi_pblock_set(pb, SLAPI_SEARCH_SCOPE, &scope);
+    slapi_pblock_set(pb, SLAPI_SEARCH_STRFILTER, "(uid=member)");
+    slapi_pblock_set(pb, SLAPI_SEARCH_ATTRSONLY, &zero);
+    slapi_pblock_set(pb, SLAPI_SEARCH_SIZELIMIT, &zero);
+    slapi_pblock_set(pb, SLAPI_REQCONTROLS, controls);
+    return pb;
+}
+
+static void
+searchcache_pb_free(Slapi_PBlock *pb)
+{
+    Slapi_DN *sdn = NULL;
+
+    slapi_pblock_get(pb, SLAPI_SEARCH_TARGET_SDN, &sdn);
+    slapi_sdn_free(&sdn);
+    slapi_pblock_set(pb, SLAPI_REQCONTROLS, NULL);
+    slapi_pblock_destroy(pb);
+}
+
+static Slapi_Entry *
+searchcache_entry(const char *dn)
+{
+    Slapi_Entry *e = slapi_entry_alloc();
+
+    slapi_entry_init(e, slapi_ch_strdup(dn), NULL);
+    slapi_entry_add_string(e, "uid", "member");
+    return e;
+}
+
+/* Cache a result of nbentries entries under key */
+static void
+searchcache_put(cb_backend_instance *inst, const char *key, size_t nbentries, int rc)
+{
+    cb_search_cache_fill *fill = NULL;
+
+    fill = cb_search_cache_fill_new(inst, slapi_ch_strdup(key), cb_search_cache_generation(inst));
+    assert_non_null(fill);
+    for (size_t i = 0; i < nbentries; i++) {
+        Slapi_Entry *e = searchcache_entry("uid=member,dc=example,dc=com");
+        cb_search_cache_fill_add(inst, &fill, e);
+        slapi_entry_free(e);
+    }
+    cb_search_cache_fill_done(inst, &fill, rc);
+    assert_null(fill);
+}
+
+/* Return the number of entries cached under key, -1 if it is not cached */
+static int
+searchcache_lookup(cb_backend_instance *inst, const char *key)
+{
+    Slapi_Entry **entries = NULL;
+    size_t nbentries = 0;
+    int rc = LDAP_SUCCESS;
+
+    if (!cb_search_cache_get(inst, key, &entries, &nbentries, &rc)) {
+        return -1;
+    }
+    for (size_t i = 0; i < nbentries; i++) {
+        assert_non_null(entries[i]);
+        slapi_entry_free(entries[i]);
+    }
+    assert_null(entries[nbentries]);
+    slapi_ch_free((void **)&entries);
+    return (int)nbentries;
+}
+
+void
+test_plugin_chainingdb_searchcache_key(void **state __attribute__((unused)))
+{
+    cb_backend_instance *inst = searchcache_inst(60, 100);
+    char oid[] = "1.2.3";
+    LDAPControl ctrl = {.ldctl_oid = oid, .ldctl_value = {0, NULL}, .ldctl_iscritical = 0};
+    LDAPControl *controls[] = {&ctrl, NULL};
+    char *attrs_ctrl[] = {"1.2.3", "0", "", NULL};
+    char *attrs_split[] = {"1:a", NULL};
+    char *attrs_joined[] = {"1", "a", NULL};
+    Slapi_PBlock *pb, *pb_ctrl;
+    char *key1, *key2;
+
+    ndn_cache_init();
+    pb = searchcache_pb(NULL);
+    pb_ctrl = searchcache_pb(controls);
+
+    /* identical searches share their key */
+    key1 = cb_search_cache_key(inst, pb, attrs_split);
+    key2 = cb_search_cache_key(inst, pb, attrs_split);
+    assert_non_null(key1);
+    assert_string_equal(key1, key2);
+    slapi_ch_free_string(&key2);
+
+    /* the components are length prefixed */
+    key2 = cb_search_cache_key(inst, pb, attrs_joined);
+    assert_string_not_equal(key1, key2);
+    slapi_ch_free_string(&key1);
+    slapi_ch_free_string(&key2);
+
+    /*
+     * The components of a control (oid, criticality, value) must not be
+     * taken for requested attributes: an empty component separates them.
+     */
+    key1 = cb_search_cache_key(inst, pb, attrs_ctrl);
+    key2 = cb_search_cache_key(inst, pb_ctrl, NULL);
+    assert_string_not_equal(key1, key2);
+    slapi_ch_free_string(&key1);
+    slapi_ch_free_string(&key2);
+
+    /* no key when the cache is disabled */
+    inst->searchcache_ttl = 0;
+    assert_null(cb_search_cache_key(inst, pb, NULL));
+
+    searchcache_pb_free(pb);
+    searchcache_pb_free(pb_ctrl);
+    searchcache_inst_free(inst);
+    ndn_cache_destroy();
+}
+
+void
+test_plugin_chainingdb_searchcache_flush(void **state __attribute__((unused)))
+{
+    cb_backend_instance *inst = searchcache_inst(60, 100);
+    cb_search_cache_fill *fill = NULL;
+    Slapi_Entry *e = searchcache_entry("uid=member,dc=example,dc=com");
+
+    /* a result read while a write is sent is not cached */
+    fill = cb_search_cache_fill_new(inst, slapi_ch_strdup("search"), cb_search_cache_generation(inst));
+    cb_search_cache_fill_add(inst, &fill, e);
+    cb_search_cache_flush(inst);
+    cb_search_cache_fill_done(inst, &fill, LDAP_SUCCESS);
+    assert_null(fill);
+    assert_int_equal(searchcache_lookup(inst, "search"), -1);
+
+    /* the next one is */
+    searchcache_put(inst, "search", 1, LDAP_SUCCESS);
+    assert_int_equal(searchcache_lookup(inst, "search"), 1);
+
+    /* and a write flushes it */
+    cb_search_cache_flush(inst);
+    assert_int_equal(searchcache_lookup(inst, "search"), -1);
+
+    /* a failed search is not cached */
+    searchcache_put(inst, "search", 0, LDAP_BUSY);
+    assert_int_equal(searchcache_lookup(inst, "search"), -1);
+
+    slapi_entry_free(e);
+    searchcache_inst_free(inst);
+}
+
+void
+test_plugin_chainingdb_searchcache_evict(void **state __attribute__((unused)))
+{
+    cb_backend_instance *inst = searchcache_inst(60, 4);
+    uint64_t hits, misses;
+    size_t nbentries;
+
+    searchcache_put(inst, "a", 2, LDAP_SUCCESS);
+    searchcache_put(inst, "b", 1, LDAP_SUCCESS);
+    /* a missing base counts as one entry */
+    searchcache_put(inst, "c", 0, LDAP_NO_SUCH_OBJECT);
+    cb_search_cache_get_stats(inst, &hits, &misses, &nbentries);
+    assert_int_equal(nbentries, 4);
+
+    /* the oldest result makes room for the new one */
+    searchcache_put(inst, "d", 1, LDAP_SUCCESS);
+    assert_int_equal(searchcache_lookup(inst, "a"), -1);
+    assert_int_equal(searchcache_lookup(inst, "b"), 1);
+    assert_int_equal(searchcache_lookup(inst, "c"), 0);
+    assert_int_equal(searchcache_lookup(inst, "d"), 1);
+    cb_search_cache_get_stats(inst, &hits, &misses, &nbentries);
+    assert_int_equal(nbentries, 3);
+
+    /* a result larger than the cache is not cached and evicts nothing */
+    searchcache_put(inst, "e", 5, LDAP_SUCCESS);
+    assert_int_equal(searchcache_lookup(inst, "e"), -1);
+    assert_int_equal(searchcache_lookup(inst, "b"), 1);
+    cb_search_cache_get_stats(inst, &hits, &misses, &nbentries);
+    assert_int_equal(nbentries, 3);
+    assert_int_equal(hits, 4);
+    assert_int_equal(misses, 2);
+
+    searchcache_inst_free(inst);
+}
@@ -0,0 +1,184 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#include "../../test_slapd.h"
+
+#include <slap.h>
+#include <vattr_spi.h>
+#include <cos_cache.h>
+
+#define TEST_SUFFIX "dc=example,dc=com"
+
+/* Number of times the testGrade virtual attribute was computed */
+static int cache_grade_gets = 0;
+
+/* testGrade is a virtual copy of testGradeSource */
+static int
+cache_grade_get(vattr_sp_handle *handle __attribute__((unused)),
+                vattr_context *c __attribute__((unused)),
+                Slapi_Entry *e,
+                char *type,
+                Slapi_ValueSet **results,
+                int *type_name_disposition,
+                char **actual_type_name,
+                int flags __attribute__((unused)),
+                int *free_flags,
+                void *hint __attribute__((unused)))
+{
+    Slapi_Attr *attr = NULL;
+
+    cache_grade_gets++;
+    if (slapi_entry_attr_find(e, "testGradeSource", &attr)) {
+        return SLAPI_VIRTUALATTRS_NOT_FOUND;
+    }
+    slapi_attr_get_valueset(attr, results);
+    *type_name_disposition = SLAPI_VIRTUALATTRS_TYPE_NAME_MATCHED_EXACTLY_OR_ALIAS;
+    *actual_type_name = slapi_ch_strdup(type);
+    *free_flags = SLAPI_VIRTUALATTRS_RETURNED_COPIES;
+    return 0;
+}
+
+static int
+cache_grade_compare(vattr_sp_handle *handle __attribute__((unused)),
+                    vattr_context *c __attribute__((unused)),
+                    Slapi_Entry *e __attribute__((unused)),
+                    char *type __attribute__((unused)),
+                    Slapi_Value *test_this __attribute__((unused)),
+                    int *result __attribute__((unused)),
+                    int flags __attribute__((unused)),
+                    void *hint __attribute__((unused)))
+{
+    return SLAPI_VIRTUALATTRS_NOT_FOUND;
+}
+
+static int
+cache_grade_types(vattr_sp_handle *handle __attribute__((unused)),
+                  Slapi_Entry *e __attribute__((unused)),
+                  vattr_type_list_context *type_context __attribute__((unused)),
+                  int flags __attribute__((unused)))
+{
+    return 0;
+}
+
+static void
+cache_register_grade(void)
+{
+    static vattr_sp_handle *handle = NULL;
+
+    if (handle == NULL) {
+        vattr_init();
+        assert_int_equal(slapi_vattrspi_register(&handle, cache_grade_get, cache_grade_compare, cache_grade_types), 0);
+        assert_int_equal(slapi_vattrspi_regattr(handle, "testGrade", NULL, NULL), 0);
+    }
+}
+
+static Slapi_Entry *
+cache_entry(const char *dn, const char *grade)
+{
+    Slapi_Entry *e = slapi_entry_alloc();
+
+    slapi_entry_init(e, slapi_ch_strdup(dn), NULL);
+    slapi_entry_add_string(e, "uid", "member");
+    if (grade) {
+        slapi_entry_add_string(e, "testGradeSource", grade);
+    }
+    return e;
+}
+
+/*
+ * Query testCosAttr on an entry with the given grade, returns the value
+ * found (NULL if none) and checks the grade was computed gets times
+ */
+static char *
+cache_query(cos_cache *cache, const char *dn, const char *grade, int gets)
+{
+    Slapi_Entry *e = cache_entry(dn, grade);
+    Slapi_ValueSet *vs = NULL;
+    Slapi_Value *v = NULL;
+    char *value = NULL;
+
+    cache_grade_gets = 0;
+    if (cos_cache_test_query(cache, e, "testCosAttr", &vs) == 0) {
+        assert_int_equal(slapi_valueset_count(vs), 1);
+        slapi_valueset_first_value(vs, &v);
+        value = slapi_ch_strdup(slapi_value_get_string(v));
+    }
+    assert_int_equal(cache_grade_gets, gets);
+    slapi_valueset_free(vs);
+    slapi_entry_free(e);
+    return value;
+}
+
+static void
+cache_check(cos_cache *cache, const char *dn, const char *grade, int gets, const char *expected)
+{
+    char *value = cache_query(cache, dn, grade, gets);
+
+    if (expected) {
+        assert_non_null(value);
+        assert_string_equal(value, expected);
+    } else {
+        assert_null(value);
+    }
+    slapi_ch_free_string(&value);
+}
+
+void
+test_plugin_cos_cache_classic(void **state __attribute__((unused)))
+{
+    char *specifiers[] = {"testGrade", NULL};
+    char *grades[] = {"gold", "silver", "testGrade-default", NULL};
+    cos_cache *cache = NULL;
+    Slapi_Entry *e = NULL;
+    Slapi_ValueSet *vs = NULL;
+
+    ndn_cache_init();
+    cache_register_grade();
+    cache = cos_cache_test_classic(TEST_SUFFIX, specifiers, grades, "testCosAttr");
+    assert_non_null(cache);
+
+    /* the specifier is computed once per query, not once per template */
+    cache_check(cache, "uid=a,ou=people," TEST_SUFFIX, "gold", 1, "gold");
+    cache_check(cache, "uid=a,ou=people," TEST_SUFFIX, "Silver", 1, "silver");
+    /* without a template of its grade, the entry gets the default one */
+    cache_check(cache, "uid=a,ou=people," TEST_SUFFIX, "bronze", 1, "testGrade-default");
+    cache_check(cache, "uid=a,ou=people," TEST_SUFFIX, NULL, 1, "testGrade-default");
+    /* out of scope */
+    cache_check(cache, "uid=a,dc=example,dc=org", "gold", 0, NULL);
+
+    /* an attribute the cache does not supply */
+    e = cache_entry("uid=a," TEST_SUFFIX, "gold");
+    assert_int_equal(cos_cache_test_query(cache, e, "testOtherAttr", &vs), -1);
+    assert_null(vs);
+    slapi_entry_free(e);
+
+    cos_cache_test_free(cache);
+    ndn_cache_destroy();
+}
+
+void
+test_plugin_cos_cache_specifiers(void **state __attribute__((unused)))
+{
+    /* testMissing is a real attribute the entries do not have */
+    char *specifiers[] = {"testMissing", "testGrade", NULL};
+    char *grades[] = {"gold", "testMissing-default", NULL};
+    cos_cache *cache = NULL;
+
+    ndn_cache_init();
+    cache_register_grade();
+    cache = cos_cache_test_classic(TEST_SUFFIX, specifiers, grades, "testCosAttr");
+    assert_non_null(cache);
+
+    /* the specifiers are tried in order, each one computed once */
+    cache_check(cache, "uid=a," TEST_SUFFIX, "gold", 1, "gold");
+    /* the default template is graded after the first specifier */
+    cache_check(cache, "uid=a," TEST_SUFFIX, "silver", 1, "testMissing-default");
+
+    cos_cache_test_free(cache);
+    ndn_cache_destroy();
+}
@@ -78,3 +78,76 @@ test_plugin_pwdstorage_pbkdf2_rounds(void **state __attribute__((unused)))
     assert_true(pbkdf2_sha256_calculate_iterations(2500000) == 20000);
 #endif
 }
+
+void
+test_plugin_pwdstorage_pbkdf2_mb_vectors(void **state __attribute__((unused)))
+{
+#if (NSS_VMAJOR * 100 + NSS_VMINOR) > 328
+    /* RFC 7914 section 11: PBKDF2-HMAC-SHA256 (P="passwd", S="salt", c=1, dkLen=64) */
+    const unsigned char rfc_dk[64] = {
+        0x55, 0xac, 0x04, 0x6e, 0x56, 0xe3, 0x08, 0x9f, 0xec, 0x16, 0x91, 0xc2, 0x25, 0x44, 0xb6, 0x05,
+        0xf9, 0x41, 0x85, 0x21, 0x6d, 0xde, 0x04, 0x65, 0xe6, 0x8b, 0x9d, 0x57, 0xc2, 0x0d, 0xac, 0xbc,
+        0x49, 0xca, 0x9c, 0xcc, 0xf1, 0x79, 0xb6, 0x45, 0x99, 0x16, 0x64, 0xb3, 0x9d, 0x77, 0xef, 0x31,
+        0x7c, 0x71, 0xb8, 0x45, 0xb1, 0xe3, 0x0b, 0xd5, 0x09, 0x11, 0x20, 0x41, 0xd3, 0xa1, 0x97, 0x83};
+    unsigned char dk[256];
+    pbkdf2_mb_job job = {(const unsigned char *)"passwd", 6, (const unsigned char *)"salt", 4, 1, dk, 64};
+
+    pbkdf2_sha256_mb(&job, 1);
+    assert_memory_equal(dk, rfc_dk, sizeof(rfc_dk));
+
+    /*
+     * The multi-buffer kernel must agree with NSS for every shape we can
+     * hit: short, block sized and over long passwords (which get hashed
+     * into the HMAC key), odd salt and output lengths.
+     */
+    for (size_t t = 0; t < 24; t++) {
+        char pwd[160];
+        char salt[80];
+        char nss_dk[256];
+        size_t pwd_len = (t * 37) % sizeof(pwd);
+        size_t salt_len = (t * 13) % sizeof(salt) + 1;
+        size_t dk_len = (t % 4 == 0) ? 256 : 1 + (t * 53) % 256;
+        uint32_t iterations = 1 + (t * 97) % 1500;
+        SECItem pwdItem = {siBuffer, (unsigned char *)pwd, pwd_len};
+        SECItem saltItem = {siBuffer, (unsigned char *)salt, salt_len};
+
+        for (size_t i = 0; i < sizeof(pwd); i++) {
+            pwd[i] = (char)(i * 7 + t);
+        }
+        for (size_t i = 0; i < sizeof(salt); i++) {
+            salt[i] = (char)(i * 3 + t);
+        }
+
+        job = (pbkdf2_mb_job){(unsigned char *)pwd, pwd_len, (unsigned char *)salt, salt_len, iterations, dk, dk_len};
+        pbkdf2_sha256_mb(&job, 1);
+        /*
+         * The NSS path unwraps the key with AES so wants whole blocks. A
+         * shorter PBKDF2 output is a prefix of a longer one, so compare
+         * against the full length.
+         */
+        assert_true(pbkdf2_sha256_hash_nss(nss_dk, sizeof(nss_dk), &pwdItem, &saltItem, iterations) == SECSuccess);
+        assert_memory_equal(dk, nss_dk, dk_len);
+    }
+
+    /* A batch mixing iteration counts and lengths fills and refills the lanes */
+    {
+        pbkdf2_mb_job jobs[11];
+        unsigned char out[11][256];
+        char nss_dk[256];
+        const char *salt = "saltsaltsalt";
+
+        for (size_t t = 0; t < 11; t++) {
+            jobs[t] = (pbkdf2_mb_job){(const unsigned char *)"password", 8,
+                                      (const unsigned char *)salt, 12 - (t % 3),
+                                      100 + t * 50, out[t], t * 23 + 5};
+        }
+        pbkdf2_sha256_mb(jobs, 11);
+        for (size_t t = 0; t < 11; t++) {
+            SECItem pwdItem = {siBuffer, (unsigned char *)"password", 8};
+            SECItem saltItem = {siBuffer, (unsigned char *)salt, jobs[t].salt_len};
+            assert_true(pbkdf2_sha256_hash_nss(nss_dk, sizeof(nss_dk), &pwdItem, &saltItem, jobs[t].iterations) == SECSuccess);
+            assert_memory_equal(out[t], nss_dk, jobs[t].out_len);
+        }
+    }
+#endif
+}
@@ -0,0 +1,197 @@
+/** BEGIN COPYRIGHT BLOCK
+ * Copyright (C) 2026 Red Hat, Inc.
+ * All rights reserved.
+ *
+ * License: GPL (version 3 or any later version).
+ * See LICENSE for details.
+ * END COPYRIGHT BLOCK **/
+
+#include "../../test_slapd.h"
+
+#include <slap.h>
+#include <vattr_spi.h>
+#include <roles_cache.h>
+
+#define TEST_UNIQUEID "11111111-22222222-33333333-44444444"
+
+#define TEST_CSN1 "5f3b8a2c000000010000"
+#define TEST_CSN2 "5f3b8a2c000100010000"
+
+/* An entry whose version is its max csn */
+static Slapi_Entry *
+membership_entry(const char *uniqueid, const char *maxcsn)
+{
+    Slapi_Entry *e = slapi_entry_alloc();
+
+    slapi_entry_init(e, slapi_ch_strdup("uid=member,dc=example,dc=com"), NULL);
+    slapi_entry_set_uniqueid(e, slapi_ch_strdup(uniqueid));
+    slapi_entry_add_string(e, "uid", "member");
+    slapi_entry_add_string(e, "modifyTimestamp", "20260101000000Z");
+    if (maxcsn) {
+        CSN *csn = csn_new_by_string(maxcsn);
+        entry_set_maxcsn(e, csn);
+        csn_free(&csn);
+    }
+    return e;
+}
+
+/* Record that the entry is a member of role 0 and not of role 1 */
+static void
+membership_record(roles_membership_table *table, Slapi_Entry *e, uint64_t generation)
+{
+    roles_membership *m = roles_membership_get(table, e, 3, generation);
+
+    assert_non_null(m);
+    roles_membership_record(m, 0, 1);
+    roles_membership_record(m, 1, 0);
+    roles_membership_put(table, m, generation);
+}
+
+/* Return 1 if role 0 is known for e */
+static int
+membership_known(roles_membership_table *table, Slapi_Entry *e, int nb_roles, uint64_t generation)
+{
+    roles_membership *m = roles_membership_get(table, e, nb_roles, generation);
+    int present = 0;
+    int known = roles_membership_lookup(m, 0, &present);
+
+    /* not a member of role 1, not evaluated for role 2 */
+    if (known) {
+        assert_int_equal(present, 1);
+        present = 0;
+        assert_int_equal(roles_membership_lookup(m, 1, &present), 1);
+        assert_int_equal(present, 0);
+        assert_int_equal(roles_membership_lookup(m, 2, &present), 0);
+    }
+    roles_membership_put(table, m, generation);
+    return known;
+}
+
+/* The record belongs to a version of the entry, not to its address */
+void
+test_plugin_roles_membership_version(void **state __attribute__((unused)))
+{
+    roles_membership_table *table = roles_membership_table_new();
+    Slapi_Entry *e1 = membership_entry(TEST_UNIQUEID, TEST_CSN1);
+    Slapi_Entry *copy = slapi_entry_dup(e1);
+    Slapi_Entry *e2 = membership_entry(TEST_UNIQUEID, TEST_CSN2);
+    Slapi_Entry *noversion = membership_entry(TEST_UNIQUEID, NULL);
+    Slapi_Entry *usn1 = membership_entry(TEST_UNIQUEID, NULL);
+    Slapi_Entry *usn2 = membership_entry(TEST_UNIQUEID, NULL);
+
+    assert_non_null(table);
+    membership_record(table, e1, 1);
+    assert_int_equal(roles_membership_count(table), 1);
+
+    /* same version at another address */
+    assert_int_equal(membership_known(table, copy, 3, 1), 1);
+    assert_int_equal(membership_known(table, e1, 3, 1), 1);
+
+    /* the entry was updated */
+    assert_int_equal(membership_known(table, e2, 3, 1), 0);
+    /* e2 evaluated nothing, its record replaced the one of e1 */
+    assert_int_equal(membership_known(table, e1, 3, 1), 0);
+
+    /* an entry without csn nor entryusn is never recorded: its
+       modifyTimestamp is the same for the updates made within a second */
+    assert_null(roles_membership_get(table, noversion, 3, 1));
+
+    /* without replication, the entryusn identifies the version */
+    slapi_entry_add_string(usn1, "entryusn", "10");
+    slapi_entry_add_string(usn2, "entryusn", "11");
+    membership_record(table, usn1, 1);
+    assert_int_equal(membership_known(table, usn1, 3, 1), 1);
+    assert_int_equal(membership_known(table, usn2, 3, 1), 0);
+
+    slapi_entry_free(e1);
+    slapi_entry_free(copy);
+    slapi_entry_free(e2);
+    slapi_entry_free(noversion);
+    slapi_entry_free(usn1);
+    slapi_entry_free(usn2);
+    roles_membership_table_free(&table);
+    assert_null(table);
+}
+
+/* The records are discarded when the entry or the roles change */
+void
+test_plugin_roles_membership_invalidate(void **state __attribute__((unused)))
+{
+    roles_membership_table *table = roles_membership_table_new();
+    Slapi_Entry *e = membership_entry(TEST_UNIQUEID, TEST_CSN1);
+    roles_membership *m = NULL;
+
+    /* the entry is modified or deleted */
+    membership_record(table, e, 1);
+    roles_membership_forget(table, TEST_UNIQUEID);
+    assert_int_equal(roles_membership_count(table), 0);
+    assert_int_equal(membership_known(table, e, 3, 1), 0);
+
+    /* an entry is updated while the roles are evaluated: the result may be
+       older than what the post operation discarded, it is not recorded */
+    roles_membership_clear(table);
+    m = roles_membership_get(table, e, 3, 1);
+    roles_membership_record(m, 0, 1);
+    roles_membership_forget(table, TEST_UNIQUEID);
+    roles_membership_put(table, m, 1);
+    assert_int_equal(roles_membership_count(table), 0);
+
+    /* a role definition changes */
+    membership_record(table, e, 1);
+    assert_int_equal(membership_known(table, e, 3, 2), 0);
+    membership_record(table, e, 2);
+    m = roles_membership_get(table, e, 3, 2);
+    roles_membership_record(m, 0, 1);
+    roles_membership_put(table, m, 3);
+    assert_int_equal(membership_known(table, e, 3, 3), 0);
+
+    /* a role is added to the suffix */
+    membership_record(table, e, 3);
+    assert_int_equal(membership_known(table, e, 4, 3), 0);
+
+    /* the virtual attributes change */
+    membership_record(table, e, 3);
+    slapi_entrycache_vattrcache_watermark_invalidate();
+    assert_int_equal(membership_known(table, e, 3, 3), 0);
+
+    /* the evaluation depends on more than the entry */
+    roles_membership_clear(table);
+    m = roles_membership_get(table, e, 3, 3);
+    roles_membership_record(m, 0, 1);
+    roles_membership_uncacheable(m);
+    roles_membership_put(table, m, 3);
+    assert_int_equal(roles_membership_count(table), 0);
+
+    /* all the roles of the suffix are reindexed */
+    membership_record(table, e, 3);
+    roles_membership_clear(table);
+    assert_int_equal(roles_membership_count(table), 0);
+
+    slapi_entry_free(e);
+    roles_membership_table_free(&table);
+}
+
+/* A full table makes room for new entries without dropping them all */
+void
+test_plugin_roles_membership_evict(void **state __attribute__((unused)))
+{
+    roles_membership_table *table = roles_membership_table_new();
+    Slapi_Entry *e = NULL;
+    char uniqueid[64];
+
+    for (size_t i = 0; i < MAX_MEMBERSHIP_ENTRIES; i++) {
+        snprintf(uniqueid, sizeof(uniqueid), "%08zx-00000000-00000000-00000000", i);
+        e = membership_entry(uniqueid, TEST_CSN1);
+        membership_record(table, e, 1);
+        slapi_entry_free(e);
+    }
+    assert_int_equal(roles_membership_count(table), MAX_MEMBERSHIP_ENTRIES);
+
+    e = membership_entry(TEST_UNIQUEID, TEST_CSN1);
+    membership_record(table, e, 1);
+    assert_int_equal(roles_membership_count(table), MAX_MEMBERSHIP_ENTRIES - MEMBERSHIP_EVICT_ENTRIES + 1);
+    assert_int_equal(membership_known(table, e, 3, 1), 1);
+
+    slapi_entry_free(e);
+    roles_membership_table_free(&table);
+}
@@ -20,12 +20,30 @@ run_plugin_tests(void)
 {
     const struct CMUnitTest tests[] = {
         cmocka_unit_test(test_plugin_hello),
+        cmocka_unit_test(test_plugin_back_ldbm_id2entry_roundtrip),
+        cmocka_unit_test(test_plugin_back_ldbm_id2entry_truncated),
+        cmocka_unit_test_setup_teardown(test_plugin_back_ldbm_mdbbackup_chain,
+                                        test_plugin_pwdstorage_nss_setup,
+                                        test_plugin_pwdstorage_nss_stop),
+        cmocka_unit_test(test_plugin_back_ldbm_scopeindex_add_race),
+        cmocka_unit_test(test_plugin_back_ldbm_scopeindex_committed),
+        cmocka_unit_test(test_plugin_chainingdb_searchcache_key),
+        cmocka_unit_test(test_plugin_chainingdb_searchcache_flush),
+        cmocka_unit_test(test_plugin_chainingdb_searchcache_evict),
         cmocka_unit_test_setup_teardown(test_plugin_pwdstorage_pbkdf2_auth,
                                         test_plugin_pwdstorage_nss_setup,
                                         test_plugin_pwdstorage_nss_stop),
         cmocka_unit_test_setup_teardown(test_plugin_pwdstorage_pbkdf2_rounds,
                                         test_plugin_pwdstorage_nss_setup,
                                         test_plugin_pwdstorage_nss_stop),
+        cmocka_unit_test_setup_teardown(test_plugin_pwdstorage_pbkdf2_mb_vectors,
+                                        test_plugin_pwdstorage_nss_setup,
+                                        test_plugin_pwdstorage_nss_stop),
+        cmocka_unit_test(test_plugin_cos_cache_classic),
+        cmocka_unit_test(test_plugin_cos_cache_specifiers),
+        cmocka_unit_test(test_plugin_roles_membership_version),
+        cmocka_unit_test(test_plugin_roles_membership_invalidate),
+        cmocka_unit_test(test_plugin_roles_membership_evict),
     };
     return cmocka_run_group_tests(tests, NULL, NULL);
 }
@@ -27,9 +27,28 @@ int run_plugin_tests(void);
 /* libslapd */
 void test_libslapd_hello(void **state);
 
+/* libslapd-attr-atom */
+void test_libslapd_attr_atom(void **state);
+
+/* libslapd-entry-binary */
+void test_libslapd_entry_binary_roundtrip(void **state);
+void test_libslapd_entry_binary_truncated(void **state);
+
 /* libslapd-filter-optimise */
 void test_libslapd_filter_optimise(void **state);
 
+/* libslapd-filter-substr */
+void test_libslapd_filter_substr_match(void **state);
+
+/* libslapd-mapping_tree-index */
+void test_libslapd_mapping_tree_index(void **state);
+
+/* libslapd-value-normalized */
+void test_libslapd_value_normalized(void **state);
+
+/* libslapd-valueset-hash */
+void test_libslapd_valueset_hash(void **state);
+
 /* libslapd-pblock-analytics */
 void test_libslapd_pblock_analytics(void **state);
 
@@ -42,6 +61,10 @@ void test_libslapd_pblock_v3c_target_uniqueid(void **state);
 /* libslapd-schema-filter-validate */
 void test_libslapd_schema_filter_validate_simple(void **state);
 
+/* libslapd-schema-snapshot */
+void test_libslapd_schema_snapshot_refresh(void **state);
+void test_libslapd_schema_snapshot_reclaim(void **state);
+
 /* libslapd-operation-v3_compat */
 void test_libslapd_operation_v3c_target_spec(void **state);
 
@@ -72,6 +95,22 @@ void test_haproxy_ipv4_mask_edge_cases(void **state);
 
 void test_plugin_hello(void **state);
 
+/* plugin-back-ldbm-id2entry */
+void test_plugin_back_ldbm_id2entry_roundtrip(void **state);
+void test_plugin_back_ldbm_id2entry_truncated(void **state);
+
+/* plugin-back-ldbm-mdbbackup */
+void test_plugin_back_ldbm_mdbbackup_chain(void **state);
+
+/* plugin-back-ldbm-scopeindex */
+void test_plugin_back_ldbm_scopeindex_add_race(void **state);
+void test_plugin_back_ldbm_scopeindex_committed(void **state);
+
+/* plugin-chainingdb-searchcache */
+void test_plugin_chainingdb_searchcache_key(void **state);
+void test_plugin_chainingdb_searchcache_flush(void **state);
+void test_plugin_chainingdb_searchcache_evict(void **state);
+
 /* plugin-pwdstorage-pbkdf2 */
 
 int test_plugin_pwdstorage_nss_setup(void **state);
@@ -79,3 +118,13 @@ int test_plugin_pwdstorage_nss_stop(void **state);
 
 void test_plugin_pwdstorage_pbkdf2_auth(void **state);
 void test_plugin_pwdstorage_pbkdf2_rounds(void **state);
+void test_plugin_pwdstorage_pbkdf2_mb_vectors(void **state);
+
+/* plugin-cos-cache */
+void test_plugin_cos_cache_classic(void **state);
+void test_plugin_cos_cache_specifiers(void **state);
+
+/* plugin-roles-membership */
+void test_plugin_roles_membership_version(void **state);
+void test_plugin_roles_membership_invalidate(void **state);
+void test_plugin_roles_membership_evict(void **state);